@@ -107,14 +107,42 @@ Popup {
 
                     Text { text: "Execution Time:"; color: textColorDisable; font.pixelSize: 12 }
                     Text {
-                        text: (entryData.executionTime || 0).toFixed(0) + " ms"
+                        text: (entryData.executionTime || 0).toFixed(3) + " ms"
                         color: cyanColor
                         font.pixelSize: 12
                     }
 
+                    Text {
+                        text: "Stages:"
+                        color: textColorDisable
+                        font.pixelSize: 12
+                        visible: stagesText.text !== ""
+                    }
+                    Text {
+                        id: stagesText
+                        // Same pipeline order as the comparison breakdown
+                        text: {
+                            var stages = entryData.stages || {}
+                            var order = ["encode", "cache", "queue", "start", "write", "read",
+                                         "load", "compute", "worker", "transfer", "parse"]
+                            var parts = []
+                            for (var i = 0; i < order.length; i++) {
+                                if (stages[order[i]] !== undefined)
+                                    parts.push(order[i] + " " + (stages[order[i]] / 1e6).toFixed(3))
+                            }
+                            return parts.length > 0 ? parts.join(" · ") + " ms" : ""
+                        }
+                        visible: text !== ""
+                        color: textColor
+                        font.pixelSize: 11
+                        wrapMode: Text.Wrap
+                        Layout.fillWidth: true
+                    }
+
                     Text { text: "Status:"; color: textColorDisable; font.pixelSize: 12 }
                     Text {
-                        text: (entryData.status === "success") ? "✅ Success" : "❌ Error"
+                        text: (entryData.status === "success") ? "✅ Success" :
+                              (entryData.status === "timeout") ? "⏱ Timed out" : "❌ Error"
                         color: (entryData.status === "success") ? lightGreenColor : magentaColor
                         font.pixelSize: 12
                         font.bold: true
@@ -210,7 +238,7 @@ Popup {
                         width: parent.width
 
                         Text {
-                            text: (entryData.status === "error") ? "Error Message:" : "Notes:"
+                            text: (entryData.status !== "success") ? "Error Message:" : "Notes:"
                             font.pixelSize: 14
                             font.bold: true
                             color: textColor
@@ -221,7 +249,7 @@ Popup {
                             height: 60
                             color: Qt.darker(bgColor, 1.2)
                             radius: 5
-                            border.color: (entryData.status === "error") ? magentaColor : elementsColor
+                            border.color: (entryData.status !== "success") ? magentaColor : elementsColor
                             border.width: 1
 
                             ScrollView {
@@ -229,11 +257,11 @@ Popup {
                                 anchors.margins: 5
 
                                 Text {
-                                    text: (entryData.status === "error") ?
+                                    text: (entryData.status !== "success") ?
                                           (entryData.errorMessage || "") :
                                           (entryData.notes || "")
                                     font.pixelSize: 11
-                                    color: (entryData.status === "error") ? magentaColor : textColorDisable
+                                    color: (entryData.status !== "success") ? magentaColor : textColorDisable
                                     wrapMode: Text.Wrap
                                 }
                             }
@@ -7,10 +7,10 @@ Rectangle {
     height: 80
     radius: 5
     color: {
-        if (entryData.status === "error") return Qt.darker(removeColor, 1.5)
+        if (entryData.status !== "success") return Qt.darker(removeColor, 1.5)
         return index % 2 === 0 ? Qt.darker(bgColor, 1.2) : Qt.darker(bgColor, 1.3)
     }
-    border.color: entryData.status === "error" ? magentaColor : elementsColor
+    border.color: entryData.status !== "success" ? magentaColor : elementsColor
     border.width: 1
 
     property var entryData: ({})
@@ -23,12 +23,12 @@ Rectangle {
         onClicked: entryCard.clicked()
 
         onEntered: {
-            if (entryData.status !== "error") {
+            if (entryData.status === "success") {
                 entryCard.color = Qt.darker(elementsColor, 1.3)
             }
         }
         onExited: {
-            if (entryData.status !== "error") {
+            if (entryData.status === "success") {
                 entryCard.color = index % 2 === 0 ? Qt.darker(bgColor, 1.2) : Qt.darker(bgColor, 1.3)
             }
         }
@@ -108,11 +108,11 @@ Rectangle {
 
             // Notes/Error
             Text {
-                text: entryData.status === "error" ?
-                      "❌ " + (entryData.errorMessage || "Error") :
+                text: entryData.status !== "success" ?
+                      (entryData.status === "timeout" ? "⏱ " : "❌ ") + (entryData.errorMessage || "Error") :
                       (entryData.notes || "")
                 font.pixelSize: 10
-                color: entryData.status === "error" ? magentaColor : textColorDisable
+                color: entryData.status !== "success" ? magentaColor : textColorDisable
                 elide: Text.ElideRight
                 visible: text.length > 0
                 Layout.fillWidth: true
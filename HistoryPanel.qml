@@ -251,11 +251,11 @@ Popup {
 
                                         // Notes/Error
                                         Text {
-                                            text: _entryData.status === "error" ?
-                                                  "❌ " + (_entryData.errorMessage || "Error") :
+                                            text: _entryData.status !== "success" ?
+                                                  (_entryData.status === "timeout" ? "⏱ " : "❌ ") + (_entryData.errorMessage || "Error") :
                                                   (_entryData.notes || "")
                                             font.pixelSize: 9
-                                            color: _entryData.status === "error" ? magentaColor : textColorDisable
+                                            color: _entryData.status !== "success" ? magentaColor : textColorDisable
                                             elide: Text.ElideRight
                                             visible: text.length > 0
                                         }
@@ -683,14 +683,14 @@ Popup {
         if (engine && engine.historyManager) {
             var hm = engine.historyManager()
             if (hm) {
-                var stats = hm.getStatistics()
+                var stats = hm.statistics
                 totalEntriesText.text = stats["totalEntries"] || 0
                 successRateText.text = (stats["successRate"] || 0).toFixed(1) + "%"
                 avgResultText.text = (stats["averageResult"] || 0).toFixed(4)
                 avgTimeText.text = (stats["averageExecutionTime"] || 0).toFixed(0) + "ms"
 
                 // Algorithm statistics
-                var algoStats = hm.getAlgorithmStatistics()
+                var algoStats = hm.algorithmStatistics
                 var algoList = []
                 for (var algo in algoStats) {
                     algoList.push({
@@ -41,6 +41,36 @@ ApplicationWindow {
     ListModel {
         id: agentModel
     }
+
+    // Mirror agent edits into the engine so the live algorithm's result
+    // follows them without a full run
+    Connections {
+        target: agentModel
+
+        function onRowsInserted(parent, first, last) {
+            for (let i = first; i <= last; i++) {
+                let agent = agentModel.get(i)
+                engine.addAgent(agent.value, agent.confidence !== undefined ? agent.confidence : 1.0)
+            }
+        }
+
+        function onRowsRemoved(parent, first, last) {
+            if (agentModel.count === 0) {
+                engine.clearValues()
+                return
+            }
+            for (let i = last; i >= first; i--) {
+                engine.removeAgent(i)
+            }
+        }
+
+        function onDataChanged(topLeft, bottomRight, roles) {
+            for (let i = topLeft.row; i <= bottomRight.row; i++) {
+                let agent = agentModel.get(i)
+                engine.updateAgent(i, agent.value, agent.confidence !== undefined ? agent.confidence : 1.0)
+            }
+        }
+    }
     FontLoader {
         id: fontAwsomeRegular
         source: "fonts/FontAwesomeFree-Solid-900.otf"
@@ -54,6 +84,7 @@ ApplicationWindow {
         ListElement { name: "Random Forest"; value: "random_forest.py"; description: "Ensemble method" }
         ListElement { name: "Consensus"; value: "consensus.py"; description: "Consensus-based fusion" }
         ListElement { name: "Weighted with Confidence"; value: "weighted_with_confidence.py"; description: "weighted_with_confidence" }
+        ListElement { name: "Robust Weighted"; value: "robust_weighted.pipeline.json"; description: "Drop outliers, weight by confidence, clamp" }
     }
 
     // Property for custom script path
@@ -61,6 +92,7 @@ ApplicationWindow {
 
     DecisionEngine {
         id: engine
+        liveAlgorithm: scriptComboBox.currentIndex >= 0 ? scriptModel.get(scriptComboBox.currentIndex).value : ""
         onPythonError: (msg) => {
                            console.log("Python error:", msg)
                            showMessage("Error: " + msg, removeColor)
@@ -701,6 +733,15 @@ ApplicationWindow {
                                     }
                                 }
 
+                                Text {
+                                    text: "Result cache: " + engine.resultCacheHits + " hits / "
+                                          + engine.resultCacheMisses + " misses"
+                                    visible: engine.resultCacheEnabled
+                                    font.pixelSize: 11
+                                    color: Qt.lighter(textColor, 1.3)
+                                    Layout.alignment: Qt.AlignHCenter
+                                }
+
                                 MyButton {
                                     id: runFusionButton
                                     mainColor: elementsColor
@@ -756,14 +797,7 @@ ApplicationWindow {
                                         for (let i = 0; i < scriptModel.count; i++)
                                             scripts.push(scriptModel.get(i).value)
 
-                                        // Clear previous results
-                                        comparisonPopup.comparisonData.clear()
-
-                                        // Connect to finished signal
-                                        engine.comparisonFinished.connect(function() {
-                                            comparisonPopup.loadComparisonData()
-                                        })
-
+                                        // The popup's table fills from engine.comparisonModel as scripts finish
                                         // Use the confidence-aware comparison
                                         engine.runComparisonWithConfidence(values, confidences, scripts)
                                         comparisonPopup.open()
@@ -781,6 +815,15 @@ ApplicationWindow {
                                     font.pixelSize: 12
                                     onClicked: {
                                         engine.clearValues()
+                                        // Keep the engine's copy of the agents, only the result goes
+                                        let values = []
+                                        let confidences = []
+                                        for (let i = 0; i < agentModel.count; i++) {
+                                            let agent = agentModel.get(i)
+                                            values.push(agent.value)
+                                            confidences.push(agent.confidence !== undefined ? agent.confidence : 1.0)
+                                        }
+                                        engine.setAgents(values, confidences)
                                         showMessage("Results cleared", warningColor)
                                     }
                                 }
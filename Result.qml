@@ -13,23 +13,30 @@ Popup {
     anchors.centerIn: Overlay.overlay
 
     property string title: "Algorithm Comparison Results"
-    property bool showProgress: engine.isComparing
-    property ListModel comparisonData: ListModel {}
-
-    function loadComparisonData() {
-           comparisonData.clear()
-           var results = engine.getComparisonResults()
-           for (var i = 0; i < results.length; i++) {
-               comparisonData.append(results[i])
-           }
-       }
-
-    onOpened: {
-            if (!engine.isComparing) {
-                loadComparisonData()
-            }
+    // Rows appear as scripts finish; the overlay only covers an empty table
+    property bool showProgress: engine.isComparing && engine.comparisonCount === 0
+
+    // Colours of the stages in the breakdown bar, in pipeline order
+    readonly property var stageColors: ["#8E7CC3", "#6FA8DC", "#999999", "#E69138", "#F6B26B",
+                                        "#93C47D", "#FFD966", "#00BCD4", "#C27BA0", "#76A5AF", "#B4A7D6"]
+
+    // Where a result's time went: "encode 0.012 · compute 1.204 · ... ms"
+    function formatStages(stages) {
+        var parts = []
+        for (var i = 0; i < stages.length; i++) {
+            var stage = stages[i]
+            parts.push(stage.stage + " " + stage.ms.toFixed(3))
         }
+        return parts.length > 0 ? parts.join("  ·  ") + " ms" : "No breakdown recorded"
+    }
 
+    function stagesSum(stages) {
+        var sum = 0
+        for (var i = 0; i < stages.length; i++) {
+            sum += stages[i].ms
+        }
+        return sum
+    }
 
     background: Rectangle {
         color: bgColor
@@ -80,6 +87,16 @@ Popup {
                 color: Qt.lighter(textColor, 1.3)
                 font.pixelSize: 12
             }
+
+            MyButton {
+                Layout.alignment: Qt.AlignHCenter
+                mainColor: removeColor
+                _width: 120
+                _height: 35
+                text: "Cancel"
+                font.pixelSize: 12
+                onClicked: engine.cancelComparison()
+            }
         }
     }
 
@@ -100,6 +117,23 @@ Popup {
                 Layout.fillWidth: true
             }
 
+            Text {
+                visible: engine.isComparing && !showProgress
+                text: "Comparing... (" + engine.comparisonProgressCurrent + "/" + engine.comparisonProgressTotal + ")"
+                font.pixelSize: 12
+                color: Qt.lighter(textColor, 1.3)
+            }
+
+            MyButton {
+                visible: engine.isComparing && !showProgress
+                mainColor: removeColor
+                _width: 80
+                _height: 30
+                text: "Cancel"
+                font.pixelSize: 12
+                onClicked: engine.cancelComparison()
+            }
+
             MyButton {
                 mainColor: removeColor
                 _width: 30
@@ -291,16 +325,24 @@ Popup {
                 anchors.fill: parent
                 anchors.margins: 2
                 clip: true
-                model: comparisonData
+                model: engine.comparisonModel
 
                 delegate: Rectangle {
+                    id: resultRow
                     width: comparisonListView.width
-                    height: 40
+                    height: 68
                     color: index % 2 === 0 ? Qt.darker(bgColor, 1.1) : Qt.darker(bgColor, 1.15)
 
+                    property var stages: model.stages
+                    property real stagesTotal: stages ? stagesSum(stages) : 0
+
                     RowLayout {
-                        anchors.fill: parent
+                        id: resultColumns
+                        anchors.left: parent.left
+                        anchors.right: parent.right
+                        anchors.top: parent.top
                         anchors.margins: 10
+                        height: 24
                         spacing: 10
 
                         Text {
@@ -324,7 +366,7 @@ Popup {
                         }
 
                         Text {
-                            text: model.executionTime.toFixed(1)
+                            text: model.executionTime.toFixed(3)
                             font.pixelSize: 11
                             color: cyanColor
                             Layout.preferredWidth: 80
@@ -372,6 +414,41 @@ Popup {
                             }
                         }
                     }
+
+                    // Per-stage time breakdown
+                    Row {
+                        id: stageBar
+                        anchors.left: parent.left
+                        anchors.right: parent.right
+                        anchors.top: resultColumns.bottom
+                        anchors.leftMargin: 10
+                        anchors.rightMargin: 10
+                        anchors.topMargin: 4
+                        height: 6
+                        visible: resultRow.stagesTotal > 0
+
+                        Repeater {
+                            model: resultRow.stages
+                            delegate: Rectangle {
+                                width: stageBar.width * modelData.ms / resultRow.stagesTotal
+                                height: stageBar.height
+                                color: stageColors[index % stageColors.length]
+                            }
+                        }
+                    }
+
+                    Text {
+                        anchors.left: parent.left
+                        anchors.right: parent.right
+                        anchors.top: stageBar.bottom
+                        anchors.leftMargin: 10
+                        anchors.rightMargin: 10
+                        anchors.topMargin: 4
+                        text: resultRow.stages ? formatStages(resultRow.stages) : ""
+                        font.pixelSize: 10
+                        color: Qt.lighter(textColor, 1.3)
+                        elide: Text.ElideRight
+                    }
                 }
             }
         }
@@ -50,7 +50,7 @@ Rectangle {
                             Text { text: "Total Entries:"; color: textColorDisable; font.pixelSize: 11 }
                             Text {
                                 text: {
-                                    var stats = historyManager.getStatistics()
+                                    var stats = historyManager.statistics
                                     return stats["totalEntries"] || 0
                                 }
                                 color: lightGreenColor; font.pixelSize: 11; font.bold: true
@@ -59,7 +59,7 @@ Rectangle {
                             Text { text: "Success Rate:"; color: textColorDisable; font.pixelSize: 11 }
                             Text {
                                 text: {
-                                    var stats = historyManager.getStatistics()
+                                    var stats = historyManager.statistics
                                     var rate = stats["successRate"] || 0
                                     return rate.toFixed(1) + "%"
                                 }
@@ -70,7 +70,7 @@ Rectangle {
                             Text { text: "Success Count:"; color: textColorDisable; font.pixelSize: 11 }
                             Text {
                                 text: {
-                                    var stats = historyManager.getStatistics()
+                                    var stats = historyManager.statistics
                                     return stats["successCount"] || 0
                                 }
                                 color: lightGreenColor; font.pixelSize: 11; font.bold: true
@@ -79,7 +79,7 @@ Rectangle {
                             Text { text: "Error Count:"; color: textColorDisable; font.pixelSize: 11 }
                             Text {
                                 text: {
-                                    var stats = historyManager.getStatistics()
+                                    var stats = historyManager.statistics
                                     return stats["errorCount"] || 0
                                 }
                                 color: magentaColor; font.pixelSize: 11; font.bold: true
@@ -88,14 +88,14 @@ Rectangle {
                             // Row 3
                             Text { text: "Average Result:"; color: textColorDisable; font.pixelSize: 11 }
                             Text {
-                                text: (historyManager.getAverageResult() || 0).toFixed(4)
+                                text: (historyManager.averageResult || 0).toFixed(4)
                                 color: yellowColor; font.pixelSize: 11; font.bold: true
                             }
 
                             Text { text: "Avg Confidence:"; color: textColorDisable; font.pixelSize: 11 }
                             Text {
                                 text: {
-                                    var stats = historyManager.getStatistics()
+                                    var stats = historyManager.statistics
                                     var conf = stats["averageConfidence"] || 0
                                     return (conf * 100).toFixed(1) + "%"
                                 }
@@ -106,7 +106,7 @@ Rectangle {
                             Text { text: "Avg Execution Time:"; color: textColorDisable; font.pixelSize: 11 }
                             Text {
                                 text: {
-                                    var stats = historyManager.getStatistics()
+                                    var stats = historyManager.statistics
                                     var time = stats["averageExecutionTime"] || 0
                                     return time.toFixed(0) + "ms"
                                 }
@@ -141,7 +141,7 @@ Rectangle {
                             Layout.fillHeight: true
                             clip: true
                             model: {
-                                var algoStats = historyManager.getAlgorithmStatistics()
+                                var algoStats = historyManager.algorithmStatistics
                                 return Object.keys(algoStats)
                             }
 
@@ -170,7 +170,7 @@ Rectangle {
 
                                         Text {
                                             text: {
-                                                var algoStats = historyManager.getAlgorithmStatistics()
+                                                var algoStats = historyManager.algorithmStatistics
                                                 var stats = algoStats[modelData] || {}
                                                 return stats["usageCount"] + " uses"
                                             }
@@ -193,7 +193,7 @@ Rectangle {
 
                                             Rectangle {
                                                 width: {
-                                                    var algoStats = historyManager.getAlgorithmStatistics()
+                                                    var algoStats = historyManager.algorithmStatistics
                                                     var stats = algoStats[modelData] || {}
                                                     var percentage = stats["usagePercentage"] || 0
                                                     return parent.width * (percentage / 100)
@@ -207,7 +207,7 @@ Rectangle {
                                         // Percentage
                                         Text {
                                             text: {
-                                                var algoStats = historyManager.getAlgorithmStatistics()
+                                                var algoStats = historyManager.algorithmStatistics
                                                 var stats = algoStats[modelData] || {}
                                                 var percentage = stats["usagePercentage"] || 0
                                                 return percentage.toFixed(1) + "%"
@@ -230,7 +230,7 @@ Rectangle {
 
                                         Text {
                                             text: {
-                                                var algoStats = historyManager.getAlgorithmStatistics()
+                                                var algoStats = historyManager.algorithmStatistics
                                                 var stats = algoStats[modelData] || {}
                                                 return stats["averageResult"] ? stats["averageResult"].toFixed(4) : "0.0000"
                                             }
@@ -248,7 +248,7 @@ Rectangle {
 
                                         Text {
                                             text: {
-                                                var algoStats = historyManager.getAlgorithmStatistics()
+                                                var algoStats = historyManager.algorithmStatistics
                                                 var stats = algoStats[modelData] || {}
                                                 return stats["averageExecutionTime"] ?
                                                        stats["averageExecutionTime"].toFixed(0) + "ms" : "0ms"
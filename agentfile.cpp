@@ -0,0 +1,88 @@
+#include "agentfile.h"
+#include <QFile>
+#include <QList>
+
+namespace AgentFile {
+
+namespace {
+
+bool isHeader(const QByteArray &line)
+{
+    QByteArray lower = line.trimmed().toLower();
+    return lower.contains("value") || lower.contains("confidence") || lower.contains("agent");
+}
+
+// Same precedence as Main.qml: comma, semicolon, tab, colon
+char separatorOf(const QByteArray &line)
+{
+    for (char separator : { ',', ';', '\t', ':' }) {
+        if (line.contains(separator)) {
+            return separator;
+        }
+    }
+    return 0;
+}
+
+bool toUnit(const QByteArray &field, double &number)
+{
+    bool ok = false;
+    number = field.trimmed().toDouble(&ok);
+    return ok && number >= 0.0 && number <= 1.0;
+}
+
+} // namespace
+
+Agents parse(const QByteArray &content)
+{
+    Agents agents;
+    const QList<QByteArray> lines = content.split('\n');
+
+    for (qsizetype i = 0; i < lines.size(); ++i) {
+        QByteArray line = lines[i].trimmed();
+
+        if (i == 0 && isHeader(line)) {
+            continue;
+        }
+        if (line.isEmpty() || line.startsWith('#') || line.startsWith("//")) {
+            continue;
+        }
+
+        double value = 0.0;
+        double confidence = 1.0;
+        bool valid;
+
+        char separator = separatorOf(line);
+        if (separator == 0) {
+            valid = toUnit(line, value);
+        } else {
+            QList<QByteArray> parts = line.split(separator);
+            valid = toUnit(parts[0], value) && toUnit(parts[1], confidence);
+        }
+
+        if (!valid) {
+            agents.invalidLines++;
+            continue;
+        }
+
+        agents.values.append(value);
+        agents.confidences.append(confidence);
+    }
+
+    return agents;
+}
+
+bool read(const QString &path, Agents &agents, QString *errorString)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (errorString) {
+            *errorString = file.errorString();
+        }
+        return false;
+    }
+
+    agents = parse(file.readAll());
+    return true;
+}
+
+} // namespace AgentFile
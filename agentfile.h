@@ -0,0 +1,29 @@
+#ifndef AGENTFILE_H
+#define AGENTFILE_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVariantList>
+
+// Reader for agent files, with the same rules as the file loader in Main.qml:
+// one agent per line as "value", "value,confidence", "value;confidence",
+// "value<TAB>confidence" or "value:confidence". Extra columns are ignored,
+// a header line mentioning value/confidence/agent is skipped, as are blank
+// lines and lines starting with # or //. Values and confidences must lie in
+// [0, 1]; other lines are counted as invalid and dropped.
+namespace AgentFile {
+
+struct Agents {
+    QVariantList values;
+    QVariantList confidences;  // one per value, 1.0 when the line has none
+    int invalidLines = 0;
+};
+
+Agents parse(const QByteArray &content);
+
+// False with errorString set if the file cannot be read
+bool read(const QString &path, Agents &agents, QString *errorString = nullptr);
+
+} // namespace AgentFile
+
+#endif // AGENTFILE_H
@@ -0,0 +1,148 @@
+#include "comparisonresultmodel.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+ComparisonResultModel::ComparisonResultModel(QObject *parent)
+    : QAbstractListModel(parent)
+{
+}
+
+int ComparisonResultModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : static_cast<int>(m_results.size());
+}
+
+QVariant ComparisonResultModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_results.size()) {
+        return QVariant();
+    }
+
+    const ComparisonResult &result = m_results.at(index.row());
+    switch (role) {
+    case Qt::DisplayRole:
+    case AlgorithmRole:
+        return result.algorithm;
+    case ValueRole:
+        return result.value;
+    case ConfidenceRole:
+        return result.confidence;
+    case ExecutionTimeRole:
+        return result.executionTime;
+    case RankRole:
+        return index.row() + 1;
+    case OkRole:
+        return result.ok;
+    case StagesRole:
+        return result.stages;
+    default:
+        return QVariant();
+    }
+}
+
+QHash<int, QByteArray> ComparisonResultModel::roleNames() const
+{
+    return {
+        { AlgorithmRole, "algorithm" },
+        { ValueRole, "value" },
+        { ConfidenceRole, "confidence" },
+        { ExecutionTimeRole, "executionTime" },
+        { RankRole, "rank" },
+        { OkRole, "ok" },
+        { StagesRole, "stages" }
+    };
+}
+
+int ComparisonResultModel::add(const ComparisonResult &result)
+{
+    // After any equal values, so ties keep their arrival order
+    auto position = std::upper_bound(m_results.begin(), m_results.end(), result,
+                                     [](const ComparisonResult &a, const ComparisonResult &b) {
+                                         return a.value > b.value;
+                                     });
+    const int row = static_cast<int>(position - m_results.begin());
+
+    beginInsertRows(QModelIndex(), row, row);
+    m_results.insert(row, result);
+    endInsertRows();
+
+    // Everything below moved down one rank
+    const int last = static_cast<int>(m_results.size()) - 1;
+    if (row < last) {
+        emit dataChanged(index(row + 1), index(last), { RankRole });
+    }
+    return row;
+}
+
+void ComparisonResultModel::clear()
+{
+    if (m_results.isEmpty()) {
+        return;
+    }
+    beginResetModel();
+    m_results.clear();
+    endResetModel();
+}
+
+const QVector<ComparisonResult> &ComparisonResultModel::results() const
+{
+    return m_results;
+}
+
+bool ComparisonResultModel::isEmpty() const
+{
+    return m_results.isEmpty();
+}
+
+ComparisonResultModel::Summary ComparisonResultModel::summary() const
+{
+    Summary summary;
+    if (m_results.isEmpty()) {
+        return summary;
+    }
+
+    double sum = 0.0;
+    for (const ComparisonResult &result : m_results) {
+        sum += result.value;
+    }
+    summary.mean = sum / m_results.size();
+
+    double variance = 0.0;
+    for (const ComparisonResult &result : m_results) {
+        const double diff = result.value - summary.mean;
+        variance += diff * diff;
+    }
+    summary.stdDev = std::sqrt(variance / m_results.size());
+
+    // Rows are sorted by value, so the best is the first
+    summary.bestAlgorithm = m_results.first().algorithm;
+
+    double fastestTime = std::numeric_limits<double>::max();
+    for (const ComparisonResult &result : m_results) {
+        if (result.executionTime < fastestTime) {
+            fastestTime = result.executionTime;
+            summary.fastestAlgorithm = result.algorithm;
+        }
+    }
+    return summary;
+}
+
+QVariantList ComparisonResultModel::toVariantList() const
+{
+    QVariantList list;
+    list.reserve(m_results.size());
+    for (int i = 0; i < m_results.size(); ++i) {
+        const ComparisonResult &result = m_results.at(i);
+        QVariantMap item;
+        item["algorithm"] = result.algorithm;
+        item["value"] = result.value;
+        item["confidence"] = result.confidence;
+        item["executionTime"] = result.executionTime;
+        item["rank"] = i + 1;
+        item["ok"] = result.ok;
+        item["stages"] = result.stages;
+        list.append(item);
+    }
+    return list;
+}
@@ -0,0 +1,71 @@
+#ifndef COMPARISONRESULTMODEL_H
+#define COMPARISONRESULTMODEL_H
+
+#include <QAbstractListModel>
+#include <QString>
+#include <QVariantList>
+#include <QVector>
+
+// One script's outcome in a comparison
+struct ComparisonResult {
+    QString algorithm;
+    double value = 0.0;  // 0 for failed scripts, which still take a row
+    double confidence = 1.0;
+    double executionTime = 0.0;  // ms
+    bool ok = false;
+    QVariantList stages;  // {stage, ms} in pipeline order, see DecisionEngine::orderedStages()
+};
+Q_DECLARE_METATYPE(ComparisonResult)
+
+// The results of the current comparison, best value first.
+//
+// Rows are kept sorted as they arrive: every finished script is one
+// beginInsertRows() at its place, so views show results progressively and
+// never rebuild. The rank is the row number and is not stored; an insert
+// only re-announces the ranks below it.
+class ComparisonResultModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    enum Role {
+        AlgorithmRole = Qt::UserRole + 1,
+        ValueRole,
+        ConfidenceRole,
+        ExecutionTimeRole,
+        RankRole,
+        OkRole,
+        StagesRole
+    };
+
+    explicit ComparisonResultModel(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+    // Returns the row the result landed on
+    int add(const ComparisonResult &result);
+    void clear();
+
+    const QVector<ComparisonResult> &results() const;
+    bool isEmpty() const;
+
+    // Over every row, failed scripts included; zeros and empty names when
+    // there are no rows
+    struct Summary {
+        double mean = 0.0;
+        double stdDev = 0.0;
+        QString bestAlgorithm;
+        QString fastestAlgorithm;
+    };
+    Summary summary() const;
+
+    // Rows as {algorithm, value, confidence, executionTime, rank, ok, stages} maps
+    QVariantList toVariantList() const;
+
+private:
+    QVector<ComparisonResult> m_results;  // sorted by value, descending
+};
+
+#endif // COMPARISONRESULTMODEL_H
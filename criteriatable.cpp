@@ -0,0 +1,129 @@
+#include "criteriatable.h"
+
+CriteriaTable::CriteriaTable(const QStringList &criteria, qsizetype agentCount)
+    : m_criteria(criteria),
+    m_agentCount(agentCount),
+    m_cells(criteria.size() * agentCount, 0.0)
+{
+}
+
+QStringList CriteriaTable::criteria() const
+{
+    return m_criteria;
+}
+
+int CriteriaTable::criteriaCount() const
+{
+    return static_cast<int>(m_criteria.size());
+}
+
+qsizetype CriteriaTable::agentCount() const
+{
+    return m_agentCount;
+}
+
+qsizetype CriteriaTable::cellCount() const
+{
+    return m_cells.size();
+}
+
+bool CriteriaTable::isEmpty() const
+{
+    return m_cells.isEmpty();
+}
+
+double *CriteriaTable::column(int criterion)
+{
+    return m_cells.data() + criterion * m_agentCount;
+}
+
+const double *CriteriaTable::column(int criterion) const
+{
+    return m_cells.constData() + criterion * m_agentCount;
+}
+
+const double *CriteriaTable::cells() const
+{
+    return m_cells.constData();
+}
+
+double CriteriaTable::value(qsizetype agent, int criterion) const
+{
+    return m_cells.at(criterion * m_agentCount + agent);
+}
+
+void CriteriaTable::setValue(qsizetype agent, int criterion, double value)
+{
+    m_cells[criterion * m_agentCount + agent] = value;
+}
+
+const double *CriteriaTable::confidences() const
+{
+    return m_confidences.isEmpty() ? nullptr : m_confidences.constData();
+}
+
+bool CriteriaTable::hasConfidences() const
+{
+    return !m_confidences.isEmpty();
+}
+
+bool CriteriaTable::setConfidences(const QVector<double> &confidences)
+{
+    if (!confidences.isEmpty() && confidences.size() != m_agentCount) {
+        return false;
+    }
+    m_confidences = confidences;
+    return true;
+}
+
+bool CriteriaTable::fromColumns(const QStringList &criteria, const QVariantList &columns,
+                                const QVariantList &confidences, CriteriaTable &table,
+                                QString *errorString)
+{
+    auto fail = [errorString](const QString &message) {
+        if (errorString) {
+            *errorString = message;
+        }
+        return false;
+    };
+
+    if (columns.isEmpty()) {
+        return fail("No criteria provided.");
+    }
+    if (!criteria.isEmpty() && criteria.size() != columns.size()) {
+        return fail(QString("%1 criterion names for %2 columns.").arg(criteria.size()).arg(columns.size()));
+    }
+
+    QStringList names = criteria;
+    for (int k = names.size(); k < columns.size(); ++k) {
+        names.append(QString("criterion %1").arg(k + 1));
+    }
+
+    const qsizetype agentCount = columns.first().toList().size();
+    if (agentCount == 0) {
+        return fail("No agent values provided.");
+    }
+
+    table = CriteriaTable(names, agentCount);
+    for (int k = 0; k < columns.size(); ++k) {
+        const QVariantList column = columns[k].toList();
+        if (column.size() != agentCount) {
+            return fail(QString("Criterion \"%1\" has %2 values for %3 agents.")
+                            .arg(names[k]).arg(column.size()).arg(agentCount));
+        }
+        double *out = table.column(k);
+        for (qsizetype i = 0; i < agentCount; ++i) {
+            out[i] = column[i].toDouble();
+        }
+    }
+
+    // Like the single-criterion input, a confidence list of the wrong size is ignored
+    if (confidences.size() == agentCount) {
+        QVector<double> agentConfidences(agentCount);
+        for (qsizetype i = 0; i < agentCount; ++i) {
+            agentConfidences[i] = confidences[i].toDouble();
+        }
+        table.setConfidences(agentConfidences);
+    }
+    return true;
+}
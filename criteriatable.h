@@ -0,0 +1,62 @@
+#ifndef CRITERIATABLE_H
+#define CRITERIATABLE_H
+
+#include <QString>
+#include <QStringList>
+#include <QVariantList>
+#include <QVector>
+
+// Agents scored on several criteria, stored column-major.
+//
+// All of one criterion's values sit in one contiguous run of the cell
+// array, so every fusion kernel walks agents with unit stride exactly as it
+// does for single-criterion input, and the columns go into a binary frame
+// (and from there into a numpy (criteria, agents) view) without being
+// transposed. Confidences belong to the agent, not to a criterion: there
+// is one per agent or none at all.
+//
+// The cells are implicitly shared, so a table is cheap to hand to the
+// executor's thread by value.
+class CriteriaTable
+{
+public:
+    CriteriaTable() = default;
+    // Zero-filled table of agentCount agents for the named criteria
+    CriteriaTable(const QStringList &criteria, qsizetype agentCount);
+
+    QStringList criteria() const;
+    int criteriaCount() const;
+    qsizetype agentCount() const;
+    qsizetype cellCount() const;
+    bool isEmpty() const;
+
+    // One criterion's values for every agent, contiguous
+    double *column(int criterion);
+    const double *column(int criterion) const;
+    // Every column back to back
+    const double *cells() const;
+
+    double value(qsizetype agent, int criterion) const;
+    void setValue(qsizetype agent, int criterion, double value);
+
+    // Null when the agents have no confidences
+    const double *confidences() const;
+    bool hasConfidences() const;
+    // Empty, or one per agent; anything else is ignored
+    bool setConfidences(const QVector<double> &confidences);
+
+    // From QML: columns holds one list of agent values per criterion, all of
+    // the same length, and criteria their names (empty for "criterion 1", ...).
+    // False with errorString set on mismatched sizes.
+    static bool fromColumns(const QStringList &criteria, const QVariantList &columns,
+                            const QVariantList &confidences, CriteriaTable &table,
+                            QString *errorString = nullptr);
+
+private:
+    QStringList m_criteria;
+    qsizetype m_agentCount = 0;
+    QVector<double> m_cells;  // criterion k at [k * m_agentCount, (k + 1) * m_agentCount)
+    QVector<double> m_confidences;  // empty or one per agent
+};
+
+#endif // CRITERIATABLE_H
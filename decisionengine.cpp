@@ -1,23 +1,48 @@
-#include "DecisionEngine.h"
+#include "decisionengine.h"
+#include "nativefusion.h"
+#include "fusionexecutor.h"
+#include "fusionpipeline.h"
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QDebug>
 #include <QFileInfo>
 #include <QDir>
+#include <QStandardPaths>
 #include <QFile>
 #include <QDateTime>
 #include <QTimer>
+#include <QThread>
 #include <algorithm>
 #include <cmath>
+#include <limits>
 
 
 DecisionEngine::DecisionEngine(QObject *parent)
     : QObject(parent),
     m_fusedValue(0.0),
-    m_python(new QProcess(this)),
+    m_executor(new FusionExecutor),
+    m_executorThread(new QThread(this)),
+    m_workerPoolSize(qBound(2, QThread::idealThreadCount(), 8)),
+    m_pythonProgram("python"),
+    m_activeRequestId(0),
+    m_inputGeneration(0),
+    m_nativeFusionEnabled(true),
+    m_binaryFramingEnabled(true),
+    m_sharedMemoryEnabled(true),
     m_scriptBasePath("C:/Users/Karabey/Documents/DSSS-2025/scripts/"),
     m_isComparing(false),
+    m_comparisonModel(new ComparisonResultModel(this)),
+    m_batchId(0),
+    m_nextBatchId(1),
+    m_batchProgressCurrent(0),
+    m_batchProgressTotal(0),
+    m_batchStartTime(0),
+    m_nextCriteriaRunId(1),
+    m_resultCacheEnabled(true),
+    m_inputDigestGeneration(0),
+    m_scriptTimeout(60000),
+    m_livePushPending(false),
     m_meanValue(0.0),
     m_stdDevValue(0.0),
     m_bestAlgorithm(""),
@@ -27,46 +52,48 @@ DecisionEngine::DecisionEngine(QObject *parent)
     m_historyManager(new HistoryManager(this)),
     m_currentSingleScript("")
 {
-    connect(m_python, &QProcess::finished,
-            this, &DecisionEngine::onPythonFinished);
+    m_executionTimer.start();
 
-    connect(m_python, &QProcess::readyReadStandardOutput, this, [this]() {
-        m_pythonOutput.append(m_python->readAllStandardOutput());
-        qDebug() << "Python partial STDOUT:" << m_pythonOutput;
-    });
+    // Enough workers to run a full comparison side by side; they start lazily
+    m_executor->setPoolSize(m_workerPoolSize);
+    m_executor->setPythonProgram(m_pythonProgram);
+    m_executor->setWorkerScript(m_scriptBasePath + "gdss_worker.py");
 
-    connect(m_python, &QProcess::readyReadStandardError, this, [this]() {
-        QByteArray error = m_python->readAllStandardError();
-        if (!error.isEmpty()) {
-            qDebug() << "Python STDERR:" << error;
-            emit pythonError(QString("Python error: %1").arg(QString(error)));
-        }
-    });
+    // Trained models persist next to the history files (see scripts/model_cache.py)
+    QProcessEnvironment environment = QProcessEnvironment::systemEnvironment();
+    QString documentsPath = QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation);
+    environment.insert("GDSS_MODEL_CACHE", QDir(documentsPath).filePath("GDSS/model_cache"));
+    m_executor->setProcessEnvironment(environment);
 
-    connect(m_python, &QProcess::errorOccurred, this, [this](QProcess::ProcessError error) {
-        QString errorMsg;
-        switch (error) {
-        case QProcess::FailedToStart:
-            errorMsg = "Python failed to start. Make sure Python is installed and the script exists.";
-            break;
-        case QProcess::Crashed:
-            errorMsg = "Python script crashed.";
-            break;
-        case QProcess::Timedout:
-            errorMsg = "Python script timed out.";
-            break;
-        case QProcess::WriteError:
-            errorMsg = "Error writing to Python process.";
-            break;
-        case QProcess::ReadError:
-            errorMsg = "Error reading from Python process.";
-            break;
-        default:
-            errorMsg = "Unknown Python process error.";
-        }
-        emit pythonError(errorMsg);
+    // From here on the executor is only reached through its thread's event loop
+    m_executorThread->setObjectName("FusionExecutor");
+    m_executor->moveToThread(m_executorThread);
+
+    connect(m_executor, &FusionExecutor::requestStarted,
+            this, &DecisionEngine::onWorkerStarted);
+
+    connect(m_executor, &FusionExecutor::requestFinished,
+            this, &DecisionEngine::onWorkerFinished);
+
+    connect(m_executor, &FusionExecutor::nativeFinished,
+            this, &DecisionEngine::onNativeFinished);
+
+    connect(m_executor, &FusionExecutor::nativeBatchFinished,
+            this, &DecisionEngine::onNativeBatchFinished);
+
+    connect(m_executor, &FusionExecutor::pipelineFinished,
+            this, &DecisionEngine::onPipelineFinished);
+
+    connect(m_executor, &FusionExecutor::criteriaFinished,
+            this, &DecisionEngine::onCriteriaFinished);
+
+    connect(m_executor, &FusionExecutor::workerError, this, [this](const QString &message) {
+        m_historyManager->logError(message, "Worker");
+        emit pythonError(message);
     });
 
+    m_executorThread->start();
+
     // Log startup
     m_historyManager->logInfo("DecisionEngine initialized", "System");
 }
@@ -74,18 +101,19 @@ DecisionEngine::DecisionEngine(QObject *parent)
 // Add destructor implementation
 DecisionEngine::~DecisionEngine()
 {
-    // Cleanup
-    if (m_python->state() == QProcess::Running) {
-        m_python->terminate();
-        m_python->waitForFinished(1000);
-    }
+    // Cleanup: stop the workers without reporting their requests as failures
+    m_executor->disconnect(this);
+    FusionExecutor *executor = m_executor;
+    QMetaObject::invokeMethod(m_executor, [executor]() { executor->shutdown(); },
+                              Qt::BlockingQueuedConnection);
+    m_executorThread->quit();
+    m_executorThread->wait();
+    delete m_executor;
 
     // Log shutdown
     if (m_historyManager) {
         m_historyManager->logInfo("DecisionEngine shutting down", "System");
     }
-
-    delete m_python;
 }
 
 void DecisionEngine::addAgentValue(double value)
@@ -96,16 +124,66 @@ void DecisionEngine::addAgent(double value, double confidence)
 {
     confidence = qBound(0.0, confidence, 1.0); // Clamp to [0, 1]
     m_agents.append(AgentData(value, confidence));
+    m_incremental.add(value, confidence);
+    scheduleLivePush();
     emit agentsChanged();
 }
 void DecisionEngine::updateAgentConfidence(int index, double confidence)
 {
     if (index >= 0 && index < m_agents.size()) {
-        confidence = qBound(0.0, confidence, 1.0);
-        m_agents[index].confidence = confidence;
+        updateAgent(index, m_agents[index].value, confidence);
+    }
+}
+
+void DecisionEngine::updateAgent(int index, double value, double confidence)
+{
+    if (index < 0 || index >= m_agents.size()) {
+        return;
+    }
+
+    confidence = qBound(0.0, confidence, 1.0);
+    AgentData &agent = m_agents[index];
+    if (agent.value == value && agent.confidence == confidence) {
+        return;
+    }
+
+    m_incremental.replace(agent.value, agent.confidence, value, confidence);
+    bool confidenceChanged = agent.confidence != confidence;
+    agent = AgentData(value, confidence);
+    scheduleLivePush();
+
+    if (confidenceChanged) {
         emit agentConfidenceChanged(index);
-        emit agentsChanged();
     }
+    emit agentsChanged();
+}
+
+void DecisionEngine::removeAgent(int index)
+{
+    if (index < 0 || index >= m_agents.size()) {
+        return;
+    }
+
+    const AgentData agent = m_agents.takeAt(index);
+    m_incremental.remove(agent.value, agent.confidence);
+    scheduleLivePush();
+    emit agentsChanged();
+}
+
+void DecisionEngine::setAgents(const QVariantList &values, const QVariantList &confidences)
+{
+    m_agents.clear();
+    m_incremental.clear();
+    m_agents.reserve(values.size());
+
+    for (int i = 0; i < values.size(); ++i) {
+        double confidence = i < confidences.size() ? qBound(0.0, confidences[i].toDouble(), 1.0) : 1.0;
+        m_agents.append(AgentData(values[i].toDouble(), confidence));
+        m_incremental.add(m_agents.last().value, confidence);
+    }
+
+    scheduleLivePush();
+    emit agentsChanged();
 }
 
 void DecisionEngine::setAgentConfidence(int index, double confidence)
@@ -136,40 +214,56 @@ QVariantList DecisionEngine::getAgentsWithConfidence() const
 void DecisionEngine::clearValues()
 {
     m_agents.clear();
+    m_incremental.clear();
     m_fusedValue = 0.0;
     emit fusedValueChanged();
     emit agentsChanged();
 }
 
-// ========== JSON CREATION HELPERS ==========
+// ========== LIVE FUSION ==========
 
-QJsonObject DecisionEngine::createJsonForPython(const QVariantList &values,
-                                                const QVariantList &confidences)
+void DecisionEngine::scheduleLivePush()
 {
-    QJsonArray valuesArray;
-    QJsonArray confidencesArray;
-
-    // Add values
-    for (const QVariant &v : values) {
-        valuesArray.append(v.toDouble());
+    // Bulk edits from QML (a file load appends agent by agent) coalesce
+    // into one result once control returns to the event loop
+    if (m_livePushPending || m_liveAlgorithm.isEmpty()) {
+        return;
     }
+    m_livePushPending = true;
+    QTimer::singleShot(0, this, &DecisionEngine::pushLiveResult);
+}
+
+void DecisionEngine::pushLiveResult()
+{
+    m_livePushPending = false;
 
-    // Add confidences if provided
-    bool hasConfidences = !confidences.isEmpty() && (confidences.size() == values.size());
-    for (const QVariant &c : confidences) {
-        confidencesArray.append(c.toDouble());
+    if (!m_nativeFusionEnabled || !IncrementalFusion::supports(m_liveAlgorithm) || m_agents.isEmpty()) {
+        return;
+    }
+    if (m_activeRequestId != 0 || m_isComparing) {
+        // The run in flight publishes its own result
+        return;
     }
 
-    QJsonObject root;
-    root["values"] = valuesArray;
-    root["agent_count"] = static_cast<int>(values.size());
+    if (m_incremental.needsRebuild()) {
+        m_incremental.clear();
+        for (const AgentData &agent : m_agents) {
+            m_incremental.add(agent.value, agent.confidence);
+        }
+    }
 
-    if (hasConfidences) {
-        root["confidences"] = confidencesArray;
+    NativeFusionResult result = m_incremental.result(m_liveAlgorithm);
+    if (!result.ok) {
+        qDebug() << "Live fusion skipped:" << result.errorMessage;
+        return;
     }
 
-    return root;
+    if (m_fusedValue != result.fused) {
+        m_fusedValue = result.fused;
+        emit fusedValueChanged();
+    }
 }
+
 void DecisionEngine::runFusionWithConfidence(const QVariantList &agentValues,
                                              const QVariantList &confidences)
 {
@@ -180,18 +274,7 @@ void DecisionEngine::runFusionWithConfidence(const QVariantList &agentValues,
                                              const QVariantList &confidences,
                                              const QString &scriptName)
 {
-    if (agentValues.isEmpty()) {
-        QString errorMsg = "No agent data!";
-        m_historyManager->logError(errorMsg, "Fusion");
-        emit pythonError(errorMsg);
-        return;
-    }
-
-    // Store confidences
-    m_currentAgentConfidences = confidences;
-
-    // Call regular runFusion
-    runFusion(agentValues, scriptName);
+    startFusion(agentValues, confidences, scriptName);
 }
 
 void DecisionEngine::runFusion(const QVariantList &agentValues)
@@ -200,6 +283,13 @@ void DecisionEngine::runFusion(const QVariantList &agentValues)
 }
 
 void DecisionEngine::runFusion(const QVariantList &agentValues, const QString &scriptName)
+{
+    // No confidences: none may be left over from an earlier run
+    startFusion(agentValues, QVariantList(), scriptName);
+}
+
+void DecisionEngine::startFusion(const QVariantList &agentValues, const QVariantList &confidences,
+                                 const QString &scriptName)
 {
     if (agentValues.isEmpty()) {
         QString errorMsg = "No agent data!";
@@ -216,12 +306,8 @@ void DecisionEngine::runFusion(const QVariantList &agentValues, const QString &s
         "Fusion"
         );
 
-    if (m_isComparing && !scriptName.isEmpty()) {
-        m_startTimes[scriptName] = QTime::currentTime();
-    }
-
-    // Check if a process is already running
-    if (m_python->state() == QProcess::Running) {
+    // Check if a script or comparison is already in flight
+    if (m_activeRequestId != 0 || m_isComparing) {
         QString errorMsg = "Python process is already running. Please wait.";
         m_historyManager->logError(errorMsg, "Fusion");
         emit pythonError(errorMsg);
@@ -230,153 +316,158 @@ void DecisionEngine::runFusion(const QVariantList &agentValues, const QString &s
 
     // Store values internally if needed
     m_agentValues = agentValues;
+    m_agentConfidences = confidences;
+    m_currentAgentConfidences = confidences;
+    m_currentSingleScript = scriptName;
+    m_inputGeneration++;
 
-    // Store script name for single fusion (if not comparing)
-    if (!m_isComparing) {
-        m_currentSingleScript = scriptName;
+    // Pipelines chain their stages on the executor's thread
+    if (FusionPipeline::isPipelineName(scriptName)) {
+        QString errorMsg;
+        m_activeRequestId = submitPipeline(scriptName, errorMsg);
+        if (m_activeRequestId == 0) {
+            m_historyManager->logError(errorMsg, "Fusion");
+            emit pythonError(errorMsg);
+        }
+        return;
     }
 
-    // Clear previous output
-    m_pythonOutput.clear();
-
-    QJsonArray arr;
-    for (const QVariant &v : agentValues)
-        arr.append(v.toDouble());
-
-    QJsonObject root;
-    root["values"] = arr;
-    root["agent_count"] = static_cast<int>(agentValues.size());
-
-    // Add confidences if available (FIXED: use m_agentConfidences)
-    if (!m_agentConfidences.isEmpty() &&
-        m_agentConfidences.size() == agentValues.size()) {
-        QJsonArray confidencesArr;
-        for (const QVariant &c : m_agentConfidences) {
-            confidencesArr.append(c.toDouble());
+    // Deterministic algorithms run in-process; everything else goes to Python
+    if (m_nativeFusionEnabled && NativeFusion::contains(scriptName)) {
+        // Large sets are unpacked and fused on the executor's thread
+        if (m_agentValues.size() >= EXECUTOR_NATIVE_MIN_AGENTS) {
+            m_activeRequestId = submitNative(scriptName);
+            return;
         }
-        root["confidences"] = confidencesArr;
+
+        QVariantMap stages;
+        NativeFusionResult result = runNative(scriptName, stages);
+        finishSingleFusion(scriptName, result.ok, result.fused, result.confidence,
+                           stages, result.errorMessage);
+        return;
     }
 
-    QByteArray inputData = QJsonDocument(root).toJson();
-    qDebug() << "Sending to Python:" << inputData;
+    // A repeat of an earlier run is answered without Python
+    QElapsedTimer stageTimer;
+    stageTimer.start();
+    QByteArray cacheKey = resultCacheKey(scriptName);
+    FusionResultCache::Entry cached;
+    if (lookupCachedResult(cacheKey, cached)) {
+        finishSingleFusion(scriptName, true, cached.fused, cached.confidence,
+                           cachedStages(stageTimer.nsecsElapsed()), QString());
+        return;
+    }
 
-    QString scriptPath;
-    QFileInfo scriptFile(scriptName);
+    // Clear previous output
+    m_pythonOutput.clear();
 
-    if (scriptFile.isAbsolute()) {
-        scriptPath = scriptName;
-    } else {
-        scriptPath = m_scriptBasePath + scriptName;
+    m_activeRequestId = submitScript(scriptName);
+    if (m_activeRequestId != 0 && !cacheKey.isEmpty()) {
+        m_requestCacheKeys.insert(m_activeRequestId, cacheKey);
     }
+}
+
+quint64 DecisionEngine::submitScript(const QString &scriptName)
+{
+    QString scriptPath = resolveScriptPath(scriptName);
 
     // Check if script exists
     if (!QFile::exists(scriptPath)) {
         QString errorMsg = QString("Script file not found: %1").arg(scriptPath);
         m_historyManager->logError(errorMsg, "Fusion");
         emit pythonError(errorMsg);
-        return;
+        return 0;
     }
 
-    qDebug() << "Running Python script:" << scriptPath;
-
-    // Set up the Python process
-    m_python->setProgram("python");
-    QStringList arguments;
-    arguments << scriptPath;
-
-    qDebug() << "Python arguments:" << arguments;
-    m_python->setArguments(arguments);
+    // The executor encodes the input and hands it to a worker; the reply
+    // arrives in onWorkerFinished
+    FusionExecutor::Input input;
+    input.values = m_agentValues;
+    input.confidences = m_agentConfidences;
+    input.generation = m_inputGeneration;
+
+    quint64 requestId = m_executor->reserveRequestId();
+    FusionExecutor *executor = m_executor;
+    QMetaObject::invokeMethod(m_executor, [executor, requestId, scriptPath, input]() {
+        executor->runScript(requestId, scriptPath, input);
+    }, Qt::QueuedConnection);
+
+    RequestTiming timing;
+    timing.submitted = m_executionTimer.nsecsElapsed();
+    m_requestTimings.insert(requestId, timing);
+    return requestId;
+}
 
-    // Start the process
-    m_python->start();
+quint64 DecisionEngine::submitNative(const QString &scriptName)
+{
+    FusionExecutor::Input input;
+    input.values = m_agentValues;
+    input.confidences = m_agentConfidences;
+    input.generation = m_inputGeneration;
+
+    // Answered through onNativeFinished
+    quint64 requestId = m_executor->reserveRequestId();
+    FusionExecutor *executor = m_executor;
+    QMetaObject::invokeMethod(m_executor, [executor, requestId, scriptName, input]() {
+        executor->runNative(requestId, scriptName, input);
+    }, Qt::QueuedConnection);
+    return requestId;
+}
 
-    // Check if process started successfully
-    if (!m_python->waitForStarted(5000)) {
-        QString errorMsg = "Failed to start Python process. Make sure Python is installed.";
-        m_historyManager->logError(errorMsg, "Fusion");
-        emit pythonError(errorMsg);
-        return;
+bool DecisionEngine::loadPipeline(const QString &pipelineName, FusionPipeline &pipeline,
+                                  QString &errorMsg) const
+{
+    if (!FusionPipeline::read(resolveScriptPath(pipelineName), pipeline, &errorMsg)) {
+        return false;
     }
 
-    // Send JSON to python stdin
-    qint64 bytesWritten = m_python->write(inputData);
-    if (bytesWritten == -1) {
-        QString errorMsg = "Failed to write data to Python process.";
-        m_historyManager->logError(errorMsg, "Fusion");
-        m_python->terminate();
-        emit pythonError(errorMsg);
-        return;
+    // Fusing stages take the native path under the same rule as plain scripts
+    for (FusionPipeline::Stage &stage : pipeline.stages) {
+        if (stage.kind == FusionPipeline::Stage::Op) {
+            continue;
+        }
+        stage.path = resolveScriptPath(stage.name);
+        stage.native = stage.kind == FusionPipeline::Stage::Fuse
+                       && m_nativeFusionEnabled && NativeFusion::contains(stage.name);
+        if (!stage.native && !QFile::exists(stage.path)) {
+            errorMsg = QString("Script file not found: %1 (stage of %2)").arg(stage.path, pipelineName);
+            return false;
+        }
     }
-
-    qDebug() << "Written" << bytesWritten << "bytes to Python stdin";
-    m_python->closeWriteChannel();
+    return true;
 }
 
-void DecisionEngine::sendToPython(const QJsonObject &jsonData, const QString &scriptName)
+quint64 DecisionEngine::submitPipeline(const QString &pipelineName, QString &errorMsg)
 {
-    if (m_isComparing && !scriptName.isEmpty()) {
-        m_startTimes[scriptName] = QTime::currentTime();
-    }
-
-    // Check if a process is already running
-    if (m_python->state() == QProcess::Running) {
-        emit pythonError("Python process is already running. Please wait.");
-        return;
+    FusionPipeline pipeline;
+    if (!loadPipeline(pipelineName, pipeline, errorMsg)) {
+        return 0;
     }
 
-    // Clear previous output
-    m_pythonOutput.clear();
-
-    QByteArray inputData = QJsonDocument(jsonData).toJson();
-    qDebug() << "Sending to Python:" << inputData;
+    FusionExecutor::Input input;
+    input.values = m_agentValues;
+    input.confidences = m_agentConfidences;
+    input.generation = m_inputGeneration;
+
+    // Answered through onPipelineFinished
+    quint64 requestId = m_executor->reserveRequestId();
+    FusionExecutor *executor = m_executor;
+    QMetaObject::invokeMethod(m_executor, [executor, requestId, pipeline, input]() {
+        executor->runPipeline(requestId, pipeline, input);
+    }, Qt::QueuedConnection);
+    return requestId;
+}
 
-    QString scriptPath;
+QString DecisionEngine::resolveScriptPath(const QString &scriptName) const
+{
     QFileInfo scriptFile(scriptName);
 
     if (scriptFile.isAbsolute()) {
-        scriptPath = scriptName;
-    } else {
-        scriptPath = m_scriptBasePath + scriptName;
-    }
-
-    // Check if script exists
-    if (!QFile::exists(scriptPath)) {
-        emit pythonError(QString("Script file not found: %1").arg(scriptPath));
-        return;
-    }
-
-    qDebug() << "Running Python script:" << scriptPath;
-
-    // Set up the Python process
-    m_python->setProgram("python");
-    QStringList arguments;
-    arguments << scriptPath;
-
-    qDebug() << "Python arguments:" << arguments;
-    m_python->setArguments(arguments);
-
-    // Start the process
-    m_python->start();
-
-    // Check if process started successfully
-    if (!m_python->waitForStarted(5000)) {
-        emit pythonError("Failed to start Python process. Make sure Python is installed.");
-        return;
+        return scriptName;
     }
-
-    // Send JSON to python stdin
-    qint64 bytesWritten = m_python->write(inputData);
-    if (bytesWritten == -1) {
-        emit pythonError("Failed to write data to Python process.");
-        m_python->terminate();
-        return;
-    }
-
-    qDebug() << "Written" << bytesWritten << "bytes to Python stdin";
-    m_python->closeWriteChannel();
+    return m_scriptBasePath + scriptName;
 }
 
-
 void DecisionEngine::runComparison(const QVariantList &agentValues,
                                    const QStringList &scripts)
 {
@@ -394,7 +485,7 @@ void DecisionEngine::runComparisonWithConfidence(const QVariantList &agentValues
         return;
     }
 
-    if (m_python->state() == QProcess::Running) {
+    if (m_activeRequestId != 0 || m_isComparing) {
         QString errorMsg = "Python process already running.";
         m_historyManager->logError(errorMsg, "Comparison");
         emit pythonError(errorMsg);
@@ -407,10 +498,10 @@ void DecisionEngine::runComparisonWithConfidence(const QVariantList &agentValues
 
     m_agentValues = agentValues;
     m_agentConfidences = confidences;
+    m_inputGeneration++;
 
     m_pendingScripts = scripts;
-    m_comparisonResults.clear();
-    m_executionTimes.clear();
+    m_comparisonModel->clear();
 
     // Set progress tracking
     m_comparisonProgressCurrent = 0;
@@ -420,366 +511,935 @@ void DecisionEngine::runComparisonWithConfidence(const QVariantList &agentValues
     emit comparisonCountChanged();
     emit comparisonStatsChanged();
 
-    m_currentScript = m_pendingScripts.takeFirst();
-
     // Log comparison start
     m_historyManager->logInfo(
-        QString("Starting comparison of %1 algorithms with %2 agents")
+        QString("Starting comparison of %1 algorithms with %2 agents on up to %3 workers")
             .arg(scripts.size())
-            .arg(agentValues.size()),
+            .arg(agentValues.size())
+            .arg(qMin(static_cast<int>(scripts.size()), m_workerPoolSize)),
         "Comparison"
         );
 
-    runFusion(agentValues, m_currentScript);
+    startComparison();
 }
 
-void DecisionEngine::onPythonFinished(int exitCode, QProcess::ExitStatus status)
+void DecisionEngine::startComparison()
 {
-    qDebug() << "Python process finished. Exit code:" << exitCode << "Status:" << status;
+    // Submit everything at once; the pool runs up to workerPoolSize scripts in
+    // parallel and the executor serializes the shared input once per format
+    while (!m_pendingScripts.isEmpty()) {
+        QString scriptName = m_pendingScripts.takeFirst();
+
+        if (FusionPipeline::isPipelineName(scriptName)) {
+            QString errorMsg;
+            quint64 requestId = submitPipeline(scriptName, errorMsg);
+            if (requestId == 0) {
+                recordComparisonResult(scriptName, false, 0.0, 1.0, QVariantMap(), errorMsg);
+                continue;
+            }
+            m_comparisonRequests.insert(requestId, scriptName);
+            continue;
+        }
+
+        if (m_nativeFusionEnabled && NativeFusion::contains(scriptName)) {
+            if (m_agentValues.size() >= EXECUTOR_NATIVE_MIN_AGENTS) {
+                m_comparisonRequests.insert(submitNative(scriptName), scriptName);
+                continue;
+            }
+
+            QVariantMap stages;
+            NativeFusionResult result = runNative(scriptName, stages);
+            recordComparisonResult(scriptName, result.ok, result.fused, result.confidence,
+                                   stages, result.errorMessage);
+            continue;
+        }
 
-    // Calculate execution time
-    qint64 executionTime = 100; // Default
-    QString currentScriptForHistory = m_currentScript.isEmpty() ? m_currentSingleScript : m_currentScript;
+        QElapsedTimer stageTimer;
+        stageTimer.start();
+        QByteArray cacheKey = resultCacheKey(scriptName);
+        FusionResultCache::Entry cached;
+        if (lookupCachedResult(cacheKey, cached)) {
+            recordComparisonResult(scriptName, true, cached.fused, cached.confidence,
+                                   cachedStages(stageTimer.nsecsElapsed()), QString());
+            continue;
+        }
 
-    if (m_startTimes.contains(currentScriptForHistory)) {
-        QTime startTime = m_startTimes[currentScriptForHistory];
-        QTime endTime = QTime::currentTime();
-        executionTime = startTime.msecsTo(endTime);
-        m_startTimes.remove(currentScriptForHistory);
+        quint64 requestId = submitScript(scriptName);
+        if (requestId == 0) {
+            recordComparisonResult(scriptName, false, 0.0, 1.0, QVariantMap(),
+                                   QString("Script file not found: %1").arg(resolveScriptPath(scriptName)));
+            continue;
+        }
+        m_comparisonRequests.insert(requestId, scriptName);
+        if (!cacheKey.isEmpty()) {
+            m_requestCacheKeys.insert(requestId, cacheKey);
+        }
     }
 
-    if (status != QProcess::NormalExit) {
-        QString errorMsg = "Python script crashed.";
+    if (m_comparisonRequests.isEmpty() && m_isComparing) {
+        finishComparison();
+    }
+}
 
-        if (m_isComparing) {
-            // Handle error during comparison
-            if (!m_currentScript.isEmpty()) {
-                m_executionTimes[m_currentScript] = executionTime;
-                m_comparisonResults.insert(m_currentScript, QVariant::fromValue(0.0));
+void DecisionEngine::onWorkerStarted(quint64 requestId)
+{
+    // The deadline runs from dispatch, so queueing behind other scripts is not charged
+    QString scriptName = requestScriptName(requestId);
+    int timeout = scriptTimeoutFor(scriptName);
+    if (timeout > 0 && m_batchRequests.contains(requestId)) {
+        // A batch chunk runs the script once per case, so each case gets the full deadline
+        const qint64 cases = m_batchRequests.value(requestId).second;
+        timeout = static_cast<int>(qMin<qint64>(timeout * cases, std::numeric_limits<int>::max()));
+    }
+    if (!scriptName.isEmpty() && timeout > 0) {
+        QTimer::singleShot(timeout, this, [this, requestId, timeout]() {
+            onRequestDeadline(requestId, timeout);
+        });
+    }
+}
 
-                // Save error to history
-                m_historyManager->saveErrorResult(
-                    m_agentValues,
-                    m_agentConfidences,  // FIXED: use m_agentConfidences
-                    m_currentScript,
-                    errorMsg,
-                    executionTime
-                    );
+void DecisionEngine::onWorkerFinished(quint64 requestId, int exitCode,
+                                      const QByteArray &output, const QString &errorOutput,
+                                      const QVariantMap &timings)
+{
+    const qint64 received = m_executionTimer.nsecsElapsed();
+    bool timedOut = m_timedOutRequests.remove(requestId);
 
-                // Update progress
-                m_comparisonProgressCurrent = m_comparisonResults.size();
-                emit comparisonProgressChanged();
+    if (m_batchRequests.contains(requestId)) {
+        finishBatchChunk(requestId, exitCode, output, errorOutput);
+        return;
+    }
 
-                // Continue with next script or finish
-                if (!m_pendingScripts.isEmpty()) {
-                    m_currentScript = m_pendingScripts.takeFirst();
-                    runFusion(m_agentValues, m_currentScript);
-                } else {
-                    finishComparison();
-                }
-            }
+    QString scriptName = requestScriptName(requestId);
+    if (scriptName.isEmpty()) {
+        qDebug() << "Ignoring reply for stale request" << requestId;
+        return;
+    }
 
-            m_isComparing = false;
-            emit isComparingChanged();
-            emit pythonError(errorMsg);
-        } else {
-            // Save single fusion error
-            m_historyManager->saveErrorResult(
-                m_agentValues,
-                m_agentConfidences,  // FIXED: use m_agentConfidences
-                m_currentSingleScript,
-                errorMsg,
-                executionTime
-                );
+    qDebug() << "Python script" << scriptName << "finished. Request:" << requestId << "Exit code:" << exitCode;
 
-            emit pythonError(errorMsg);
-        }
+    double fusedValue = 0.0;
+    double resultConfidence = 1.0; // Default confidence
+    QString errorMsg;
+    qint64 computeNs = 0;
+    QElapsedTimer parseTimer;
+    parseTimer.start();
+    bool ok = parseScriptOutput(exitCode, output, errorOutput, fusedValue, resultConfidence, errorMsg,
+                                &computeNs);
+    QVariantMap stages = scriptStages(m_requestTimings.take(requestId), timings, received,
+                                      parseTimer.nsecsElapsed(), computeNs);
+
+    QByteArray cacheKey = m_requestCacheKeys.take(requestId);
+    if (ok) {
+        storeCachedResult(cacheKey, fusedValue, resultConfidence);
+    }
 
-        m_historyManager->logError(errorMsg, "Fusion");
+    routeResult(requestId, ok, fusedValue, resultConfidence, stages, errorMsg, timedOut);
+}
+
+void DecisionEngine::onNativeFinished(quint64 requestId, bool ok, double fusedValue,
+                                      double resultConfidence, const QString &errorMsg,
+                                      const QVariantMap &stages)
+{
+    if (requestScriptName(requestId).isEmpty()) {
+        qDebug() << "Ignoring native result for stale request" << requestId;
         return;
     }
+    routeResult(requestId, ok, fusedValue, resultConfidence, stages, errorMsg, false);
+}
 
-    // Read any remaining output
-    m_pythonOutput.append(m_python->readAllStandardOutput());
+void DecisionEngine::onPipelineFinished(quint64 requestId, bool ok, double fusedValue,
+                                        double resultConfidence, const QString &errorMsg,
+                                        const QVariantMap &stages)
+{
+    bool timedOut = m_timedOutRequests.remove(requestId);
 
-    // Check for Python errors
-    if (exitCode != 0) {
-        QString error = QString::fromUtf8(m_python->readAllStandardError());
-        if (error.isEmpty()) {
-            error = "Unknown error";
+    if (m_batchRequests.contains(requestId)) {
+        recordBatchResult(m_batchRequests.take(requestId).first, ok, fusedValue,
+                          resultConfidence, errorMsg);
+        if (m_batchRequests.isEmpty()) {
+            finishBatch();
         }
+        return;
+    }
 
-        QString errorMsg = QString("Python script exited with code %1. Error: %2").arg(exitCode).arg(error);
-
-        if (m_isComparing && !m_currentScript.isEmpty()) {
-            // Handle error but continue comparison
-            m_executionTimes[m_currentScript] = executionTime;
-            m_comparisonResults.insert(m_currentScript, QVariant::fromValue(0.0));
+    if (requestScriptName(requestId).isEmpty()) {
+        qDebug() << "Ignoring pipeline result for stale request" << requestId;
+        return;
+    }
+    routeResult(requestId, ok, fusedValue, resultConfidence, stages, errorMsg, timedOut);
+}
 
-            // Save error to history
-            m_historyManager->saveErrorResult(
-                m_agentValues,
-                m_agentConfidences,  // FIXED: use m_agentConfidences
-                m_currentScript,
-                errorMsg,
-                executionTime
-                );
+void DecisionEngine::routeResult(quint64 requestId, bool ok, double fusedValue,
+                                 double resultConfidence, const QVariantMap &stages,
+                                 const QString &errorMsg, bool timedOut)
+{
+    if (m_comparisonRequests.contains(requestId)) {
+        QString scriptName = m_comparisonRequests.take(requestId);
+        recordComparisonResult(scriptName, ok, fusedValue, resultConfidence, stages,
+                               errorMsg, timedOut);
+        return;
+    }
 
-            // Update progress
-            m_comparisonProgressCurrent = m_comparisonResults.size();
-            emit comparisonProgressChanged();
+    m_activeRequestId = 0;
+    finishSingleFusion(m_currentSingleScript, ok, fusedValue, resultConfidence, stages,
+                       errorMsg, timedOut);
+}
 
-            // Continue with next script or finish
-            if (!m_pendingScripts.isEmpty()) {
-                m_currentScript = m_pendingScripts.takeFirst();
-                runFusion(m_agentValues, m_currentScript);
-            } else {
-                finishComparison();
-            }
-        } else {
-            // Save single fusion error
-            m_historyManager->saveErrorResult(
-                m_agentValues,
-                m_agentConfidences,  // FIXED: use m_agentConfidences
-                m_currentSingleScript,
-                errorMsg,
-                executionTime
-                );
+// ========== STAGE TIMINGS ==========
 
-            emit pythonError(errorMsg);
+QVariantMap DecisionEngine::scriptStages(const RequestTiming &timing, const QVariantMap &timings,
+                                         qint64 received, qint64 parseNs, qint64 computeNs) const
+{
+    // Submission to reply on our clock; the executor, the pool and the worker split it up
+    const qint64 roundTrip = received - timing.submitted;
+    const qint64 queue = timings.value("queue_ns").toLongLong();
+    const qint64 load = timings.value("load_ns").toLongLong();
+    const qint64 call = timings.value("call_ns").toLongLong();
+    const qint64 run = timings.value("run_ns").toLongLong();
+
+    // A script's own figure leaves out what it does around the algorithm
+    const qint64 compute = computeNs > 0 && (call == 0 || computeNs <= call) ? computeNs : call;
+
+    QVariantMap stages;
+    const qint64 encode = timings.value("encode_ns").toLongLong();
+    stages["encode"] = encode;
+    qint64 accounted = encode;
+    auto addStage = [&stages, &accounted](const char *stage, qint64 ns) {
+        if (ns > 0) {
+            stages[stage] = ns;
+            accounted += ns;
         }
+    };
+    addStage("queue", queue);
+    addStage("start", timings.value("start_ns").toLongLong());
+    addStage("write", timings.value("write_ns").toLongLong());
+    addStage("read", timings.value("read_ns").toLongLong());
+    addStage("load", load);
+    addStage("compute", compute);
+    addStage("worker", run - load - compute);  // Frame decoding, runpy, JSON in the worker
+
+    // What is left is the thread hops, pipes, scheduling and encoding the reply
+    stages["transfer"] = qMax<qint64>(0, roundTrip - accounted);
+    stages["parse"] = parseNs;
+
+    // Waiting for a free worker is shown, but not charged to the script
+    stages["total"] = roundTrip - queue + parseNs;
+    return stages;
+}
 
-        m_historyManager->logError(errorMsg, "Fusion");
-        return;
+QVariantMap DecisionEngine::cachedStages(qint64 lookupNs)
+{
+    QVariantMap stages;
+    stages["cache"] = lookupNs;
+    stages["total"] = lookupNs;
+    return stages;
+}
+
+double DecisionEngine::stagesToMs(const QVariantMap &stages)
+{
+    return stages.value("total").toLongLong() / 1e6;
+}
+
+QVariantList DecisionEngine::orderedStages(const QVariantMap &stages)
+{
+    // Pipeline order, for display
+    static const QStringList order = { "encode", "cache", "queue", "start", "write", "read",
+                                       "load", "compute", "worker", "transfer", "parse" };
+    QVariantList list;
+    for (const QString &stage : order) {
+        if (stages.contains(stage)) {
+            QVariantMap item;
+            item["stage"] = stage;
+            item["ms"] = stages.value(stage).toLongLong() / 1e6;
+            list.append(item);
+        }
     }
+    return list;
+}
 
-    // Check for empty output
-    if (m_pythonOutput.isEmpty()) {
-        QString errorMsg = "Python script returned no output.";
+QString DecisionEngine::requestScriptName(quint64 requestId) const
+{
+    // Empty once the request has been answered or abandoned
+    if (m_comparisonRequests.contains(requestId)) {
+        return m_comparisonRequests.value(requestId);
+    }
+    if (requestId != 0 && requestId == m_activeRequestId) {
+        return m_currentSingleScript;
+    }
+    if (m_batchRequests.contains(requestId)) {
+        return m_batchScript;
+    }
+    if (m_criteriaRequests.contains(requestId)) {
+        return m_criteriaRequests.value(requestId).scriptName;
+    }
+    return QString();
+}
 
-        if (m_isComparing && !m_currentScript.isEmpty()) {
-            // Handle empty output but continue comparison
-            m_executionTimes[m_currentScript] = executionTime;
-            m_comparisonResults.insert(m_currentScript, QVariant::fromValue(0.0));
+void DecisionEngine::onRequestDeadline(quint64 requestId, int timeout)
+{
+    QString scriptName = requestScriptName(requestId);
+    if (scriptName.isEmpty()) {
+        return; // Finished in time
+    }
 
-            // Save error to history
-            m_historyManager->saveErrorResult(
-                m_agentValues,
-                m_agentConfidences,  // FIXED: use m_agentConfidences
-                m_currentScript,
-                errorMsg,
-                executionTime
-                );
+    m_historyManager->logWarning(
+        QString("%1 exceeded its %2ms deadline; stopping it").arg(scriptName).arg(timeout),
+        "Fusion"
+        );
 
-            // Update progress
-            m_comparisonProgressCurrent = m_comparisonResults.size();
-            emit comparisonProgressChanged();
+    // The kill comes back through onWorkerFinished like any other reply; if
+    // the script beat it, the flag only matters for a failed result
+    m_timedOutRequests.insert(requestId);
+    QString reason = QString("Timed out after %1 ms").arg(timeout);
+    FusionExecutor *executor = m_executor;
+    QMetaObject::invokeMethod(m_executor, [executor, requestId, reason]() {
+        executor->cancel(requestId, reason);
+    }, Qt::QueuedConnection);
+}
 
-            // Continue with next script or finish
-            if (!m_pendingScripts.isEmpty()) {
-                m_currentScript = m_pendingScripts.takeFirst();
-                runFusion(m_agentValues, m_currentScript);
-            } else {
-                finishComparison();
-            }
-        } else {
-            // Save single fusion error
-            m_historyManager->saveErrorResult(
-                m_agentValues,
-                m_agentConfidences,  // FIXED: use m_agentConfidences
-                m_currentSingleScript,
-                errorMsg,
-                executionTime
-                );
+void DecisionEngine::cancelRequest(quint64 requestId)
+{
+    // Forgotten first, so whatever the executor reports is ignored as stale
+    forgetRequest(requestId);
+    FusionExecutor *executor = m_executor;
+    QMetaObject::invokeMethod(m_executor, [executor, requestId]() {
+        executor->cancel(requestId, "Cancelled");
+    }, Qt::QueuedConnection);
+}
 
-            emit pythonError(errorMsg);
-        }
+void DecisionEngine::forgetRequest(quint64 requestId)
+{
+    m_requestTimings.remove(requestId);
+    m_requestCacheKeys.remove(requestId);
+    m_timedOutRequests.remove(requestId);
+}
 
-        m_historyManager->logError(errorMsg, "Fusion");
+void DecisionEngine::cancelFusion()
+{
+    if (m_activeRequestId == 0) {
         return;
     }
 
-    qDebug() << "Python full output:" << m_pythonOutput;
-
-    // Parse JSON response
-    QJsonParseError parseError;
-    QJsonDocument doc = QJsonDocument::fromJson(m_pythonOutput, &parseError);
+    // Forget the request first so the failure the pool reports is ignored as stale
+    quint64 requestId = m_activeRequestId;
+    m_activeRequestId = 0;
+    cancelRequest(requestId);
 
-    if (parseError.error != QJsonParseError::NoError) {
-        QString errorMsg = QString("Failed to parse JSON from Python: %1").arg(parseError.errorString());
+    m_historyManager->logInfo(QString("Fusion with %1 cancelled").arg(m_currentSingleScript), "Fusion");
+    emit fusionCancelled();
+}
 
-        if (m_isComparing && !m_currentScript.isEmpty()) {
-            // Handle JSON parse error but continue comparison
-            m_executionTimes[m_currentScript] = executionTime;
-            m_comparisonResults.insert(m_currentScript, QVariant::fromValue(0.0));
+void DecisionEngine::cancelComparison()
+{
+    if (!m_isComparing) {
+        return;
+    }
 
-            // Save error to history
-            m_historyManager->saveErrorResult(
-                m_agentValues,
-                m_agentConfidences,  // FIXED: use m_agentConfidences
-                m_currentScript,
-                errorMsg,
-                executionTime
-                );
+    const QList<quint64> requestIds = m_comparisonRequests.keys();
+    QStringList abandoned = m_comparisonRequests.values();
+    abandoned += m_pendingScripts;
+    m_comparisonRequests.clear();
+    m_pendingScripts.clear();
 
-            // Update progress
-            m_comparisonProgressCurrent = m_comparisonResults.size();
-            emit comparisonProgressChanged();
+    for (quint64 requestId : requestIds) {
+        cancelRequest(requestId);
+    }
 
-            // Continue with next script or finish
-            if (!m_pendingScripts.isEmpty()) {
-                m_currentScript = m_pendingScripts.takeFirst();
-                runFusion(m_agentValues, m_currentScript);
-            } else {
-                finishComparison();
-            }
+    m_historyManager->logInfo(
+        QString("Comparison cancelled with %1 of %2 algorithms finished (abandoned: %3)")
+            .arg(m_comparisonModel->rowCount())
+            .arg(m_comparisonProgressTotal)
+            .arg(abandoned.join(", ")),
+        "Comparison"
+        );
+
+    finishComparison();
+    emit comparisonCancelled();
+}
+
+void DecisionEngine::finishSingleFusion(const QString &scriptName, bool ok,
+                                        double fusedValue, double resultConfidence,
+                                        const QVariantMap &stages, const QString &errorMsg,
+                                        bool timedOut)
+{
+    double executionTime = stagesToMs(stages);
+
+    if (!ok) {
+        // Save single fusion error
+        if (timedOut) {
+            m_historyManager->saveTimeoutResult(m_agentValues, m_agentConfidences,
+                                                scriptName, errorMsg, executionTime, stages);
         } else {
-            // Save single fusion error
             m_historyManager->saveErrorResult(
                 m_agentValues,
-                m_agentConfidences,  // FIXED: use m_agentConfidences
-                m_currentSingleScript,
+                m_agentConfidences,
+                scriptName,
                 errorMsg,
-                executionTime
+                executionTime,
+                stages
                 );
-
-            emit pythonError(errorMsg);
         }
 
         m_historyManager->logError(errorMsg, "Fusion");
+        emit pythonError(errorMsg);
         return;
     }
 
-    if (!doc.isObject()) {
-        QString errorMsg = "Python did not return a valid JSON object.";
-
-        if (m_isComparing && !m_currentScript.isEmpty()) {
-            // Handle invalid JSON but continue comparison
-            m_executionTimes[m_currentScript] = executionTime;
-            m_comparisonResults.insert(m_currentScript, QVariant::fromValue(0.0));
-
-            // Save error to history
-            m_historyManager->saveErrorResult(
-                m_agentValues,
-                m_agentConfidences,  // FIXED: use m_agentConfidences
-                m_currentScript,
-                errorMsg,
-                executionTime
-                );
+    // Single fusion (not comparison mode)
+    m_fusedValue = fusedValue;
+    emit fusedValueChanged();
 
-            // Update progress
-            m_comparisonProgressCurrent = m_comparisonResults.size();
-            emit comparisonProgressChanged();
+    // Save to history
+    m_historyManager->saveFusionResult(
+        m_agentValues,
+        m_agentConfidences,
+        scriptName,
+        fusedValue,
+        resultConfidence,
+        executionTime,
+        "Single fusion",
+        stages
+        );
 
-            // Continue with next script or finish
-            if (!m_pendingScripts.isEmpty()) {
-                m_currentScript = m_pendingScripts.takeFirst();
-                runFusion(m_agentValues, m_currentScript);
-            } else {
-                finishComparison();
-            }
-        } else {
-            // Save single fusion error
-            m_historyManager->saveErrorResult(
-                m_agentValues,
-                m_agentConfidences,  // FIXED: use m_agentConfidences
-                m_currentSingleScript,
-                errorMsg,
-                executionTime
-                );
+    // Log success
+    m_historyManager->logInfo(
+        QString("Fusion completed in %1ms with result: %2 (confidence: %3)")
+            .arg(executionTime, 0, 'f', 3)
+            .arg(fusedValue, 0, 'f', 4)
+            .arg(resultConfidence, 0, 'f', 2),
+        "Fusion"
+        );
+}
 
-            emit pythonError(errorMsg);
-        }
+NativeFusionResult DecisionEngine::runNative(const QString &scriptName, QVariantMap &stages) const
+{
+    return FusionExecutor::fuseNative(scriptName, m_agentValues, m_agentConfidences, stages);
+}
 
-        m_historyManager->logError(errorMsg, "Fusion");
-        return;
+bool DecisionEngine::parseScriptOutput(int exitCode, const QByteArray &output,
+                                       const QString &errorOutput, double &fusedValue,
+                                       double &resultConfidence, QString &errorMsg,
+                                       qint64 *computeNs)
+{
+    // The worker itself failed (crash, start or pipe error)
+    if (exitCode < 0) {
+        errorMsg = errorOutput;
+        return false;
     }
 
-    QJsonObject result = doc.object();
-
-    double fusedValue = 0.0;
-    double resultConfidence = 1.0; // Default confidence
+    if (!errorOutput.isEmpty()) {
+        qDebug() << "Python STDERR:" << errorOutput;
+        emit pythonError(QString("Python error: %1").arg(errorOutput));
+    }
 
-    if (result.contains("fused")) {
-        QJsonValue fusedJson = result["fused"];
-        if (fusedJson.isDouble()) {
-            fusedValue = fusedJson.toDouble();
+    // Check for Python errors
+    if (exitCode != 0) {
+        QString error = errorOutput;
+        if (error.isEmpty()) {
+            error = "Unknown error";
         }
+        errorMsg = QString("Python script exited with code %1. Error: %2").arg(exitCode).arg(error);
+        return false;
     }
 
-    // Check if Python returned confidence
-    if (result.contains("confidence")) {
-        QJsonValue confidenceJson = result["confidence"];
-        if (confidenceJson.isDouble()) {
-            resultConfidence = confidenceJson.toDouble();
-        }
+    // Check for empty output
+    if (output.isEmpty()) {
+        errorMsg = "Python script returned no output.";
+        return false;
     }
 
-    // Handle successful completion
-    if (m_isComparing && !m_currentScript.isEmpty()) {
-        // Store actual execution time
-        m_executionTimes[m_currentScript] = executionTime;
-        qDebug() << "Script" << m_currentScript << "execution time:" << executionTime << "ms";
+    qDebug() << "Python full output:" << output;
 
-        // Store result
-        m_comparisonResults.insert(m_currentScript, QVariant::fromValue(fusedValue));
+    return FusionExecutor::parseResult(output, fusedValue, resultConfidence, errorMsg, computeNs);
+}
 
-        // Save to history
+void DecisionEngine::recordComparisonResult(const QString &scriptName, bool ok,
+                                            double fusedValue, double resultConfidence,
+                                            const QVariantMap &stages, const QString &errorMsg,
+                                            bool timedOut)
+{
+    // Store actual execution time
+    double executionTime = stagesToMs(stages);
+    qDebug() << "Script" << scriptName << "execution time:" << executionTime << "ms";
+
+    // Failed scripts still take a row so the comparison completes; views
+    // see the row as soon as it is inserted
+    ComparisonResult result;
+    result.algorithm = scriptName;
+    result.value = ok ? fusedValue : 0.0;
+    result.confidence = resultConfidence;
+    result.executionTime = executionTime;
+    result.ok = ok;
+    result.stages = orderedStages(stages);
+    m_comparisonModel->add(result);
+    emit comparisonCountChanged();
+
+    // Save to history
+    if (ok) {
         m_historyManager->saveFusionResult(
             m_agentValues,
             m_agentConfidences,
-            m_currentScript,
+            scriptName,
             fusedValue,
             resultConfidence,
             executionTime,
-            "Comparison run"
+            "Comparison run",
+            stages
             );
+    } else if (timedOut) {
+        m_historyManager->saveTimeoutResult(m_agentValues, m_agentConfidences,
+                                            scriptName, errorMsg, executionTime, stages);
+    } else {
+        m_historyManager->saveErrorResult(
+            m_agentValues,
+            m_agentConfidences,
+            scriptName,
+            errorMsg,
+            executionTime,
+            stages
+            );
+        m_historyManager->logError(errorMsg, "Comparison");
+    }
+
+    // Update progress
+    m_comparisonProgressCurrent = m_comparisonModel->rowCount();
+    emit comparisonProgressChanged();
+    emit comparisonProgress(m_comparisonProgressCurrent, m_comparisonProgressTotal);
+
+    // Finish once every submitted script has reported back
+    if (m_comparisonRequests.isEmpty() && m_pendingScripts.isEmpty()) {
+        finishComparison();
+    }
+}
 
-        // Update progress
-        m_comparisonProgressCurrent = m_comparisonResults.size();
-        emit comparisonProgressChanged();
+// ========== RESULT CACHE ==========
 
-        // Emit progress signal
-        emit comparisonProgress(m_comparisonResults.size(),
-                                m_comparisonResults.size() + m_pendingScripts.size());
+QByteArray DecisionEngine::resultCacheKey(const QString &scriptName)
+{
+    if (!m_resultCacheEnabled) {
+        return QByteArray();
+    }
+    if (m_inputDigest.isEmpty() || m_inputDigestGeneration != m_inputGeneration) {
+        m_inputDigest = FusionResultCache::inputDigest(m_agentValues, m_agentConfidences);
+        m_inputDigestGeneration = m_inputGeneration;
+    }
+    return m_resultCache.key(scriptName, resolveScriptPath(scriptName), m_inputDigest);
+}
+
+bool DecisionEngine::lookupCachedResult(const QByteArray &key, FusionResultCache::Entry &entry)
+{
+    if (key.isEmpty()) {
+        return false;
+    }
+
+    bool hit = m_resultCache.lookup(key, entry);
+    emit resultCacheStatsChanged();
+    return hit;
+}
+
+void DecisionEngine::storeCachedResult(const QByteArray &key, double fusedValue, double resultConfidence)
+{
+    if (key.isEmpty() || !m_resultCacheEnabled) {
+        return;
+    }
 
-        // Run next script or finish
-        if (!m_pendingScripts.isEmpty()) {
-            m_currentScript = m_pendingScripts.takeFirst();
-            m_pythonOutput.clear();
-            runFusion(m_agentValues, m_currentScript);
+    FusionResultCache::Entry entry;
+    entry.fused = fusedValue;
+    entry.confidence = resultConfidence;
+    m_resultCache.insert(key, entry);
+}
+
+void DecisionEngine::clearResultCache()
+{
+    m_resultCache.clear();
+    m_historyManager->logInfo("Result cache cleared", "System");
+    emit resultCacheStatsChanged();
+}
+
+bool DecisionEngine::resultCacheEnabled() const
+{
+    return m_resultCacheEnabled;
+}
+
+void DecisionEngine::setResultCacheEnabled(bool enabled)
+{
+    if (m_resultCacheEnabled != enabled) {
+        m_resultCacheEnabled = enabled;
+        m_historyManager->logInfo(QString("Result cache %1").arg(enabled ? "enabled" : "disabled"), "System");
+        emit resultCacheEnabledChanged();
+    }
+}
+
+bool DecisionEngine::diskResultCacheEnabled() const
+{
+    return !m_resultCache.diskDirectory().isEmpty();
+}
+
+void DecisionEngine::setDiskResultCacheEnabled(bool enabled)
+{
+    if (diskResultCacheEnabled() == enabled) {
+        return;
+    }
+
+    // Stored next to the history files so results survive restarts
+    QString directory;
+    if (enabled) {
+        QString documentsPath = QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation);
+        directory = QDir(documentsPath).filePath("GDSS/result_cache");
+    }
+    m_resultCache.setDiskDirectory(directory);
+
+    m_historyManager->logInfo(QString("On-disk result cache %1").arg(enabled ? "enabled" : "disabled"), "System");
+    emit diskResultCacheEnabledChanged();
+}
+
+int DecisionEngine::resultCacheHits() const
+{
+    return m_resultCache.hits();
+}
+
+int DecisionEngine::resultCacheMisses() const
+{
+    return m_resultCache.misses();
+}
+
+// ========== BATCH FUSION ==========
+
+int DecisionEngine::runBatchFusion(const QVariantList &cases, const QString &scriptName)
+{
+    if (cases.isEmpty()) {
+        QString errorMsg = "No cases provided for batch fusion.";
+        m_historyManager->logError(errorMsg, "Batch");
+        emit pythonError(errorMsg);
+        return 0;
+    }
+
+    if (m_batchId != 0) {
+        QString errorMsg = "A batch is already running. Please wait.";
+        m_historyManager->logError(errorMsg, "Batch");
+        emit pythonError(errorMsg);
+        return 0;
+    }
+
+    bool isPipeline = FusionPipeline::isPipelineName(scriptName);
+    FusionPipeline pipeline;
+    QString errorMsg;
+    if (isPipeline && !loadPipeline(scriptName, pipeline, errorMsg)) {
+        m_historyManager->logError(errorMsg, "Batch");
+        emit pythonError(errorMsg);
+        return 0;
+    }
+
+    bool native = m_nativeFusionEnabled && NativeFusion::contains(scriptName);
+    QString scriptPath = resolveScriptPath(scriptName);
+    if (!isPipeline && !native && !QFile::exists(scriptPath)) {
+        errorMsg = QString("Script file not found: %1").arg(scriptPath);
+        m_historyManager->logError(errorMsg, "Batch");
+        emit pythonError(errorMsg);
+        return 0;
+    }
+
+    m_batchId = m_nextBatchId++;
+    m_batchScript = scriptName;
+    m_batchResults = QVariantList(cases.size());
+    m_batchProgressCurrent = 0;
+    m_batchProgressTotal = cases.size();
+    m_batchStartTime = m_executionTimer.elapsed();
+    emit isBatchRunningChanged();
+    emit batchProgressChanged();
+
+    m_historyManager->logInfo(
+        QString("Starting batch of %1 cases using %2").arg(cases.size()).arg(scriptName),
+        "Batch"
+        );
+
+    // Each case is a pipeline run of its own, answered in onPipelineFinished
+    if (isPipeline) {
+        FusionExecutor *executor = m_executor;
+        for (int i = 0; i < cases.size(); ++i) {
+            FusionExecutor::Input input;
+            FusionExecutor::splitBatchCase(cases[i], input.values, input.confidences);
+
+            quint64 requestId = m_executor->reserveRequestId();
+            m_batchRequests.insert(requestId, qMakePair(i, 1));
+            QMetaObject::invokeMethod(m_executor, [executor, requestId, pipeline, input]() {
+                executor->runPipeline(requestId, pipeline, input);
+            }, Qt::QueuedConnection);
+        }
+        return m_batchId;
+    }
+
+    // Python chunks go one per worker so the whole pool shares the batch;
+    // native chunks run one after another on the executor's thread. Either
+    // way the cap keeps progress moving on very large batches, and every
+    // result arrives through the event loop after the caller has the batch id.
+    int workers = native ? 1 : m_workerPoolSize;
+    int chunkSize = qBound(1, static_cast<int>((cases.size() + workers - 1) / workers), MAX_BATCH_CHUNK);
+    FusionExecutor *executor = m_executor;
+
+    for (int first = 0; first < cases.size(); first += chunkSize) {
+        int count = qMin(chunkSize, static_cast<int>(cases.size()) - first);
+        QVariantList chunk = cases.mid(first, count);
+
+        quint64 requestId = m_executor->reserveRequestId();
+        m_batchRequests.insert(requestId, qMakePair(first, count));
+
+        if (native) {
+            QMetaObject::invokeMethod(m_executor, [executor, requestId, scriptName, chunk]() {
+                executor->runNativeBatch(requestId, scriptName, chunk);
+            }, Qt::QueuedConnection);
         } else {
-            finishComparison();
+            QMetaObject::invokeMethod(m_executor, [executor, requestId, scriptPath, chunk]() {
+                executor->runBatchChunk(requestId, scriptPath, chunk);
+            }, Qt::QueuedConnection);
         }
+    }
+
+    return m_batchId;
+}
+
+void DecisionEngine::onNativeBatchFinished(quint64 requestId, const QVariantList &results)
+{
+    if (!m_batchRequests.contains(requestId)) {
+        return; // Not a chunk of the running batch (unknown or stale id)
+    }
+
+    QPair<int, int> range = m_batchRequests.take(requestId);
+    for (int i = 0; i < range.second && i < results.size(); ++i) {
+        QVariantMap result = results[i].toMap();
+        recordBatchResult(range.first + i, result.value("ok").toBool(),
+                          result.value("fused").toDouble(), result.value("confidence").toDouble(),
+                          result.value("error").toString());
+    }
+
+    if (m_batchRequests.isEmpty()) {
+        finishBatch();
+    }
+}
+
+void DecisionEngine::finishBatchChunk(quint64 requestId, int exitCode,
+                                      const QByteArray &output, const QString &errorOutput)
+{
+    QPair<int, int> range = m_batchRequests.take(requestId);
+    int first = range.first;
+    int count = range.second;
+
+    // An error here fails every case of the chunk
+    QString chunkError;
+    QJsonArray results;
+
+    if (exitCode < 0) {
+        chunkError = errorOutput;
+    } else if (exitCode != 0) {
+        chunkError = QString("Python script exited with code %1. Error: %2")
+                         .arg(exitCode)
+                         .arg(errorOutput.isEmpty() ? QString("Unknown error") : errorOutput);
     } else {
-        // Single fusion (not comparison mode)
-        m_fusedValue = fusedValue;
-        emit fusedValueChanged();
+        if (!errorOutput.isEmpty()) {
+            qDebug() << "Python STDERR:" << errorOutput;
+        }
 
-        // Save to history
-        m_historyManager->saveFusionResult(
-            m_agentValues,
-            m_agentConfidences,
-            m_currentSingleScript,
-            fusedValue,
-            resultConfidence,
-            executionTime,
-            "Single fusion"
-            );
+        QJsonParseError parseError;
+        QJsonDocument doc = QJsonDocument::fromJson(output, &parseError);
+        if (parseError.error != QJsonParseError::NoError || !doc.isObject()) {
+            chunkError = QString("Failed to parse batch reply from Python: %1").arg(parseError.errorString());
+        } else {
+            results = doc.object().value("results").toArray();
+            if (results.size() != count) {
+                chunkError = QString("Batch reply has %1 results for %2 cases.").arg(results.size()).arg(count);
+            }
+        }
+    }
+
+    for (int i = 0; i < count; ++i) {
+        if (!chunkError.isEmpty()) {
+            recordBatchResult(first + i, false, 0.0, 1.0, chunkError);
+            continue;
+        }
+
+        QJsonObject result = results[i].toObject();
+        if (result.contains("error") || !result.value("fused").isDouble()) {
+            QString errorMsg = result.value("error").toString();
+            recordBatchResult(first + i, false, 0.0, 1.0,
+                              errorMsg.isEmpty() ? QString("Python returned no fused value.") : errorMsg);
+            continue;
+        }
+
+        recordBatchResult(first + i, true, result.value("fused").toDouble(),
+                          result.value("confidence").toDouble(1.0), QString());
+    }
+
+    if (m_batchRequests.isEmpty()) {
+        finishBatch();
+    }
+}
+
+void DecisionEngine::recordBatchResult(int caseIndex, bool ok, double fusedValue,
+                                       double resultConfidence, const QString &errorMsg)
+{
+    QVariantMap result;
+    result["index"] = caseIndex;
+    result["ok"] = ok;
+    result["fused"] = ok ? fusedValue : 0.0;
+    result["confidence"] = resultConfidence;
+    if (!ok) {
+        result["error"] = errorMsg;
+    }
+    m_batchResults[caseIndex] = result;
+
+    m_batchProgressCurrent++;
+    emit batchCaseFinished(m_batchId, caseIndex, result);
+    emit batchProgressChanged();
+    emit batchProgress(m_batchProgressCurrent, m_batchProgressTotal);
+}
+
+void DecisionEngine::finishBatch()
+{
+    int batchId = m_batchId;
+    QVariantList results = m_batchResults;
+    qint64 executionTime = m_executionTimer.elapsed() - m_batchStartTime;
+
+    int failed = 0;
+    for (const QVariant &result : results) {
+        if (!result.toMap().value("ok").toBool()) {
+            failed++;
+        }
+    }
+
+    // Cases are not written to the history one by one; a batch can hold thousands
+    m_historyManager->logInfo(
+        QString("Batch of %1 cases using %2 finished in %3ms (%4 failed)")
+            .arg(results.size())
+            .arg(m_batchScript)
+            .arg(executionTime)
+            .arg(failed),
+        "Batch"
+        );
+
+    m_batchId = 0;
+    m_batchResults.clear();
+    emit isBatchRunningChanged();
+    emit batchFinished(batchId, results);
+}
+
+// ========== MULTI-CRITERIA FUSION ==========
+
+int DecisionEngine::runCriteriaFusion(const QStringList &criteria, const QVariantList &columns,
+                                      const QVariantList &confidences, const QString &scriptName)
+{
+    CriteriaTable table;
+    QString errorMsg;
+    if (!CriteriaTable::fromColumns(criteria, columns, confidences, table, &errorMsg)) {
+        m_historyManager->logError(errorMsg, "Fusion");
+        emit pythonError(errorMsg);
+        return 0;
+    }
+    return runCriteriaFusion(table, scriptName);
+}
+
+int DecisionEngine::runCriteriaFusion(const CriteriaTable &table, const QString &scriptName)
+{
+    QString errorMsg;
+    if (table.isEmpty()) {
+        errorMsg = "No agent data provided for multi-criteria fusion.";
+    } else if (FusionPipeline::isPipelineName(scriptName)) {
+        errorMsg = QString("%1 is a pipeline; pipelines fuse single-criterion agents only.").arg(scriptName);
+    }
+
+    bool native = m_nativeFusionEnabled && NativeFusion::contains(scriptName);
+    QString scriptPath = resolveScriptPath(scriptName);
+    if (errorMsg.isEmpty() && !native && !QFile::exists(scriptPath)) {
+        errorMsg = QString("Script file not found: %1").arg(scriptPath);
+    }
+
+    if (!errorMsg.isEmpty()) {
+        m_historyManager->logError(errorMsg, "Fusion");
+        emit pythonError(errorMsg);
+        return 0;
+    }
+
+    CriteriaRequest request;
+    request.runId = m_nextCriteriaRunId++;
+    request.scriptName = scriptName;
+    request.agentCount = table.agentCount();
+    request.criteriaCount = table.criteriaCount();
+
+    // Always on the executor's thread: a table is meant for large inputs, and
+    // the result arrives after the caller has the run id either way
+    quint64 requestId = m_executor->reserveRequestId();
+    m_criteriaRequests.insert(requestId, request);
+    FusionExecutor *executor = m_executor;
+    QMetaObject::invokeMethod(m_executor, [executor, requestId, scriptName, scriptPath, native, table]() {
+        executor->runCriteria(requestId, scriptName, scriptPath, native, table);
+    }, Qt::QueuedConnection);
+
+    m_historyManager->logInfo(
+        QString("Starting multi-criteria fusion of %1 agents x %2 criteria using %3")
+            .arg(table.agentCount())
+            .arg(table.criteriaCount())
+            .arg(scriptName),
+        "Fusion"
+        );
+    return request.runId;
+}
+
+void DecisionEngine::cancelCriteriaFusion(int runId)
+{
+    for (auto it = m_criteriaRequests.constBegin(); it != m_criteriaRequests.constEnd(); ++it) {
+        if (it.value().runId != runId) {
+            continue;
+        }
+        QString scriptName = it.value().scriptName;
+        quint64 requestId = it.key();
+        m_criteriaRequests.remove(requestId);
+        cancelRequest(requestId);
+
+        m_historyManager->logInfo(QString("Multi-criteria fusion with %1 cancelled").arg(scriptName), "Fusion");
+        return;
+    }
+}
+
+void DecisionEngine::onCriteriaFinished(quint64 requestId, const QVariantList &results,
+                                        const QString &errorMsg, const QVariantMap &stages)
+{
+    bool timedOut = m_timedOutRequests.remove(requestId);
+    if (!m_criteriaRequests.contains(requestId)) {
+        qDebug() << "Ignoring multi-criteria result for stale request" << requestId;
+        return;
+    }
+    CriteriaRequest request = m_criteriaRequests.take(requestId);
 
-        // Log success
+    int failed = 0;
+    for (const QVariant &result : results) {
+        if (!result.toMap().value("ok").toBool()) {
+            failed++;
+        }
+    }
+
+    // Like a batch, a run is logged rather than written to the history: it
+    // has one value per criterion and can cover millions of cells
+    if (!errorMsg.isEmpty()) {
+        QString message = timedOut ? QString("%1 timed out: %2").arg(request.scriptName, errorMsg)
+                                   : QString("Multi-criteria fusion with %1 failed: %2")
+                                         .arg(request.scriptName, errorMsg);
+        m_historyManager->logError(message, "Fusion");
+        emit pythonError(message);
+    } else {
         m_historyManager->logInfo(
-            QString("Fusion completed in %1ms with result: %2 (confidence: %3)")
-                .arg(executionTime)
-                .arg(fusedValue, 0, 'f', 4)
-                .arg(resultConfidence, 0, 'f', 2),
+            QString("Multi-criteria fusion of %1 agents x %2 criteria using %3 finished in %4ms (%5 failed)")
+                .arg(request.agentCount)
+                .arg(request.criteriaCount)
+                .arg(request.scriptName)
+                .arg(stagesToMs(stages), 0, 'f', 2)
+                .arg(failed),
             "Fusion"
             );
     }
 
-    // Clear output for next run
-    m_pythonOutput.clear();
+    emit criteriaFusionFinished(request.runId, request.scriptName, results, orderedStages(stages));
 }
+
 double DecisionEngine::fusedValue() const
 {
     return m_fusedValue;
@@ -798,6 +1458,11 @@ void DecisionEngine::setScriptBasePath(const QString &path)
         if (!m_scriptBasePath.endsWith('/') && !m_scriptBasePath.endsWith('\\')) {
             m_scriptBasePath += '/';
         }
+        FusionExecutor *executor = m_executor;
+        QString workerScript = m_scriptBasePath + "gdss_worker.py";
+        QMetaObject::invokeMethod(m_executor, [executor, workerScript]() {
+            executor->setWorkerScript(workerScript);
+        }, Qt::QueuedConnection);
         emit scriptBasePathChanged();
     }
 }
@@ -809,10 +1474,13 @@ QStringList DecisionEngine::availableScripts() const
 
     if (scriptDir.exists()) {
         QStringList filters;
-        filters << "*.py";
+        filters << "*.py" << "*.pipeline.json";
         scriptDir.setNameFilters(filters);
 
         scripts = scriptDir.entryList(QDir::Files);
+        scripts.removeAll("gdss_worker.py"); // Worker adapter, not a fusion algorithm
+        scripts.removeAll("model_cache.py"); // Helper modules imported by the scripts
+        scripts.removeAll("batch_utils.py");
     }
 
     return scripts;
@@ -828,73 +1496,25 @@ bool DecisionEngine::validateScript(const QString &scriptName) const
 void DecisionEngine::finishComparison()
 {
     m_isComparing = false;
-    m_currentScript.clear();
 
     updateComparisonStats();
 
     emit isComparingChanged();
     emit comparisonFinished();
     emit comparisonStatsChanged();
-     emit comparisonResultsChanged();
+    emit comparisonResultsChanged();
 }
 void DecisionEngine::updateComparisonStats()
 {
-    if (m_comparisonResults.isEmpty()) {
-        m_meanValue = 0.0;
-        m_stdDevValue = 0.0;
-        m_bestAlgorithm = "";
-        m_fastestAlgorithm = "";
-        return;
-    }
-
-    // Calculate mean
-    double sum = 0.0;
-    int count = 0;
-
-    QList<double> values;
-    for (auto it = m_comparisonResults.begin(); it != m_comparisonResults.end(); ++it) {
-        double val = it.value().toDouble();
-        values.append(val);
-        sum += val;
-        count++;
-    }
-
-    m_meanValue = sum / count;
-
-    // Calculate standard deviation
-    double variance = 0.0;
-    for (double val : values) {
-        double diff = val - m_meanValue;
-        variance += diff * diff;
-    }
-    m_stdDevValue = std::sqrt(variance / count);
-
-    // Find best algorithm (closest to 0.5 as example, or highest value)
-    double bestValue = -1.0;
-    for (auto it = m_comparisonResults.begin(); it != m_comparisonResults.end(); ++it) {
-        double val = it.value().toDouble();
-        if (val > bestValue) {
-            bestValue = val;
-            m_bestAlgorithm = it.key();
-        }
-    }
-
-    // Find fastest algorithm (placeholder - you need to track actual times)
-    if (!m_executionTimes.isEmpty()) {
-        qint64 fastestTime = std::numeric_limits<qint64>::max();
-        for (auto it = m_executionTimes.begin(); it != m_executionTimes.end(); ++it) {
-            if (it.value() < fastestTime) {
-                fastestTime = it.value();
-                m_fastestAlgorithm = it.key();
-            }
-        }
-    } else {
-        m_fastestAlgorithm = m_bestAlgorithm; // Fallback
-    }
+    const ComparisonResultModel::Summary summary = m_comparisonModel->summary();
+    m_meanValue = summary.mean;
+    m_stdDevValue = summary.stdDev;
+    m_bestAlgorithm = summary.bestAlgorithm;
+    m_fastestAlgorithm = summary.fastestAlgorithm;
 }
 void DecisionEngine::exportComparisonCSV(const QString &filePath)
 {
-    if (m_comparisonResults.isEmpty()) {
+    if (m_comparisonModel->isEmpty()) {
         emit pythonError("No comparison results to export.");
         return;
     }
@@ -911,16 +1531,14 @@ void DecisionEngine::exportComparisonCSV(const QString &filePath)
     // Write header with all columns
     out << "Algorithm,FusedValue,ExecutionTime(ms),Rank\n";
 
-    // Get sorted results
-    QVariantList results = getComparisonResults();
-
-    for (const QVariant &item : results) {
-        QVariantMap result = item.toMap();
+    // Rows are already sorted; the rank is the row number
+    const QVector<ComparisonResult> &results = m_comparisonModel->results();
 
-        QString algorithm = result["algorithm"].toString();
-        double value = result["value"].toDouble();
-        qint64 execTime = result["executionTime"].toLongLong();
-        int rank = result["rank"].toInt();
+    for (int i = 0; i < results.size(); ++i) {
+        QString algorithm = results[i].algorithm;
+        double value = results[i].value;
+        double execTime = results[i].executionTime;
+        int rank = i + 1;
 
         // Escape commas in algorithm names if needed
         QString safeAlgorithm = algorithm;
@@ -930,7 +1548,7 @@ void DecisionEngine::exportComparisonCSV(const QString &filePath)
 
         out << safeAlgorithm << ","
             << QString::number(value, 'f', 6) << ","
-            << execTime << ","
+            << QString::number(execTime, 'f', 3) << ","
             << rank << "\n";
     }
 
@@ -940,7 +1558,8 @@ void DecisionEngine::exportComparisonCSV(const QString &filePath)
 }
 
 bool DecisionEngine::isComparing() const { return m_isComparing; }
-int DecisionEngine::comparisonCount() const { return m_comparisonResults.size(); }
+int DecisionEngine::comparisonCount() const { return m_comparisonModel->rowCount(); }
+ComparisonResultModel *DecisionEngine::comparisonModel() const { return m_comparisonModel; }
 double DecisionEngine::comparisonMean() const { return m_meanValue; }
 double DecisionEngine::comparisonStdDev() const { return m_stdDevValue; }
 QString DecisionEngine::bestAlgorithm() const { return m_bestAlgorithm; }
@@ -948,73 +1567,166 @@ QString DecisionEngine::fastestAlgorithm() const { return m_fastestAlgorithm; }
 
 QVariantList DecisionEngine::comparisonResults() const
 {
-    QVariantList results;
-
-    // Create sorted list by value (descending)
-    QList<QPair<QString, double>> sortedResults;
-    for (auto it = m_comparisonResults.begin(); it != m_comparisonResults.end(); ++it) {
-        sortedResults.append(qMakePair(it.key(), it.value().toDouble()));
-    }
-
-    // Sort by value (descending)
-    std::sort(sortedResults.begin(), sortedResults.end(),
-              [](const QPair<QString, double> &a, const QPair<QString, double> &b) {
-                  return a.second > b.second;
-              });
-
-    // Create result objects with rank
-    for (int i = 0; i < sortedResults.size(); ++i) {
-        QVariantMap result;
-        result["algorithm"] = sortedResults[i].first;
-        result["value"] = sortedResults[i].second;
-        result["executionTime"] = m_executionTimes.value(sortedResults[i].first, 0);
-        result["rank"] = i + 1;
-        results.append(result);
-    }
-
-    return results;
-}
-
-QVariantList DecisionEngine::getComparisonResults() const {
-    QVariantList results;
-
-    // Create sorted results
-    QList<QPair<QString, double>> sortedResults;
-    for (auto it = m_comparisonResults.begin(); it != m_comparisonResults.end(); ++it) {
-        sortedResults.append(qMakePair(it.key(), it.value().toDouble()));
-    }
-
-    // Sort by value (descending)
-    std::sort(sortedResults.begin(), sortedResults.end(),
-              [](const QPair<QString, double> &a, const QPair<QString, double> &b) {
-                  return a.second > b.second;
-              });
-
-    // Create result objects with ACTUAL execution times
-    for (int i = 0; i < sortedResults.size(); ++i) {
-        QVariantMap result;
-        QString algorithm = sortedResults[i].first;
-        result["algorithm"] = algorithm;
-        result["value"] = sortedResults[i].second;
-
-        // Get actual execution time or default
-        qint64 execTime = m_executionTimes.value(algorithm, 0);
-        if (execTime == 0) {
-            // Estimate based on script name (you can adjust these)
-            if (algorithm.contains("neural") || algorithm.contains("random_forest"))
-                execTime = 150;
-            else if (algorithm.contains("weighted"))
-                execTime = 50;
-            else
-                execTime = 80;
-        }
+    return m_comparisonModel->toVariantList();
+}
+
+QVariantList DecisionEngine::getComparisonResults() const
+{
+    return m_comparisonModel->toVariantList();
+}
+
+bool DecisionEngine::nativeFusionEnabled() const
+{
+    return m_nativeFusionEnabled;
+}
+
+void DecisionEngine::setNativeFusionEnabled(bool enabled)
+{
+    if (m_nativeFusionEnabled != enabled) {
+        m_nativeFusionEnabled = enabled;
+        m_historyManager->logInfo(QString("Native fusion %1").arg(enabled ? "enabled" : "disabled"), "System");
+        emit nativeFusionEnabledChanged();
+    }
+}
+
+QStringList DecisionEngine::nativeAlgorithms() const
+{
+    return NativeFusion::algorithms();
+}
+
+bool DecisionEngine::isBatchRunning() const
+{
+    return m_batchId != 0;
+}
+
+int DecisionEngine::batchProgressCurrent() const
+{
+    return m_batchProgressCurrent;
+}
+
+int DecisionEngine::batchProgressTotal() const
+{
+    return m_batchProgressTotal;
+}
 
-        result["executionTime"] = execTime;
-        result["rank"] = i + 1;
-        results.append(result);
+bool DecisionEngine::binaryFramingEnabled() const
+{
+    return m_binaryFramingEnabled;
+}
+
+void DecisionEngine::setBinaryFramingEnabled(bool enabled)
+{
+    if (m_binaryFramingEnabled != enabled) {
+        m_binaryFramingEnabled = enabled;
+        FusionExecutor *executor = m_executor;
+        QMetaObject::invokeMethod(m_executor, [executor, enabled]() {
+            executor->setBinaryFramingEnabled(enabled);
+        }, Qt::QueuedConnection);
+        m_historyManager->logInfo(QString("Binary script framing %1").arg(enabled ? "enabled" : "disabled"), "System");
+        emit binaryFramingEnabledChanged();
     }
+}
 
-    return results;
+bool DecisionEngine::sharedMemoryEnabled() const
+{
+    return m_sharedMemoryEnabled;
+}
+
+void DecisionEngine::setSharedMemoryEnabled(bool enabled)
+{
+    if (m_sharedMemoryEnabled != enabled) {
+        m_sharedMemoryEnabled = enabled;
+        FusionExecutor *executor = m_executor;
+        QMetaObject::invokeMethod(m_executor, [executor, enabled]() {
+            executor->setSharedMemoryEnabled(enabled);
+        }, Qt::QueuedConnection);
+        m_historyManager->logInfo(QString("Shared-memory agent transport %1").arg(enabled ? "enabled" : "disabled"), "System");
+        emit sharedMemoryEnabledChanged();
+    }
+}
+
+int DecisionEngine::scriptTimeout() const
+{
+    return m_scriptTimeout;
+}
+
+void DecisionEngine::setScriptTimeout(int milliseconds)
+{
+    milliseconds = qMax(0, milliseconds);
+    if (m_scriptTimeout != milliseconds) {
+        m_scriptTimeout = milliseconds;
+        m_historyManager->logInfo(milliseconds > 0
+                                      ? QString("Script deadline set to %1ms").arg(milliseconds)
+                                      : QString("Script deadline disabled"),
+                                  "System");
+        emit scriptTimeoutChanged();
+    }
+}
+
+void DecisionEngine::setScriptTimeoutFor(const QString &scriptName, int milliseconds)
+{
+    if (milliseconds < 0) {
+        m_scriptTimeouts.remove(scriptName);
+    } else {
+        m_scriptTimeouts.insert(scriptName, milliseconds);
+    }
+}
+
+int DecisionEngine::scriptTimeoutFor(const QString &scriptName) const
+{
+    return m_scriptTimeouts.value(scriptName, m_scriptTimeout);
+}
+
+QString DecisionEngine::pythonProgram() const
+{
+    return m_pythonProgram;
+}
+
+void DecisionEngine::setPythonProgram(const QString &program)
+{
+    if (m_pythonProgram != program) {
+        // Workers already running keep their interpreter until they retire
+        m_pythonProgram = program;
+        FusionExecutor *executor = m_executor;
+        QMetaObject::invokeMethod(m_executor, [executor, program]() {
+            executor->setPythonProgram(program);
+        }, Qt::QueuedConnection);
+        m_historyManager->logInfo(QString("Python interpreter set to %1").arg(program), "System");
+        emit pythonProgramChanged();
+    }
+}
+
+QString DecisionEngine::liveAlgorithm() const
+{
+    return m_liveAlgorithm;
+}
+
+void DecisionEngine::setLiveAlgorithm(const QString &scriptName)
+{
+    if (m_liveAlgorithm != scriptName) {
+        // Takes effect with the next agent edit; switching alone publishes nothing
+        m_liveAlgorithm = scriptName;
+        emit liveAlgorithmChanged();
+    }
+}
+
+int DecisionEngine::workerPoolSize() const
+{
+    return m_workerPoolSize;
+}
+
+void DecisionEngine::setWorkerPoolSize(int size)
+{
+    size = qMax(1, size);
+    if (m_workerPoolSize != size) {
+        m_workerPoolSize = size;
+        FusionExecutor *executor = m_executor;
+        QMetaObject::invokeMethod(m_executor, [executor, size]() {
+            executor->setPoolSize(size);
+        }, Qt::QueuedConnection);
+        m_historyManager->logInfo(QString("Python worker pool size set to %1").arg(size), "System");
+        emit workerPoolSizeChanged();
+    }
 }
 
 int DecisionEngine::getComparisonProgressTotal() const
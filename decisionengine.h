@@ -8,7 +8,18 @@
 #include <QStringList>
 #include <QElapsedTimer>
 #include <QTime>
-#include "HistoryManager.h"
+#include <QHash>
+#include <QSet>
+#include "historymanager.h"
+#include "comparisonresultmodel.h"
+#include "criteriatable.h"
+#include "fusionresultcache.h"
+#include "incrementalfusion.h"
+
+struct NativeFusionResult;
+class FusionExecutor;
+class FusionPipeline;
+class QThread;
 
 class HistoryManager;
 
@@ -22,14 +33,7 @@ struct AgentData {
         return qFuzzyCompare(value, other.value) && qFuzzyCompare(confidence, other.confidence);
     }
 };
-struct ComparisonResult {
-    QString algorithm;
-    double value;
-    double executionTime;
-    int rank;
-};
 Q_DECLARE_METATYPE(AgentData)
-Q_DECLARE_METATYPE(ComparisonResult)
 
 class DecisionEngine : public QObject
 {
@@ -42,9 +46,24 @@ class DecisionEngine : public QObject
     Q_PROPERTY(double comparisonStdDev READ comparisonStdDev NOTIFY comparisonStatsChanged)
     Q_PROPERTY(QString bestAlgorithm READ bestAlgorithm NOTIFY comparisonStatsChanged)
     Q_PROPERTY(QString fastestAlgorithm READ fastestAlgorithm NOTIFY comparisonStatsChanged)
-    Q_PROPERTY(QVariantList comparisonModel READ getComparisonResults NOTIFY comparisonResultsChanged)
+    Q_PROPERTY(ComparisonResultModel *comparisonModel READ comparisonModel CONSTANT)
     Q_PROPERTY(int comparisonProgressCurrent READ getComparisonProgressCurrent NOTIFY comparisonProgressChanged)
     Q_PROPERTY(int comparisonProgressTotal READ getComparisonProgressTotal NOTIFY comparisonProgressChanged)
+    Q_PROPERTY(int workerPoolSize READ workerPoolSize WRITE setWorkerPoolSize NOTIFY workerPoolSizeChanged)
+    Q_PROPERTY(bool nativeFusionEnabled READ nativeFusionEnabled WRITE setNativeFusionEnabled NOTIFY nativeFusionEnabledChanged)
+    Q_PROPERTY(bool isBatchRunning READ isBatchRunning NOTIFY isBatchRunningChanged)
+    Q_PROPERTY(int batchProgressCurrent READ batchProgressCurrent NOTIFY batchProgressChanged)
+    Q_PROPERTY(int batchProgressTotal READ batchProgressTotal NOTIFY batchProgressChanged)
+    Q_PROPERTY(bool resultCacheEnabled READ resultCacheEnabled WRITE setResultCacheEnabled NOTIFY resultCacheEnabledChanged)
+    Q_PROPERTY(bool diskResultCacheEnabled READ diskResultCacheEnabled WRITE setDiskResultCacheEnabled NOTIFY diskResultCacheEnabledChanged)
+    Q_PROPERTY(int resultCacheHits READ resultCacheHits NOTIFY resultCacheStatsChanged)
+    Q_PROPERTY(int resultCacheMisses READ resultCacheMisses NOTIFY resultCacheStatsChanged)
+    Q_PROPERTY(bool binaryFramingEnabled READ binaryFramingEnabled WRITE setBinaryFramingEnabled NOTIFY binaryFramingEnabledChanged)
+    Q_PROPERTY(bool sharedMemoryEnabled READ sharedMemoryEnabled WRITE setSharedMemoryEnabled NOTIFY sharedMemoryEnabledChanged)
+    Q_PROPERTY(int scriptTimeout READ scriptTimeout WRITE setScriptTimeout NOTIFY scriptTimeoutChanged)
+    Q_PROPERTY(QString pythonProgram READ pythonProgram WRITE setPythonProgram NOTIFY pythonProgramChanged)
+    // Script whose result follows agent edits (see IncrementalFusion); empty turns it off
+    Q_PROPERTY(QString liveAlgorithm READ liveAlgorithm WRITE setLiveAlgorithm NOTIFY liveAlgorithmChanged)
 
 
 public:
@@ -59,10 +78,34 @@ public:
     void setScriptBasePath(const QString &path);
     bool isComparing() const;
     int comparisonCount() const;
+    ComparisonResultModel *comparisonModel() const;
     double comparisonMean() const;
     double comparisonStdDev() const;
     QString bestAlgorithm() const;
     QString fastestAlgorithm() const;
+    int workerPoolSize() const;
+    void setWorkerPoolSize(int size);
+    bool nativeFusionEnabled() const;
+    void setNativeFusionEnabled(bool enabled);
+    bool isBatchRunning() const;
+    int batchProgressCurrent() const;
+    int batchProgressTotal() const;
+    bool resultCacheEnabled() const;
+    void setResultCacheEnabled(bool enabled);
+    bool diskResultCacheEnabled() const;
+    void setDiskResultCacheEnabled(bool enabled);
+    int resultCacheHits() const;
+    int resultCacheMisses() const;
+    bool binaryFramingEnabled() const;
+    void setBinaryFramingEnabled(bool enabled);
+    bool sharedMemoryEnabled() const;
+    void setSharedMemoryEnabled(bool enabled);
+    int scriptTimeout() const;
+    void setScriptTimeout(int milliseconds);
+    QString pythonProgram() const;
+    void setPythonProgram(const QString &program);
+    QString liveAlgorithm() const;
+    void setLiveAlgorithm(const QString &scriptName);
 
     Q_INVOKABLE void addAgentValue(double value);
     Q_INVOKABLE void clearValues();
@@ -76,16 +119,46 @@ public:
     Q_INVOKABLE void runComparisonWithConfidence(const QVariantList &agentValues,
                                                  const QVariantList &confidences,
                                                  const QStringList &scripts);
+    // Fuse many independent cases with one script. Each case is a list of
+    // values or a map {values, confidences}. Returns the batch id reported
+    // by batchCaseFinished()/batchFinished(), or 0 if the batch was refused.
+    Q_INVOKABLE int runBatchFusion(const QVariantList &cases, const QString &scriptName);
+    // Fuse agents scored on several criteria, every criterion with the same
+    // script. columns holds one list of agent values per criterion, criteria
+    // their names (may be empty) and confidences one per agent (optional).
+    // Returns the run id reported by criteriaFusionFinished(), or 0 if the
+    // run was refused. Pipelines are single-criterion and are refused.
+    Q_INVOKABLE int runCriteriaFusion(const QStringList &criteria, const QVariantList &columns,
+                                      const QVariantList &confidences, const QString &scriptName);
+    // Same for a table built in C++, without a QVariant per cell
+    int runCriteriaFusion(const CriteriaTable &table, const QString &scriptName);
+    Q_INVOKABLE void cancelCriteriaFusion(int runId);
     Q_INVOKABLE QStringList availableScripts() const;
     Q_INVOKABLE bool validateScript(const QString &scriptName) const;
+    Q_INVOKABLE QStringList nativeAlgorithms() const;
+    Q_INVOKABLE void clearResultCache();
+    // Deadline for one script run in ms, overriding scriptTimeout; 0 means
+    // no deadline and a negative value removes the override. A batch chunk
+    // gets it once per case it carries
+    Q_INVOKABLE void setScriptTimeoutFor(const QString &scriptName, int milliseconds);
+    Q_INVOKABLE int scriptTimeoutFor(const QString &scriptName) const;
+    // Abandon the running single fusion / comparison. Scripts still running
+    // are killed; a cancelled comparison finishes with the results it has.
+    Q_INVOKABLE void cancelFusion();
+    Q_INVOKABLE void cancelComparison();
     Q_INVOKABLE void exportComparisonCSV(const QString &filePath);
     Q_INVOKABLE QVariantList getAgentsWithConfidence() const;
     Q_INVOKABLE double getAgentConfidence(int index) const;
     Q_INVOKABLE void setAgentConfidence(int index, double confidence);
+    // Snapshots of comparisonModel, for callers that want plain maps
     Q_INVOKABLE QVariantList getComparisonResults() const;
     Q_INVOKABLE QVariantList comparisonResults() const;
     Q_INVOKABLE void addAgent(double value, double confidence = 1.0);
     Q_INVOKABLE void updateAgentConfidence(int index, double confidence);
+    Q_INVOKABLE void updateAgent(int index, double value, double confidence);
+    Q_INVOKABLE void removeAgent(int index);
+    // Replaces the agent list without publishing a live result
+    Q_INVOKABLE void setAgents(const QVariantList &values, const QVariantList &confidences);
 
     void finishComparison();
     int getComparisonProgressTotal() const;
@@ -104,30 +177,155 @@ signals:
     void agentsChanged();
     void agentConfidenceChanged(int index);
     void comparisonProgressChanged();
+    void workerPoolSizeChanged();
+    void nativeFusionEnabledChanged();
+    void isBatchRunningChanged();
+    void batchProgressChanged();
+    void batchProgress(int current, int total);
+    // result: {index, ok, fused, confidence, error}
+    void batchCaseFinished(int batchId, int caseIndex, const QVariantMap &result);
+    void batchFinished(int batchId, const QVariantList &results);
+    // results: one {criterion, ok, fused, confidence, error} map per criterion,
+    // in table order; stages as the comparison rows' {stage, ms} list
+    void criteriaFusionFinished(int runId, const QString &scriptName,
+                                const QVariantList &results, const QVariantList &stages);
+    void resultCacheEnabledChanged();
+    void diskResultCacheEnabledChanged();
+    void resultCacheStatsChanged();
+    void binaryFramingEnabledChanged();
+    void sharedMemoryEnabledChanged();
+    void scriptTimeoutChanged();
+    void pythonProgramChanged();
+    void liveAlgorithmChanged();
+    void fusionCancelled();
+    void comparisonCancelled();
 
 private slots:
-    void onPythonFinished(int exitCode, QProcess::ExitStatus exitStatus);
+    void onWorkerStarted(quint64 requestId);
+    void onWorkerFinished(quint64 requestId, int exitCode,
+                          const QByteArray &output, const QString &errorOutput,
+                          const QVariantMap &timings);
+    void onNativeFinished(quint64 requestId, bool ok, double fusedValue, double resultConfidence,
+                          const QString &errorMsg, const QVariantMap &stages);
+    void onNativeBatchFinished(quint64 requestId, const QVariantList &results);
+    void onPipelineFinished(quint64 requestId, bool ok, double fusedValue, double resultConfidence,
+                            const QString &errorMsg, const QVariantMap &stages);
+    void onCriteriaFinished(quint64 requestId, const QVariantList &results,
+                            const QString &errorMsg, const QVariantMap &stages);
 
 private:
+    // A multi-criteria run in flight
+    struct CriteriaRequest {
+        int runId = 0;
+        QString scriptName;
+        qsizetype agentCount = 0;
+        int criteriaCount = 0;
+    };
+
+    // Engine-side span of a script run, completed from the executor's timings
+    struct RequestTiming {
+        qint64 submitted = 0;  // ns on m_executionTimer
+    };
+
     double m_fusedValue;
-    QProcess *m_python;
+    // Encoding, the Python workers and large native runs, on m_executorThread
+    FusionExecutor *m_executor;
+    QThread *m_executorThread;
+    int m_workerPoolSize;  // mirrors of the executor's configuration
+    QString m_pythonProgram;
+    quint64 m_activeRequestId;  // 0 when no script is in flight
+    quint64 m_inputGeneration;  // bumped with every new agent set sent to the executor
+    bool m_nativeFusionEnabled;
+    bool m_binaryFramingEnabled;
+    bool m_sharedMemoryEnabled;
+    static const int EXECUTOR_NATIVE_MIN_AGENTS = 1024;  // smaller native runs stay on this thread
     QString m_scriptBasePath;
     QVariantList m_agentValues;
     QByteArray m_pythonOutput;
     QList<AgentData> m_agents;
-    QMap<QString, qint64> m_executionTimes;
     QElapsedTimer m_executionTimer;
-    QMap<QString, QTime> m_startTimes;
+    QHash<quint64, RequestTiming> m_requestTimings;
     QVariantList m_agentConfidences;
     // Comparison state
     bool m_isComparing;
     QStringList m_pendingScripts;
-    QString m_currentScript;
-    QVariantMap m_comparisonResults;  // scriptName -> fusedValue
+    QHash<quint64, QString> m_comparisonRequests;  // requestId -> scriptName, in flight
+    ComparisonResultModel *m_comparisonModel;  // sorted as results arrive
+    // Batch state
+    int m_batchId;  // 0 when no batch is running
+    int m_nextBatchId;
+    QString m_batchScript;
+    QVariantList m_batchResults;  // one result map per case, in case order
+    QHash<quint64, QPair<int, int>> m_batchRequests;  // requestId -> (first case, case count)
+    int m_batchProgressCurrent;
+    int m_batchProgressTotal;
+    qint64 m_batchStartTime;
+    static constexpr int MAX_BATCH_CHUNK = 1000;  // cases per worker request
+    // Multi-criteria runs
+    QHash<quint64, CriteriaRequest> m_criteriaRequests;  // requestId -> run
+    int m_nextCriteriaRunId;
+    // Result cache
+    FusionResultCache m_resultCache;
+    bool m_resultCacheEnabled;
+    QByteArray m_inputDigest;  // FusionResultCache::inputDigest() of the agent set, see resultCacheKey()
+    quint64 m_inputDigestGeneration;
+    QHash<quint64, QByteArray> m_requestCacheKeys;  // requestId -> cache key
+    // Deadlines
+    int m_scriptTimeout;  // ms, 0 = none
+    QHash<QString, int> m_scriptTimeouts;  // scriptName -> ms, overrides m_scriptTimeout
+    QSet<quint64> m_timedOutRequests;  // killed by their deadline, reply not yet handled
+    // Live fusion
+    IncrementalFusion m_incremental;  // running state over m_agents
+    QString m_liveAlgorithm;
+    bool m_livePushPending;  // edits in this event loop pass are published once
 
     // Helper methods
+    // Single run behind runFusion() and runFusionWithConfidence(); confidences may be empty
+    void startFusion(const QVariantList &agentValues, const QVariantList &confidences,
+                     const QString &scriptName);
     void startComparison();
     void updateComparisonStats();
+    quint64 submitScript(const QString &scriptName);
+    quint64 submitNative(const QString &scriptName);
+    // Reads pipelineName and resolves the scripts of its stages
+    bool loadPipeline(const QString &pipelineName, FusionPipeline &pipeline, QString &errorMsg) const;
+    // 0 with errorMsg set if the pipeline cannot run
+    quint64 submitPipeline(const QString &pipelineName, QString &errorMsg);
+    bool parseScriptOutput(int exitCode, const QByteArray &output, const QString &errorOutput,
+                           double &fusedValue, double &resultConfidence, QString &errorMsg,
+                           qint64 *computeNs = nullptr);
+    // stages: ns per stage plus "total", see scriptStages()
+    void finishSingleFusion(const QString &scriptName, bool ok, double fusedValue,
+                            double resultConfidence, const QVariantMap &stages,
+                            const QString &errorMsg, bool timedOut = false);
+    NativeFusionResult runNative(const QString &scriptName, QVariantMap &stages) const;
+    void routeResult(quint64 requestId, bool ok, double fusedValue, double resultConfidence,
+                     const QVariantMap &stages, const QString &errorMsg, bool timedOut);
+    void recordComparisonResult(const QString &scriptName, bool ok, double fusedValue,
+                                double resultConfidence, const QVariantMap &stages,
+                                const QString &errorMsg, bool timedOut = false);
+    QVariantMap scriptStages(const RequestTiming &timing, const QVariantMap &timings,
+                             qint64 received, qint64 parseNs, qint64 computeNs) const;
+    static QVariantMap cachedStages(qint64 lookupNs);
+    static double stagesToMs(const QVariantMap &stages);
+    static QVariantList orderedStages(const QVariantMap &stages);
+    QString requestScriptName(quint64 requestId) const;
+    void onRequestDeadline(quint64 requestId, int timeout);
+    void cancelRequest(quint64 requestId);
+    void forgetRequest(quint64 requestId);
+    void scheduleLivePush();
+    void pushLiveResult();
+    QString resolveScriptPath(const QString &scriptName) const;
+    void finishBatchChunk(quint64 requestId, int exitCode,
+                          const QByteArray &output, const QString &errorOutput);
+    void recordBatchResult(int caseIndex, bool ok, double fusedValue,
+                           double resultConfidence, const QString &errorMsg);
+    void finishBatch();
+    // Hashes the agent set once per m_inputGeneration; every script after
+    // the first only adds its own name and source hash
+    QByteArray resultCacheKey(const QString &scriptName);
+    bool lookupCachedResult(const QByteArray &key, FusionResultCache::Entry &entry);
+    void storeCachedResult(const QByteArray &key, double fusedValue, double resultConfidence);
 
     // Statistics
     double m_meanValue;
@@ -137,9 +335,6 @@ private:
     int m_comparisonProgressTotal;
     int m_comparisonProgressCurrent;
 
-    QJsonObject createJsonForPython(const QVariantList &values,
-                                    const QVariantList &confidences = QVariantList());
-    void sendToPython(const QJsonObject &jsonData, const QString &scriptName);
     HistoryManager* m_historyManager;
     QString m_currentFusionScript;
     QVariantList m_currentAgentConfidences;
@@ -0,0 +1,77 @@
+#include "engineoptions.h"
+#include "decisionengine.h"
+#include "fusionpipeline.h"
+#include "historymanager.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QThread>
+
+namespace EngineOptions {
+
+namespace {
+
+// GDSS_SCRIPTS, else a scripts directory next to the executable
+QString defaultScriptDirectory()
+{
+    QString fromEnvironment = qEnvironmentVariable("GDSS_SCRIPTS");
+    if (!fromEnvironment.isEmpty()) {
+        return fromEnvironment;
+    }
+    QDir besideBinary(QCoreApplication::applicationDirPath());
+    return besideBinary.exists("scripts") ? besideBinary.filePath("scripts") : QString();
+}
+
+} // namespace
+
+void addTo(QCommandLineParser &parser)
+{
+    parser.addOptions({
+        QCommandLineOption(QStringList() << "s" << "scripts",
+                           "Directory holding the fusion scripts (default: $GDSS_SCRIPTS "
+                           "or ./scripts next to the executable).",
+                           "dir"),
+        QCommandLineOption(QStringList() << "j" << "jobs",
+                           "Python workers to run side by side (default: one per core).", "n"),
+        QCommandLineOption("python", "Python interpreter (default: python).", "program"),
+        QCommandLineOption("timeout", "Deadline per script run in ms, 0 for none.", "ms"),
+        QCommandLineOption("no-native", "Run every algorithm through its Python script."),
+        QCommandLineOption("history-backend",
+                           "Where results are recorded: json or sqlite (default: "
+                           "$GDSS_HISTORY_BACKEND or json).",
+                           "backend"),
+    });
+}
+
+void apply(const QCommandLineParser &parser, DecisionEngine &engine)
+{
+    QString scriptDirectory = parser.isSet("scripts") ? parser.value("scripts")
+                                                      : defaultScriptDirectory();
+    if (!scriptDirectory.isEmpty()) {
+        engine.setScriptBasePath(QDir(scriptDirectory).absolutePath());
+    }
+
+    engine.setWorkerPoolSize(parser.isSet("jobs") ? parser.value("jobs").toInt()
+                                                  : QThread::idealThreadCount());
+    engine.setNativeFusionEnabled(!parser.isSet("no-native"));
+
+    if (parser.isSet("python")) {
+        engine.setPythonProgram(parser.value("python"));
+    }
+    if (parser.isSet("timeout")) {
+        engine.setScriptTimeout(parser.value("timeout").toInt());
+    }
+    if (parser.isSet("history-backend")) {
+        engine.historyManager()->setStorageBackend(parser.value("history-backend"));
+    }
+}
+
+QString scriptFileName(const QString &algorithm)
+{
+    // Pipelines are named by their definition file
+    if (algorithm.endsWith(".py") || FusionPipeline::isPipelineName(algorithm)) {
+        return algorithm;
+    }
+    return algorithm + ".py";
+}
+
+} // namespace EngineOptions
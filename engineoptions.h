@@ -0,0 +1,21 @@
+#ifndef ENGINEOPTIONS_H
+#define ENGINEOPTIONS_H
+
+#include <QCommandLineParser>
+
+class DecisionEngine;
+
+// Command-line options the console tools (gdss-cli, gdss-service) share for
+// setting up their DecisionEngine: --scripts, --jobs, --python, --timeout,
+// --no-native and --history-backend.
+namespace EngineOptions {
+
+void addTo(QCommandLineParser &parser);
+void apply(const QCommandLineParser &parser, DecisionEngine &engine);
+
+// "weighted" -> "weighted.py"; names ending in .py or .pipeline.json are kept
+QString scriptFileName(const QString &algorithm);
+
+} // namespace EngineOptions
+
+#endif // ENGINEOPTIONS_H
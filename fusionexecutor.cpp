@@ -0,0 +1,756 @@
+#include "fusionexecutor.h"
+#include "pythonworkerpool.h"
+#include "nativefusion.h"
+#include "fusionframe.h"
+#include "sharedagentbuffer.h"
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QVector>
+
+namespace {
+
+void addStage(QVariantMap &stages, const char *stage, qint64 ns)
+{
+    if (ns > 0) {
+        stages[stage] = stages.value(stage).toLongLong() + ns;
+    }
+}
+
+// Splits a worker round trip the way DecisionEngine::scriptStages() does;
+// whatever the pool and worker timings do not cover is transfer
+void addWorkerStages(QVariantMap &stages, const QVariantMap &timings, qint64 roundTrip)
+{
+    const qint64 load = timings.value("load_ns").toLongLong();
+    const qint64 call = timings.value("call_ns").toLongLong();
+    qint64 accounted = 0;
+    auto account = [&stages, &accounted](const char *stage, qint64 ns) {
+        addStage(stages, stage, ns);
+        accounted += qMax<qint64>(0, ns);
+    };
+    account("queue", timings.value("queue_ns").toLongLong());
+    account("start", timings.value("start_ns").toLongLong());
+    account("write", timings.value("write_ns").toLongLong());
+    account("read", timings.value("read_ns").toLongLong());
+    account("load", load);
+    account("compute", call);
+    account("worker", timings.value("run_ns").toLongLong() - load - call);
+    addStage(stages, "transfer", roundTrip - accounted);
+}
+
+} // namespace
+
+FusionExecutor::FusionExecutor(QObject *parent)
+    : QObject(parent),
+    m_pool(new PythonWorkerPool(this)),
+    m_binaryFramingEnabled(true),
+    m_sharedMemoryEnabled(true),
+    m_encodedGeneration(0)
+{
+    connect(m_pool, &PythonWorkerPool::requestStarted, this, &FusionExecutor::onRequestStarted);
+    connect(m_pool, &PythonWorkerPool::requestFinished, this, &FusionExecutor::onRequestFinished);
+    connect(m_pool, &PythonWorkerPool::workerError, this, &FusionExecutor::workerError);
+}
+
+FusionExecutor::~FusionExecutor()
+{
+    shutdown();
+}
+
+quint64 FusionExecutor::reserveRequestId()
+{
+    return m_pool->reserveRequestId();
+}
+
+// ========== CONFIGURATION ==========
+
+void FusionExecutor::setPoolSize(int size)
+{
+    m_pool->setPoolSize(size);
+}
+
+void FusionExecutor::setPythonProgram(const QString &program)
+{
+    m_pool->setPythonProgram(program);
+}
+
+void FusionExecutor::setWorkerScript(const QString &path)
+{
+    m_pool->setWorkerScript(path);
+}
+
+void FusionExecutor::setProcessEnvironment(const QProcessEnvironment &environment)
+{
+    m_pool->setProcessEnvironment(environment);
+}
+
+void FusionExecutor::setBinaryFramingEnabled(bool enabled)
+{
+    m_binaryFramingEnabled = enabled;
+}
+
+void FusionExecutor::setSharedMemoryEnabled(bool enabled)
+{
+    m_sharedMemoryEnabled = enabled;
+}
+
+// ========== RUNS ==========
+
+void FusionExecutor::runScript(quint64 requestId, const QString &scriptPath, const Input &input)
+{
+    QElapsedTimer timer;
+    timer.start();
+    ScriptInput encoded = encode(scriptPath, input);
+    m_encodeTimes.insert(requestId, timer.nsecsElapsed());
+
+    if (encoded.shared) {
+        qDebug() << "Running Python script:" << scriptPath << "on shared segment" << encoded.shared->path();
+        m_pool->submitShared(scriptPath, encoded.shared->path(), encoded.shared->size(),
+                             encoded.entry, requestId);
+        m_requestSegments.insert(requestId, encoded.shared);
+    } else {
+        qDebug() << "Running Python script:" << scriptPath << "with" << encoded.data.size()
+                 << "bytes" << (encoded.entry.isEmpty() ? "of JSON" : "in a binary frame");
+        m_pool->submit(scriptPath, encoded.data, encoded.entry, requestId);
+    }
+}
+
+void FusionExecutor::runBatchChunk(quint64 requestId, const QString &scriptPath, const QVariantList &cases)
+{
+    QJsonArray chunk;
+    for (const QVariant &item : cases) {
+        QVariantList values;
+        QVariantList confidences;
+        splitBatchCase(item, values, confidences);
+        chunk.append(createJsonForPython(values, confidences));
+    }
+
+    QJsonObject root;
+    root["cases"] = chunk;
+    m_pool->submit(scriptPath, QJsonDocument(root).toJson(QJsonDocument::Compact), "fuse_batch", requestId);
+}
+
+void FusionExecutor::runNative(quint64 requestId, const QString &scriptName, const Input &input)
+{
+    QVariantMap stages;
+    NativeFusionResult result = fuseNative(scriptName, input.values, input.confidences, stages);
+    emit nativeFinished(requestId, result.ok, result.fused, result.confidence, result.errorMessage, stages);
+}
+
+void FusionExecutor::runNativeBatch(quint64 requestId, const QString &scriptName, const QVariantList &cases)
+{
+    QVector<double> values;
+    QVector<double> confidences;
+    QVariantList results;
+    results.reserve(cases.size());
+
+    for (const QVariant &item : cases) {
+        QVariantList caseValues;
+        QVariantList caseConfidences;
+        splitBatchCase(item, caseValues, caseConfidences);
+        bool hasConfidences = !caseConfidences.isEmpty() && caseConfidences.size() == caseValues.size();
+
+        values.resize(caseValues.size());
+        for (int j = 0; j < caseValues.size(); ++j) {
+            values[j] = caseValues[j].toDouble();
+        }
+        confidences.resize(hasConfidences ? caseConfidences.size() : 0);
+        for (int j = 0; j < confidences.size(); ++j) {
+            confidences[j] = caseConfidences[j].toDouble();
+        }
+
+        NativeFusionResult result = NativeFusion::run(scriptName, values.constData(),
+                                                      hasConfidences ? confidences.constData() : nullptr,
+                                                      values.size());
+        QVariantMap reply;
+        reply["ok"] = result.ok;
+        reply["fused"] = result.fused;
+        reply["confidence"] = result.confidence;
+        if (!result.ok) {
+            reply["error"] = result.errorMessage;
+        }
+        results.append(reply);
+    }
+
+    emit nativeBatchFinished(requestId, results);
+}
+
+void FusionExecutor::cancel(quint64 requestId, const QString &reason)
+{
+    // A pipeline is waiting on its Python segment, if anything; the pool
+    // fails the segment, which fails the pipeline
+    auto run = m_pipelineRuns.constFind(requestId);
+    if (run != m_pipelineRuns.constEnd()) {
+        if (run->segment != 0) {
+            m_pool->cancel(run->segment, reason);
+        }
+        return;
+    }
+
+    // Native runs cannot be interrupted; their late reply is ignored as stale
+    m_pool->cancel(requestId, reason);
+}
+
+void FusionExecutor::shutdown()
+{
+    // Stop the workers without reporting their requests as failures
+    m_pool->disconnect(this);
+    m_pool->shutdown();
+    m_encoded.clear();
+    m_encodeTimes.clear();
+    m_requestSegments.clear();
+    m_pipelineRuns.clear();
+    m_pipelineSegments.clear();
+    m_criteriaRuns.clear();
+}
+
+void FusionExecutor::onRequestStarted(quint64 requestId)
+{
+    // A pipeline's deadline runs from its first Python segment
+    auto segment = m_pipelineSegments.constFind(requestId);
+    if (segment == m_pipelineSegments.constEnd()) {
+        emit requestStarted(requestId);
+        return;
+    }
+    auto run = m_pipelineRuns.find(segment.value());
+    if (run != m_pipelineRuns.end() && !run->started) {
+        run->started = true;
+        emit requestStarted(segment.value());
+    }
+}
+
+void FusionExecutor::onRequestFinished(quint64 requestId, int exitCode, const QByteArray &output,
+                                       const QString &errorOutput, const QVariantMap &timings)
+{
+    if (m_pipelineSegments.contains(requestId)) {
+        onPipelineSegmentFinished(requestId, exitCode, output, errorOutput, timings);
+        return;
+    }
+    if (m_criteriaRuns.contains(requestId)) {
+        onCriteriaRequestFinished(requestId, exitCode, output, errorOutput, timings);
+        return;
+    }
+
+    // The worker is done with the shared segment; the last run using it deletes it
+    m_requestSegments.remove(requestId);
+
+    QVariantMap allTimings = timings;
+    auto encodeTime = m_encodeTimes.constFind(requestId);
+    if (encodeTime != m_encodeTimes.constEnd()) {
+        allTimings["encode_ns"] = encodeTime.value();
+        m_encodeTimes.erase(encodeTime);
+
+        // Nothing else reads the encodings once every run of the set is done
+        if (m_encodeTimes.isEmpty()) {
+            m_encoded.clear();
+        }
+    }
+
+    emit requestFinished(requestId, exitCode, output, errorOutput, allTimings);
+}
+
+// ========== PIPELINES ==========
+
+void FusionExecutor::runPipeline(quint64 requestId, const FusionPipeline &pipeline, const Input &input)
+{
+    PipelineRun run;
+    run.pipeline = pipeline;
+    run.clock.start();
+
+    // Unpacked once; the ops filter these arrays in place from here on
+    run.values.reserve(input.values.size());
+    for (const QVariant &value : input.values) {
+        run.values.append(value.toDouble());
+    }
+    if (FusionFrame::hasConfidences(input.values, input.confidences)) {
+        run.confidences.reserve(input.confidences.size());
+        for (const QVariant &confidence : input.confidences) {
+            run.confidences.append(confidence.toDouble());
+        }
+    }
+    addStage(run.stages, "encode", run.clock.nsecsElapsed());
+
+    m_pipelineRuns.insert(requestId, run);
+    advancePipeline(requestId);
+}
+
+void FusionExecutor::advancePipeline(quint64 requestId)
+{
+    PipelineRun &run = m_pipelineRuns[requestId];
+    const QVector<FusionPipeline::Stage> &stages = run.pipeline.stages;
+
+    while (run.next < stages.size()) {
+        const FusionPipeline::Stage &stage = stages[run.next];
+        if (!stage.native) {
+            submitPipelineSegment(requestId, run);
+            return;
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+        QString errorMessage;
+        if (run.fused) {
+            FusionPipeline::applyOp(stage, run.fusedValue);
+        } else if (stage.kind == FusionPipeline::Stage::Fuse) {
+            NativeFusionResult result = NativeFusion::run(stage.name, run.values.constData(),
+                                                          run.confidences.isEmpty() ? nullptr : run.confidences.constData(),
+                                                          run.values.size());
+            if (!result.ok) {
+                finishPipeline(requestId, result.errorMessage);
+                return;
+            }
+            run.fused = true;
+            run.fusedValue = result.fused;
+            run.confidence = result.confidence;
+        } else if (!FusionPipeline::applyOp(stage, run.values, run.confidences, &errorMessage)) {
+            finishPipeline(requestId, errorMessage);
+            return;
+        }
+        addStage(run.stages, "compute", timer.nsecsElapsed());
+        run.next++;
+    }
+
+    finishPipeline(requestId, QString());
+}
+
+void FusionExecutor::submitPipelineSegment(quint64 requestId, PipelineRun &run)
+{
+    // Every Python stage up to the next native one goes in one request
+    const QVector<FusionPipeline::Stage> &stages = run.pipeline.stages;
+    QVariantList segment;
+    int end = run.next;
+    while (end < stages.size() && !stages[end].native) {
+        QVariantMap stage;
+        stage["path"] = stages[end].path;
+        stage["call"] = stages[end].kind == FusionPipeline::Stage::Transform ? "transform" : "fuse";
+        segment.append(stage);
+        end++;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    QByteArray frame = FusionFrame::encode(run.values.constData(),
+                                           run.confidences.isEmpty() ? nullptr : run.confidences.constData(),
+                                           run.values.size(), FusionFrame::ItemType::Float64);
+    addStage(run.stages, "encode", timer.nsecsElapsed());
+
+    run.segment = m_pool->reserveRequestId();
+    run.segmentEnd = end;
+    run.segmentSubmitted = run.clock.nsecsElapsed();
+    m_pipelineSegments.insert(run.segment, requestId);
+
+    qDebug() << "Running pipeline" << run.pipeline.name << "stages" << run.next + 1 << "to" << end
+             << "in one worker request";
+    m_pool->submitPipeline(segment, frame, run.segment);
+}
+
+void FusionExecutor::onPipelineSegmentFinished(quint64 segmentId, int exitCode, const QByteArray &output,
+                                               const QString &errorOutput, const QVariantMap &timings)
+{
+    const quint64 requestId = m_pipelineSegments.take(segmentId);
+    auto it = m_pipelineRuns.find(requestId);
+    if (it == m_pipelineRuns.end()) {
+        return;
+    }
+    PipelineRun &run = it.value();
+    run.segment = 0;
+
+    addWorkerStages(run.stages, timings, run.clock.nsecsElapsed() - run.segmentSubmitted);
+
+    if (exitCode != 0) {
+        finishPipeline(requestId, exitCode < 0 ? errorOutput
+                                               : QString("Pipeline stage exited with code %1. Error: %2")
+                                                     .arg(exitCode).arg(errorOutput));
+        return;
+    }
+    if (!errorOutput.isEmpty()) {
+        qDebug() << "Pipeline STDERR:" << errorOutput;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    QJsonParseError parseError;
+    QJsonObject result = QJsonDocument::fromJson(output, &parseError).object();
+    if (parseError.error != QJsonParseError::NoError) {
+        finishPipeline(requestId, QString("Failed to parse pipeline output: %1").arg(parseError.errorString()));
+        return;
+    }
+
+    if (run.pipeline.stages[run.segmentEnd - 1].kind == FusionPipeline::Stage::Fuse) {
+        run.fused = true;
+        run.fusedValue = result.value("fused").toDouble();
+        run.confidence = result.value("confidence").toDouble(1.0);
+    } else {
+        // The segment ended on a transform; native stages carry on with its arrays
+        const QJsonArray values = result.value("values").toArray();
+        const QJsonArray confidences = result.value("confidences").toArray();
+        run.values.resize(values.size());
+        for (qsizetype i = 0; i < values.size(); ++i) {
+            run.values[i] = values[i].toDouble();
+        }
+        run.confidences.resize(confidences.size() == values.size() ? confidences.size() : 0);
+        for (qsizetype i = 0; i < run.confidences.size(); ++i) {
+            run.confidences[i] = confidences[i].toDouble();
+        }
+    }
+    addStage(run.stages, "parse", timer.nsecsElapsed());
+
+    run.next = run.segmentEnd;
+    advancePipeline(requestId);
+}
+
+void FusionExecutor::finishPipeline(quint64 requestId, const QString &errorMessage)
+{
+    PipelineRun run = m_pipelineRuns.take(requestId);
+
+    // Waiting for a free worker is shown, but not charged to the pipeline
+    run.stages["total"] = run.clock.nsecsElapsed() - run.stages.value("queue").toLongLong();
+
+    bool ok = errorMessage.isEmpty() && run.fused;
+    qDebug() << "Pipeline" << run.pipeline.name << (ok ? "->" : "failed:")
+             << (ok ? QString::number(run.fusedValue) : errorMessage);
+    emit pipelineFinished(requestId, ok, run.fusedValue, run.confidence,
+                          ok ? QString() : errorMessage, run.stages);
+}
+
+// ========== MULTI-CRITERIA ==========
+
+void FusionExecutor::runCriteria(quint64 requestId, const QString &scriptName, const QString &scriptPath,
+                                 bool native, const CriteriaTable &table)
+{
+    CriteriaRun run;
+    run.criteria = table.criteria();
+    run.clock.start();
+
+    if (native) {
+        const QVector<NativeFusionResult> fused = NativeFusion::run(scriptName, table);
+        const qint64 computed = run.clock.nsecsElapsed();
+
+        QVariantList results;
+        results.reserve(fused.size());
+        for (int k = 0; k < fused.size(); ++k) {
+            QVariantMap result;
+            result["criterion"] = run.criteria.value(k);
+            result["ok"] = fused[k].ok;
+            result["fused"] = fused[k].fused;
+            result["confidence"] = fused[k].confidence;
+            if (!fused[k].ok) {
+                result["error"] = fused[k].errorMessage;
+            }
+            results.append(result);
+        }
+
+        // The table is already columnar, so there is nothing to encode
+        run.stages["compute"] = computed;
+        run.stages["total"] = computed;
+        qDebug() << "Native fusion" << scriptName << "of" << table.agentCount() << "agents x"
+                 << table.criteriaCount() << "criteria in" << computed / 1e6 << "ms";
+        emit criteriaFinished(requestId, results, QString(), run.stages);
+        return;
+    }
+
+    // The worker takes any script: fuse_matrix() gets every criterion in one
+    // call, fuse() one per criterion, and scripts with neither run as __main__
+    PythonWorkerPool::ScriptCapabilities capabilities;
+    FusionFrame::ItemType type = FusionFrame::ItemType::Float64;
+    if (m_pool->scriptCapabilities(scriptPath, capabilities)) {
+        type = FusionFrame::itemTypeFromName(capabilities.dtype);
+    }
+
+    QByteArray frame;
+    if (!m_binaryFramingEnabled) {
+        // The same table as JSON text; the worker takes either
+        frame = QJsonDocument(createJsonForPython(table)).toJson(QJsonDocument::Compact);
+    } else if (m_sharedMemoryEnabled && table.cellCount() >= SHARED_MEMORY_MIN_AGENTS) {
+        QSharedPointer<SharedAgentBuffer> shared(new SharedAgentBuffer);
+        if (shared->write(table, type)) {
+            run.shared = shared;
+        } else {
+            qDebug() << "Shared segment unavailable, piping the frame:" << shared->errorString();
+        }
+    }
+    if (m_binaryFramingEnabled && !run.shared) {
+        frame = FusionFrame::encodeCriteria(table.cells(), table.confidences(), table.agentCount(),
+                                            table.criteriaCount(), type);
+    }
+    addStage(run.stages, "encode", run.clock.nsecsElapsed());
+    run.submitted = run.clock.nsecsElapsed();
+
+    // Tracked before submitting, in case the pool fails the request right away
+    m_criteriaRuns.insert(requestId, run);
+
+    qDebug() << "Running Python script:" << scriptPath << "on" << table.agentCount() << "agents x"
+             << table.criteriaCount() << "criteria";
+    if (run.shared) {
+        m_pool->submitShared(scriptPath, run.shared->path(), run.shared->size(), "fuse_criteria", requestId);
+    } else {
+        m_pool->submit(scriptPath, frame, "fuse_criteria", requestId);
+    }
+}
+
+void FusionExecutor::onCriteriaRequestFinished(quint64 requestId, int exitCode, const QByteArray &output,
+                                               const QString &errorOutput, const QVariantMap &timings)
+{
+    CriteriaRun run = m_criteriaRuns.take(requestId);
+    addWorkerStages(run.stages, timings, run.clock.nsecsElapsed() - run.submitted);
+
+    QString errorMessage;
+    QJsonArray replies;
+    QElapsedTimer timer;
+    timer.start();
+
+    if (exitCode < 0) {
+        errorMessage = errorOutput;
+    } else if (exitCode != 0) {
+        errorMessage = QString("Python script exited with code %1. Error: %2")
+                           .arg(exitCode)
+                           .arg(errorOutput.isEmpty() ? QString("Unknown error") : errorOutput);
+    } else {
+        if (!errorOutput.isEmpty()) {
+            qDebug() << "Python STDERR:" << errorOutput;
+        }
+
+        QJsonParseError parseError;
+        QJsonDocument document = QJsonDocument::fromJson(output, &parseError);
+        if (parseError.error != QJsonParseError::NoError || !document.isObject()) {
+            errorMessage = QString("Failed to parse multi-criteria reply from Python: %1")
+                               .arg(parseError.errorString());
+        } else {
+            replies = document.object().value("criteria").toArray();
+            if (replies.size() != run.criteria.size()) {
+                errorMessage = QString("Reply has %1 results for %2 criteria.")
+                                   .arg(replies.size()).arg(run.criteria.size());
+            }
+        }
+    }
+
+    QVariantList results;
+    results.reserve(run.criteria.size());
+    for (int k = 0; k < run.criteria.size(); ++k) {
+        QVariantMap result;
+        result["criterion"] = run.criteria[k];
+
+        QJsonObject reply = errorMessage.isEmpty() ? replies[k].toObject() : QJsonObject();
+        QString error = errorMessage;
+        if (error.isEmpty() && (reply.contains("error") || !reply.value("fused").isDouble())) {
+            error = reply.value("error").toString();
+            if (error.isEmpty()) {
+                error = "Python returned no fused value.";
+            }
+        }
+
+        result["ok"] = error.isEmpty();
+        result["fused"] = error.isEmpty() ? reply.value("fused").toDouble() : 0.0;
+        result["confidence"] = reply.value("confidence").toDouble(1.0);
+        if (!error.isEmpty()) {
+            result["error"] = error;
+        }
+        results.append(result);
+    }
+    addStage(run.stages, "parse", timer.nsecsElapsed());
+
+    // Waiting for a free worker is shown, but not charged to the run
+    run.stages["total"] = run.clock.nsecsElapsed() - run.stages.value("queue").toLongLong();
+    emit criteriaFinished(requestId, results, errorMessage, run.stages);
+}
+
+// ========== ENCODING ==========
+
+FusionExecutor::ScriptInput FusionExecutor::encode(const QString &scriptPath, const Input &input)
+{
+    if (input.generation != m_encodedGeneration) {
+        m_encoded.clear();
+        m_encodedGeneration = input.generation;
+    }
+
+    // Scripts the pool has not described yet get JSON; that first reply
+    // tells us whether fuse() takes binary frames and in which precision
+    PythonWorkerPool::ScriptCapabilities capabilities;
+    bool binary = m_binaryFramingEnabled
+                  && m_pool->scriptCapabilities(scriptPath, capabilities)
+                  && capabilities.entries.contains("fuse");
+
+    QString format = binary ? capabilities.dtype : QString("json");
+
+    // Scripts sharing a format share one encoding of the input
+    auto it = m_encoded.constFind(format);
+    if (it != m_encoded.constEnd()) {
+        return it.value();
+    }
+
+    ScriptInput encoded;
+    if (binary) {
+        encoded.entry = "fuse";
+        FusionFrame::ItemType type = FusionFrame::itemTypeFromName(format);
+
+        // Large frames are written once into a shared segment the workers map
+        if (m_sharedMemoryEnabled && input.values.size() >= SHARED_MEMORY_MIN_AGENTS) {
+            QSharedPointer<SharedAgentBuffer> shared(new SharedAgentBuffer);
+            if (shared->write(input.values, input.confidences, type)) {
+                encoded.shared = shared;
+            } else {
+                qDebug() << "Shared segment unavailable, piping the frame:" << shared->errorString();
+            }
+        }
+
+        if (!encoded.shared) {
+            encoded.data = FusionFrame::encode(input.values, input.confidences, type);
+        }
+    } else {
+        encoded.data = QJsonDocument(createJsonForPython(input.values, input.confidences))
+                           .toJson(QJsonDocument::Compact);
+    }
+    m_encoded.insert(format, encoded);
+    return encoded;
+}
+
+NativeFusionResult FusionExecutor::fuseNative(const QString &scriptName, const QVariantList &values,
+                                              const QVariantList &confidences, QVariantMap &stages)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    bool hasConfidences = !confidences.isEmpty() && confidences.size() == values.size();
+
+    // Unpack into contiguous arrays for the SIMD kernels
+    QVector<double> valueArray;
+    QVector<double> confidenceArray;
+    valueArray.reserve(values.size());
+    for (const QVariant &value : values) {
+        valueArray.append(value.toDouble());
+    }
+    if (hasConfidences) {
+        confidenceArray.reserve(confidences.size());
+        for (const QVariant &confidence : confidences) {
+            confidenceArray.append(confidence.toDouble());
+        }
+    }
+
+    const qint64 unpacked = timer.nsecsElapsed();
+    NativeFusionResult result = NativeFusion::run(scriptName, valueArray.constData(),
+                                                  hasConfidences ? confidenceArray.constData() : nullptr,
+                                                  valueArray.size());
+    const qint64 computed = timer.nsecsElapsed();
+
+    stages.clear();
+    stages["encode"] = unpacked;
+    stages["compute"] = computed - unpacked;
+    stages["total"] = computed;
+
+    qDebug() << "Native fusion" << scriptName << "->" << result.fused << "in" << computed / 1e6 << "ms";
+    return result;
+}
+
+QJsonObject FusionExecutor::createJsonForPython(const QVariantList &values,
+                                                const QVariantList &confidences)
+{
+    QJsonArray valuesArray;
+    QJsonArray confidencesArray;
+
+    // Add values
+    for (const QVariant &v : values) {
+        valuesArray.append(v.toDouble());
+    }
+
+    // Add confidences if provided
+    bool hasConfidences = !confidences.isEmpty() && (confidences.size() == values.size());
+    for (const QVariant &c : confidences) {
+        confidencesArray.append(c.toDouble());
+    }
+
+    QJsonObject root;
+    root["values"] = valuesArray;
+    root["agent_count"] = static_cast<int>(values.size());
+
+    if (hasConfidences) {
+        root["confidences"] = confidencesArray;
+    }
+
+    return root;
+}
+
+bool FusionExecutor::parseResult(const QByteArray &output, double &fusedValue,
+                                 double &resultConfidence, QString &errorMsg, qint64 *computeNs)
+{
+    // Parse JSON response
+    QJsonParseError parseError;
+    QJsonDocument doc = QJsonDocument::fromJson(output, &parseError);
+
+    if (parseError.error != QJsonParseError::NoError) {
+        errorMsg = QString("Failed to parse JSON from Python: %1").arg(parseError.errorString());
+        return false;
+    }
+
+    if (!doc.isObject()) {
+        errorMsg = "Python did not return a valid JSON object.";
+        return false;
+    }
+
+    QJsonObject result = doc.object();
+
+    if (result.contains("fused")) {
+        QJsonValue fusedJson = result["fused"];
+        if (fusedJson.isDouble()) {
+            fusedValue = fusedJson.toDouble();
+        }
+    }
+
+    // Check if Python returned confidence
+    if (result.contains("confidence")) {
+        QJsonValue confidenceJson = result["confidence"];
+        if (confidenceJson.isDouble()) {
+            resultConfidence = confidenceJson.toDouble();
+        }
+    }
+
+    // Scripts may time their algorithm themselves
+    if (computeNs && result["compute_ns"].isDouble()) {
+        *computeNs = static_cast<qint64>(result["compute_ns"].toDouble());
+    }
+
+    return true;
+}
+
+QJsonObject FusionExecutor::createJsonForPython(const CriteriaTable &table)
+{
+    QJsonArray criteria;
+    for (int k = 0; k < table.criteriaCount(); ++k) {
+        const double *column = table.column(k);
+        QJsonArray values;
+        for (qsizetype i = 0; i < table.agentCount(); ++i) {
+            values.append(column[i]);
+        }
+        criteria.append(values);
+    }
+
+    QJsonObject root;
+    root["criteria"] = criteria;
+    root["agent_count"] = static_cast<int>(table.agentCount());
+
+    if (table.hasConfidences()) {
+        const double *confidences = table.confidences();
+        QJsonArray confidencesArray;
+        for (qsizetype i = 0; i < table.agentCount(); ++i) {
+            confidencesArray.append(confidences[i]);
+        }
+        root["confidences"] = confidencesArray;
+    }
+
+    return root;
+}
+
+void FusionExecutor::splitBatchCase(const QVariant &item, QVariantList &values,
+                                    QVariantList &confidences)
+{
+    // A case is either a plain list of values or {values, confidences}
+    if (item.typeId() == QMetaType::QVariantMap) {
+        QVariantMap map = item.toMap();
+        values = map.value("values").toList();
+        confidences = map.value("confidences").toList();
+    } else {
+        values = item.toList();
+        confidences.clear();
+    }
+}
@@ -0,0 +1,174 @@
+#ifndef FUSIONEXECUTOR_H
+#define FUSIONEXECUTOR_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QJsonObject>
+#include <QProcessEnvironment>
+#include <QSharedPointer>
+#include <QString>
+#include <QVariantList>
+#include <QVariantMap>
+#include <QVector>
+#include "criteriatable.h"
+#include "fusionpipeline.h"
+
+struct NativeFusionResult;
+class PythonWorkerPool;
+class SharedAgentBuffer;
+
+// The expensive half of DecisionEngine, run on a thread of its own.
+//
+// Encoding agent sets (JSON, binary frames, shared segments), the Python
+// worker pool with its processes and pipes, and native fusion of large
+// inputs all happen here, so a comparison over a million agents never
+// stalls the thread the engine and QML live on. DecisionEngine keeps all
+// the state its properties expose and only talks to the executor through
+// queued calls; the results come back through queued signals.
+//
+// Request ids are taken with reserveRequestId(), which is thread safe, so
+// the engine can track a request before the executor has even seen it.
+// Everything else must be called on the executor's thread.
+class FusionExecutor : public QObject
+{
+    Q_OBJECT
+
+public:
+    // One agent set; every script of a run gets the same one
+    struct Input {
+        QVariantList values;
+        QVariantList confidences;
+        quint64 generation = 0;  // changes whenever the agent set does
+    };
+
+    explicit FusionExecutor(QObject *parent = nullptr);
+    ~FusionExecutor();
+
+    quint64 reserveRequestId();
+
+    // Configuration
+    void setPoolSize(int size);
+    void setPythonProgram(const QString &program);
+    void setWorkerScript(const QString &path);
+    void setProcessEnvironment(const QProcessEnvironment &environment);
+    void setBinaryFramingEnabled(bool enabled);
+    void setSharedMemoryEnabled(bool enabled);
+
+    // Runs; each one is answered by requestFinished(), nativeFinished(),
+    // pipelineFinished() or criteriaFinished()
+    void runScript(quint64 requestId, const QString &scriptPath, const Input &input);
+    void runBatchChunk(quint64 requestId, const QString &scriptPath, const QVariantList &cases);
+    void runNative(quint64 requestId, const QString &scriptName, const Input &input);
+    void runNativeBatch(quint64 requestId, const QString &scriptName, const QVariantList &cases);
+    // Stage paths and the native flags must already be filled in
+    void runPipeline(quint64 requestId, const FusionPipeline &pipeline, const Input &input);
+    // Every criterion of the table with one script: natively, or in one
+    // worker request over a multi-criteria frame (JSON when binary framing
+    // is off)
+    void runCriteria(quint64 requestId, const QString &scriptName, const QString &scriptPath,
+                     bool native, const CriteriaTable &table);
+    void cancel(quint64 requestId, const QString &reason);
+    // Stops every worker; nothing is reported for requests still running
+    void shutdown();
+
+    // Also used in place for inputs too small to be worth the thread hop.
+    // stages gets "encode" (unpacking), "compute" and "total" in ns.
+    static NativeFusionResult fuseNative(const QString &scriptName, const QVariantList &values,
+                                         const QVariantList &confidences, QVariantMap &stages);
+    static QJsonObject createJsonForPython(const QVariantList &values,
+                                           const QVariantList &confidences = QVariantList());
+    // {"criteria": [[values of criterion 0], ...], "confidences": [...]}
+    static QJsonObject createJsonForPython(const CriteriaTable &table);
+    // Reads "fused", "confidence" and "compute_ns" from a script's JSON reply;
+    // keys that are missing leave the outputs as they are
+    static bool parseResult(const QByteArray &output, double &fusedValue, double &resultConfidence,
+                            QString &errorMsg, qint64 *computeNs = nullptr);
+    // A batch case is either a plain list of values or {values, confidences}
+    static void splitBatchCase(const QVariant &item, QVariantList &values, QVariantList &confidences);
+
+signals:
+    void requestStarted(quint64 requestId);
+    // As PythonWorkerPool::requestFinished(); timings also carry "encode_ns"
+    void requestFinished(quint64 requestId, int exitCode, const QByteArray &output,
+                         const QString &errorOutput, const QVariantMap &timings);
+    void nativeFinished(quint64 requestId, bool ok, double fused, double confidence,
+                        const QString &errorMessage, const QVariantMap &stages);
+    // One {ok, fused, confidence, error} map per case, in case order
+    void nativeBatchFinished(quint64 requestId, const QVariantList &results);
+    // stages as DecisionEngine::scriptStages(), summed over every stage of the pipeline
+    void pipelineFinished(quint64 requestId, bool ok, double fused, double confidence,
+                          const QString &errorMessage, const QVariantMap &stages);
+    // One {criterion, ok, fused, confidence, error} map per criterion, in table
+    // order; errorMessage is set when the whole run failed. stages as pipelineFinished()
+    void criteriaFinished(quint64 requestId, const QVariantList &results,
+                          const QString &errorMessage, const QVariantMap &stages);
+    void workerError(const QString &message);
+
+private:
+    // What a script run is fed: bytes for the pipe or a shared segment
+    struct ScriptInput {
+        QString entry;
+        QByteArray data;
+        QSharedPointer<SharedAgentBuffer> shared;
+    };
+
+    // A pipeline between stages; the arrays are filtered in place
+    struct PipelineRun {
+        FusionPipeline pipeline;
+        int next = 0;  // first stage not run yet
+        QVector<double> values;
+        QVector<double> confidences;  // empty when the input had none
+        bool fused = false;
+        double fusedValue = 0.0;
+        double confidence = 1.0;
+        QVariantMap stages;  // ns per stage
+        QElapsedTimer clock;
+        // The Python segment in flight
+        quint64 segment = 0;  // pool request id, 0 when none
+        int segmentEnd = 0;  // stage after the segment
+        qint64 segmentSubmitted = 0;  // ns on clock
+        bool started = false;  // a segment has reached a worker
+    };
+
+    // A multi-criteria run waiting on its worker
+    struct CriteriaRun {
+        QStringList criteria;
+        QVariantMap stages;  // ns per stage
+        QElapsedTimer clock;
+        qint64 submitted = 0;  // ns on clock
+        QSharedPointer<SharedAgentBuffer> shared;  // kept until the reply
+    };
+
+    ScriptInput encode(const QString &scriptPath, const Input &input);
+    void advancePipeline(quint64 requestId);
+    void submitPipelineSegment(quint64 requestId, PipelineRun &run);
+    void onPipelineSegmentFinished(quint64 segmentId, int exitCode, const QByteArray &output,
+                                   const QString &errorOutput, const QVariantMap &timings);
+    void finishPipeline(quint64 requestId, const QString &errorMessage);
+    void onCriteriaRequestFinished(quint64 requestId, int exitCode, const QByteArray &output,
+                                   const QString &errorOutput, const QVariantMap &timings);
+    void onRequestStarted(quint64 requestId);
+    void onRequestFinished(quint64 requestId, int exitCode, const QByteArray &output,
+                           const QString &errorOutput, const QVariantMap &timings);
+
+    PythonWorkerPool *m_pool;
+    bool m_binaryFramingEnabled;
+    bool m_sharedMemoryEnabled;
+
+    // Encodings of the current agent set by format ("json", "float32", ...)
+    quint64 m_encodedGeneration;
+    QHash<QString, ScriptInput> m_encoded;
+    QHash<quint64, qint64> m_encodeTimes;  // requestId -> ns spent encoding its input
+    QHash<quint64, QSharedPointer<SharedAgentBuffer>> m_requestSegments;  // kept until the reply
+    // Pipelines
+    QHash<quint64, PipelineRun> m_pipelineRuns;  // requestId -> run
+    QHash<quint64, quint64> m_pipelineSegments;  // pool requestId -> pipeline requestId
+    // Multi-criteria runs on a worker
+    QHash<quint64, CriteriaRun> m_criteriaRuns;
+
+    static const int SHARED_MEMORY_MIN_AGENTS = 65536;  // smaller inputs go through the pipe (cells for criteria)
+};
+
+#endif // FUSIONEXECUTOR_H
@@ -0,0 +1,134 @@
+#include "fusionframe.h"
+#include <QtEndian>
+#include <cstring>
+
+namespace FusionFrame {
+
+namespace {
+
+const char MAGIC[4] = { 'G', 'D', 'S', 'B' };
+const quint8 VERSION = 1;
+const quint8 CRITERIA_VERSION = 2;
+const quint8 FLAG_CONFIDENCES = 0x01;
+const qsizetype HEADER_BYTES = 16;
+const qsizetype CRITERIA_HEADER_BYTES = 24;  // + uint32 criteria count, uint32 reserved
+
+char *writeArray(char *dest, const QVariantList &items, ItemType type)
+{
+    if (type == ItemType::Float32) {
+        for (const QVariant &item : items) {
+            qToLittleEndian<float>(static_cast<float>(item.toDouble()), dest);
+            dest += sizeof(float);
+        }
+    } else {
+        for (const QVariant &item : items) {
+            qToLittleEndian<double>(item.toDouble(), dest);
+            dest += sizeof(double);
+        }
+    }
+    return dest;
+}
+
+char *writeArray(char *dest, const double *items, qsizetype count, ItemType type)
+{
+    if (type == ItemType::Float32) {
+        for (qsizetype i = 0; i < count; ++i) {
+            qToLittleEndian<float>(static_cast<float>(items[i]), dest);
+            dest += sizeof(float);
+        }
+    } else {
+        qToLittleEndian<double>(items, count, dest);
+        dest += count * sizeof(double);
+    }
+    return dest;
+}
+
+void writeHeader(char *dest, qsizetype count, bool withConfidences, ItemType type,
+                 quint8 version = VERSION)
+{
+    std::memcpy(dest, MAGIC, sizeof(MAGIC));
+    dest[4] = static_cast<char>(version);
+    dest[5] = static_cast<char>(type);
+    dest[6] = static_cast<char>(withConfidences ? FLAG_CONFIDENCES : 0);
+    dest[7] = 0;
+    qToLittleEndian<quint64>(static_cast<quint64>(count), dest + 8);
+}
+
+} // namespace
+
+ItemType itemTypeFromName(const QString &name)
+{
+    return name == "float32" ? ItemType::Float32 : ItemType::Float64;
+}
+
+bool hasConfidences(const QVariantList &values, const QVariantList &confidences)
+{
+    return !confidences.isEmpty() && confidences.size() == values.size();
+}
+
+qsizetype encodedSize(qsizetype count, bool withConfidences, ItemType type)
+{
+    return HEADER_BYTES + count * static_cast<qsizetype>(type) * (withConfidences ? 2 : 1);
+}
+
+void encodeInto(char *dest, const QVariantList &values, const QVariantList &confidences, ItemType type)
+{
+    bool withConfidences = hasConfidences(values, confidences);
+    writeHeader(dest, values.size(), withConfidences, type);
+
+    char *out = writeArray(dest + HEADER_BYTES, values, type);
+    if (withConfidences) {
+        writeArray(out, confidences, type);
+    }
+}
+
+QByteArray encode(const QVariantList &values, const QVariantList &confidences, ItemType type)
+{
+    QByteArray frame(encodedSize(values.size(), hasConfidences(values, confidences), type),
+                     Qt::Uninitialized);
+    encodeInto(frame.data(), values, confidences, type);
+    return frame;
+}
+
+QByteArray encode(const double *values, const double *confidences, qsizetype count, ItemType type)
+{
+    QByteArray frame(encodedSize(count, confidences != nullptr, type), Qt::Uninitialized);
+    char *out = frame.data();
+    writeHeader(out, count, confidences != nullptr, type);
+
+    out = writeArray(out + HEADER_BYTES, values, count, type);
+    if (confidences) {
+        writeArray(out, confidences, count, type);
+    }
+    return frame;
+}
+
+qsizetype encodedCriteriaSize(qsizetype count, int criteria, bool withConfidences, ItemType type)
+{
+    return CRITERIA_HEADER_BYTES
+           + count * static_cast<qsizetype>(type) * (criteria + (withConfidences ? 1 : 0));
+}
+
+void encodeCriteriaInto(char *dest, const double *columns, const double *confidences,
+                        qsizetype count, int criteria, ItemType type)
+{
+    writeHeader(dest, count, confidences != nullptr, type, CRITERIA_VERSION);
+    qToLittleEndian<quint32>(static_cast<quint32>(criteria), dest + 16);
+    qToLittleEndian<quint32>(0, dest + 20);
+
+    // The columns are already back to back, so they go out as one array
+    char *out = writeArray(dest + CRITERIA_HEADER_BYTES, columns, count * criteria, type);
+    if (confidences) {
+        writeArray(out, confidences, count, type);
+    }
+}
+
+QByteArray encodeCriteria(const double *columns, const double *confidences,
+                          qsizetype count, int criteria, ItemType type)
+{
+    QByteArray frame(encodedCriteriaSize(count, criteria, confidences != nullptr, type), Qt::Uninitialized);
+    encodeCriteriaInto(frame.data(), columns, confidences, count, criteria, type);
+    return frame;
+}
+
+} // namespace FusionFrame
@@ -0,0 +1,43 @@
+#ifndef FUSIONFRAME_H
+#define FUSIONFRAME_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVariantList>
+
+// Binary input frame for a script's fuse() entry point; the layout is
+// documented in scripts/gdss_worker.py. Values travel as raw little-endian
+// float32 or float64 arrays instead of JSON text, which is far cheaper to
+// produce and parse for large agent sets.
+namespace FusionFrame {
+
+enum class ItemType {
+    Float32 = 4,
+    Float64 = 8
+};
+
+// "float32" / "float64" as reported by the worker; anything else is Float64
+ItemType itemTypeFromName(const QString &name);
+
+// Confidences are included only when there is one per value
+bool hasConfidences(const QVariantList &values, const QVariantList &confidences);
+qsizetype encodedSize(qsizetype count, bool withConfidences, ItemType type);
+
+// Write a frame into dest, which must hold encodedSize() bytes
+void encodeInto(char *dest, const QVariantList &values, const QVariantList &confidences, ItemType type);
+QByteArray encode(const QVariantList &values, const QVariantList &confidences, ItemType type);
+// Same frame from contiguous arrays; confidences may be null
+QByteArray encode(const double *values, const double *confidences, qsizetype count, ItemType type);
+
+// Multi-criteria frame (version 2): columns holds the criteria's columns of
+// count values each, back to back, followed in the frame by the count
+// confidences when there are any (null otherwise)
+qsizetype encodedCriteriaSize(qsizetype count, int criteria, bool withConfidences, ItemType type);
+void encodeCriteriaInto(char *dest, const double *columns, const double *confidences,
+                        qsizetype count, int criteria, ItemType type);
+QByteArray encodeCriteria(const double *columns, const double *confidences,
+                          qsizetype count, int criteria, ItemType type);
+
+} // namespace FusionFrame
+
+#endif // FUSIONFRAME_H
@@ -0,0 +1,401 @@
+#include "fusionkernels.h"
+#include "fusionkernels_p.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+#if defined(GDSS_HAVE_SSE2)
+#include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+namespace FusionKernels {
+
+// ========== SCALAR ==========
+
+namespace {
+
+double scalarSum(const double *x, std::size_t n)
+{
+    double total = 0.0;
+    for (std::size_t i = 0; i < n; ++i)
+        total += x[i];
+    return total;
+}
+
+double scalarDot(const double *a, const double *b, std::size_t n)
+{
+    double total = 0.0;
+    for (std::size_t i = 0; i < n; ++i)
+        total += a[i] * b[i];
+    return total;
+}
+
+void scalarScale(const double *x, double *out, std::size_t n, double factor)
+{
+    for (std::size_t i = 0; i < n; ++i)
+        out[i] = x[i] * factor;
+}
+
+void scalarShiftedMoments(const double *x, std::size_t n, double shift,
+                          double &sum, double &sumSquares)
+{
+    double s = 0.0;
+    double sq = 0.0;
+    for (std::size_t i = 0; i < n; ++i) {
+        const double d = x[i] - shift;
+        s += d;
+        sq += d * d;
+    }
+    sum = s;
+    sumSquares = sq;
+}
+
+std::size_t scalarCountWithin(const double *x, std::size_t n, double center, double radius)
+{
+    std::size_t count = 0;
+    for (std::size_t i = 0; i < n; ++i)
+        count += std::fabs(x[i] - center) < radius ? 1 : 0;
+    return count;
+}
+
+std::size_t scalarCountAbove(const double *x, std::size_t n, double threshold, double &sumAbove)
+{
+    std::size_t count = 0;
+    double total = 0.0;
+    for (std::size_t i = 0; i < n; ++i) {
+        if (x[i] > threshold) {
+            count++;
+            total += x[i];
+        }
+    }
+    sumAbove = total;
+    return count;
+}
+
+void scalarClamp(double *x, std::size_t n, double lo, double hi)
+{
+    for (std::size_t i = 0; i < n; ++i)
+        x[i] = std::min(std::max(x[i], lo), hi);
+}
+
+} // namespace
+
+const KernelTable &scalarKernels()
+{
+    static const KernelTable table = {
+        scalarSum,
+        scalarDot,
+        scalarScale,
+        scalarShiftedMoments,
+        scalarCountWithin,
+        scalarCountAbove,
+        scalarClamp,
+    };
+    return table;
+}
+
+// ========== SSE2 ==========
+
+#if defined(GDSS_HAVE_SSE2)
+
+namespace {
+
+inline double horizontalSum(__m128d v)
+{
+    return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v)));
+}
+
+inline std::size_t horizontalCount(__m128i v)
+{
+    // Lanes hold negated counts (compare masks are -1)
+    alignas(16) long long lanes[2];
+    _mm_store_si128(reinterpret_cast<__m128i *>(lanes), v);
+    return static_cast<std::size_t>(-(lanes[0] + lanes[1]));
+}
+
+double sse2Sum(const double *x, std::size_t n)
+{
+    __m128d acc0 = _mm_setzero_pd();
+    __m128d acc1 = _mm_setzero_pd();
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        acc0 = _mm_add_pd(acc0, _mm_loadu_pd(x + i));
+        acc1 = _mm_add_pd(acc1, _mm_loadu_pd(x + i + 2));
+    }
+    double total = horizontalSum(_mm_add_pd(acc0, acc1));
+    for (; i < n; ++i)
+        total += x[i];
+    return total;
+}
+
+double sse2Dot(const double *a, const double *b, std::size_t n)
+{
+    __m128d acc0 = _mm_setzero_pd();
+    __m128d acc1 = _mm_setzero_pd();
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        acc0 = _mm_add_pd(acc0, _mm_mul_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+        acc1 = _mm_add_pd(acc1, _mm_mul_pd(_mm_loadu_pd(a + i + 2), _mm_loadu_pd(b + i + 2)));
+    }
+    double total = horizontalSum(_mm_add_pd(acc0, acc1));
+    for (; i < n; ++i)
+        total += a[i] * b[i];
+    return total;
+}
+
+void sse2Scale(const double *x, double *out, std::size_t n, double factor)
+{
+    const __m128d f = _mm_set1_pd(factor);
+    std::size_t i = 0;
+    for (; i + 2 <= n; i += 2)
+        _mm_storeu_pd(out + i, _mm_mul_pd(_mm_loadu_pd(x + i), f));
+    for (; i < n; ++i)
+        out[i] = x[i] * factor;
+}
+
+void sse2ShiftedMoments(const double *x, std::size_t n, double shift,
+                        double &sum, double &sumSquares)
+{
+    const __m128d k = _mm_set1_pd(shift);
+    __m128d s = _mm_setzero_pd();
+    __m128d sq = _mm_setzero_pd();
+    std::size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        const __m128d d = _mm_sub_pd(_mm_loadu_pd(x + i), k);
+        s = _mm_add_pd(s, d);
+        sq = _mm_add_pd(sq, _mm_mul_pd(d, d));
+    }
+    double totalSum = horizontalSum(s);
+    double totalSquares = horizontalSum(sq);
+    for (; i < n; ++i) {
+        const double d = x[i] - shift;
+        totalSum += d;
+        totalSquares += d * d;
+    }
+    sum = totalSum;
+    sumSquares = totalSquares;
+}
+
+std::size_t sse2CountWithin(const double *x, std::size_t n, double center, double radius)
+{
+    const __m128d c = _mm_set1_pd(center);
+    const __m128d r = _mm_set1_pd(radius);
+    const __m128d signMask = _mm_set1_pd(-0.0);
+    __m128i counts = _mm_setzero_si128();
+    std::size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        const __m128d distance = _mm_andnot_pd(signMask, _mm_sub_pd(_mm_loadu_pd(x + i), c));
+        counts = _mm_add_epi64(counts, _mm_castpd_si128(_mm_cmplt_pd(distance, r)));
+    }
+    std::size_t count = horizontalCount(counts);
+    for (; i < n; ++i)
+        count += std::fabs(x[i] - center) < radius ? 1 : 0;
+    return count;
+}
+
+std::size_t sse2CountAbove(const double *x, std::size_t n, double threshold, double &sumAbove)
+{
+    const __m128d t = _mm_set1_pd(threshold);
+    __m128d total = _mm_setzero_pd();
+    __m128i counts = _mm_setzero_si128();
+    std::size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        const __m128d v = _mm_loadu_pd(x + i);
+        const __m128d mask = _mm_cmpgt_pd(v, t);
+        total = _mm_add_pd(total, _mm_and_pd(mask, v));
+        counts = _mm_add_epi64(counts, _mm_castpd_si128(mask));
+    }
+    std::size_t count = horizontalCount(counts);
+    double totalAbove = horizontalSum(total);
+    for (; i < n; ++i) {
+        if (x[i] > threshold) {
+            count++;
+            totalAbove += x[i];
+        }
+    }
+    sumAbove = totalAbove;
+    return count;
+}
+
+void sse2Clamp(double *x, std::size_t n, double lo, double hi)
+{
+    const __m128d l = _mm_set1_pd(lo);
+    const __m128d h = _mm_set1_pd(hi);
+    std::size_t i = 0;
+    for (; i + 2 <= n; i += 2)
+        _mm_storeu_pd(x + i, _mm_min_pd(_mm_max_pd(_mm_loadu_pd(x + i), l), h));
+    for (; i < n; ++i)
+        x[i] = std::min(std::max(x[i], lo), hi);
+}
+
+} // namespace
+
+const KernelTable &sse2Kernels()
+{
+    static const KernelTable table = {
+        sse2Sum,
+        sse2Dot,
+        sse2Scale,
+        sse2ShiftedMoments,
+        sse2CountWithin,
+        sse2CountAbove,
+        sse2Clamp,
+    };
+    return table;
+}
+
+#endif // GDSS_HAVE_SSE2
+
+// ========== DISPATCH ==========
+
+namespace {
+
+bool cpuSupportsAvx2()
+{
+#if !defined(GDSS_HAVE_AVX2)
+    return false;
+#elif defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool fma = (info[2] & (1 << 12)) != 0;
+    if (!osxsave || !fma)
+        return false;
+    // The OS must save the YMM registers on context switches
+    if ((_xgetbv(0) & 0x6) != 0x6)
+        return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#elif defined(__GNUC__)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#else
+    return false;
+#endif
+}
+
+const KernelTable &tableFor(Isa isa)
+{
+    switch (isa) {
+#if defined(GDSS_HAVE_AVX2)
+    case Isa::AVX2:
+        return avx2Kernels();
+#endif
+#if defined(GDSS_HAVE_SSE2)
+    case Isa::SSE2:
+        return sse2Kernels();
+#endif
+    default:
+        return scalarKernels();
+    }
+}
+
+std::atomic<int> &isaSetting()
+{
+    static std::atomic<int> setting(static_cast<int>(bestSupportedIsa()));
+    return setting;
+}
+
+const KernelTable &kernels()
+{
+    return tableFor(static_cast<Isa>(isaSetting().load(std::memory_order_relaxed)));
+}
+
+} // namespace
+
+Isa bestSupportedIsa()
+{
+    static const Isa best = []() {
+        if (cpuSupportsAvx2())
+            return Isa::AVX2;
+#if defined(GDSS_HAVE_SSE2)
+        return Isa::SSE2;
+#else
+        return Isa::Scalar;
+#endif
+    }();
+    return best;
+}
+
+Isa activeIsa()
+{
+    return static_cast<Isa>(isaSetting().load(std::memory_order_relaxed));
+}
+
+void setIsa(Isa isa)
+{
+    const Isa best = bestSupportedIsa();
+    if (static_cast<int>(isa) > static_cast<int>(best))
+        isa = best;
+    isaSetting().store(static_cast<int>(isa), std::memory_order_relaxed);
+}
+
+const char *isaName(Isa isa)
+{
+    switch (isa) {
+    case Isa::AVX2: return "avx2";
+    case Isa::SSE2: return "sse2";
+    default: return "scalar";
+    }
+}
+
+// ========== PUBLIC KERNELS ==========
+
+double sum(const double *x, std::size_t n)
+{
+    return kernels().sum(x, n);
+}
+
+double dot(const double *a, const double *b, std::size_t n)
+{
+    return kernels().dot(a, b, n);
+}
+
+double normalize(const double *confidences, double *weights, std::size_t n)
+{
+    const double total = kernels().sum(confidences, n);
+    if (total != 0.0)
+        kernels().scale(confidences, weights, n, 1.0 / total);
+    return total;
+}
+
+void meanVariance(const double *x, std::size_t n, double &mean, double &variance)
+{
+    if (n == 0) {
+        mean = 0.0;
+        variance = 0.0;
+        return;
+    }
+
+    // Shifting by a sample keeps the one-pass formula free of cancellation
+    const double shift = x[0];
+    double shiftedSum = 0.0;
+    double shiftedSquares = 0.0;
+    kernels().shiftedMoments(x, n, shift, shiftedSum, shiftedSquares);
+
+    const double shiftedMean = shiftedSum / n;
+    mean = shift + shiftedMean;
+    variance = std::max(0.0, shiftedSquares / n - shiftedMean * shiftedMean);
+}
+
+std::size_t countWithin(const double *x, std::size_t n, double center, double radius)
+{
+    return kernels().countWithin(x, n, center, radius);
+}
+
+std::size_t countAbove(const double *x, std::size_t n, double threshold, double &sumAbove)
+{
+    return kernels().countAbove(x, n, threshold, sumAbove);
+}
+
+void clamp(double *x, std::size_t n, double lo, double hi)
+{
+    kernels().clamp(x, n, lo, hi);
+}
+
+} // namespace FusionKernels
@@ -0,0 +1,52 @@
+#ifndef FUSIONKERNELS_H
+#define FUSIONKERNELS_H
+
+#include <cstddef>
+
+// Vectorized reductions behind the native fusion algorithms.
+//
+// Every kernel has a scalar, an SSE2 and an AVX2 (+FMA) implementation; the
+// widest one the CPU supports is picked on first use. All kernels work on
+// contiguous double arrays so they stream at memory bandwidth for very
+// large agent sets.
+namespace FusionKernels {
+
+enum class Isa {
+    Scalar,
+    SSE2,
+    AVX2
+};
+
+// Instruction set currently used by the kernels
+Isa activeIsa();
+// Best instruction set this CPU and build support
+Isa bestSupportedIsa();
+// Force an instruction set (clamped to what is supported); used by benchmarks
+void setIsa(Isa isa);
+const char *isaName(Isa isa);
+
+// sum(x)
+double sum(const double *x, std::size_t n);
+
+// sum(a * b): the weighted sum np.sum(values * weights)
+double dot(const double *a, const double *b, std::size_t n);
+
+// weights = confidences / sum(confidences); returns the sum.
+// The output is left untouched when the sum is zero.
+double normalize(const double *confidences, double *weights, std::size_t n);
+
+// Mean and population variance (np.mean / np.var) in a single pass
+void meanVariance(const double *x, std::size_t n, double &mean, double &variance);
+
+// Number of elements with |x - center| < radius (consensus.py's agreement test)
+std::size_t countWithin(const double *x, std::size_t n, double center, double radius);
+
+// Number of elements with x > threshold; their sum is stored in sumAbove
+std::size_t countAbove(const double *x, std::size_t n, double threshold, double &sumAbove);
+
+// x = min(max(x, lo), hi) in place
+void clamp(double *x, std::size_t n, double lo, double hi);
+
+} // namespace FusionKernels
+
+#endif // FUSIONKERNELS_H
@@ -0,0 +1,194 @@
+// AVX2 + FMA kernels. This file is compiled with -mavx2 -mfma (/arch:AVX2 on
+// MSVC) and its functions are only called after a runtime CPU check.
+#include "fusionkernels_p.h"
+#include <immintrin.h>
+#include <algorithm>
+#include <cmath>
+
+#if defined(GDSS_HAVE_AVX2)
+
+namespace FusionKernels {
+
+namespace {
+
+inline double horizontalSum(__m256d v)
+{
+    const __m128d pair = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+    return _mm_cvtsd_f64(_mm_add_sd(pair, _mm_unpackhi_pd(pair, pair)));
+}
+
+inline std::size_t horizontalCount(__m256i v)
+{
+    // Lanes hold negated counts (compare masks are -1)
+    alignas(32) long long lanes[4];
+    _mm256_store_si256(reinterpret_cast<__m256i *>(lanes), v);
+    return static_cast<std::size_t>(-(lanes[0] + lanes[1] + lanes[2] + lanes[3]));
+}
+
+double avx2Sum(const double *x, std::size_t n)
+{
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();
+    __m256d acc2 = _mm256_setzero_pd();
+    __m256d acc3 = _mm256_setzero_pd();
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        acc0 = _mm256_add_pd(acc0, _mm256_loadu_pd(x + i));
+        acc1 = _mm256_add_pd(acc1, _mm256_loadu_pd(x + i + 4));
+        acc2 = _mm256_add_pd(acc2, _mm256_loadu_pd(x + i + 8));
+        acc3 = _mm256_add_pd(acc3, _mm256_loadu_pd(x + i + 12));
+    }
+    for (; i + 4 <= n; i += 4)
+        acc0 = _mm256_add_pd(acc0, _mm256_loadu_pd(x + i));
+
+    double total = horizontalSum(_mm256_add_pd(_mm256_add_pd(acc0, acc1),
+                                               _mm256_add_pd(acc2, acc3)));
+    for (; i < n; ++i)
+        total += x[i];
+    return total;
+}
+
+double avx2Dot(const double *a, const double *b, std::size_t n)
+{
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();
+    __m256d acc2 = _mm256_setzero_pd();
+    __m256d acc3 = _mm256_setzero_pd();
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        acc0 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i), acc0);
+        acc1 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i + 4), _mm256_loadu_pd(b + i + 4), acc1);
+        acc2 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i + 8), _mm256_loadu_pd(b + i + 8), acc2);
+        acc3 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i + 12), _mm256_loadu_pd(b + i + 12), acc3);
+    }
+    for (; i + 4 <= n; i += 4)
+        acc0 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i), acc0);
+
+    double total = horizontalSum(_mm256_add_pd(_mm256_add_pd(acc0, acc1),
+                                               _mm256_add_pd(acc2, acc3)));
+    for (; i < n; ++i)
+        total += a[i] * b[i];
+    return total;
+}
+
+void avx2Scale(const double *x, double *out, std::size_t n, double factor)
+{
+    const __m256d f = _mm256_set1_pd(factor);
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+        _mm256_storeu_pd(out + i, _mm256_mul_pd(_mm256_loadu_pd(x + i), f));
+    for (; i < n; ++i)
+        out[i] = x[i] * factor;
+}
+
+void avx2ShiftedMoments(const double *x, std::size_t n, double shift,
+                        double &sum, double &sumSquares)
+{
+    const __m256d k = _mm256_set1_pd(shift);
+    __m256d s0 = _mm256_setzero_pd();
+    __m256d s1 = _mm256_setzero_pd();
+    __m256d sq0 = _mm256_setzero_pd();
+    __m256d sq1 = _mm256_setzero_pd();
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256d d0 = _mm256_sub_pd(_mm256_loadu_pd(x + i), k);
+        const __m256d d1 = _mm256_sub_pd(_mm256_loadu_pd(x + i + 4), k);
+        s0 = _mm256_add_pd(s0, d0);
+        s1 = _mm256_add_pd(s1, d1);
+        sq0 = _mm256_fmadd_pd(d0, d0, sq0);
+        sq1 = _mm256_fmadd_pd(d1, d1, sq1);
+    }
+
+    double totalSum = horizontalSum(_mm256_add_pd(s0, s1));
+    double totalSquares = horizontalSum(_mm256_add_pd(sq0, sq1));
+    for (; i < n; ++i) {
+        const double d = x[i] - shift;
+        totalSum += d;
+        totalSquares += d * d;
+    }
+    sum = totalSum;
+    sumSquares = totalSquares;
+}
+
+std::size_t avx2CountWithin(const double *x, std::size_t n, double center, double radius)
+{
+    const __m256d c = _mm256_set1_pd(center);
+    const __m256d r = _mm256_set1_pd(radius);
+    const __m256d signMask = _mm256_set1_pd(-0.0);
+    __m256i counts0 = _mm256_setzero_si256();
+    __m256i counts1 = _mm256_setzero_si256();
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256d d0 = _mm256_andnot_pd(signMask, _mm256_sub_pd(_mm256_loadu_pd(x + i), c));
+        const __m256d d1 = _mm256_andnot_pd(signMask, _mm256_sub_pd(_mm256_loadu_pd(x + i + 4), c));
+        counts0 = _mm256_add_epi64(counts0, _mm256_castpd_si256(_mm256_cmp_pd(d0, r, _CMP_LT_OQ)));
+        counts1 = _mm256_add_epi64(counts1, _mm256_castpd_si256(_mm256_cmp_pd(d1, r, _CMP_LT_OQ)));
+    }
+
+    std::size_t count = horizontalCount(_mm256_add_epi64(counts0, counts1));
+    for (; i < n; ++i)
+        count += std::fabs(x[i] - center) < radius ? 1 : 0;
+    return count;
+}
+
+std::size_t avx2CountAbove(const double *x, std::size_t n, double threshold, double &sumAbove)
+{
+    const __m256d t = _mm256_set1_pd(threshold);
+    __m256d total0 = _mm256_setzero_pd();
+    __m256d total1 = _mm256_setzero_pd();
+    __m256i counts0 = _mm256_setzero_si256();
+    __m256i counts1 = _mm256_setzero_si256();
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256d v0 = _mm256_loadu_pd(x + i);
+        const __m256d v1 = _mm256_loadu_pd(x + i + 4);
+        const __m256d m0 = _mm256_cmp_pd(v0, t, _CMP_GT_OQ);
+        const __m256d m1 = _mm256_cmp_pd(v1, t, _CMP_GT_OQ);
+        total0 = _mm256_add_pd(total0, _mm256_and_pd(m0, v0));
+        total1 = _mm256_add_pd(total1, _mm256_and_pd(m1, v1));
+        counts0 = _mm256_add_epi64(counts0, _mm256_castpd_si256(m0));
+        counts1 = _mm256_add_epi64(counts1, _mm256_castpd_si256(m1));
+    }
+
+    std::size_t count = horizontalCount(_mm256_add_epi64(counts0, counts1));
+    double totalAbove = horizontalSum(_mm256_add_pd(total0, total1));
+    for (; i < n; ++i) {
+        if (x[i] > threshold) {
+            count++;
+            totalAbove += x[i];
+        }
+    }
+    sumAbove = totalAbove;
+    return count;
+}
+
+void avx2Clamp(double *x, std::size_t n, double lo, double hi)
+{
+    const __m256d l = _mm256_set1_pd(lo);
+    const __m256d h = _mm256_set1_pd(hi);
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+        _mm256_storeu_pd(x + i, _mm256_min_pd(_mm256_max_pd(_mm256_loadu_pd(x + i), l), h));
+    for (; i < n; ++i)
+        x[i] = std::min(std::max(x[i], lo), hi);
+}
+
+} // namespace
+
+const KernelTable &avx2Kernels()
+{
+    static const KernelTable table = {
+        avx2Sum,
+        avx2Dot,
+        avx2Scale,
+        avx2ShiftedMoments,
+        avx2CountWithin,
+        avx2CountAbove,
+        avx2Clamp,
+    };
+    return table;
+}
+
+} // namespace FusionKernels
+
+#endif // GDSS_HAVE_AVX2
@@ -0,0 +1,38 @@
+#ifndef FUSIONKERNELS_P_H
+#define FUSIONKERNELS_P_H
+
+#include <cstddef>
+
+// SSE2 is part of the x86-64 baseline; AVX2 is enabled by the build
+// (GDSS_HAVE_AVX2) only where fusionkernels_avx2.cpp can be compiled.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GDSS_HAVE_SSE2
+#endif
+
+// Per-instruction-set kernel implementations. Only fusionkernels.cpp calls
+// these, through the dispatch table; the AVX2 set lives in its own
+// translation unit because it is compiled with AVX2/FMA code generation.
+namespace FusionKernels {
+
+struct KernelTable {
+    double (*sum)(const double *x, std::size_t n);
+    double (*dot)(const double *a, const double *b, std::size_t n);
+    void (*scale)(const double *x, double *out, std::size_t n, double factor);
+    void (*shiftedMoments)(const double *x, std::size_t n, double shift,
+                           double &sum, double &sumSquares);
+    std::size_t (*countWithin)(const double *x, std::size_t n, double center, double radius);
+    std::size_t (*countAbove)(const double *x, std::size_t n, double threshold, double &sumAbove);
+    void (*clamp)(double *x, std::size_t n, double lo, double hi);
+};
+
+const KernelTable &scalarKernels();
+#if defined(GDSS_HAVE_SSE2)
+const KernelTable &sse2Kernels();
+#endif
+#if defined(GDSS_HAVE_AVX2)
+const KernelTable &avx2Kernels();
+#endif
+
+} // namespace FusionKernels
+
+#endif // FUSIONKERNELS_P_H
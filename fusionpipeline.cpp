@@ -0,0 +1,210 @@
+#include "fusionpipeline.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace {
+
+const char PIPELINE_SUFFIX[] = ".pipeline.json";
+
+bool fail(QString *errorString, const QString &message)
+{
+    if (errorString) {
+        *errorString = message;
+    }
+    return false;
+}
+
+double median(std::vector<double> items)
+{
+    const std::size_t middle = items.size() / 2;
+    std::nth_element(items.begin(), items.begin() + middle, items.end());
+    double result = items[middle];
+    if (items.size() % 2 == 0) {
+        result = (*std::max_element(items.begin(), items.begin() + middle) + result) / 2.0;
+    }
+    return result;
+}
+
+// Keeps the agents for which keep(i) holds, in order
+template <typename Predicate>
+void compact(QVector<double> &values, QVector<double> &confidences, Predicate keep)
+{
+    const bool withConfidences = !confidences.isEmpty();
+    qsizetype kept = 0;
+    for (qsizetype i = 0; i < values.size(); ++i) {
+        if (!keep(i)) {
+            continue;
+        }
+        values[kept] = values[i];
+        if (withConfidences) {
+            confidences[kept] = confidences[i];
+        }
+        kept++;
+    }
+    values.resize(kept);
+    if (withConfidences) {
+        confidences.resize(kept);
+    }
+}
+
+} // namespace
+
+bool FusionPipeline::isPipelineName(const QString &name)
+{
+    return name.endsWith(QLatin1String(PIPELINE_SUFFIX), Qt::CaseInsensitive);
+}
+
+QStringList FusionPipeline::ops()
+{
+    return { "drop_outliers", "min_confidence", "clamp" };
+}
+
+bool FusionPipeline::read(const QString &path, FusionPipeline &pipeline, QString *errorString)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return fail(errorString, QString("Cannot open pipeline %1: %2").arg(path, file.errorString()));
+    }
+
+    QJsonParseError parseError;
+    QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &parseError);
+    if (parseError.error != QJsonParseError::NoError || !document.isObject()) {
+        return fail(errorString, QString("Pipeline %1 is not a JSON object: %2")
+                                     .arg(path, parseError.errorString()));
+    }
+
+    QJsonArray stageArray = document.object().value("stages").toArray();
+    if (stageArray.isEmpty()) {
+        return fail(errorString, QString("Pipeline %1 has no stages").arg(path));
+    }
+
+    pipeline.name = QFileInfo(path).fileName();
+    pipeline.stages.clear();
+    bool fused = false;
+
+    for (int i = 0; i < stageArray.size(); ++i) {
+        QVariantMap object = stageArray[i].toObject().toVariantMap();
+        const QString where = QString("Stage %1 of %2").arg(i + 1).arg(pipeline.name);
+
+        Stage stage;
+        if (object.contains("op")) {
+            stage.kind = Stage::Op;
+            stage.name = object.take("op").toString();
+            stage.native = true;
+        } else if (object.contains("script")) {
+            stage.kind = Stage::Fuse;
+            stage.name = object.take("script").toString();
+        } else if (object.contains("transform")) {
+            stage.kind = Stage::Transform;
+            stage.name = object.take("transform").toString();
+        }
+        stage.parameters = object;
+
+        if (stage.name.isEmpty()) {
+            return fail(errorString, where + " needs an \"op\", \"script\" or \"transform\"");
+        }
+        if (stage.kind != Stage::Op && isPipelineName(stage.name)) {
+            return fail(errorString, where + " names another pipeline; pipelines do not nest");
+        }
+        if (stage.kind == Stage::Op && !ops().contains(stage.name)) {
+            return fail(errorString, QString("%1: unknown op \"%2\" (known: %3)")
+                                         .arg(where, stage.name, ops().join(", ")));
+        }
+
+        // Only the fused value is left after the fusing stage
+        if (fused && (stage.kind != Stage::Op || stage.name != "clamp")) {
+            return fail(errorString, where + " follows the fusing stage; only clamp can");
+        }
+        if (stage.kind == Stage::Fuse) {
+            fused = true;
+        }
+
+        if (stage.name == "clamp"
+            && stage.parameters.value("min", 0.0).toDouble() > stage.parameters.value("max", 1.0).toDouble()) {
+            return fail(errorString, where + ": clamp min is above max");
+        }
+
+        pipeline.stages.append(stage);
+    }
+
+    if (!fused) {
+        return fail(errorString, QString("Pipeline %1 has no \"script\" stage to fuse with").arg(pipeline.name));
+    }
+    return true;
+}
+
+bool FusionPipeline::applyOp(const Stage &stage, QVector<double> &values, QVector<double> &confidences,
+                             QString *errorString)
+{
+    if (stage.name == "clamp") {
+        const double low = stage.parameters.value("min", 0.0).toDouble();
+        const double high = stage.parameters.value("max", 1.0).toDouble();
+        for (double &value : values) {
+            value = qBound(low, value, high);
+        }
+        return true;
+    }
+
+    if (stage.name == "min_confidence") {
+        if (confidences.isEmpty()) {
+            return true; // Every agent counts as fully confident
+        }
+        const double threshold = stage.parameters.value("threshold", 0.5).toDouble();
+        compact(values, confidences, [&confidences, threshold](qsizetype i) {
+            return confidences[i] >= threshold;
+        });
+        if (values.isEmpty()) {
+            return fail(errorString, QString("No agent has a confidence of at least %1").arg(threshold));
+        }
+        return true;
+    }
+
+    if (stage.name == "drop_outliers") {
+        if (values.size() < 3) {
+            return true;
+        }
+
+        // Modified z-scores (Iglewicz and Hoaglin): robust to the outliers
+        // they look for, unlike the mean and standard deviation
+        const double threshold = stage.parameters.value("threshold", 3.5).toDouble();
+        const double center = median(std::vector<double>(values.cbegin(), values.cend()));
+
+        std::vector<double> deviations(values.size());
+        double deviationSum = 0.0;
+        for (qsizetype i = 0; i < values.size(); ++i) {
+            deviations[i] = std::abs(values[i] - center);
+            deviationSum += deviations[i];
+        }
+
+        // With more than half the agents on the median the MAD is zero;
+        // the mean absolute deviation stands in for it then
+        double scale = median(deviations) / 0.6745;
+        if (scale == 0.0) {
+            scale = 1.253314 * deviationSum / values.size();
+        }
+        if (scale == 0.0) {
+            return true; // All agents agree
+        }
+
+        compact(values, confidences, [&values, center, scale, threshold](qsizetype i) {
+            return std::abs(values[i] - center) / scale <= threshold;
+        });
+        return true;
+    }
+
+    return fail(errorString, QString("Unknown op \"%1\"").arg(stage.name));
+}
+
+void FusionPipeline::applyOp(const Stage &stage, double &fusedValue)
+{
+    if (stage.name == "clamp") {
+        fusedValue = qBound(stage.parameters.value("min", 0.0).toDouble(), fusedValue,
+                            stage.parameters.value("max", 1.0).toDouble());
+    }
+}
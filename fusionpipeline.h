@@ -0,0 +1,60 @@
+#ifndef FUSIONPIPELINE_H
+#define FUSIONPIPELINE_H
+
+#include <QString>
+#include <QStringList>
+#include <QVariantMap>
+#include <QVector>
+
+// A chain of stages run as one fusion: filters over the agent arrays, one
+// fusing stage, then adjustments of the fused value.
+//
+// Definitions are JSON files next to the scripts, named *.pipeline.json and
+// run by that file name wherever a script name is accepted:
+//
+//   {"stages": [{"op": "drop_outliers", "threshold": 3.5},
+//               {"script": "weighted_with_confidence.py"},
+//               {"op": "clamp", "min": 0, "max": 1}]}
+//
+// "op" stages are built in and always run in-process. "script" is the one
+// fusing stage: native when NativeFusion has the script, otherwise the
+// script's fuse() in a Python worker. "transform" stages name Python scripts
+// whose transform(values, confidences) returns the arrays for the next stage;
+// they must come before the fusing stage. FusionExecutor runs consecutive
+// Python stages in one worker request, handing the numpy arrays from one
+// stage to the next without copying them.
+class FusionPipeline
+{
+public:
+    struct Stage {
+        enum Kind {
+            Op,
+            Transform,
+            Fuse
+        };
+
+        Kind kind = Op;
+        QString name;  // op name or script file name
+        QVariantMap parameters;  // everything else in the stage object
+        QString path;  // script path, filled in by the engine
+        bool native = false;  // runs in-process; set for ops and native fusing scripts
+    };
+
+    QString name;  // file name, e.g. "robust_weighted.pipeline.json"
+    QVector<Stage> stages;
+
+    static bool isPipelineName(const QString &name);
+    // Built-in ops, in the order they are documented
+    static QStringList ops();
+
+    // False with errorString set if the file cannot be read or is not a valid pipeline
+    static bool read(const QString &path, FusionPipeline &pipeline, QString *errorString = nullptr);
+
+    // Runs an op before fusion, in place; confidences is empty or one per value
+    static bool applyOp(const Stage &stage, QVector<double> &values, QVector<double> &confidences,
+                        QString *errorString = nullptr);
+    // Runs an op on the fused value
+    static void applyOp(const Stage &stage, double &fusedValue);
+};
+
+#endif // FUSIONPIPELINE_H
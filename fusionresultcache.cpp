@@ -0,0 +1,300 @@
+#include "fusionresultcache.h"
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRegularExpression>
+#include <QSaveFile>
+#include <QSet>
+#include <QDebug>
+
+FusionResultCache::FusionResultCache(int capacity)
+    : m_memory(qMax(1, capacity)),
+    m_diskCapacity(DEFAULT_DISK_CAPACITY),
+    m_diskCount(0),
+    m_hits(0),
+    m_misses(0)
+{
+}
+
+void FusionResultCache::setCapacity(int capacity)
+{
+    m_memory.setMaxCost(qMax(1, capacity));
+}
+
+int FusionResultCache::capacity() const
+{
+    return static_cast<int>(m_memory.maxCost());
+}
+
+void FusionResultCache::setDiskDirectory(const QString &path)
+{
+    m_diskDirectory = path;
+    m_diskCount = 0;
+    if (!m_diskDirectory.isEmpty()) {
+        QDir().mkpath(m_diskDirectory);
+        // Counted once; insert() keeps the count from here on
+        m_diskCount = QDir(m_diskDirectory).entryList(QStringList() << "*.json", QDir::Files).size();
+        if (m_diskCount > m_diskCapacity) {
+            pruneDisk();
+        }
+    }
+}
+
+QString FusionResultCache::diskDirectory() const
+{
+    return m_diskDirectory;
+}
+
+void FusionResultCache::setDiskCapacity(int files)
+{
+    m_diskCapacity = qMax(1, files);
+    if (!m_diskDirectory.isEmpty() && m_diskCount > m_diskCapacity) {
+        pruneDisk();
+    }
+}
+
+int FusionResultCache::diskCapacity() const
+{
+    return m_diskCapacity;
+}
+
+QByteArray FusionResultCache::inputDigest(const QVariantList &values, const QVariantList &confidences)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+
+    // Same rule as createJsonForPython: confidences only count when complete
+    bool hasConfidences = !confidences.isEmpty() && confidences.size() == values.size();
+    qint64 counts[2] = { values.size(), hasConfidences ? confidences.size() : -1 };
+    hash.addData(QByteArrayView(reinterpret_cast<const char *>(counts), sizeof(counts)));
+
+    for (const QVariant &value : values) {
+        double v = value.toDouble();
+        hash.addData(QByteArrayView(reinterpret_cast<const char *>(&v), sizeof(v)));
+    }
+    if (hasConfidences) {
+        for (const QVariant &confidence : confidences) {
+            double c = confidence.toDouble();
+            hash.addData(QByteArrayView(reinterpret_cast<const char *>(&c), sizeof(c)));
+        }
+    }
+
+    return hash.result();
+}
+
+QByteArray FusionResultCache::key(const QString &scriptName, const QString &scriptPath,
+                                  const QByteArray &inputDigest)
+{
+    QByteArray source = scriptHash(scriptPath);
+    if (source.isEmpty()) {
+        return QByteArray();
+    }
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(scriptName.toUtf8());
+    hash.addData(QByteArrayView("\0", 1));
+    hash.addData(source);
+    hash.addData(inputDigest);
+    return hash.result().toHex();
+}
+
+bool FusionResultCache::lookup(const QByteArray &key, Entry &entry)
+{
+    if (key.isEmpty()) {
+        return false;
+    }
+
+    if (Entry *cached = m_memory.object(key)) {
+        entry = *cached;
+        m_hits++;
+        return true;
+    }
+
+    if (!m_diskDirectory.isEmpty()) {
+        // Opened for writing too: Windows refuses setFileTime() on a read-only
+        // handle. A cache on read-only storage still answers from the file.
+        QFile file(diskPath(key));
+        const bool writable = file.open(QIODevice::ReadWrite | QIODevice::ExistingOnly);
+        if (writable || file.open(QIODevice::ReadOnly)) {
+            QJsonObject stored = QJsonDocument::fromJson(file.readAll()).object();
+            if (stored.value("fused").isDouble()) {
+                // The modification time orders the files for pruneDisk()
+                if (!writable
+                    || !file.setFileTime(QDateTime::currentDateTimeUtc(), QFileDevice::FileModificationTime)) {
+                    qDebug() << "Failed to mark result cache entry as used:" << file.fileName();
+                }
+                entry.fused = stored.value("fused").toDouble();
+                entry.confidence = stored.value("confidence").toDouble(1.0);
+                m_memory.insert(key, new Entry(entry));
+                m_hits++;
+                return true;
+            }
+        }
+    }
+
+    m_misses++;
+    return false;
+}
+
+void FusionResultCache::insert(const QByteArray &key, const Entry &entry)
+{
+    if (key.isEmpty()) {
+        return;
+    }
+
+    m_memory.insert(key, new Entry(entry));
+
+    if (!m_diskDirectory.isEmpty()) {
+        QJsonObject stored;
+        stored["fused"] = entry.fused;
+        stored["confidence"] = entry.confidence;
+
+        QSaveFile file(diskPath(key));
+        const bool existed = QFile::exists(file.fileName());
+        if (file.open(QIODevice::WriteOnly)) {
+            file.write(QJsonDocument(stored).toJson(QJsonDocument::Compact));
+            if (!file.commit()) {
+                qDebug() << "Failed to write result cache entry:" << file.fileName();
+            } else if (!existed && ++m_diskCount > m_diskCapacity) {
+                pruneDisk();
+            }
+        }
+    }
+}
+
+void FusionResultCache::clear()
+{
+    m_memory.clear();
+    m_hits = 0;
+    m_misses = 0;
+
+    if (!m_diskDirectory.isEmpty()) {
+        QDir directory(m_diskDirectory);
+        const QStringList files = directory.entryList(QStringList() << "*.json", QDir::Files);
+        for (const QString &file : files) {
+            directory.remove(file);
+        }
+        m_diskCount = 0;
+    }
+}
+
+int FusionResultCache::hits() const
+{
+    return m_hits;
+}
+
+int FusionResultCache::misses() const
+{
+    return m_misses;
+}
+
+QByteArray FusionResultCache::scriptHash(const QString &scriptPath)
+{
+    // The script first, then its helpers in the order they are reached
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    QStringList pending { scriptPath };
+    QSet<QString> seen { scriptPath };
+    for (qsizetype i = 0; i < pending.size(); ++i) {
+        const ScriptDigest *digest = sourceDigest(pending[i]);
+        if (!digest) {
+            if (i == 0) {
+                return QByteArray();
+            }
+            continue;  // A helper removed since it was found; the script fails without it anyway
+        }
+
+        hash.addData(QFileInfo(pending[i]).fileName().toUtf8());
+        hash.addData(QByteArrayView("\0", 1));
+        hash.addData(digest->hash);
+        for (const QString &module : digest->imports) {
+            if (!seen.contains(module)) {
+                seen.insert(module);
+                pending.append(module);
+            }
+        }
+    }
+
+    return hash.result();
+}
+
+const FusionResultCache::ScriptDigest *FusionResultCache::sourceDigest(const QString &path)
+{
+    QFileInfo info(path);
+    if (!info.exists()) {
+        m_scriptDigests.remove(path);
+        return nullptr;
+    }
+
+    // Re-hash only when the file changed since the last look
+    ScriptDigest &digest = m_scriptDigests[path];
+    if (digest.hash.isEmpty() || digest.modified != info.lastModified() || digest.size != info.size()) {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly)) {
+            m_scriptDigests.remove(path);
+            return nullptr;
+        }
+        const QByteArray source = file.readAll();
+        digest.hash = QCryptographicHash::hash(source, QCryptographicHash::Sha1);
+        digest.imports = localImports(path, source);
+        digest.modified = info.lastModified();
+        digest.size = info.size();
+    }
+
+    return &digest;
+}
+
+QStringList FusionResultCache::localImports(const QString &path, const QByteArray &source)
+{
+    // "from name import ..." and "import name[.sub] [as alias], ..."; only
+    // names with a .py beside the script are ours, the rest are packages
+    static const QRegularExpression statement(
+        QStringLiteral(R"(^[ \t]*(?:from[ \t]+([A-Za-z_]\w*)[ \t.]|import[ \t]+([^#;\r\n]+)))"),
+        QRegularExpression::MultilineOption);
+
+    const QDir directory = QFileInfo(path).absoluteDir();
+    QStringList imports;
+    auto it = statement.globalMatch(QString::fromUtf8(source));
+    while (it.hasNext()) {
+        const QRegularExpressionMatch match = it.next();
+        QStringList names;
+        if (!match.captured(1).isEmpty()) {
+            names.append(match.captured(1));
+        } else {
+            for (const QString &name : match.captured(2).split(',')) {
+                names.append(name.trimmed().section(' ', 0, 0).section('.', 0, 0));
+            }
+        }
+
+        for (const QString &name : std::as_const(names)) {
+            const QString module = directory.filePath(name + ".py");
+            if (!name.isEmpty() && !imports.contains(module) && QFileInfo::exists(module)) {
+                imports.append(module);
+            }
+        }
+    }
+    return imports;
+}
+
+QString FusionResultCache::diskPath(const QByteArray &key) const
+{
+    return QDir(m_diskDirectory).filePath(QString::fromLatin1(key) + ".json");
+}
+
+void FusionResultCache::pruneDisk()
+{
+    // Down to seven eighths of the capacity, so the directory is not
+    // listed again on every following insert
+    QDir directory(m_diskDirectory);
+    const QFileInfoList files = directory.entryInfoList(QStringList() << "*.json", QDir::Files,
+                                                        QDir::Time);  // newest first
+    const qsizetype keep = m_diskCapacity - m_diskCapacity / 8;
+    qsizetype remaining = files.size();
+    for (qsizetype i = keep; i < files.size(); ++i) {
+        if (directory.remove(files[i].fileName())) {
+            remaining--;
+        }
+    }
+    m_diskCount = static_cast<int>(remaining);
+}
@@ -0,0 +1,79 @@
+#ifndef FUSIONRESULTCACHE_H
+#define FUSIONRESULTCACHE_H
+
+#include <QByteArray>
+#include <QCache>
+#include <QDateTime>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QVariantList>
+
+// Content-addressed cache of script fusion results.
+//
+// A key is the SHA-1 of the script name, the SHA-1 of the script's source
+// together with the sources of the helper modules it imports from its own
+// directory (batch_utils.py, model_cache.py, ...), and a digest of the raw
+// agent values and confidences, so editing a script, a helper or any input never returns
+// a stale result. Results live in an in-memory LRU and, when a directory is
+// set, in one small JSON file per key so they survive restarts. The disk
+// tier keeps the diskCapacity() most recently used files.
+class FusionResultCache
+{
+public:
+    struct Entry {
+        double fused = 0.0;
+        double confidence = 1.0;
+    };
+
+    explicit FusionResultCache(int capacity = 256);
+
+    void setCapacity(int capacity);
+    int capacity() const;
+    // Empty disables the on-disk tier
+    void setDiskDirectory(const QString &path);
+    QString diskDirectory() const;
+    // Files kept in the on-disk tier; the least recently used go first
+    void setDiskCapacity(int files);
+    int diskCapacity() const;
+
+    // Hash of the agent values and confidences, the O(n) part of a key;
+    // callers keep it while the agent set is unchanged
+    static QByteArray inputDigest(const QVariantList &values, const QVariantList &confidences);
+    // Empty when the script cannot be read (nothing is cached then)
+    QByteArray key(const QString &scriptName, const QString &scriptPath, const QByteArray &inputDigest);
+
+    bool lookup(const QByteArray &key, Entry &entry);
+    void insert(const QByteArray &key, const Entry &entry);
+    void clear();
+
+    int hits() const;
+    int misses() const;
+
+private:
+    struct ScriptDigest {
+        QDateTime modified;
+        qint64 size = -1;
+        QByteArray hash;
+        QStringList imports;  // paths of the local modules the source imports
+    };
+
+    // The script and every local module it pulls in, directly or not
+    QByteArray scriptHash(const QString &scriptPath);
+    const ScriptDigest *sourceDigest(const QString &path);
+    static QStringList localImports(const QString &path, const QByteArray &source);
+    QString diskPath(const QByteArray &key) const;
+    void pruneDisk();
+
+    QCache<QByteArray, Entry> m_memory;
+    QString m_diskDirectory;
+    int m_diskCapacity;
+    int m_diskCount;  // files in m_diskDirectory, counted when it is set
+    QHash<QString, ScriptDigest> m_scriptDigests;  // path -> source hash and imports
+    int m_hits;
+    int m_misses;
+
+    static constexpr int DEFAULT_DISK_CAPACITY = 4096;
+};
+
+#endif // FUSIONRESULTCACHE_H
@@ -0,0 +1,435 @@
+#include "fusionservice.h"
+#include "decisionengine.h"
+#include "engineoptions.h"
+#include "historymanager.h"
+#include "serviceprotocol.h"
+#include <QLocalSocket>
+#include <QDebug>
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+FusionService::FusionService(DecisionEngine *engine, QObject *parent)
+    : QObject(parent),
+    m_engine(engine),
+    m_nextCallId(1),
+    m_runningBatchId(0),
+    m_runningStartedAt(0),
+    m_batchWindow(2),
+    m_maxBatchSize(256),
+    m_completedRequests(0),
+    m_failedRequests(0),
+    m_batches(0),
+    m_batchedJobs(0),
+    m_latencyNext(0)
+{
+    m_clock.start();
+
+    // Only the user running the service may connect
+    m_server.setSocketOptions(QLocalServer::UserAccessOption);
+    connect(&m_server, &QLocalServer::newConnection, this, &FusionService::onNewConnection);
+
+    m_flushTimer.setSingleShot(true);
+    connect(&m_flushTimer, &QTimer::timeout, this, &FusionService::flush);
+
+    connect(m_engine, &DecisionEngine::batchFinished, this, &FusionService::onBatchFinished);
+    connect(m_engine, &DecisionEngine::pythonError, this, [this](const QString &message) {
+        m_lastEngineError = message;
+    });
+}
+
+FusionService::~FusionService()
+{
+    m_server.close();
+}
+
+bool FusionService::listen(const QString &name)
+{
+    bool listening = m_server.listen(name);
+
+    // A socket file left behind by a crashed service blocks the name; take it
+    // over only if nothing answers on it
+    if (!listening && m_server.serverError() == QAbstractSocket::AddressInUseError) {
+        QLocalSocket probe;
+        probe.connectToServer(name);
+        if (!probe.waitForConnected(500)) {
+            QLocalServer::removeServer(name);
+            listening = m_server.listen(name);
+        }
+    }
+
+    if (listening) {
+        m_engine->historyManager()->logInfo(
+            QString("Fusion service listening on %1").arg(m_server.fullServerName()), "Service");
+        return true;
+    }
+
+    m_engine->historyManager()->logError(
+        QString("Fusion service cannot listen on %1: %2").arg(name, m_server.errorString()), "Service");
+    return false;
+}
+
+QString FusionService::serverName() const
+{
+    return m_server.fullServerName();
+}
+
+QString FusionService::errorString() const
+{
+    return m_server.errorString();
+}
+
+void FusionService::setBatchWindow(int milliseconds)
+{
+    m_batchWindow = qMax(0, milliseconds);
+}
+
+int FusionService::batchWindow() const
+{
+    return m_batchWindow;
+}
+
+void FusionService::setMaxBatchSize(int size)
+{
+    m_maxBatchSize = qMax(1, size);
+}
+
+int FusionService::maxBatchSize() const
+{
+    return m_maxBatchSize;
+}
+
+// ========== CONNECTIONS ==========
+
+void FusionService::onNewConnection()
+{
+    while (QLocalSocket *socket = m_server.nextPendingConnection()) {
+        m_buffers.insert(socket, QByteArray());
+
+        connect(socket, &QLocalSocket::readyRead, this, [this, socket]() {
+            onReadyRead(socket);
+        });
+        connect(socket, &QLocalSocket::disconnected, this, [this, socket]() {
+            // Its requests still run; their replies are dropped
+            m_buffers.remove(socket);
+            socket->deleteLater();
+        });
+    }
+}
+
+void FusionService::onReadyRead(QLocalSocket *socket)
+{
+    auto it = m_buffers.find(socket);
+    if (it == m_buffers.end()) {
+        return;
+    }
+    it->append(socket->readAll());
+
+    // Take every complete request now; the batch is flushed once the read is done
+    for (;;) {
+        QJsonObject request;
+        QString error;
+        ServiceProtocol::ReadStatus status = ServiceProtocol::take(*it, request, error);
+
+        if (status == ServiceProtocol::ReadStatus::NeedMoreData) {
+            return;
+        }
+        if (status == ServiceProtocol::ReadStatus::Oversized) {
+            sendError(socket, QJsonValue(), error);
+            socket->disconnectFromServer();
+            return;
+        }
+        if (status == ServiceProtocol::ReadStatus::Malformed) {
+            sendError(socket, QJsonValue(), error);
+            continue;
+        }
+
+        handleRequest(socket, request);
+    }
+}
+
+void FusionService::handleRequest(QLocalSocket *socket, const QJsonObject &request)
+{
+    QJsonValue id = request.value("id");
+    QString op = request.value("op").toString();
+
+    if (op == "stats") {
+        QJsonObject reply;
+        reply["id"] = id;
+        reply["ok"] = true;
+        reply["stats"] = statistics();
+        send(socket, reply);
+        return;
+    }
+
+    if (op != "fuse" && op != "compare") {
+        sendError(socket, id, QString("Unknown op: %1").arg(op));
+        return;
+    }
+
+    QJsonArray values = request.value("values").toArray();
+    if (values.isEmpty()) {
+        sendError(socket, id, "No agent values");
+        return;
+    }
+
+    Call call;
+    call.socket = socket;
+    call.id = id;
+    call.comparison = op == "compare";
+    call.receivedAt = m_clock.nsecsElapsed();
+
+    if (call.comparison) {
+        for (const QJsonValue &algorithm : request.value("algorithms").toArray()) {
+            call.algorithms.append(EngineOptions::scriptFileName(algorithm.toString()));
+        }
+    } else {
+        call.algorithms.append(EngineOptions::scriptFileName(
+            request.value("algorithm").toString("weighted_with_confidence")));
+    }
+    if (call.algorithms.isEmpty()) {
+        sendError(socket, id, "No algorithms to compare");
+        return;
+    }
+
+    QVariantMap agents;
+    agents["values"] = values.toVariantList();
+    agents["confidences"] = request.value("confidences").toArray().toVariantList();
+
+    call.remaining = call.algorithms.size();
+    for (int i = 0; i < call.algorithms.size(); ++i) {
+        call.results.append(QJsonValue());
+    }
+
+    quint64 callId = m_nextCallId++;
+    m_calls.insert(callId, call);
+
+    for (int part = 0; part < call.algorithms.size(); ++part) {
+        enqueue(call.algorithms[part], Job{ callId, part, agents, call.receivedAt });
+    }
+}
+
+void FusionService::sendError(QLocalSocket *socket, const QJsonValue &id, const QString &message)
+{
+    QJsonObject reply;
+    reply["id"] = id;
+    reply["ok"] = false;
+    reply["error"] = message;
+    send(socket, reply);
+}
+
+void FusionService::send(QLocalSocket *socket, const QJsonObject &message)
+{
+    if (socket && socket->state() == QLocalSocket::ConnectedState) {
+        socket->write(ServiceProtocol::encode(message));
+    }
+}
+
+// ========== MICRO-BATCHING ==========
+
+void FusionService::enqueue(const QString &algorithm, const Job &job)
+{
+    QList<Job> &queue = m_pending[algorithm];
+    queue.append(job);
+
+    if (m_runningBatchId != 0) {
+        return; // Goes out with the next batch, right after the running one
+    }
+
+    if (queue.size() >= m_maxBatchSize) {
+        m_flushTimer.start(0);
+    } else if (!m_flushTimer.isActive()) {
+        m_flushTimer.start(m_batchWindow);
+    }
+}
+
+void FusionService::flush()
+{
+    m_flushTimer.stop();
+    if (m_runningBatchId != 0) {
+        return;
+    }
+
+    // The queue whose oldest request has waited longest goes first
+    QString algorithm;
+    qint64 oldest = std::numeric_limits<qint64>::max();
+    for (auto it = m_pending.cbegin(); it != m_pending.cend(); ++it) {
+        if (!it->isEmpty() && it->first().queuedAt < oldest) {
+            oldest = it->first().queuedAt;
+            algorithm = it.key();
+        }
+    }
+    if (algorithm.isEmpty()) {
+        return;
+    }
+
+    QList<Job> &queue = m_pending[algorithm];
+    int count = qMin(static_cast<int>(queue.size()), m_maxBatchSize);
+    m_running = queue.mid(0, count);
+    queue.remove(0, count);
+    if (queue.isEmpty()) {
+        m_pending.remove(algorithm);
+    }
+
+    QVariantList cases;
+    cases.reserve(count);
+    for (const Job &job : std::as_const(m_running)) {
+        cases.append(job.agents);
+    }
+
+    m_lastEngineError.clear();
+    m_runningStartedAt = m_clock.nsecsElapsed();
+    int batchId = m_engine->runBatchFusion(cases, algorithm);
+
+    if (batchId == 0) {
+        QList<Job> refused;
+        refused.swap(m_running);
+
+        QJsonObject result;
+        result["ok"] = false;
+        result["error"] = m_lastEngineError.isEmpty() ? QString("Batch refused") : m_lastEngineError;
+        result["batch_size"] = count;
+        for (const Job &job : std::as_const(refused)) {
+            completeJob(job, result);
+        }
+
+        if (!m_pending.isEmpty()) {
+            m_flushTimer.start(0);
+        }
+        return;
+    }
+
+    m_runningBatchId = batchId;
+    m_batches++;
+    m_batchedJobs += count;
+}
+
+void FusionService::onBatchFinished(int batchId, const QVariantList &results)
+{
+    if (batchId != m_runningBatchId) {
+        return;
+    }
+
+    QList<Job> finished;
+    finished.swap(m_running);
+    m_runningBatchId = 0;
+
+    for (int i = 0; i < finished.size(); ++i) {
+        const Job &job = finished[i];
+        QVariantMap caseResult = results.value(i).toMap();
+
+        QJsonObject result;
+        result["ok"] = caseResult.value("ok").toBool();
+        if (result["ok"].toBool()) {
+            result["fused"] = caseResult.value("fused").toDouble();
+            result["confidence"] = caseResult.value("confidence").toDouble();
+        } else {
+            result["error"] = caseResult.value("error").toString();
+        }
+        result["batch_size"] = static_cast<int>(finished.size());
+        result["queue_us"] = (m_runningStartedAt - job.queuedAt) / 1000;
+
+        completeJob(job, result);
+    }
+
+    // Requests that arrived meanwhile have already waited a whole batch
+    if (!m_pending.isEmpty()) {
+        flush();
+    }
+}
+
+void FusionService::completeJob(const Job &job, const QJsonObject &result)
+{
+    auto it = m_calls.find(job.callId);
+    if (it == m_calls.end()) {
+        return;
+    }
+
+    Call &call = it.value();
+    QJsonObject partResult = result;
+    partResult["algorithm"] = call.algorithms[job.part];
+
+    QJsonObject reply;
+    if (call.comparison) {
+        call.results[job.part] = partResult;
+        if (--call.remaining > 0) {
+            return;
+        }
+
+        bool anyOk = false;
+        for (const QJsonValue &value : std::as_const(call.results)) {
+            anyOk = anyOk || value.toObject().value("ok").toBool();
+        }
+        reply["ok"] = anyOk;
+        reply["results"] = call.results;
+    } else {
+        reply = partResult;
+    }
+
+    qint64 latency = m_clock.nsecsElapsed() - call.receivedAt;
+    reply["id"] = call.id;
+    reply["latency_us"] = latency / 1000;
+
+    if (!reply["ok"].toBool()) {
+        m_failedRequests++;
+    }
+    recordLatency(latency);
+    send(call.socket, reply);
+    m_calls.erase(it);
+}
+
+// ========== STATISTICS ==========
+
+void FusionService::recordLatency(qint64 nanoseconds)
+{
+    m_completedRequests++;
+    if (m_latencies.size() < LATENCY_SAMPLES) {
+        m_latencies.append(nanoseconds);
+    } else {
+        m_latencies[m_latencyNext] = nanoseconds;
+    }
+    m_latencyNext = (m_latencyNext + 1) % LATENCY_SAMPLES;
+}
+
+QJsonObject FusionService::statistics() const
+{
+    QVector<qint64> sorted = m_latencies;
+    std::sort(sorted.begin(), sorted.end());
+
+    auto percentile = [&sorted](double p) -> qint64 {
+        if (sorted.isEmpty()) {
+            return 0;
+        }
+        int index = qMin(static_cast<int>(p * sorted.size()), static_cast<int>(sorted.size()) - 1);
+        return sorted[index] / 1000;
+    };
+
+    qint64 total = 0;
+    for (qint64 sample : sorted) {
+        total += sample;
+    }
+
+    int pending = m_running.size();
+    for (const QList<Job> &queue : m_pending) {
+        pending += queue.size();
+    }
+
+    QJsonObject latency;
+    latency["samples"] = static_cast<int>(sorted.size());
+    latency["mean_us"] = sorted.isEmpty() ? 0 : total / sorted.size() / 1000;
+    latency["p50_us"] = percentile(0.50);
+    latency["p90_us"] = percentile(0.90);
+    latency["p99_us"] = percentile(0.99);
+    latency["max_us"] = sorted.isEmpty() ? 0 : sorted.last() / 1000;
+
+    QJsonObject stats;
+    stats["requests"] = static_cast<qint64>(m_completedRequests);
+    stats["failed"] = static_cast<qint64>(m_failedRequests);
+    stats["batches"] = static_cast<qint64>(m_batches);
+    stats["mean_batch_size"] = m_batches > 0 ? double(m_batchedJobs) / m_batches : 0.0;
+    stats["pending_jobs"] = pending;
+    stats["connections"] = static_cast<int>(m_buffers.size());
+    stats["latency"] = latency;
+    stats["persistence"] = QJsonObject::fromVariantMap(m_engine->historyManager()->persistenceMetrics());
+    return stats;
+}
@@ -0,0 +1,109 @@
+#ifndef FUSIONSERVICE_H
+#define FUSIONSERVICE_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QJsonValue>
+#include <QList>
+#include <QLocalServer>
+#include <QPointer>
+#include <QTimer>
+#include <QVariantMap>
+#include <QVector>
+
+class DecisionEngine;
+class QLocalSocket;
+
+// Fusion over a local socket for tools that cannot embed the engine.
+//
+// Requests (see serviceprotocol.h) are not run one by one: every fusion,
+// including each algorithm of a comparison, joins a queue per algorithm,
+// and a queue is handed to DecisionEngine::runBatchFusion() as one batch
+// once it holds maxBatchSize requests or its oldest request has waited
+// batchWindow ms. The engine runs one batch at a time across the whole
+// worker pool; whatever arrives meanwhile forms the next batch, so batches
+// grow with load instead of requests queueing one by one.
+class FusionService : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit FusionService(DecisionEngine *engine, QObject *parent = nullptr);
+    ~FusionService();
+
+    bool listen(const QString &name);
+    QString serverName() const;
+    QString errorString() const;
+
+    void setBatchWindow(int milliseconds);
+    int batchWindow() const;
+    void setMaxBatchSize(int size);
+    int maxBatchSize() const;
+
+    // Counters and latency percentiles over the most recent requests
+    QJsonObject statistics() const;
+
+private slots:
+    void onNewConnection();
+    void onBatchFinished(int batchId, const QVariantList &results);
+
+private:
+    // One algorithm run on one agent set
+    struct Job {
+        quint64 callId;
+        int part;  // index into the call's algorithms
+        QVariantMap agents;  // {values, confidences}
+        qint64 queuedAt;  // ns on m_clock
+    };
+
+    // One client request; a comparison has a job per algorithm
+    struct Call {
+        QPointer<QLocalSocket> socket;
+        QJsonValue id;
+        bool comparison = false;
+        QStringList algorithms;
+        QJsonArray results;
+        int remaining = 0;
+        qint64 receivedAt = 0;  // ns on m_clock
+    };
+
+    void onReadyRead(QLocalSocket *socket);
+    void handleRequest(QLocalSocket *socket, const QJsonObject &request);
+    void sendError(QLocalSocket *socket, const QJsonValue &id, const QString &message);
+    void send(QLocalSocket *socket, const QJsonObject &message);
+    void enqueue(const QString &algorithm, const Job &job);
+    void flush();
+    void completeJob(const Job &job, const QJsonObject &result);
+    void recordLatency(qint64 nanoseconds);
+
+    DecisionEngine *m_engine;
+    QLocalServer m_server;
+    QHash<QLocalSocket *, QByteArray> m_buffers;  // unread bytes per connection
+
+    QHash<quint64, Call> m_calls;
+    quint64 m_nextCallId;
+    QHash<QString, QList<Job>> m_pending;  // algorithm -> queued jobs, oldest first
+    QList<Job> m_running;  // jobs of the batch in flight, in case order
+    int m_runningBatchId;  // 0 when the engine is idle
+    qint64 m_runningStartedAt;
+    QString m_lastEngineError;
+
+    QTimer m_flushTimer;
+    int m_batchWindow;  // ms
+    int m_maxBatchSize;
+    QElapsedTimer m_clock;
+
+    // Statistics
+    quint64 m_completedRequests;
+    quint64 m_failedRequests;
+    quint64 m_batches;
+    quint64 m_batchedJobs;
+    QVector<qint64> m_latencies;  // ring of the last LATENCY_SAMPLES, ns
+    int m_latencyNext;
+    static const int LATENCY_SAMPLES = 4096;
+};
+
+#endif // FUSIONSERVICE_H
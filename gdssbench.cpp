@@ -0,0 +1,631 @@
+// Benchmark suite for the fusion paths and data-handling hot spots.
+//
+//   gdssbench [--filter text] [--sizes 10,1000,...] [--history-sizes 1000,...]
+//             [--min-ms 200] [--scripts dir] [--python-max n]
+//
+// Prints one JSON object per line:
+//   {"benchmark", "size", "iterations", "nsPerIteration", "itemsPerSecond"[, "isa"]}
+// size is the agent count (history entries for history/ and statistics/),
+// and items are the agents or entries one iteration processes (one edit for
+// fusion/incremental). Groups:
+//
+//   kernels/*             every FusionKernels reduction on every supported ISA
+//   serialize/*           agent set -> script input (JSON, binary frames)
+//   parse/result          a script reply -> fused value and confidence
+//   fusion/native/*       NativeFusion on one agent set
+//   fusion/criteria/*     NativeFusion per criterion of a CriteriaTable with 8
+//                         criteria; items are cells (agents x criteria)
+//   fusion/incremental/*  one agent edit plus the new result (IncrementalFusion)
+//   fusion/stream/*       one StreamingFusion tick with a reading per agent
+//   fusion/batch/*        DecisionEngine::runBatchFusion over sets of 10 agents
+//   fusion/python-*/*     a worker round trip, only with --scripts
+//   history/*             HistoryJournal snapshot compaction, load (snapshot plus
+//                         journal replay), one append as queued for the writer
+//                         thread and one written through (flushed); one
+//                         HistoryManager lookup by id
+//   history/sqlite-*      the same history in HistoryDatabase: bulk import, one
+//                         insert, an indexed query for 100 entries of one algorithm
+//   statistics/*          history statistics recomputed after a change (from the
+//                         running totals), the totals rebuilt over the whole
+//                         history or seeded from HistoryDatabase, and the
+//                         comparison summary
+//
+// Everything runs in Qt's test mode, so the history and log files of the
+// user are never touched.
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLoggingCategory>
+#include <QRandomGenerator>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QUuid>
+#include <QVector>
+#include <functional>
+#include "comparisonresultmodel.h"
+#include "criteriatable.h"
+#include "decisionengine.h"
+#include "fusionexecutor.h"
+#include "fusionframe.h"
+#include "fusionkernels.h"
+#include "historyaggregates.h"
+#include "historydatabase.h"
+#include "historyjournal.h"
+#include "historymanager.h"
+#include "historywriter.h"
+#include "incrementalfusion.h"
+#include "nativefusion.h"
+#include "pythonworkerpool.h"
+#include "streamingfusion.h"
+
+namespace {
+
+volatile double g_sink = 0.0; // Keeps results observable so nothing is optimized away
+
+struct Measurement {
+    qint64 iterations;
+    double seconds;
+};
+
+Measurement measure(const std::function<void()> &body, double minSeconds)
+{
+    QElapsedTimer timer;
+    timer.start();
+    body(); // Warm up; a body slower than minSeconds is reported from this run alone
+    const double first = timer.nsecsElapsed() / 1e9;
+    if (first >= minSeconds) {
+        return { 1, first };
+    }
+
+    qint64 iterations = 0;
+    timer.restart();
+    do {
+        body();
+        iterations++;
+    } while (timer.nsecsElapsed() < minSeconds * 1e9);
+    return { iterations, timer.nsecsElapsed() / 1e9 };
+}
+
+QList<qint64> parseSizes(const QString &text)
+{
+    QList<qint64> sizes;
+    for (const QString &part : text.split(',', Qt::SkipEmptyParts)) {
+        qint64 size = part.trimmed().toLongLong();
+        if (size > 0) {
+            sizes.append(size);
+        }
+    }
+    return sizes;
+}
+
+} // namespace
+
+// Befriended by DecisionEngine and HistoryManager to reach their internals
+class EngineBenchmark
+{
+public:
+    EngineBenchmark(const QString &filter, double minSeconds)
+        : m_filter(filter), m_minSeconds(minSeconds), m_out(stdout)
+    {
+    }
+
+    bool selected(const QString &name) const
+    {
+        return m_filter.isEmpty() || name.contains(m_filter);
+    }
+
+    // Lets a group skip building its inputs when none of its benchmarks run
+    bool anySelected(const QStringList &names) const
+    {
+        for (const QString &name : names) {
+            if (selected(name)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    QStringList pythonNames() const
+    {
+        QStringList names;
+        for (const QString &algorithm : NativeFusion::algorithms()) {
+            names << "fusion/python-json/" + algorithm << "fusion/python-frame/" + algorithm;
+        }
+        return names;
+    }
+
+    void run(const QString &name, qint64 size, qint64 items, const std::function<void()> &body,
+             const QString &isa = QString())
+    {
+        if (!selected(name)) {
+            return;
+        }
+
+        Measurement m = measure(body, m_minSeconds);
+
+        QJsonObject line;
+        line["benchmark"] = name;
+        if (!isa.isEmpty()) {
+            line["isa"] = isa;
+        }
+        line["size"] = size;
+        line["iterations"] = m.iterations;
+        line["nsPerIteration"] = m.seconds * 1e9 / m.iterations;
+        line["itemsPerSecond"] = items * m.iterations / m.seconds;
+        m_out << QJsonDocument(line).toJson(QJsonDocument::Compact) << Qt::endl;
+    }
+
+    void kernels(const QVector<double> &values, const QVector<double> &confidences)
+    {
+        const std::size_t n = values.size();
+        QVector<double> weights(values.size());
+
+        struct Kernel {
+            const char *name;
+            std::function<void()> run;
+        };
+        const QList<Kernel> kernels = {
+            { "sum", [&]() { g_sink = FusionKernels::sum(values.constData(), n); } },
+            { "weightedSum", [&]() { g_sink = FusionKernels::dot(values.constData(), confidences.constData(), n); } },
+            { "normalize", [&]() { g_sink = FusionKernels::normalize(confidences.constData(), weights.data(), n); } },
+            { "meanVariance", [&]() {
+                  double mean = 0.0;
+                  double variance = 0.0;
+                  FusionKernels::meanVariance(values.constData(), n, mean, variance);
+                  g_sink = mean + variance;
+              } },
+            { "countWithin", [&]() {
+                  g_sink = static_cast<double>(FusionKernels::countWithin(values.constData(), n, 0.5, 0.2));
+              } },
+            { "countAbove", [&]() {
+                  double sumAbove = 0.0;
+                  g_sink = static_cast<double>(FusionKernels::countAbove(values.constData(), n, 0.5, sumAbove));
+              } },
+            { "clamp", [&]() {
+                  FusionKernels::clamp(weights.data(), n, 0.0, 1.0);
+                  g_sink = weights[0];
+              } },
+        };
+
+        const FusionKernels::Isa best = FusionKernels::bestSupportedIsa();
+        for (int level = 0; level <= static_cast<int>(best); ++level) {
+            const FusionKernels::Isa isa = static_cast<FusionKernels::Isa>(level);
+            FusionKernels::setIsa(isa);
+            for (const Kernel &kernel : kernels) {
+                run(QString("kernels/%1").arg(kernel.name), n, n, kernel.run, FusionKernels::isaName(isa));
+            }
+        }
+        FusionKernels::setIsa(best);
+    }
+
+    void serialization(const QVariantList &values, const QVariantList &confidences)
+    {
+        const qint64 n = values.size();
+        run("serialize/json", n, n, [&]() {
+            QByteArray data = QJsonDocument(FusionExecutor::createJsonForPython(values, confidences))
+                                  .toJson(QJsonDocument::Compact);
+            g_sink = data.size();
+        });
+        run("serialize/frame-float64", n, n, [&]() {
+            g_sink = FusionFrame::encode(values, confidences, FusionFrame::ItemType::Float64).size();
+        });
+        run("serialize/frame-float32", n, n, [&]() {
+            g_sink = FusionFrame::encode(values, confidences, FusionFrame::ItemType::Float32).size();
+        });
+    }
+
+    void parsing()
+    {
+        const QByteArray reply = R"({"fused": 0.7312845511, "confidence": 0.8125})";
+        run("parse/result", 1, 1, [&]() {
+            double fused = 0.0;
+            double confidence = 1.0;
+            QString error;
+            FusionExecutor::parseResult(reply, fused, confidence, error);
+            g_sink = fused + confidence;
+        });
+    }
+
+    void nativeFusion(const QVector<double> &values, const QVector<double> &confidences)
+    {
+        const qint64 n = values.size();
+        for (const QString &algorithm : NativeFusion::algorithms()) {
+            run("fusion/native/" + algorithm, n, n, [&]() {
+                g_sink = NativeFusion::run(algorithm, values.constData(), confidences.constData(), n).fused;
+            });
+        }
+    }
+
+    void criteriaFusion(const QVector<double> &values, const QVector<double> &confidences)
+    {
+        const int criteriaCount = 8;
+        const qint64 n = values.size();
+        QStringList names;
+        QStringList criteria;
+        for (const QString &algorithm : NativeFusion::algorithms()) {
+            names << "fusion/criteria/" + algorithm;
+        }
+        if (!anySelected(names)) {
+            return;
+        }
+        for (int k = 0; k < criteriaCount; ++k) {
+            criteria << QString("criterion %1").arg(k + 1);
+        }
+
+        // Every criterion is the agent set shifted by k, so the columns differ
+        CriteriaTable table(criteria, n);
+        for (int k = 0; k < criteriaCount; ++k) {
+            double *column = table.column(k);
+            for (qint64 i = 0; i < n; ++i) {
+                column[i] = values[(i + k) % n];
+            }
+        }
+        table.setConfidences(confidences);
+
+        for (const QString &algorithm : NativeFusion::algorithms()) {
+            run("fusion/criteria/" + algorithm, n, n * criteriaCount, [&]() {
+                g_sink = NativeFusion::run(algorithm, table).first().fused;
+            });
+        }
+    }
+
+    void incrementalFusion(const QVector<double> &values, const QVector<double> &confidences)
+    {
+        const qint64 n = values.size();
+        for (const QString &algorithm : NativeFusion::algorithms()) {
+            const QString name = "fusion/incremental/" + algorithm;
+            if (!IncrementalFusion::supports(algorithm) || !selected(name)) {
+                continue;
+            }
+
+            IncrementalFusion state;
+            QVector<double> current = values;
+            for (qint64 i = 0; i < n; ++i) {
+                state.add(current[i], confidences[i]);
+            }
+
+            // Each iteration moves one agent, the way a slider edit does
+            qint64 next = 0;
+            run(name, n, 1, [&]() {
+                const qint64 i = next++ % n;
+                const double value = 1.0 - current[i];
+                state.replace(current[i], confidences[i], value, confidences[i]);
+                current[i] = value;
+                if (state.needsRebuild()) {
+                    state.clear();
+                    for (qint64 j = 0; j < n; ++j) {
+                        state.add(current[j], confidences[j]);
+                    }
+                }
+                g_sink = state.result(algorithm).fused;
+            });
+        }
+    }
+
+    void streamingFusion(const QVector<double> &values, const QVector<double> &confidences)
+    {
+        const qint64 n = values.size();
+        if (n > 65536) {
+            return; // One tick's readings must fit the ring
+        }
+
+        QStringList agents;
+        for (qint64 i = 0; i < n; ++i) {
+            agents.append(QString("agent%1").arg(i));
+        }
+
+        for (const QString &algorithm : NativeFusion::algorithms()) {
+            if (!selected("fusion/stream/" + algorithm)) {
+                continue;
+            }
+            StreamingFusion stream;
+            stream.setAlgorithm(algorithm);
+            stream.setWindowSize(4);
+            run("fusion/stream/" + algorithm, n, n, [&]() {
+                for (qint64 i = 0; i < n; ++i) {
+                    stream.push(agents[i], values[i], confidences[i]);
+                }
+                stream.tick();
+                g_sink = stream.fusedValue();
+            });
+        }
+    }
+
+    void batchFusion(DecisionEngine &engine, const QVector<double> &values, const QVector<double> &confidences)
+    {
+        const int agentsPerCase = 10;
+        const qint64 caseCount = values.size() / agentsPerCase;
+        if (caseCount == 0 || caseCount > 100000) {
+            return;
+        }
+        QStringList names;
+        for (const QString &algorithm : NativeFusion::algorithms()) {
+            names << "fusion/batch/" + algorithm;
+        }
+        if (!anySelected(names)) {
+            return;
+        }
+
+        QVariantList cases;
+        for (qint64 c = 0; c < caseCount; ++c) {
+            QVariantList caseValues;
+            QVariantList caseConfidences;
+            for (int i = 0; i < agentsPerCase; ++i) {
+                caseValues.append(values[c * agentsPerCase + i]);
+                caseConfidences.append(confidences[c * agentsPerCase + i]);
+            }
+            QVariantMap agentSet;
+            agentSet["values"] = caseValues;
+            agentSet["confidences"] = caseConfidences;
+            cases.append(agentSet);
+        }
+
+        for (const QString &algorithm : NativeFusion::algorithms()) {
+            run("fusion/batch/" + algorithm, values.size(), caseCount * agentsPerCase, [&]() {
+                QEventLoop loop;
+                QObject::connect(&engine, &DecisionEngine::batchFinished, &loop, &QEventLoop::quit);
+                if (engine.runBatchFusion(cases, algorithm) != 0) {
+                    loop.exec();
+                }
+            });
+        }
+    }
+
+    void pythonFusion(PythonWorkerPool &pool, const QString &scriptsPath,
+                      const QVariantList &values, const QVariantList &confidences)
+    {
+        const qint64 n = values.size();
+        const QByteArray json = QJsonDocument(FusionExecutor::createJsonForPython(values, confidences))
+                                    .toJson(QJsonDocument::Compact);
+        const QByteArray frame = FusionFrame::encode(values, confidences, FusionFrame::ItemType::Float64);
+
+        auto roundTrip = [&pool](const QString &script, const QByteArray &input, const QString &entry) {
+            QEventLoop loop;
+            quint64 id = pool.submit(script, input, entry);
+            QObject::connect(&pool, &PythonWorkerPool::requestFinished, &loop,
+                             [&loop, id](quint64 requestId) {
+                                 if (requestId == id) {
+                                     loop.quit();
+                                 }
+                             });
+            loop.exec();
+        };
+
+        for (const QString &algorithm : NativeFusion::algorithms()) {
+            const QString script = QDir(scriptsPath).filePath(algorithm);
+            run("fusion/python-json/" + algorithm, n, n, [&]() { roundTrip(script, json, QString()); });
+            run("fusion/python-frame/" + algorithm, n, n, [&]() { roundTrip(script, frame, "fuse"); });
+        }
+    }
+
+    void history(HistoryManager &history, const QString &path, qint64 entryCount)
+    {
+        if (!anySelected({ "history/compact", "history/load", "history/get-entry",
+                           "history/append", "history/append-flush",
+                           "history/sqlite-import", "history/sqlite-insert", "history/sqlite-query",
+                           "statistics/history", "statistics/algorithms", "statistics/rebuild",
+                           "statistics/sqlite-seed" })) {
+            return;
+        }
+
+        // Entries like the GUI writes them: ten agents, a few algorithms, some failures
+        const QStringList algorithms = NativeFusion::algorithms();
+        QRandomGenerator random(7);
+        const QDateTime start = QDateTime::currentDateTime();
+        QList<HistoryEntry> entries;
+        entries.reserve(entryCount);
+        for (qint64 i = 0; i < entryCount; ++i) {
+            HistoryEntry entry;
+            entry.id = QUuid::createUuid().toString(QUuid::WithoutBraces);
+            entry.timestamp = start.addSecs(i);
+            for (int a = 0; a < 10; ++a) {
+                entry.agents.append(random.generateDouble());
+                entry.confidences.append(random.generateDouble());
+            }
+            entry.algorithm = algorithms[i % algorithms.size()];
+            entry.result = random.generateDouble();
+            entry.confidence = 1.0;
+            entry.executionTime = random.bounded(100);
+            entry.status = i % 20 == 0 ? "error" : "success";
+            entries.append(entry);
+        }
+
+        // The journal HistoryManager persists through, on a history of its own
+        HistoryWriter writer;
+        HistoryJournal journal(&writer);
+        QList<HistoryEntry> loaded;
+        journal.load(path, loaded);
+        run("history/compact", entryCount, entryCount, [&]() { g_sink = journal.compactNow(entries); });
+        run("history/load", entryCount, entryCount, [&]() { g_sink = journal.load(path, loaded); });
+        // What saving one result costs, whatever the history size
+        const HistoryEntry newest = entries.last();
+        run("history/append", entryCount, 1, [&]() {
+            g_sink = journal.appendEntry(newest, entryCount);
+        });
+        writer.flush();
+        run("history/append-flush", entryCount, 1, [&]() {
+            journal.appendEntry(newest, entryCount);
+            g_sink = writer.flush();
+        });
+        // Folds the appends above back out before the manager loads the file
+        journal.compactNow(entries);
+
+        // One lookup by id, as a history delegate makes
+        history.setMaxHistoryEntries(static_cast<int>(entryCount));
+        history.setHistoryFilePath(path);
+        const QString middleId = entries[entries.size() / 2].id;
+        run("history/get-entry", entryCount, 1, [&]() {
+            g_sink = history.getEntry(middleId).size();
+        });
+
+        // A statistics refresh after a change: the running totals to maps
+        HistoryAggregates aggregates;
+        aggregates.rebuild(entries);
+        run("statistics/history", entryCount, 1, [&]() {
+            g_sink = aggregates.statistics().size();
+        });
+        run("statistics/algorithms", entryCount, 1, [&]() {
+            g_sink = aggregates.algorithmStatistics().size();
+        });
+        // What a load pays once to build them
+        run("statistics/rebuild", entryCount, entryCount, [&]() {
+            aggregates.rebuild(entries);
+        });
+
+        if (HistoryDatabase::isAvailable()) {
+            HistoryDatabase database;
+            if (database.open(QString(path).replace(".json", ".sqlite"))) {
+                run("history/sqlite-import", entryCount, entryCount, [&]() {
+                    database.clear();
+                    g_sink = database.insert(entries);
+                });
+                HistoryEntry added = newest;
+                qint64 sequence = 0;
+                run("history/sqlite-insert", entryCount, 1, [&]() {
+                    added.id = QString::number(sequence++);
+                    g_sink = database.insert(added);
+                });
+                HistoryDatabase::Filter filter;
+                filter.algorithm = newest.algorithm;
+                filter.limit = 100;
+                run("history/sqlite-query", entryCount, 100, [&]() {
+                    g_sink = database.query(filter).size();
+                });
+                // What opening the sqlite backend costs on top of the connection
+                run("statistics/sqlite-seed", entryCount, entryCount, [&]() {
+                    HistoryAggregates seeded;
+                    database.forEachSummary([&seeded](const HistoryEntry &entry) { seeded.add(entry); });
+                    g_sink = seeded.statistics().size();
+                });
+                database.clear();
+            } else {
+                qWarning() << "history/sqlite skipped:" << database.errorString();
+            }
+        }
+
+    }
+
+    void comparisonStatistics()
+    {
+        // A full comparison over every bundled script
+        const QStringList scripts = { "neural.py", "weighted.py", "weighted_with_confidence.py",
+                                      "consensus.py", "fuzzy.py", "random_forest.py", "fuse.py" };
+        QRandomGenerator random(11);
+        ComparisonResultModel model;
+        for (const QString &script : scripts) {
+            ComparisonResult result;
+            result.algorithm = script;
+            result.value = random.generateDouble();
+            result.executionTime = random.bounded(1000);
+            result.ok = true;
+            model.add(result);
+        }
+
+        run("statistics/comparison", scripts.size(), scripts.size(), [&]() {
+            g_sink = model.summary().mean;
+        });
+    }
+
+private:
+    QString m_filter;
+    double m_minSeconds;
+    QTextStream m_out;
+};
+
+int main(int argc, char *argv[])
+{
+    // Keep every history and log file in Qt's test locations
+    QStandardPaths::setTestModeEnabled(true);
+
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("gdssbench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Benchmarks the GDSS fusion paths and data handling.");
+    parser.addHelpOption();
+
+    QCommandLineOption filterOption("filter", "Only run benchmarks whose name contains this text.", "text");
+    QCommandLineOption sizesOption("sizes", "Agent counts (default: 10,1000,100000,1000000,10000000).",
+                                   "list", "10,1000,100000,1000000,10000000");
+    QCommandLineOption historySizesOption("history-sizes", "History entry counts (default: 1000,100000,1000000).",
+                                          "list", "1000,100000,1000000");
+    QCommandLineOption minMsOption("min-ms", "Shortest measuring time per benchmark (default: 200).", "ms", "200");
+    QCommandLineOption scriptsOption("scripts", "Scripts directory; enables the Python worker benchmarks.", "dir");
+    QCommandLineOption pythonMaxOption("python-max", "Largest agent count sent to Python (default: 1000000).",
+                                       "n", "1000000");
+
+    parser.addOptions({ filterOption, sizesOption, historySizesOption, minMsOption, scriptsOption,
+                        pythonMaxOption });
+    parser.process(app);
+
+    QLoggingCategory::setFilterRules("*.debug=false");
+
+    EngineBenchmark bench(parser.value(filterOption), parser.value(minMsOption).toDouble() / 1000.0);
+
+    QTemporaryDir workDir;
+    DecisionEngine engine;
+    engine.setResultCacheEnabled(false); // Repeated runs must not be served from the cache
+    engine.historyManager()->setLogFilePath(workDir.filePath("engine_log.txt"));
+
+    PythonWorkerPool pool;
+    const bool python = parser.isSet(scriptsOption);
+    if (python) {
+        pool.setWorkerScript(QDir(parser.value(scriptsOption)).filePath("gdss_worker.py"));
+        pool.setPoolSize(1);
+    }
+    const qint64 pythonMax = parser.value(pythonMaxOption).toLongLong();
+
+    bench.parsing();
+    bench.comparisonStatistics();
+
+    QRandomGenerator random(42);
+    for (qint64 size : parseSizes(parser.value(sizesOption))) {
+        QVector<double> values(size);
+        QVector<double> confidences(size);
+        for (qint64 i = 0; i < size; ++i) {
+            values[i] = random.generateDouble();
+            confidences[i] = random.generateDouble();
+        }
+
+        bench.kernels(values, confidences);
+        bench.nativeFusion(values, confidences);
+        bench.criteriaFusion(values, confidences);
+        bench.incrementalFusion(values, confidences);
+        bench.streamingFusion(values, confidences);
+        bench.batchFusion(engine, values, confidences);
+
+        const bool pythonSize = python && size <= pythonMax;
+        if (bench.anySelected({ "serialize/json", "serialize/frame-float64", "serialize/frame-float32" })
+            || (pythonSize && bench.anySelected(bench.pythonNames()))) {
+            QVariantList valueList;
+            QVariantList confidenceList;
+            valueList.reserve(size);
+            confidenceList.reserve(size);
+            for (qint64 i = 0; i < size; ++i) {
+                valueList.append(values[i]);
+                confidenceList.append(confidences[i]);
+            }
+
+            bench.serialization(valueList, confidenceList);
+            if (pythonSize) {
+                bench.pythonFusion(pool, parser.value(scriptsOption), valueList, confidenceList);
+            }
+        }
+    }
+
+    HistoryManager history;
+    history.setLogFilePath(workDir.filePath("history_log.txt"));
+    for (qint64 entries : parseSizes(parser.value(historySizesOption))) {
+        bench.history(history, workDir.filePath(QString("history-%1.json").arg(entries)), entries);
+    }
+
+    pool.shutdown();
+    return 0;
+}
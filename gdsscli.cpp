@@ -0,0 +1,316 @@
+// gdss-cli: headless batch fusion on the engine behind the GUI.
+//
+//   gdss-cli [options] [file...]
+//
+// Each input file (stdin when no file or "-" is given) holds one agent set in
+// the format the GUI loads, see agentfile.h. Every set is fused with each
+// requested algorithm through DecisionEngine::runBatchFusion(), so native
+// algorithms run in-process and Python scripts are spread over the worker
+// pool, and one row per file and algorithm is written to stdout or --output.
+// Files are read in parallel; Python is only started if a script needs it.
+//
+//   gdss-cli --stream [--window 10] [--window-ms 0] [--tick 100] [--half-life 0] [file]
+//
+// treats the input as a continuous feed of "agent value [confidence]" lines
+// instead (see StreamingFusion) and writes one row per tick until it ends.
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QEventLoop>
+#include <QFile>
+#include <QLoggingCategory>
+#include <QTextStream>
+#include <QThreadPool>
+#include <QVector>
+#include <cstdio>
+#include "agentfile.h"
+#include "decisionengine.h"
+#include "engineoptions.h"
+#include "streamingfusion.h"
+
+namespace {
+
+struct Input {
+    QString name;
+    AgentFile::Agents agents;
+    QString error;
+    int caseIndex = -1;  // position in the batch, -1 when the file is not fused
+};
+
+QString field(const QString &text, QChar separator)
+{
+    if (!text.contains(separator) && !text.contains('"') && !text.contains('\n')) {
+        return text;
+    }
+    QString escaped = text;
+    escaped.replace('"', "\"\"");
+    return '"' + escaped + '"';
+}
+
+void readInput(Input &input)
+{
+    if (input.name == "-") {
+        QFile in;
+        if (!in.open(stdin, QIODevice::ReadOnly)) {
+            input.error = in.errorString();
+            return;
+        }
+        input.agents = AgentFile::parse(in.readAll());
+    } else if (!AgentFile::read(input.name, input.agents, &input.error)) {
+        return;
+    }
+
+    if (input.agents.values.isEmpty()) {
+        input.error = "No valid agents";
+    }
+}
+
+// --stream: one row per tick until the input ends
+int runStream(StreamingFusion &stream, const QString &algorithm, const QString &input,
+              QFile &outputFile, QChar separator)
+{
+    QTextStream out(&outputFile);
+    QTextStream err(stderr);
+
+    int errors = 0;
+    QObject::connect(&stream, &StreamingFusion::streamError, [&err, &errors](const QString &message) {
+        err << message << Qt::endl;
+        errors++;
+    });
+
+    stream.setAlgorithm(algorithm);
+    if (errors > 0) {
+        return 2;
+    }
+
+    out << QStringList({ "time_ms", "agents", "fused", "confidence" }).join(separator) << '\n';
+    out.flush();
+
+    QObject::connect(&stream, &StreamingFusion::ticked,
+                     [&out, separator](double fused, double confidence, int agents, qint64 timestamp) {
+                         if (agents == 0) {
+                             return;
+                         }
+                         QStringList row;
+                         row << QString::number(timestamp)
+                             << QString::number(agents)
+                             << QString::number(fused, 'g', 12)
+                             << QString::number(confidence, 'g', 12);
+                         out << row.join(separator) << '\n';
+                         out.flush(); // Readers downstream want every tick as it happens
+                     });
+
+    QEventLoop loop;
+    QObject::connect(&stream, &StreamingFusion::ingestionFinished, &loop,
+                     [&err, &loop](qint64 readings, qint64 invalidLines) {
+                         if (invalidLines > 0) {
+                             err << invalidLines << " invalid lines ignored, " << readings << " readings fused"
+                                 << Qt::endl;
+                         }
+                         loop.quit();
+                     });
+
+    if (!stream.ingest(input)) {
+        return 2;
+    }
+    stream.start();
+    loop.exec();
+    stream.stop();
+
+    if (stream.droppedReadings() > 0) {
+        err << stream.droppedReadings() << " readings dropped" << Qt::endl;
+    }
+    return errors > 0 ? 1 : 0;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("gdss-cli");
+    QCoreApplication::setApplicationVersion("0.1");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Fuses agent files with GDSS algorithms, without the GUI.");
+    parser.addHelpOption();
+    parser.addVersionOption();
+    parser.addPositionalArgument("files", "Agent files (CSV, TSV, ...); stdin if none or \"-\".", "[file...]");
+
+    QCommandLineOption algorithmOption(QStringList() << "a" << "algorithm",
+                                       "Algorithm to run, repeatable or comma-separated "
+                                       "(default: weighted_with_confidence).",
+                                       "name");
+    QCommandLineOption outputOption(QStringList() << "o" << "output",
+                                    "Write results to this file instead of stdout.", "file");
+    QCommandLineOption formatOption("format", "Output format: csv or tsv (default: csv).", "format", "csv");
+    QCommandLineOption verboseOption(QStringList() << "v" << "verbose", "Print engine diagnostics to stderr.");
+    QCommandLineOption streamOption("stream", "Read \"agent value [confidence]\" lines continuously and "
+                                              "write one fused row per tick (native algorithms only).");
+    QCommandLineOption windowOption("window", "Stream: readings kept per agent, 0 for no limit (default: 10).",
+                                    "n", "10");
+    QCommandLineOption windowMsOption("window-ms", "Stream: drop readings older than this, 0 for never (default: 0).",
+                                      "ms", "0");
+    QCommandLineOption tickOption("tick", "Stream: fuse every this many ms (default: 100).", "ms", "100");
+    QCommandLineOption halfLifeOption("half-life", "Stream: halve a reading's weight every this many ms, "
+                                                   "0 for equal weights (default: 0).",
+                                      "ms", "0");
+
+    parser.addOptions({ algorithmOption, outputOption, formatOption, verboseOption,
+                        streamOption, windowOption, windowMsOption, tickOption, halfLifeOption });
+    EngineOptions::addTo(parser);
+    parser.process(app);
+
+    if (!parser.isSet(verboseOption)) {
+        QLoggingCategory::setFilterRules("*.debug=false");
+    }
+
+    QTextStream err(stderr);
+
+    QString format = parser.value(formatOption);
+    if (format != "csv" && format != "tsv") {
+        err << "Unknown output format: " << format << Qt::endl;
+        return 2;
+    }
+    QChar separator = format == "tsv" ? QChar('\t') : QChar(',');
+
+    QStringList algorithms;
+    for (const QString &value : parser.values(algorithmOption)) {
+        for (const QString &name : value.split(',', Qt::SkipEmptyParts)) {
+            algorithms.append(EngineOptions::scriptFileName(name.trimmed()));
+        }
+    }
+    if (algorithms.isEmpty()) {
+        algorithms.append("weighted_with_confidence.py");
+    }
+
+    QStringList files = parser.positionalArguments();
+    if (files.isEmpty()) {
+        files.append("-");
+    }
+
+    QFile outputFile;
+    bool opened;
+    if (parser.isSet(outputOption)) {
+        outputFile.setFileName(parser.value(outputOption));
+        opened = outputFile.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text);
+    } else {
+        opened = outputFile.open(stdout, QIODevice::WriteOnly);
+    }
+    if (!opened) {
+        err << "Cannot open output: " << outputFile.errorString() << Qt::endl;
+        return 2;
+    }
+
+    if (parser.isSet(streamOption)) {
+        if (files.size() != 1 || algorithms.size() != 1) {
+            err << "--stream takes one input and one algorithm" << Qt::endl;
+            return 2;
+        }
+        StreamingFusion stream;
+        stream.setWindowSize(parser.value(windowOption).toInt());
+        stream.setWindowMs(parser.value(windowMsOption).toInt());
+        stream.setTickInterval(parser.value(tickOption).toInt());
+        stream.setDecayHalfLife(parser.value(halfLifeOption).toDouble());
+        return runStream(stream, algorithms.first(), files.first(), outputFile, separator);
+    }
+
+    // Read every file up front, in parallel
+
+    QVector<Input> inputs(files.size());
+    QThreadPool readers;
+    for (int i = 0; i < files.size(); ++i) {
+        inputs[i].name = files[i];
+        if (files[i] == "-") {
+            readInput(inputs[i]); // stdin is read once, here
+        } else {
+            Input *input = &inputs[i];
+            readers.start([input]() { readInput(*input); });
+        }
+    }
+    readers.waitForDone();
+
+    QVariantList cases;
+    for (Input &input : inputs) {
+        if (!input.error.isEmpty()) {
+            continue;
+        }
+        QVariantMap agentSet;
+        agentSet["values"] = input.agents.values;
+        agentSet["confidences"] = input.agents.confidences;
+        input.caseIndex = cases.size();
+        cases.append(agentSet);
+    }
+
+    DecisionEngine engine;
+    EngineOptions::apply(parser, engine);
+
+    QString lastError;
+    QObject::connect(&engine, &DecisionEngine::pythonError, [&lastError](const QString &message) {
+        lastError = message;
+    });
+
+    QTextStream out(&outputFile);
+    out << QStringList({ "file", "algorithm", "agents", "fused", "confidence", "status", "error" })
+               .join(separator)
+        << '\n';
+
+    int failures = 0;
+    for (const QString &algorithm : algorithms) {
+        // One batch per algorithm; the engine spreads it over the whole pool
+        QVariantList results;
+        QString batchError;
+        if (!cases.isEmpty()) {
+            QEventLoop loop;
+            int batchId = 0;
+            QMetaObject::Connection finished = QObject::connect(
+                &engine, &DecisionEngine::batchFinished, &loop,
+                [&](int id, const QVariantList &batchResults) {
+                    if (id == batchId) {
+                        results = batchResults;
+                        loop.quit();
+                    }
+                });
+
+            lastError.clear();
+            batchId = engine.runBatchFusion(cases, algorithm);
+            if (batchId != 0) {
+                loop.exec();
+            } else {
+                batchError = lastError.isEmpty() ? QString("Batch refused") : lastError;
+            }
+            QObject::disconnect(finished);
+        }
+
+        for (const Input &input : inputs) {
+            QVariantMap result;
+            if (input.caseIndex >= 0 && input.caseIndex < results.size()) {
+                result = results[input.caseIndex].toMap();
+            }
+
+            bool ok = result.value("ok").toBool();
+            QString error = !input.error.isEmpty() ? input.error
+                            : !batchError.isEmpty() ? batchError
+                                                    : result.value("error").toString();
+            if (!ok) {
+                failures++;
+            }
+
+            QStringList row;
+            row << field(input.name, separator)
+                << field(algorithm, separator)
+                << QString::number(input.agents.values.size())
+                << (ok ? QString::number(result.value("fused").toDouble(), 'g', 12) : QString())
+                << (ok ? QString::number(result.value("confidence").toDouble(), 'g', 12) : QString())
+                << (ok ? QString("ok") : QString("error"))
+                << field(error, separator);
+            out << row.join(separator) << '\n';
+        }
+        out.flush();
+    }
+
+    if (failures > 0) {
+        err << failures << " of " << inputs.size() * algorithms.size() << " fusions failed" << Qt::endl;
+    }
+    return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,236 @@
+// gdss-loadtest: loopback load generator for gdss-service.
+//
+//   gdss-loadtest [--name gdss-fusion] [-c 8] [-n 1000] [--inflight 16] [--agents 10] [-a weighted]...
+//
+// Opens several connections, keeps a fixed number of requests in flight on
+// each and prints one JSON line with throughput, client-side latency
+// percentiles, the mean batch size the service reported and the service's
+// own statistics. With more than one -a every request is a comparison.
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLocalSocket>
+#include <QRandomGenerator>
+#include <QTextStream>
+#include <QVector>
+#include <algorithm>
+#include <memory>
+#include <vector>
+#include "engineoptions.h"
+#include "serviceprotocol.h"
+
+namespace {
+
+struct Connection {
+    QLocalSocket socket;
+    QByteArray buffer;
+    int sent = 0;
+    int received = 0;
+    QHash<qint64, qint64> sentAt;  // request id -> ns
+};
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("gdss-loadtest");
+    QCoreApplication::setApplicationVersion("0.1");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Load test for gdss-service over a local socket.");
+    parser.addHelpOption();
+    parser.addVersionOption();
+
+    QCommandLineOption nameOption("name", "Local socket name (default: gdss-fusion).", "name", "gdss-fusion");
+    QCommandLineOption connectionsOption(QStringList() << "c" << "connections", "Connections (default: 8).", "n", "8");
+    QCommandLineOption requestsOption(QStringList() << "n" << "requests", "Requests per connection (default: 1000).",
+                                      "n", "1000");
+    QCommandLineOption inflightOption("inflight", "Requests in flight per connection (default: 16).", "n", "16");
+    QCommandLineOption agentsOption("agents", "Agents per request (default: 10).", "n", "10");
+    QCommandLineOption algorithmOption(QStringList() << "a" << "algorithm",
+                                       "Algorithm, repeatable (default: weighted_with_confidence).", "name");
+    QCommandLineOption seedOption("seed", "Random seed for the agent values (default: 1).", "n", "1");
+
+    parser.addOptions({ nameOption, connectionsOption, requestsOption, inflightOption, agentsOption,
+                        algorithmOption, seedOption });
+    parser.process(app);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    const QString name = parser.value(nameOption);
+    const int connectionCount = qMax(1, parser.value(connectionsOption).toInt());
+    const int requestsPerConnection = qMax(1, parser.value(requestsOption).toInt());
+    const int inflight = qMax(1, parser.value(inflightOption).toInt());
+    const int agentCount = qMax(1, parser.value(agentsOption).toInt());
+
+    QJsonArray algorithms;
+    for (const QString &algorithm : parser.values(algorithmOption)) {
+        algorithms.append(EngineOptions::scriptFileName(algorithm));
+    }
+    if (algorithms.isEmpty()) {
+        algorithms.append("weighted_with_confidence.py");
+    }
+
+    // A fixed set of agent sets, reused round robin, keeps the client cheap
+    QRandomGenerator random(parser.value(seedOption).toUInt());
+    QVector<QJsonObject> templates;
+    for (int i = 0; i < 64; ++i) {
+        QJsonArray values;
+        QJsonArray confidences;
+        for (int j = 0; j < agentCount; ++j) {
+            values.append(random.generateDouble());
+            confidences.append(0.5 + 0.5 * random.generateDouble());
+        }
+        QJsonObject request;
+        if (algorithms.size() > 1) {
+            request["op"] = "compare";
+            request["algorithms"] = algorithms;
+        } else {
+            request["op"] = "fuse";
+            request["algorithm"] = algorithms.first();
+        }
+        request["values"] = values;
+        request["confidences"] = confidences;
+        templates.append(request);
+    }
+
+    QElapsedTimer clock;
+    std::vector<std::unique_ptr<Connection>> connections;
+    std::vector<qint64> latencies;
+    latencies.reserve(size_t(connectionCount) * requestsPerConnection);
+    qint64 nextId = 1;
+    qint64 errors = 0;
+    qint64 batchSizeTotal = 0;
+    qint64 batchSizeCount = 0;
+    int finishedConnections = 0;
+    bool queryingStats = false;
+
+    auto sendMore = [&](Connection *connection) {
+        while (connection->sent < requestsPerConnection
+               && connection->sent - connection->received < inflight) {
+            QJsonObject request = templates[nextId % templates.size()];
+            request["id"] = nextId;
+            connection->sentAt.insert(nextId, clock.nsecsElapsed());
+            connection->socket.write(ServiceProtocol::encode(request));
+            connection->sent++;
+            nextId++;
+        }
+    };
+
+    auto report = [&](const QJsonObject &serviceStats) {
+        double seconds = clock.nsecsElapsed() / 1e9;
+        std::sort(latencies.begin(), latencies.end());
+        auto percentile = [&latencies](double p) {
+            if (latencies.empty()) {
+                return 0.0;
+            }
+            size_t index = std::min(size_t(p * latencies.size()), latencies.size() - 1);
+            return latencies[index] / 1e6;
+        };
+
+        QJsonObject latency;
+        latency["p50"] = percentile(0.50);
+        latency["p90"] = percentile(0.90);
+        latency["p99"] = percentile(0.99);
+        latency["max"] = latencies.empty() ? 0.0 : latencies.back() / 1e6;
+
+        QJsonObject summary;
+        summary["connections"] = connectionCount;
+        summary["requests"] = static_cast<qint64>(latencies.size());
+        summary["errors"] = errors;
+        summary["seconds"] = seconds;
+        summary["requestsPerSecond"] = seconds > 0 ? latencies.size() / seconds : 0.0;
+        summary["latencyMs"] = latency;
+        summary["meanBatchSize"] = batchSizeCount > 0 ? double(batchSizeTotal) / batchSizeCount : 0.0;
+        summary["service"] = serviceStats;
+        out << QJsonDocument(summary).toJson(QJsonDocument::Compact) << Qt::endl;
+    };
+
+    auto onMessage = [&](Connection *connection, const QJsonObject &reply) {
+        if (queryingStats) {
+            report(reply.value("stats").toObject());
+            app.exit(errors > 0 ? 1 : 0);
+            return;
+        }
+
+        qint64 id = reply.value("id").toInteger();
+        if (!connection->sentAt.contains(id)) {
+            err << "Unexpected reply: " << QJsonDocument(reply).toJson(QJsonDocument::Compact) << Qt::endl;
+            errors++;
+            return;
+        }
+        latencies.push_back(clock.nsecsElapsed() - connection->sentAt.take(id));
+        connection->received++;
+
+        if (!reply.value("ok").toBool()) {
+            errors++;
+        }
+        const QJsonArray parts = reply.contains("results") ? reply.value("results").toArray()
+                                                           : QJsonArray{ reply };
+        for (const QJsonValue &part : parts) {
+            if (part.toObject().contains("batch_size")) {
+                batchSizeTotal += part.toObject().value("batch_size").toInt();
+                batchSizeCount++;
+            }
+        }
+
+        sendMore(connection);
+        if (connection->received == requestsPerConnection && ++finishedConnections == connectionCount) {
+            // Everything answered; ask the service for its view before exiting
+            queryingStats = true;
+            QJsonObject stats;
+            stats["id"] = 0;
+            stats["op"] = "stats";
+            connection->socket.write(ServiceProtocol::encode(stats));
+        }
+    };
+
+    for (int i = 0; i < connectionCount; ++i) {
+        connections.push_back(std::make_unique<Connection>());
+        Connection *connection = connections.back().get();
+
+        QObject::connect(&connection->socket, &QLocalSocket::readyRead, &app, [&, connection]() {
+            connection->buffer.append(connection->socket.readAll());
+            QJsonObject reply;
+            QString error;
+            for (;;) {
+                ServiceProtocol::ReadStatus status = ServiceProtocol::take(connection->buffer, reply, error);
+                if (status == ServiceProtocol::ReadStatus::NeedMoreData) {
+                    break;
+                }
+                if (status != ServiceProtocol::ReadStatus::Message) {
+                    err << "Bad reply from service: " << error << Qt::endl;
+                    app.exit(2);
+                    return;
+                }
+                onMessage(connection, reply);
+            }
+        });
+        QObject::connect(&connection->socket, &QLocalSocket::errorOccurred, &app,
+                         [&, connection](QLocalSocket::LocalSocketError) {
+                             err << "Connection error: " << connection->socket.errorString() << Qt::endl;
+                             app.exit(2);
+                         });
+    }
+
+    clock.start();
+    for (const std::unique_ptr<Connection> &connection : connections) {
+        connection->socket.connectToServer(name);
+        if (!connection->socket.waitForConnected(2000)) {
+            err << "Cannot connect to " << name << ": " << connection->socket.errorString() << Qt::endl;
+            return 2;
+        }
+    }
+    for (const std::unique_ptr<Connection> &connection : connections) {
+        sendMore(connection.get());
+    }
+
+    return app.exec();
+}
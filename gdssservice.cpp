@@ -0,0 +1,72 @@
+// gdss-service: long-running fusion service on a local socket.
+//
+//   gdss-service [--name gdss-fusion] [--batch-window 2] [--max-batch 256]
+//
+// Tools connect with QLocalSocket (a Unix domain socket, or a named pipe on
+// Windows) and speak the framed protocol in serviceprotocol.h; see
+// FusionService for how concurrent requests are batched. gdss-loadtest is
+// a matching client for load tests on one machine.
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QJsonDocument>
+#include <QLoggingCategory>
+#include <QTextStream>
+#include <QTimer>
+#include "decisionengine.h"
+#include "engineoptions.h"
+#include "fusionservice.h"
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("gdss-service");
+    QCoreApplication::setApplicationVersion("0.1");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Serves fusion and comparison requests over a local socket.");
+    parser.addHelpOption();
+    parser.addVersionOption();
+
+    QCommandLineOption nameOption("name", "Local socket name (default: gdss-fusion).", "name", "gdss-fusion");
+    QCommandLineOption windowOption("batch-window", "Longest wait in ms before a partial batch is run (default: 2).",
+                                    "ms", "2");
+    QCommandLineOption maxBatchOption("max-batch", "Requests per batch at most (default: 256).", "n", "256");
+    QCommandLineOption statsOption("stats-interval", "Print statistics to stderr every n seconds, 0 for never.",
+                                   "s", "0");
+    QCommandLineOption verboseOption(QStringList() << "v" << "verbose", "Print engine diagnostics to stderr.");
+
+    parser.addOptions({ nameOption, windowOption, maxBatchOption, statsOption, verboseOption });
+    EngineOptions::addTo(parser);
+    parser.process(app);
+
+    if (!parser.isSet(verboseOption)) {
+        QLoggingCategory::setFilterRules("*.debug=false");
+    }
+
+    QTextStream err(stderr);
+
+    DecisionEngine engine;
+    EngineOptions::apply(parser, engine);
+
+    FusionService service(&engine);
+    service.setBatchWindow(parser.value(windowOption).toInt());
+    service.setMaxBatchSize(parser.value(maxBatchOption).toInt());
+
+    if (!service.listen(parser.value(nameOption))) {
+        err << "Cannot listen on " << parser.value(nameOption) << ": " << service.errorString() << Qt::endl;
+        return 1;
+    }
+    err << "Listening on " << service.serverName() << Qt::endl;
+
+    QTimer statsTimer;
+    int statsInterval = parser.value(statsOption).toInt();
+    if (statsInterval > 0) {
+        QObject::connect(&statsTimer, &QTimer::timeout, &app, [&service, &err]() {
+            err << QJsonDocument(service.statistics()).toJson(QJsonDocument::Compact) << Qt::endl;
+        });
+        statsTimer.start(statsInterval * 1000);
+    }
+
+    return app.exec();
+}
@@ -0,0 +1,913 @@
+// Tests for the in-process fusion paths and the history storage.
+//
+//   NativeFusion       against the script each algorithm replaces, run by
+//                      the Python interpreter CMake found
+//   fuse_batch()       of every script against its fuse(), case by case
+//   IncrementalFusion  against NativeFusion on the same agents, after bulk
+//                      loads and after edits
+//   StreamingFusion    window changes applied to the readings already held
+//   HistoryJournal     segments replayed over the snapshot, torn records
+//                      skipped, compaction folding the segments it covers
+//   HistoryIndex       positions through removals, trims from the front,
+//                      duplicate ids and rebuilds
+//   HistoryWriter      appends landing in order per file, removals between
+//                      them, a bounded queue, and a flush on destruction
+//   HistoryDatabase    an import in one transaction, all or nothing, read
+//                      back by id and by indexed query
+//   HistoryAggregates  removals undoing additions in any order, and the
+//                      running totals against a rebuild, under both
+//                      storage backends of HistoryManager
+//
+// Results must agree within TOLERANCE, the bound nativefusion.h and
+// incrementalfusion.h promise. The script comparisons are skipped when no
+// interpreter with numpy (and scikit-learn, for the learning scripts) is
+// available, the SQLite cases when the QSQLITE driver does not load.
+
+#include <QDir>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcess>
+#include <QProcessEnvironment>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QVector>
+#include <QtTest>
+#include "historyaggregates.h"
+#include "historydatabase.h"
+#include "historyindex.h"
+#include "historyjournal.h"
+#include "historymanager.h"
+#include "historywriter.h"
+#include "incrementalfusion.h"
+#include "nativefusion.h"
+#include "streamingfusion.h"
+
+namespace {
+
+constexpr double TOLERANCE = 1e-6;
+
+// Fixed agent sets, chosen to reach every branch of the four scripts
+struct AgentSet {
+    const char *name;
+    QVector<double> values;
+    QVector<double> confidences;
+};
+
+QVector<AgentSet> agentSets()
+{
+    QVector<AgentSet> sets = {
+        { "agreement", { 0.62, 0.58, 0.65, 0.6, 0.61 }, { 0.9, 0.8, 0.7, 0.95, 0.85 } },
+        { "conflict", { 0.9, 0.85, 0.1, 0.2, 0.95, 0.15, 0.8 }, { 0.6, 0.7, 0.9, 0.5, 0.8, 0.4, 0.75 } },
+        { "high", { 0.9, 0.92, 0.88, 0.95 }, { 1.0, 1.0, 0.5, 0.25 } },
+        { "low", { 0.1, 0.05, 0.12, 0.08 }, { 0.3, 0.6, 0.9, 0.2 } },
+        { "even-median", { 0.1, 0.4, 0.7, 0.95, 0.3, 0.55 }, { 0.5, 0.5, 0.5, 0.5, 0.5, 0.5 } },
+        { "low-majority", { 0.05, 0.3, 0.45, 0.9, 0.2 }, { 0.1, 0.2, 0.3, 0.4, 0.5 } },
+        { "single", { 0.42 }, { 0.7 } },
+        { "zeros", { 0.0, 0.0, 0.0 }, { 0.2, 0.3, 0.5 } },
+    };
+
+    // A large set, for accumulated rounding
+    AgentSet spread { "spread-1000", {}, {} };
+    for (int i = 0; i < 1000; ++i) {
+        spread.values.append(((i * 7919) % 1000) / 1000.0);
+        spread.confidences.append(0.1 + ((i * 104729) % 900) / 1000.0);
+    }
+    sets.append(spread);
+    return sets;
+}
+
+// Runs each script as __main__ on its JSON input, the way the engine does
+// without a worker, and prints the fused value and confidence of every case
+// read from stdin
+const char REFERENCE_DRIVER[] = R"(
+import io, json, os, runpy, sys
+sys.path.insert(0, sys.argv[1])
+results = []
+for case in json.load(sys.stdin):
+    sys.stdin = io.StringIO(json.dumps(case["input"]))
+    sys.stdout = output = io.StringIO()
+    try:
+        runpy.run_path(os.path.join(sys.argv[1], case["script"]), run_name="__main__")
+    finally:
+        sys.stdout = sys.__stdout__
+    result = json.loads(output.getvalue().strip().splitlines()[-1])
+    results.append([result["fused"], result.get("confidence", 1.0)])
+print(json.dumps(results))
+)";
+
+// Fuses every case read from stdin with the script's fuse() one at a time
+// and with one fuse_batch() call, and prints both result lists
+const char BATCH_DRIVER[] = R"(
+import importlib, json, sys
+sys.path.insert(0, sys.argv[1])
+module = importlib.import_module(sys.argv[2][:-len(".py")])
+cases = json.load(sys.stdin)
+single = [module.fuse(case["values"], case.get("confidences")) for case in cases]
+print(json.dumps([single, module.fuse_batch(cases)]))
+)";
+
+QList<AgentData> toAgents(const QVector<double> &values, const QVector<double> &confidences)
+{
+    QList<AgentData> agents;
+    for (qsizetype i = 0; i < values.size(); ++i) {
+        agents.append(AgentData(values[i], confidences.isEmpty() ? 1.0 : confidences[i]));
+    }
+    return agents;
+}
+
+QJsonArray toJson(const QVector<double> &values)
+{
+    QJsonArray array;
+    for (double value : values) {
+        array.append(value);
+    }
+    return array;
+}
+
+// Distinct entries, every third one failed
+HistoryEntry historyEntry(int n)
+{
+    HistoryEntry entry;
+    entry.id = QString("entry-%1").arg(n);
+    entry.timestamp = QDateTime(QDate(2024, 1, 1), QTime(0, 0)).addSecs(n * 3600);
+    entry.algorithm = n % 2 ? "weighted.py" : "fuzzy.py";
+    entry.result = ((n * 37) % 100) / 100.0;
+    entry.confidence = 0.5 + (n % 5) / 10.0;
+    entry.executionTime = 1.0 + n % 7;
+    entry.status = n % 3 == 2 ? "error" : "success";
+    return entry;
+}
+
+QStringList entryIds(const QList<HistoryEntry> &entries)
+{
+    QStringList ids;
+    for (const HistoryEntry &entry : entries) {
+        ids.append(entry.id);
+    }
+    return ids;
+}
+
+// Where a linear scan finds each id: the oldest entry carrying it
+void verifyIndex(const HistoryIndex &index, const QList<HistoryEntry> &entries)
+{
+    for (qsizetype position = 0; position < entries.size(); ++position) {
+        const QString &id = entries[position].id;
+        if (id.isEmpty()) {
+            continue;
+        }
+        qsizetype expected = 0;
+        while (entries[expected].id != id) {
+            expected++;
+        }
+        QCOMPARE(index.find(entries, id), expected);
+    }
+}
+
+// Same keys and values; numbers within TOLERANCE, as running sums round
+// differently from a fresh pass
+void compareStatistics(const QVariantMap &actual, const QVariantMap &expected)
+{
+    QCOMPARE(actual.keys(), expected.keys());
+    for (auto it = expected.cbegin(); it != expected.cend(); ++it) {
+        const QVariant value = actual.value(it.key());
+        if (it->typeId() == QMetaType::QVariantMap) {
+            compareStatistics(value.toMap(), it->toMap());
+        } else if (it->typeId() == QMetaType::Double) {
+            QVERIFY2(qAbs(value.toDouble() - it->toDouble()) <= TOLERANCE,
+                     qPrintable(QString("%1: %2, expected %3").arg(it.key()).arg(value.toDouble()).arg(it->toDouble())));
+        } else {
+            QCOMPARE(value, it.value());
+        }
+    }
+}
+
+QByteArray readFile(const QString &path)
+{
+    QFile file(path);
+    return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+}
+
+QStringList journalSegments(const QTemporaryDir &dir)
+{
+    return QDir(dir.path()).entryList({ "history.json.*.journal" }, QDir::Files, QDir::Name);
+}
+
+} // namespace
+
+class FusionTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void nativeMatchesScripts_data();
+    void nativeMatchesScripts();
+    void batchMatchesSingle_data();
+    void batchMatchesSingle();
+    void incrementalMatchesNative_data();
+    void incrementalMatchesNative();
+    void incrementalFollowsEdits_data();
+    void incrementalFollowsEdits();
+    void streamingWindowShrinks();
+    void journalReplaysOverSnapshot();
+    void journalSkipsTornRecords();
+    void journalCompactsInBackground();
+    void indexFollowsPositions();
+    void writerKeepsOrder();
+    void aggregatesUndoEachOther();
+    void aggregatesMatchAcrossBackends();
+    void writerFlushesOnDestruction();
+    void databaseImports();
+
+private:
+    struct Reference {
+        double fused;
+        double confidence;
+    };
+
+    static QString caseName(const QString &script, const AgentSet &set, bool withConfidences);
+
+    QHash<QString, Reference> m_reference;  // caseName() -> script result
+    QString m_referenceError;  // why m_reference is empty
+};
+
+QString FusionTest::caseName(const QString &script, const AgentSet &set, bool withConfidences)
+{
+    return QString("%1 %2%3").arg(script, QLatin1String(set.name),
+                                  withConfidences ? QLatin1String(" (confidences)") : QLatin1String());
+}
+
+void FusionTest::initTestCase()
+{
+    // One interpreter run answers every case
+    QJsonArray cases;
+    QStringList names;
+    for (const QString &script : NativeFusion::algorithms()) {
+        for (const AgentSet &set : agentSets()) {
+            for (bool withConfidences : { false, true }) {
+                QJsonObject input;
+                input["values"] = toJson(set.values);
+                input["agent_count"] = static_cast<int>(set.values.size());
+                if (withConfidences) {
+                    input["confidences"] = toJson(set.confidences);
+                }
+                QJsonObject request;
+                request["script"] = script;
+                request["input"] = input;
+                cases.append(request);
+                names.append(caseName(script, set, withConfidences));
+            }
+        }
+    }
+
+    QProcess python;
+    python.start(GDSS_TEST_PYTHON, { "-c", REFERENCE_DRIVER, GDSS_TEST_SCRIPTS_DIR });
+    if (!python.waitForStarted()) {
+        m_referenceError = QString("%1 did not start").arg(GDSS_TEST_PYTHON);
+        return;
+    }
+    python.write(QJsonDocument(cases).toJson(QJsonDocument::Compact));
+    python.closeWriteChannel();
+    if (!python.waitForFinished(60000) || python.exitCode() != 0) {
+        m_referenceError = QString("The scripts failed: %1")
+                               .arg(QString::fromUtf8(python.readAllStandardError()).trimmed());
+        return;
+    }
+
+    const QJsonArray results = QJsonDocument::fromJson(python.readAllStandardOutput()).array();
+    if (results.size() != names.size()) {
+        m_referenceError = "The scripts returned an unexpected number of results";
+        return;
+    }
+    for (qsizetype i = 0; i < names.size(); ++i) {
+        const QJsonArray result = results[i].toArray();
+        m_reference.insert(names[i], { result[0].toDouble(), result[1].toDouble() });
+    }
+}
+
+void FusionTest::nativeMatchesScripts_data()
+{
+    QTest::addColumn<QString>("script");
+    QTest::addColumn<QVector<double>>("values");
+    QTest::addColumn<QVector<double>>("confidences");
+    QTest::addColumn<QString>("referenceName");
+
+    for (const QString &script : NativeFusion::algorithms()) {
+        for (const AgentSet &set : agentSets()) {
+            for (bool withConfidences : { false, true }) {
+                const QString name = caseName(script, set, withConfidences);
+                QTest::newRow(qPrintable(name))
+                    << script << set.values
+                    << (withConfidences ? set.confidences : QVector<double>()) << name;
+            }
+        }
+    }
+}
+
+void FusionTest::nativeMatchesScripts()
+{
+    QFETCH(QString, script);
+    QFETCH(QVector<double>, values);
+    QFETCH(QVector<double>, confidences);
+    QFETCH(QString, referenceName);
+
+    if (m_reference.isEmpty()) {
+        QSKIP(qPrintable(m_referenceError));
+    }
+
+    const NativeFusionResult result = NativeFusion::run(script, toAgents(values, confidences),
+                                                        !confidences.isEmpty());
+    const Reference expected = m_reference.value(referenceName);
+
+    QVERIFY2(result.ok, qPrintable(result.errorMessage));
+    QVERIFY2(qAbs(result.fused - expected.fused) <= TOLERANCE,
+             qPrintable(QString("fused %1, script %2").arg(result.fused, 0, 'g', 17).arg(expected.fused, 0, 'g', 17)));
+    QVERIFY2(qAbs(result.confidence - expected.confidence) <= TOLERANCE,
+             qPrintable(QString("confidence %1, script %2").arg(result.confidence, 0, 'g', 17).arg(expected.confidence, 0, 'g', 17)));
+}
+
+void FusionTest::batchMatchesSingle_data()
+{
+    QTest::addColumn<QString>("script");
+
+    QStringList scripts = NativeFusion::algorithms();
+    scripts << "neural.py" << "fuse.py" << "random_forest.py";
+    for (const QString &script : scripts) {
+        QTest::newRow(qPrintable(script)) << script;
+    }
+}
+
+void FusionTest::batchMatchesSingle()
+{
+    QFETCH(QString, script);
+
+    if (m_reference.isEmpty()) {
+        QSKIP(qPrintable(m_referenceError));
+    }
+
+    // The small agent sets with and without confidences, plus values above 1
+    // for the scripts that clip their output. The large set is left out; it
+    // would train a 1000-input model for each learning script.
+    QJsonArray cases;
+    QVector<AgentSet> sets = agentSets();
+    sets.removeLast();
+    sets.append({ "above-range", { 1.4, 1.2, 1.9, 1.6 }, { 0.5, 0.6, 0.7, 0.8 } });
+    for (const AgentSet &set : sets) {
+        for (bool withConfidences : { false, true }) {
+            QJsonObject request;
+            request["values"] = toJson(set.values);
+            if (withConfidences) {
+                request["confidences"] = toJson(set.confidences);
+            }
+            cases.append(request);
+        }
+    }
+
+    // Keep the models this trains out of the user's cache
+    QTemporaryDir modelCache;
+    QVERIFY(modelCache.isValid());
+    QProcessEnvironment environment = QProcessEnvironment::systemEnvironment();
+    environment.insert("GDSS_MODEL_CACHE", modelCache.path());
+
+    QProcess python;
+    python.setProcessEnvironment(environment);
+    python.start(GDSS_TEST_PYTHON, { "-c", BATCH_DRIVER, GDSS_TEST_SCRIPTS_DIR, script });
+    QVERIFY(python.waitForStarted());
+    python.write(QJsonDocument(cases).toJson(QJsonDocument::Compact));
+    python.closeWriteChannel();
+    QVERIFY(python.waitForFinished(120000));
+    const QString errors = QString::fromUtf8(python.readAllStandardError()).trimmed();
+    if (python.exitCode() != 0 && errors.contains("No module named 'sklearn'")) {
+        QSKIP("scikit-learn is not installed");
+    }
+    QVERIFY2(python.exitCode() == 0, qPrintable(errors));
+
+    const QJsonArray output = QJsonDocument::fromJson(python.readAllStandardOutput()).array();
+    const QJsonArray single = output.at(0).toArray();
+    const QJsonArray batch = output.at(1).toArray();
+    QCOMPARE(single.size(), cases.size());
+    QCOMPARE(batch.size(), cases.size());
+    for (qsizetype i = 0; i < cases.size(); ++i) {
+        const QJsonObject expected = single[i].toObject();
+        const QJsonObject result = batch[i].toObject();
+        QVERIFY2(qAbs(result["fused"].toDouble() - expected["fused"].toDouble()) <= TOLERANCE,
+                 qPrintable(QString("case %1: batch %2, single %3").arg(i)
+                                .arg(result["fused"].toDouble(), 0, 'g', 17)
+                                .arg(expected["fused"].toDouble(), 0, 'g', 17)));
+        QVERIFY(qAbs(result["confidence"].toDouble(1.0) - expected["confidence"].toDouble(1.0)) <= TOLERANCE);
+    }
+}
+
+void FusionTest::incrementalMatchesNative_data()
+{
+    QTest::addColumn<QString>("script");
+    QTest::addColumn<QVector<double>>("values");
+    QTest::addColumn<QVector<double>>("confidences");
+
+    for (const QString &script : NativeFusion::algorithms()) {
+        if (!IncrementalFusion::supports(script)) {
+            continue;
+        }
+        for (const AgentSet &set : agentSets()) {
+            QTest::newRow(qPrintable(QString("%1 %2").arg(script, QLatin1String(set.name))))
+                << script << set.values << set.confidences;
+        }
+    }
+}
+
+void FusionTest::incrementalMatchesNative()
+{
+    QFETCH(QString, script);
+    QFETCH(QVector<double>, values);
+    QFETCH(QVector<double>, confidences);
+
+    IncrementalFusion incremental;
+    for (qsizetype i = 0; i < values.size(); ++i) {
+        incremental.add(values[i], confidences[i]);
+    }
+
+    const NativeFusionResult expected = NativeFusion::run(script, values.constData(),
+                                                          confidences.constData(), values.size());
+    const NativeFusionResult result = incremental.result(script);
+
+    QCOMPARE(result.ok, expected.ok);
+    QVERIFY(qAbs(result.fused - expected.fused) <= TOLERANCE);
+    QVERIFY(qAbs(result.confidence - expected.confidence) <= TOLERANCE);
+}
+
+void FusionTest::incrementalFollowsEdits_data()
+{
+    QTest::addColumn<QString>("script");
+    QTest::addColumn<int>("checkEvery");
+
+    // Checking after every edit merges one buffered edit at a time; checking
+    // rarely lets thousands pile up and merge in bulk
+    for (const QString &script : NativeFusion::algorithms()) {
+        if (IncrementalFusion::supports(script)) {
+            QTest::newRow(qPrintable(script + " each edit")) << script << 1;
+            QTest::newRow(qPrintable(script + " bursts")) << script << 2500;
+        }
+    }
+}
+
+void FusionTest::incrementalFollowsEdits()
+{
+    QFETCH(QString, script);
+    QFETCH(int, checkEvery);
+
+    // Start from the large set, then replace, remove and add agents, checking
+    // the running state against a full recompute every checkEvery edits
+    const AgentSet start = agentSets().last();
+    QVector<double> values = start.values;
+    QVector<double> confidences = start.confidences;
+
+    IncrementalFusion incremental;
+    for (qsizetype i = 0; i < values.size(); ++i) {
+        incremental.add(values[i], confidences[i]);
+    }
+
+    for (int edit = 0; edit < 10000; ++edit) {
+        const qsizetype i = (edit * 37) % values.size();
+        const double value = ((edit * 613) % 1000) / 1000.0;
+        const double confidence = 0.2 + ((edit * 211) % 800) / 1000.0;
+
+        switch (edit % 3) {
+        case 0:
+            incremental.replace(values[i], confidences[i], value, confidence);
+            values[i] = value;
+            confidences[i] = confidence;
+            break;
+        case 1:
+            incremental.remove(values[i], confidences[i]);
+            values.remove(i);
+            confidences.remove(i);
+            break;
+        default:
+            incremental.add(value, confidence);
+            values.append(value);
+            confidences.append(confidence);
+            break;
+        }
+        if ((edit + 1) % checkEvery != 0) {
+            continue;
+        }
+
+        const NativeFusionResult expected = NativeFusion::run(script, values.constData(),
+                                                              confidences.constData(), values.size());
+        const NativeFusionResult result = incremental.result(script);
+        QCOMPARE(incremental.count(), values.size());
+        QVERIFY2(qAbs(result.fused - expected.fused) <= TOLERANCE,
+                 qPrintable(QString("edit %1: fused %2, native %3").arg(edit).arg(result.fused, 0, 'g', 17).arg(expected.fused, 0, 'g', 17)));
+        QVERIFY(qAbs(result.confidence - expected.confidence) <= TOLERANCE);
+    }
+}
+
+void FusionTest::streamingWindowShrinks()
+{
+    StreamingFusion stream;
+    stream.setAlgorithm("weighted_with_confidence.py");
+    stream.setWindowSize(10);
+    for (int i = 1; i <= 10; ++i) {
+        QVERIFY(stream.push("agent", i / 10.0));
+    }
+    stream.tick();
+    QVERIFY(qAbs(stream.fusedValue() - 0.55) <= TOLERANCE);
+
+    // The last two readings, without waiting for another tick
+    QSignalSpy ticked(&stream, &StreamingFusion::ticked);
+    stream.setWindowSize(2);
+    QCOMPARE(ticked.count(), 1);
+    QVERIFY(qAbs(stream.fusedValue() - 0.95) <= TOLERANCE);
+
+    // Every reading is older than 1 ms by now
+    QTest::qWait(5);
+    stream.setWindowMs(1);
+    QCOMPARE(ticked.count(), 2);
+    QCOMPARE(stream.activeAgents(), 0);
+}
+
+void FusionTest::journalReplaysOverSnapshot()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath("history.json");
+    HistoryWriter writer;
+
+    QList<HistoryEntry> expected;
+    {
+        HistoryJournal journal(&writer);
+        QList<HistoryEntry> loaded;
+        QVERIFY(journal.load(path, loaded));
+        QVERIFY(loaded.isEmpty());
+        for (int n = 0; n < 5; ++n) {
+            expected.append(historyEntry(n));
+            QVERIFY(journal.appendEntry(expected.last(), 0));
+        }
+        QVERIFY(journal.compactNow(expected));
+
+        // Only in the segment after the snapshot
+        for (int n = 5; n < 8; ++n) {
+            expected.append(historyEntry(n));
+            QVERIFY(journal.appendEntry(expected.last(), 0));
+        }
+        QVERIFY(journal.appendRemoval(expected[1].id));
+        expected.removeAt(1);
+        QVERIFY(journal.appendTrim(4));
+        expected = expected.mid(expected.size() - 4);
+        QVERIFY(journal.appendEntry(historyEntry(8), 4));
+        expected = expected.mid(1) << historyEntry(8);
+        QVERIFY(writer.flush());
+    }
+    QCOMPARE(journalSegments(dir), QStringList({ "history.json.1.journal" }));
+
+    HistoryJournal journal(&writer);
+    QList<HistoryEntry> loaded;
+    QVERIFY(journal.load(path, loaded));
+    QCOMPARE(entryIds(loaded), entryIds(expected));
+    QCOMPARE(journal.recordCount(), 6);
+}
+
+void FusionTest::journalSkipsTornRecords()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath("history.json");
+    HistoryWriter writer;
+    {
+        HistoryJournal journal(&writer);
+        QList<HistoryEntry> loaded;
+        QVERIFY(journal.load(path, loaded));
+        for (int n = 0; n < 3; ++n) {
+            QVERIFY(journal.appendEntry(historyEntry(n), 0));
+        }
+        QVERIFY(writer.flush());
+    }
+
+    // A crash mid-append leaves half a line and no newline
+    QFile segment(dir.filePath("history.json.0.journal"));
+    QVERIFY(segment.open(QIODevice::Append));
+    segment.write(R"({"op": "add", "entry": {"id": "torn)");
+    segment.close();
+
+    HistoryJournal journal(&writer);
+    QList<HistoryEntry> loaded;
+    QVERIFY(journal.load(path, loaded));
+    QCOMPARE(entryIds(loaded), QStringList({ "entry-0", "entry-1", "entry-2" }));
+
+    // The next record starts on a line of its own
+    QVERIFY(journal.appendEntry(historyEntry(3), 0));
+    QVERIFY(journal.load(path, loaded));
+    QCOMPARE(entryIds(loaded), QStringList({ "entry-0", "entry-1", "entry-2", "entry-3" }));
+}
+
+void FusionTest::journalCompactsInBackground()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath("history.json");
+    HistoryWriter writer;
+    HistoryJournal journal(&writer);
+    QList<HistoryEntry> entries;
+    QVERIFY(journal.load(path, entries));
+    for (int n = 0; n < 100; ++n) {
+        entries.append(historyEntry(n));
+        QVERIFY(journal.appendEntry(entries.last(), 0));
+    }
+
+    QSignalSpy compacted(&journal, &HistoryJournal::compacted);
+    QVERIFY(journal.compact(entries));
+    QVERIFY(journal.isCompacting());
+    QVERIFY(!journal.compact(entries));
+
+    // Made while the snapshot is written, so only in the new segment
+    entries.append(historyEntry(100));
+    QVERIFY(journal.appendEntry(entries.last(), 0));
+    QCOMPARE(journal.recordCount(), 1);
+
+    QVERIFY(compacted.wait(10000));
+    QCOMPARE(compacted.first().at(0).toBool(), true);
+    QVERIFY(!journal.isCompacting());
+    QVERIFY(writer.flush());
+    QCOMPARE(journalSegments(dir), QStringList({ "history.json.1.journal" }));
+
+    QFile snapshot(path);
+    QVERIFY(snapshot.open(QIODevice::ReadOnly));
+    const QJsonObject root = QJsonDocument::fromJson(snapshot.readAll()).object();
+    QCOMPARE(root.value("generation").toInt(), 1);
+    QCOMPARE(root.value("entries").toArray().size(), qsizetype(100));
+
+    QList<HistoryEntry> loaded;
+    QVERIFY(journal.load(path, loaded));
+    QCOMPARE(entryIds(loaded), entryIds(entries));
+}
+
+void FusionTest::indexFollowsPositions()
+{
+    QList<HistoryEntry> entries;
+    HistoryIndex index;
+    for (int n = 0; n < 10; ++n) {
+        entries.append(historyEntry(n));
+        index.append(entries.last().id);
+    }
+    // Hashed as parsed, unlike the name-folded ids above
+    entries.append(historyEntry(10));
+    entries.last().id = QUuid::createUuid().toString(QUuid::WithoutBraces);
+    index.append(entries.last().id);
+    verifyIndex(index, entries);
+
+    // A removed entry leaves an empty slot, so nothing after it moves
+    index.remove(entries[4].id, 4);
+    entries[4] = HistoryEntry{};
+    QCOMPARE(index.find(entries, "entry-4"), qsizetype(-1));
+    verifyIndex(index, entries);
+
+    // Trims only advance the base, through the empty slot too
+    for (int i = 0; i < 5; ++i) {
+        index.removeFirst(entries.first().id);
+        entries.removeFirst();
+        verifyIndex(index, entries);
+    }
+    QCOMPARE(index.find(entries, "entry-5"), qsizetype(0));
+    QCOMPARE(index.size(), qsizetype(6));
+
+    // An id imported twice resolves to the older entry
+    entries.append(historyEntry(7));
+    index.append(entries.last().id);
+    QCOMPARE(index.find(entries, "entry-7"), qsizetype(2));
+    index.remove("entry-7", 2);
+    entries[2] = HistoryEntry{};
+    QCOMPARE(index.find(entries, "entry-7"), entries.size() - 1);
+
+    HistoryIndex rebuilt;
+    rebuilt.rebuild(entries);
+    QCOMPARE(rebuilt.size(), index.size());
+    verifyIndex(rebuilt, entries);
+    QCOMPARE(rebuilt.find(entries, "entry-0"), qsizetype(-1));
+}
+
+void FusionTest::writerKeepsOrder()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString first = dir.filePath("logs/first.log");  // directory made on the first write
+    const QString second = dir.filePath("second.log");
+
+    // Room for a few lines only, so appending waits for the thread
+    HistoryWriter writer(64);
+    QByteArray expectedFirst;
+    QByteArray expectedSecond;
+    for (int i = 0; i < 2000; ++i) {
+        const QByteArray line = QByteArray::number(i) + '\n';
+        if (i % 3 == 0) {
+            writer.append(second, line);
+            expectedSecond += line;
+        } else {
+            writer.append(first, line);
+            expectedFirst += line;
+        }
+    }
+    QVERIFY(writer.flush());
+    QCOMPARE(readFile(first), expectedFirst);
+    QCOMPARE(readFile(second), expectedSecond);
+
+    // A removal drops what came before it and keeps what came after
+    writer.append(first, "before\n");
+    writer.remove(first);
+    writer.append(first, "after\n");
+    QVERIFY(writer.flush());
+    QCOMPARE(readFile(first), QByteArray("after\n"));
+
+    const QVariantMap metrics = writer.metrics();
+    QCOMPARE(metrics.value("queueDepth").toInt(), 0);
+    QCOMPARE(metrics.value("queuedBytes").toLongLong(), qint64(0));
+    QCOMPARE(metrics.value("recordsWritten").toLongLong(), qint64(2002));
+    QCOMPARE(metrics.value("writeErrors").toLongLong(), qint64(0));
+}
+
+void FusionTest::aggregatesUndoEachOther()
+{
+    HistoryAggregates aggregates;
+    const QVariantMap empty = aggregates.statistics();
+    QList<HistoryEntry> entries;
+    for (int n = 0; n < 200; ++n) {
+        entries.append(historyEntry(n));
+        aggregates.add(entries.last());
+    }
+
+    // Removing the current extreme brings back the one before it
+    const QVariantMap before = aggregates.statistics();
+    HistoryEntry extreme = historyEntry(200);
+    extreme.status = "success";
+    extreme.result = 2.0;
+    extreme.executionTime = 100.0;
+    aggregates.add(extreme);
+    QCOMPARE(aggregates.statistics().value("maxResult").toDouble(), 2.0);
+    QCOMPARE(aggregates.algorithmStatistics().value(extreme.algorithm).toMap().value("maxExecutionTime").toDouble(), 100.0);
+    aggregates.remove(extreme);
+    compareStatistics(aggregates.statistics(), before);
+
+    // In another order than they were added; 7 and 200 are coprime
+    QList<bool> removed(entries.size(), false);
+    for (int i = 0; i < entries.size(); ++i) {
+        const int position = (i * 7) % entries.size();
+        aggregates.remove(entries[position]);
+        removed[position] = true;
+
+        if (i % 50 == 49) {
+            QList<HistoryEntry> remaining;
+            for (int j = 0; j < entries.size(); ++j) {
+                if (!removed[j]) {
+                    remaining.append(entries[j]);
+                }
+            }
+            HistoryAggregates rebuilt;
+            rebuilt.rebuild(remaining);
+            compareStatistics(aggregates.statistics(), rebuilt.statistics());
+            compareStatistics(aggregates.algorithmStatistics(), rebuilt.algorithmStatistics());
+            QVERIFY(qAbs(aggregates.averageResult() - rebuilt.averageResult()) <= TOLERANCE);
+        }
+    }
+
+    // Nothing left over, rounding residue included
+    QCOMPARE(aggregates.statistics(), empty);
+    QVERIFY(aggregates.algorithmStatistics().isEmpty());
+    QCOMPARE(aggregates.averageResult(), 0.0);
+}
+
+void FusionTest::aggregatesMatchAcrossBackends()
+{
+    if (!HistoryDatabase::isAvailable()) {
+        QSKIP("The QSQLITE driver did not load");
+    }
+    QStandardPaths::setTestModeEnabled(true);
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath("history.json");
+
+    QVariantMap statistics;
+    QVariantMap algorithmStatistics;
+    {
+        HistoryManager manager;
+        manager.setLogFilePath(dir.filePath("gdss.log"));
+        manager.setHistoryFilePath(path);
+        for (int n = 0; n < 60; ++n) {
+            const HistoryEntry entry = historyEntry(n);
+            if (n % 7 == 6) {
+                manager.saveTimeoutResult({ 0.5 }, { 1.0 }, entry.algorithm, "deadline", entry.executionTime);
+            } else if (entry.status == "error") {
+                manager.saveErrorResult({ 0.5 }, { 1.0 }, entry.algorithm, "failed", entry.executionTime);
+            } else {
+                manager.saveFusionResult({ 0.5 }, { 1.0 }, entry.algorithm, entry.result,
+                                         entry.confidence, entry.executionTime);
+            }
+        }
+
+        // The database starts with the JSON history, and its totals with the rows
+        const QVariantMap jsonStatistics = manager.getStatistics();
+        const QVariantMap jsonAlgorithmStatistics = manager.getAlgorithmStatistics();
+        manager.setStorageBackend("sqlite");
+        QCOMPARE(manager.storageBackend(), QString("sqlite"));
+        compareStatistics(manager.getStatistics(), jsonStatistics);
+        compareStatistics(manager.getAlgorithmStatistics(), jsonAlgorithmStatistics);
+
+        // Changes after that only touch the totals
+        const QVariantList shown = manager.getHistoryEntries();
+        for (int i = 0; i < shown.size(); i += 4) {
+            manager.removeEntry(shown[i].toMap().value("id").toString());
+        }
+        manager.saveFusionResult({ 0.5 }, { 1.0 }, "consensus.py", 3.0, 1.0, 250.0);
+        statistics = manager.getStatistics();
+        algorithmStatistics = manager.getAlgorithmStatistics();
+        QCOMPARE(statistics.value("totalEntries").toLongLong(), qint64(60 - 15 + 1));
+        QCOMPARE(statistics.value("maxResult").toDouble(), 3.0);
+    }
+
+    // Seeded from the database alone
+    HistoryManager reopened;
+    reopened.setLogFilePath(dir.filePath("gdss.log"));
+    reopened.setHistoryFilePath(path);
+    reopened.setStorageBackend("sqlite");
+    compareStatistics(reopened.getStatistics(), statistics);
+    compareStatistics(reopened.getAlgorithmStatistics(), algorithmStatistics);
+
+    reopened.clearHistory();
+    QCOMPARE(reopened.getStatistics().value("totalEntries").toLongLong(), qint64(0));
+}
+
+void FusionTest::writerFlushesOnDestruction()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath("history.log");
+
+    QByteArray expected;
+    {
+        HistoryWriter writer;
+        for (int i = 0; i < 10000; ++i) {
+            const QByteArray line = "line " + QByteArray::number(i) + '\n';
+            writer.append(path, line);
+            expected += line;
+        }
+    }
+    QCOMPARE(readFile(path), expected);
+}
+
+void FusionTest::databaseImports()
+{
+    if (!HistoryDatabase::isAvailable()) {
+        QSKIP("The QSQLITE driver did not load");
+    }
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath("history.sqlite");
+
+    QList<HistoryEntry> entries;
+    for (int n = 0; n < 50; ++n) {
+        HistoryEntry entry = historyEntry(n);
+        entry.agents = { n / 100.0, 0.5, 1.0 - n / 100.0 };
+        entry.confidences = { 1.0, 0.75, 0.25 };
+        entries.append(entry);
+    }
+
+    HistoryDatabase database;
+    QVERIFY2(database.open(path), qPrintable(database.errorString()));
+    QVERIFY2(database.insert(entries), qPrintable(database.errorString()));
+    QCOMPARE(database.count(), qint64(50));
+
+    HistoryEntry found;
+    QVERIFY(database.entry("entry-7", found));
+    QCOMPARE(found.timestamp, entries[7].timestamp);
+    QCOMPARE(found.algorithm, entries[7].algorithm);
+    QCOMPARE(found.result, entries[7].result);
+    QCOMPARE(found.status, entries[7].status);
+    QCOMPARE(found.agents, entries[7].agents);
+    QCOMPARE(found.confidences, entries[7].confidences);
+
+    // Newest first
+    QStringList expected;
+    for (auto it = entries.crbegin(); it != entries.crend() && expected.size() < 5; ++it) {
+        if (it->algorithm == "weighted.py" && it->status == "success") {
+            expected.append(it->id);
+        }
+    }
+    HistoryDatabase::Filter filter;
+    filter.algorithm = "weighted.py";
+    filter.status = "success";
+    filter.limit = 5;
+    QCOMPARE(entryIds(database.query(filter)), expected);
+
+    // A duplicate id fails the whole import, with the reason
+    QVERIFY(!database.insert(QList<HistoryEntry>({ historyEntry(50), historyEntry(3) })));
+    QVERIFY(!database.errorString().isEmpty());
+    QCOMPARE(database.count(), qint64(50));
+    QVERIFY(!database.entry("entry-50", found));
+
+    database.close();
+    QVERIFY(database.open(path));
+    QCOMPARE(database.count(), qint64(50));
+}
+
+QTEST_GUILESS_MAIN(FusionTest)
+#include "gdsstest.moc"
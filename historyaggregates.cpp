@@ -0,0 +1,172 @@
+#include "historyaggregates.h"
+#include "historymanager.h"
+#include <QtMath>
+
+template <typename T>
+void HistoryAggregates::Extremes<T>::add(T value)
+{
+    counts[value]++;
+}
+
+template <typename T>
+void HistoryAggregates::Extremes<T>::remove(T value)
+{
+    auto it = counts.find(value);
+    if (it != counts.end() && --it.value() == 0) {
+        counts.erase(it);
+    }
+}
+
+void HistoryAggregates::Totals::apply(const HistoryEntry &entry, int sign)
+{
+    count += sign;
+    if (entry.status != "success") {
+        if (entry.status == "timeout") {
+            timeoutCount += sign;
+        }
+        return;
+    }
+
+    successCount += sign;
+    resultSum += sign * entry.result;
+    confidenceSum += sign * entry.confidence;
+    executionTimeSum += sign * entry.executionTime;
+
+    // NaN has no place in an ordering
+    if (!qIsNaN(entry.result)) {
+        sign > 0 ? results.add(entry.result) : results.remove(entry.result);
+    }
+    if (!qIsNaN(entry.executionTime)) {
+        sign > 0 ? executionTimes.add(entry.executionTime) : executionTimes.remove(entry.executionTime);
+    }
+
+    // Subtracting leaves rounding residue behind; none is left once the
+    // last success is gone
+    if (successCount == 0) {
+        resultSum = 0.0;
+        confidenceSum = 0.0;
+        executionTimeSum = 0.0;
+    }
+}
+
+void HistoryAggregates::clear()
+{
+    m_overall = Totals();
+    m_algorithms.clear();
+    m_timestamps = Extremes<qint64>();
+}
+
+void HistoryAggregates::rebuild(const QList<HistoryEntry> &entries)
+{
+    clear();
+    for (const HistoryEntry &entry : entries) {
+        if (!entry.id.isEmpty()) {  // not a removed slot, see HistoryIndex
+            add(entry);
+        }
+    }
+}
+
+void HistoryAggregates::add(const HistoryEntry &entry)
+{
+    m_overall.apply(entry, 1);
+    m_algorithms[entry.algorithm].apply(entry, 1);
+    m_timestamps.add(entry.timestamp.toMSecsSinceEpoch());
+}
+
+void HistoryAggregates::remove(const HistoryEntry &entry)
+{
+    m_overall.apply(entry, -1);
+    auto it = m_algorithms.find(entry.algorithm);
+    if (it != m_algorithms.end()) {
+        it->apply(entry, -1);
+        if (it->count <= 0) {
+            m_algorithms.erase(it);
+        }
+    }
+    m_timestamps.remove(entry.timestamp.toMSecsSinceEpoch());
+}
+
+QVariantMap HistoryAggregates::statistics() const
+{
+    QVariantMap stats;
+
+    if (m_overall.count == 0) {
+        stats["totalEntries"] = 0;
+        stats["successCount"] = 0;
+        stats["errorCount"] = 0;
+        stats["timeoutCount"] = 0;
+        stats["averageResult"] = 0.0;
+        stats["averageConfidence"] = 0.0;
+        stats["averageExecutionTime"] = 0.0;
+        return stats;
+    }
+
+    const Totals &t = m_overall;
+    stats["totalEntries"] = t.count;
+    stats["successCount"] = t.successCount;
+    stats["errorCount"] = t.count - t.successCount;
+    stats["timeoutCount"] = t.timeoutCount;
+    stats["successRate"] = t.successCount * 100.0 / t.count;
+
+    if (t.successCount > 0) {
+        stats["averageResult"] = t.resultSum / t.successCount;
+        stats["averageConfidence"] = t.confidenceSum / t.successCount;
+        stats["averageExecutionTime"] = t.executionTimeSum / t.successCount;
+    } else {
+        stats["averageResult"] = 0.0;
+        stats["averageConfidence"] = 0.0;
+        stats["averageExecutionTime"] = 0.0;
+    }
+    if (!t.results.isEmpty()) {
+        stats["minResult"] = t.results.min();
+        stats["maxResult"] = t.results.max();
+    }
+    if (!t.executionTimes.isEmpty()) {
+        stats["minExecutionTime"] = t.executionTimes.min();
+        stats["maxExecutionTime"] = t.executionTimes.max();
+    }
+
+    // Date range
+    if (!m_timestamps.isEmpty()) {
+        stats["firstEntry"] = QDateTime::fromMSecsSinceEpoch(m_timestamps.min()).toString("yyyy-MM-dd");
+        stats["lastEntry"] = QDateTime::fromMSecsSinceEpoch(m_timestamps.max()).toString("yyyy-MM-dd");
+    }
+
+    return stats;
+}
+
+QVariantMap HistoryAggregates::algorithmStatistics() const
+{
+    QVariantMap algoStats;
+
+    for (auto it = m_algorithms.cbegin(); it != m_algorithms.cend(); ++it) {
+        const Totals &t = it.value();
+        if (t.successCount == 0) {
+            continue;  // Only algorithms that produced a result are listed
+        }
+
+        QVariantMap stats;
+        stats["usageCount"] = t.successCount;
+        stats["usagePercentage"] = t.successCount * 100.0 / m_overall.count;
+        stats["errorCount"] = t.count - t.successCount;
+        stats["averageResult"] = t.resultSum / t.successCount;
+        stats["averageExecutionTime"] = t.executionTimeSum / t.successCount;
+        if (!t.results.isEmpty()) {
+            stats["minResult"] = t.results.min();
+            stats["maxResult"] = t.results.max();
+        }
+        if (!t.executionTimes.isEmpty()) {
+            stats["minExecutionTime"] = t.executionTimes.min();
+            stats["maxExecutionTime"] = t.executionTimes.max();
+        }
+
+        algoStats[it.key()] = stats;
+    }
+
+    return algoStats;
+}
+
+double HistoryAggregates::averageResult() const
+{
+    return m_overall.successCount > 0 ? m_overall.resultSum / m_overall.successCount : 0.0;
+}
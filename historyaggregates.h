@@ -0,0 +1,68 @@
+#ifndef HISTORYAGGREGATES_H
+#define HISTORYAGGREGATES_H
+
+#include <QHash>
+#include <QList>
+#include <QMap>
+#include <QString>
+#include <QVariantMap>
+
+struct HistoryEntry;
+
+// Running totals over the history, overall and per algorithm.
+//
+// HistoryManager adds every entry it appends and subtracts every entry it
+// trims or removes, so the statistics views read numbers that are already
+// there instead of walking the whole history per call. Counts and sums are
+// plain counters. Minimum and maximum have to survive the removal of the
+// current extreme, so they keep an ordered count of the values: O(log n) per
+// change, O(1) to read.
+//
+// Averages, minimum and maximum cover successful entries only, like the
+// statistics always have; failed entries only count towards the totals.
+class HistoryAggregates
+{
+public:
+    void clear();
+    void rebuild(const QList<HistoryEntry> &entries);
+    void add(const HistoryEntry &entry);
+    void remove(const HistoryEntry &entry);
+
+    // Same keys as HistoryManager::getStatistics(), getAlgorithmStatistics()
+    // and getAverageResult()
+    QVariantMap statistics() const;
+    QVariantMap algorithmStatistics() const;
+    double averageResult() const;
+
+private:
+    // An ordered multiset: value -> how many entries have it
+    template <typename T>
+    struct Extremes {
+        QMap<T, int> counts;
+
+        void add(T value);
+        void remove(T value);
+        bool isEmpty() const { return counts.isEmpty(); }
+        T min() const { return counts.firstKey(); }
+        T max() const { return counts.lastKey(); }
+    };
+
+    struct Totals {
+        qint64 count = 0;
+        qint64 successCount = 0;
+        qint64 timeoutCount = 0;
+        double resultSum = 0.0;
+        double confidenceSum = 0.0;
+        double executionTimeSum = 0.0;
+        Extremes<double> results;
+        Extremes<double> executionTimes;
+
+        void apply(const HistoryEntry &entry, int sign);
+    };
+
+    Totals m_overall;
+    QHash<QString, Totals> m_algorithms;
+    Extremes<qint64> m_timestamps;  // ms since the epoch, every entry
+};
+
+#endif // HISTORYAGGREGATES_H
@@ -0,0 +1,516 @@
+#include "historydatabase.h"
+#include "historymanager.h"
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QtEndian>
+
+namespace {
+
+const char DRIVER[] = "QSQLITE";
+const int SCHEMA_VERSION = 1;
+
+// Columns every entry query selects, in readEntry() order
+const char ENTRY_COLUMNS[] =
+    "e.id, e.timestamp, e.algorithm, e.result, e.confidence, e.execution_time, e.stages, "
+    "e.notes, e.status, e.error_message, a.vals, a.confidences";
+const char ENTRY_SOURCE[] = "entries e LEFT JOIN agents a ON a.entry_seq = e.seq";
+
+QByteArray packDoubles(const QVariantList &values)
+{
+    QByteArray blob(values.size() * static_cast<qsizetype>(sizeof(double)), Qt::Uninitialized);
+    char *out = blob.data();
+    for (const QVariant &value : values) {
+        qToLittleEndian(value.toDouble(), out);
+        out += sizeof(double);
+    }
+    return blob;
+}
+
+QVariantList unpackDoubles(const QByteArray &blob)
+{
+    const qsizetype count = blob.size() / static_cast<qsizetype>(sizeof(double));
+    QVariantList values;
+    values.reserve(count);
+    const char *in = blob.constData();
+    for (qsizetype i = 0; i < count; ++i) {
+        values.append(qFromLittleEndian<double>(in));
+        in += sizeof(double);
+    }
+    return values;
+}
+
+} // namespace
+
+// Statements run once per save or lookup, prepared when the database opens
+struct HistoryDatabase::Statements
+{
+    explicit Statements(const QSqlDatabase &db)
+        : insertEntry(db), insertAgents(db), selectEntry(db), deleteEntry(db)
+    {
+    }
+
+    QSqlQuery insertEntry;
+    QSqlQuery insertAgents;
+    QSqlQuery selectEntry;
+    QSqlQuery deleteEntry;
+};
+
+HistoryDatabase::HistoryDatabase()
+    : m_connectionName(QString("gdss_history_%1").arg(reinterpret_cast<quintptr>(this))),
+    m_count(0)
+{
+}
+
+HistoryDatabase::~HistoryDatabase()
+{
+    close();
+}
+
+bool HistoryDatabase::isAvailable()
+{
+    return QSqlDatabase::isDriverAvailable(DRIVER);
+}
+
+bool HistoryDatabase::open(const QString &path)
+{
+    close();
+    m_errorString.clear();
+
+    if (!isAvailable()) {
+        m_errorString = "The QSQLITE driver is not available";
+        return false;
+    }
+
+    QDir dir = QFileInfo(path).dir();
+    if (!dir.exists()) {
+        dir.mkpath(".");
+    }
+
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase(DRIVER, m_connectionName);
+        db.setDatabaseName(path);
+        if (!db.open()) {
+            m_errorString = QString("Cannot open history database: %1").arg(db.lastError().text());
+        }
+    }
+    if (!m_errorString.isEmpty()) {
+        close();
+        return false;
+    }
+
+    m_path = path;
+    if (!createSchema()) {
+        close();
+        return false;
+    }
+
+    m_statements.reset(new Statements(database()));
+    Statements &s = *m_statements;
+    const bool prepared =
+        s.insertEntry.prepare("INSERT INTO entries (id, timestamp, algorithm, result, confidence, "
+                              "execution_time, stages, notes, status, error_message, agent_count) "
+                              "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)")
+        && s.insertAgents.prepare("INSERT INTO agents (entry_seq, vals, confidences) VALUES (?, ?, ?)")
+        && s.selectEntry.prepare(QString("SELECT %1 FROM %2 WHERE e.id = ?")
+                                     .arg(ENTRY_COLUMNS, ENTRY_SOURCE))
+        && s.deleteEntry.prepare("DELETE FROM entries WHERE id = ?");
+    if (!prepared) {
+        m_errorString = QString("Cannot prepare history statements: %1")
+                            .arg(database().lastError().text());
+        close();
+        return false;
+    }
+
+    QSqlQuery countQuery(database());
+    if (!countQuery.exec("SELECT COUNT(*) FROM entries") || !countQuery.next()) {
+        m_errorString = countQuery.lastError().text();
+        close();
+        return false;
+    }
+    m_count = countQuery.value(0).toLongLong();
+    return true;
+}
+
+void HistoryDatabase::close()
+{
+    // Every query on the connection has to be gone before it is removed
+    m_statements.reset();
+    if (QSqlDatabase::contains(m_connectionName)) {
+        {
+            QSqlDatabase db = QSqlDatabase::database(m_connectionName, false);
+            db.close();
+        }
+        QSqlDatabase::removeDatabase(m_connectionName);
+    }
+    m_path.clear();
+    m_count = 0;
+}
+
+bool HistoryDatabase::isOpen() const
+{
+    return m_statements != nullptr;
+}
+
+QString HistoryDatabase::path() const
+{
+    return m_path;
+}
+
+QString HistoryDatabase::errorString() const
+{
+    return m_errorString;
+}
+
+QSqlDatabase HistoryDatabase::database() const
+{
+    return QSqlDatabase::database(m_connectionName, false);
+}
+
+bool HistoryDatabase::createSchema()
+{
+    // WAL keeps a save to one append plus an fsync at checkpoints; NORMAL
+    // sync is still crash-safe under WAL, only the last commits can be lost
+    // on power failure
+    if (!exec("PRAGMA journal_mode = WAL") || !exec("PRAGMA synchronous = NORMAL")
+        || !exec("PRAGMA foreign_keys = ON")) {
+        return false;
+    }
+
+    QSqlQuery versionQuery(database());
+    if (!versionQuery.exec("PRAGMA user_version") || !versionQuery.next()) {
+        m_errorString = versionQuery.lastError().text();
+        return false;
+    }
+    const int version = versionQuery.value(0).toInt();
+    versionQuery.finish();
+    if (version == SCHEMA_VERSION) {
+        return true;
+    }
+    if (version > SCHEMA_VERSION) {
+        m_errorString = QString("History database schema %1 is newer than this build (%2)")
+                            .arg(version).arg(SCHEMA_VERSION);
+        return false;
+    }
+
+    QSqlDatabase db = database();
+    db.transaction();
+    const bool ok =
+        exec("CREATE TABLE IF NOT EXISTS entries ("
+             "seq INTEGER PRIMARY KEY AUTOINCREMENT, "
+             "id TEXT NOT NULL UNIQUE, "
+             "timestamp INTEGER NOT NULL, "
+             "algorithm TEXT NOT NULL, "
+             "result REAL NOT NULL, "
+             "confidence REAL NOT NULL, "
+             "execution_time REAL NOT NULL, "
+             "stages TEXT, "
+             "notes TEXT, "
+             "status TEXT NOT NULL, "
+             "error_message TEXT, "
+             "agent_count INTEGER NOT NULL)")
+        && exec("CREATE TABLE IF NOT EXISTS agents ("
+                "entry_seq INTEGER PRIMARY KEY REFERENCES entries(seq) ON DELETE CASCADE, "
+                "vals BLOB NOT NULL, "
+                "confidences BLOB NOT NULL)")
+        && exec("CREATE INDEX IF NOT EXISTS entries_algorithm ON entries(algorithm, status)")
+        && exec("CREATE INDEX IF NOT EXISTS entries_status ON entries(status)")
+        && exec("CREATE INDEX IF NOT EXISTS entries_timestamp ON entries(timestamp)")
+        && exec(QString("PRAGMA user_version = %1").arg(SCHEMA_VERSION));
+    if (!ok || !db.commit()) {
+        rollback(db);
+        return false;
+    }
+    return true;
+}
+
+void HistoryDatabase::rollback(QSqlDatabase &db) const
+{
+    // A failed statement has already set the error; a failed commit has not
+    if (db.lastError().isValid()) {
+        m_errorString = db.lastError().text();
+    }
+    db.rollback();
+}
+
+bool HistoryDatabase::exec(QSqlQuery &query) const
+{
+    if (!query.exec()) {
+        m_errorString = query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+bool HistoryDatabase::exec(const QString &statement) const
+{
+    QSqlQuery query(database());
+    if (!query.exec(statement)) {
+        m_errorString = query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+// ========== CHANGES ==========
+
+bool HistoryDatabase::insert(const HistoryEntry &entry)
+{
+    if (!isOpen()) {
+        return false;
+    }
+
+    // The entry and its agents go in together or not at all
+    QSqlDatabase db = database();
+    db.transaction();
+    if (!insertOne(entry) || !db.commit()) {
+        rollback(db);
+        return false;
+    }
+    m_count++;
+    return true;
+}
+
+bool HistoryDatabase::insert(const QList<HistoryEntry> &entries)
+{
+    if (!isOpen()) {
+        return false;
+    }
+
+    // One commit, hence one sync, for the whole import
+    QSqlDatabase db = database();
+    db.transaction();
+    for (const HistoryEntry &entry : entries) {
+        if (!insertOne(entry)) {
+            rollback(db);
+            return false;
+        }
+    }
+    if (!db.commit()) {
+        rollback(db);
+        return false;
+    }
+    m_count += entries.size();
+    return true;
+}
+
+bool HistoryDatabase::insertOne(const HistoryEntry &entry)
+{
+    QSqlQuery &insertEntry = m_statements->insertEntry;
+    insertEntry.bindValue(0, entry.id);
+    insertEntry.bindValue(1, entry.timestamp.toMSecsSinceEpoch());
+    insertEntry.bindValue(2, entry.algorithm);
+    insertEntry.bindValue(3, entry.result);
+    insertEntry.bindValue(4, entry.confidence);
+    insertEntry.bindValue(5, entry.executionTime);
+    insertEntry.bindValue(6, entry.stages.isEmpty()
+                                 ? QVariant()
+                                 : QVariant(QString::fromUtf8(
+                                       QJsonDocument(QJsonObject::fromVariantMap(entry.stages))
+                                           .toJson(QJsonDocument::Compact))));
+    insertEntry.bindValue(7, entry.notes);
+    insertEntry.bindValue(8, entry.status);
+    insertEntry.bindValue(9, entry.errorMessage);
+    insertEntry.bindValue(10, entry.agents.size());
+    if (!exec(insertEntry)) {
+        return false;
+    }
+
+    QSqlQuery &insertAgents = m_statements->insertAgents;
+    insertAgents.bindValue(0, insertEntry.lastInsertId());
+    insertAgents.bindValue(1, packDoubles(entry.agents));
+    insertAgents.bindValue(2, packDoubles(entry.confidences));
+    return exec(insertAgents);
+}
+
+bool HistoryDatabase::remove(const QString &id)
+{
+    m_errorString.clear();
+    if (!isOpen()) {
+        return false;
+    }
+
+    // The agents row goes with it (ON DELETE CASCADE)
+    QSqlQuery &deleteEntry = m_statements->deleteEntry;
+    deleteEntry.bindValue(0, id);
+    if (!exec(deleteEntry)) {
+        return false;
+    }
+    const int removed = deleteEntry.numRowsAffected();
+    m_count -= removed;
+    return removed > 0;
+}
+
+bool HistoryDatabase::clear()
+{
+    if (!isOpen()) {
+        return false;
+    }
+
+    // Without a WHERE clause SQLite drops the pages instead of deleting row by row
+    QSqlDatabase db = database();
+    db.transaction();
+    if (!exec("DELETE FROM agents") || !exec("DELETE FROM entries") || !db.commit()) {
+        rollback(db);
+        return false;
+    }
+    m_count = 0;
+    return true;
+}
+
+// ========== QUERIES ==========
+
+qint64 HistoryDatabase::count() const
+{
+    return m_count;
+}
+
+HistoryEntry HistoryDatabase::readEntry(const QSqlQuery &query)
+{
+    HistoryEntry entry;
+    entry.id = query.value(0).toString();
+    entry.timestamp = QDateTime::fromMSecsSinceEpoch(query.value(1).toLongLong());
+    entry.algorithm = query.value(2).toString();
+    entry.result = query.value(3).toDouble();
+    entry.confidence = query.value(4).toDouble();
+    entry.executionTime = query.value(5).toDouble();
+    const QByteArray stages = query.value(6).toString().toUtf8();
+    if (!stages.isEmpty()) {
+        entry.stages = QJsonDocument::fromJson(stages).object().toVariantMap();
+    }
+    entry.notes = query.value(7).toString();
+    entry.status = query.value(8).toString();
+    entry.errorMessage = query.value(9).toString();
+    entry.agents = unpackDoubles(query.value(10).toByteArray());
+    entry.confidences = unpackDoubles(query.value(11).toByteArray());
+    return entry;
+}
+
+bool HistoryDatabase::entry(const QString &id, HistoryEntry &entry) const
+{
+    m_errorString.clear();
+    if (!isOpen()) {
+        return false;
+    }
+
+    QSqlQuery &selectEntry = m_statements->selectEntry;
+    selectEntry.bindValue(0, id);
+    if (!exec(selectEntry)) {
+        return false;
+    }
+    const bool found = selectEntry.next();
+    if (found) {
+        entry = readEntry(selectEntry);
+    }
+    selectEntry.finish();
+    return found;
+}
+
+QList<HistoryEntry> HistoryDatabase::query(const Filter &filter) const
+{
+    QList<HistoryEntry> entries;
+    if (!isOpen()) {
+        return entries;
+    }
+
+    // Only the conditions in use, so SQLite can pick the index that fits
+    QStringList conditions;
+    QVariantList values;
+    if (!filter.algorithm.isEmpty()) {
+        conditions << "e.algorithm = ?";
+        values << filter.algorithm;
+    }
+    if (!filter.status.isEmpty()) {
+        conditions << "e.status = ?";
+        values << filter.status;
+    }
+    if (filter.from.isValid()) {
+        conditions << "e.timestamp >= ?";
+        values << filter.from.toMSecsSinceEpoch();
+    }
+    if (filter.to.isValid()) {
+        conditions << "e.timestamp <= ?";
+        values << filter.to.toMSecsSinceEpoch();
+    }
+
+    QString statement = QString("SELECT %1 FROM %2").arg(ENTRY_COLUMNS, ENTRY_SOURCE);
+    if (!conditions.isEmpty()) {
+        statement += " WHERE " + conditions.join(" AND ");
+    }
+    statement += " ORDER BY e.seq DESC LIMIT ? OFFSET ?";
+    values << filter.limit << qMax(0, filter.offset);
+
+    QSqlQuery query(database());
+    query.setForwardOnly(true);
+    if (!query.prepare(statement)) {
+        m_errorString = query.lastError().text();
+        return entries;
+    }
+    for (int i = 0; i < values.size(); ++i) {
+        query.bindValue(i, values[i]);
+    }
+    if (!exec(query)) {
+        return entries;
+    }
+
+    if (filter.limit > 0) {
+        entries.reserve(filter.limit);
+    }
+    while (query.next()) {
+        entries.append(readEntry(query));
+    }
+    return entries;
+}
+
+bool HistoryDatabase::forEach(const std::function<void(const HistoryEntry &)> &visit) const
+{
+    if (!isOpen()) {
+        return false;
+    }
+
+    QSqlQuery query(database());
+    query.setForwardOnly(true);
+    if (!query.exec(QString("SELECT %1 FROM %2 ORDER BY e.seq").arg(ENTRY_COLUMNS, ENTRY_SOURCE))) {
+        m_errorString = query.lastError().text();
+        return false;
+    }
+    while (query.next()) {
+        visit(readEntry(query));
+    }
+    return true;
+}
+
+// ========== STATISTICS ==========
+
+bool HistoryDatabase::forEachSummary(const std::function<void(const HistoryEntry &)> &visit) const
+{
+    if (!isOpen()) {
+        return false;
+    }
+
+    // entries alone: no join, no blobs
+    QSqlQuery query(database());
+    query.setForwardOnly(true);
+    if (!query.exec("SELECT id, timestamp, algorithm, result, confidence, execution_time, status "
+                    "FROM entries ORDER BY seq")) {
+        m_errorString = query.lastError().text();
+        return false;
+    }
+    HistoryEntry entry;
+    while (query.next()) {
+        entry.id = query.value(0).toString();
+        entry.timestamp = QDateTime::fromMSecsSinceEpoch(query.value(1).toLongLong());
+        entry.algorithm = query.value(2).toString();
+        entry.result = query.value(3).toDouble();
+        entry.confidence = query.value(4).toDouble();
+        entry.executionTime = query.value(5).toDouble();
+        entry.status = query.value(6).toString();
+        visit(entry);
+    }
+    return true;
+}
@@ -0,0 +1,97 @@
+#ifndef HISTORYDATABASE_H
+#define HISTORYDATABASE_H
+
+#include <QDateTime>
+#include <QList>
+#include <QString>
+#include <functional>
+#include <memory>
+
+struct HistoryEntry;
+class QSqlDatabase;
+class QSqlQuery;
+
+// SQLite storage for HistoryManager, through Qt's bundled QSQLITE driver.
+//
+// With it the history lives on disk instead of in a capped QList: entries
+// are rows, queried through indexes on algorithm, status and timestamp, so
+// years of results cost disk space rather than memory. Agent values and
+// confidences go into a separate table as little-endian float64 blobs and
+// are only read with the entries they belong to.
+//
+//   entries(seq INTEGER PRIMARY KEY, id TEXT UNIQUE, timestamp INTEGER (ms
+//           since the epoch), algorithm, result, confidence, execution_time,
+//           stages (JSON), notes, status, error_message, agent_count)
+//   agents(entry_seq -> entries.seq, vals BLOB, confidences BLOB)
+//
+// seq is the insertion order, which is the history order. Statements used
+// per save or lookup are prepared once when the database is opened. The
+// connection belongs to the thread that opened it.
+class HistoryDatabase
+{
+public:
+    // Selection for query(); empty fields do not filter
+    struct Filter {
+        QString algorithm;
+        QString status;
+        QDateTime from;  // inclusive
+        QDateTime to;  // inclusive
+        int offset = 0;
+        int limit = -1;  // -1 for no limit
+    };
+
+    HistoryDatabase();
+    ~HistoryDatabase();
+
+    // Whether the QSQLITE driver plugin can be loaded
+    static bool isAvailable();
+
+    // Opens or creates the database file and its schema
+    bool open(const QString &path);
+    void close();
+    bool isOpen() const;
+    QString path() const;
+    QString errorString() const;
+
+    bool insert(const HistoryEntry &entry);
+    // All in one transaction
+    bool insert(const QList<HistoryEntry> &entries);
+    // False if nothing was removed; errorString() tells a failure from a missing id
+    bool remove(const QString &id);
+    bool clear();
+
+    qint64 count() const;
+    // False if there is no such entry; errorString() tells a failure from a missing id
+    bool entry(const QString &id, HistoryEntry &entry) const;
+    // Newest first
+    QList<HistoryEntry> query(const Filter &filter) const;
+    // Every entry, oldest first, without holding them all in memory
+    bool forEach(const std::function<void(const HistoryEntry &)> &visit) const;
+
+    // Like forEach(), but with only id, timestamp, algorithm, result,
+    // confidence, execution time and status filled in: what
+    // HistoryAggregates reads, without the agent blobs
+    bool forEachSummary(const std::function<void(const HistoryEntry &)> &visit) const;
+
+private:
+    Q_DISABLE_COPY(HistoryDatabase)
+
+    struct Statements;
+
+    QSqlDatabase database() const;
+    bool createSchema();
+    bool insertOne(const HistoryEntry &entry);
+    bool exec(QSqlQuery &query) const;
+    bool exec(const QString &statement) const;
+    // Rolls back the open transaction, keeping why it failed in errorString()
+    void rollback(QSqlDatabase &db) const;
+    static HistoryEntry readEntry(const QSqlQuery &query);
+
+    QString m_connectionName;
+    QString m_path;
+    qint64 m_count;  // rows in entries, kept up to date instead of COUNT(*)
+    std::unique_ptr<Statements> m_statements;
+    mutable QString m_errorString;
+};
+
+#endif // HISTORYDATABASE_H
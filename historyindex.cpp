@@ -0,0 +1,65 @@
+#include "historyindex.h"
+#include "historymanager.h"
+
+QUuid HistoryIndex::key(const QString &id)
+{
+    const QUuid uuid = QUuid::fromString(id);
+    return uuid.isNull() ? QUuid::createUuidV5(QUuid(), id) : uuid;
+}
+
+void HistoryIndex::clear()
+{
+    m_sequences.clear();
+    m_base = 0;
+    m_next = 0;
+}
+
+void HistoryIndex::rebuild(const QList<HistoryEntry> &entries)
+{
+    clear();
+    m_sequences.reserve(entries.size());
+    for (const HistoryEntry &entry : entries) {
+        if (!entry.id.isEmpty()) {
+            m_sequences.insert(key(entry.id), m_next);
+        }
+        m_next++;
+    }
+}
+
+void HistoryIndex::append(const QString &id)
+{
+    m_sequences.insert(key(id), m_next++);
+}
+
+void HistoryIndex::removeFirst(const QString &id)
+{
+    if (!id.isEmpty()) {
+        m_sequences.remove(key(id), m_base);
+    }
+    m_base++;
+}
+
+void HistoryIndex::remove(const QString &id, qsizetype position)
+{
+    m_sequences.remove(key(id), m_base + position);
+}
+
+qsizetype HistoryIndex::find(const QList<HistoryEntry> &entries, const QString &id) const
+{
+    // Almost always one candidate; more only for duplicate ids or a key collision
+    const QUuid uuid = key(id);
+    qsizetype found = -1;
+    for (auto it = m_sequences.constFind(uuid); it != m_sequences.cend() && it.key() == uuid; ++it) {
+        const qsizetype position = it.value() - m_base;
+        if ((found < 0 || position < found) && position >= 0 && position < entries.size()
+            && entries[position].id == id) {
+            found = position;
+        }
+    }
+    return found;
+}
+
+qsizetype HistoryIndex::size() const
+{
+    return m_sequences.size();
+}
@@ -0,0 +1,52 @@
+#ifndef HISTORYINDEX_H
+#define HISTORYINDEX_H
+
+#include <QList>
+#include <QMultiHash>
+#include <QString>
+#include <QUuid>
+
+struct HistoryEntry;
+
+// Entry id -> position in HistoryManager's entry list.
+//
+// Ids are hashed in their parsed 128-bit form, so a lookup is one QUuid
+// hash and compare instead of a scan of string compares. Ids that are not
+// UUIDs (hand-written imports) are folded into one with a name-based UUID;
+// a hit is always confirmed against the entry's id string.
+//
+// Each entry gets a sequence number when appended, and its position is that
+// minus the sequence of the first entry. Dropping entries from the front
+// (trimming) then only advances the base; nothing after it is renumbered.
+// Removals elsewhere have to leave the list positions alone, which is why
+// HistoryManager marks removed entries instead of erasing them until it
+// rebuilds. Duplicate ids, as left by importing a file twice, resolve to
+// the oldest entry, like the linear scan did.
+class HistoryIndex
+{
+public:
+    static QUuid key(const QString &id);
+
+    void clear();
+    // Positions 0 .. entries.size() - 1; entries with an empty id are skipped
+    void rebuild(const QList<HistoryEntry> &entries);
+
+    // The entry just added at the end of the list
+    void append(const QString &id);
+    // The first entry of the list is dropped; id empty if it was already removed
+    void removeFirst(const QString &id);
+    // The entry at position is removed from the index; the list keeps its slot
+    void remove(const QString &id, qsizetype position);
+
+    // Position of the oldest entry with this id, or -1
+    qsizetype find(const QList<HistoryEntry> &entries, const QString &id) const;
+
+    qsizetype size() const;
+
+private:
+    QMultiHash<QUuid, qint64> m_sequences;
+    qint64 m_base = 0;  // sequence of the entry at position 0
+    qint64 m_next = 0;  // sequence of the next entry appended
+};
+
+#endif // HISTORYINDEX_H
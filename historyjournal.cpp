@@ -0,0 +1,363 @@
+#include "historyjournal.h"
+#include "historymanager.h"
+#include "historywriter.h"
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QSaveFile>
+
+namespace {
+
+const char SEGMENT_SUFFIX[] = ".journal";
+const int SNAPSHOT_VERSION = 2;
+
+void trimTo(QList<HistoryEntry> &entries, int keep)
+{
+    if (keep > 0 && entries.size() > keep) {
+        entries.erase(entries.begin(), entries.begin() + (entries.size() - keep));
+    }
+}
+
+} // namespace
+
+HistoryJournal::HistoryJournal(HistoryWriter *writer, QObject *parent)
+    : QObject(parent),
+    m_writer(writer),
+    m_generation(0),
+    m_recordCount(0),
+    m_compacting(false)
+{
+    m_compactor.setMaxThreadCount(1);
+}
+
+HistoryJournal::~HistoryJournal()
+{
+    // The snapshot being written is complete or not written at all; either
+    // way the segments still hold everything
+    m_compactor.waitForDone();
+}
+
+bool HistoryJournal::load(const QString &path, QList<HistoryEntry> &entries)
+{
+    // A compaction of the previous file finishes first; its late report only
+    // deletes that file's folded segments
+    m_compactor.waitForDone();
+    m_compacting = false;
+    // Records still queued for any segment are on disk before reading
+    m_writer->flush();
+    m_path = path;
+    m_recordCount = 0;
+    m_errorString.clear();
+    entries.clear();
+
+    bool ok = true;
+    quint64 snapshotGeneration = 0;
+    QFile snapshot(path);
+    if (snapshot.exists()) {
+        if (!snapshot.open(QIODevice::ReadOnly)) {
+            m_errorString = QString("Cannot open history file: %1").arg(snapshot.errorString());
+            ok = false;
+        } else {
+            QJsonParseError parseError;
+            QJsonDocument document = QJsonDocument::fromJson(snapshot.readAll(), &parseError);
+            snapshot.close();
+
+            QJsonArray entryArray;
+            if (parseError.error != QJsonParseError::NoError) {
+                m_errorString = QString("History file parse error: %1").arg(parseError.errorString());
+                ok = false;
+            } else if (document.isArray()) {
+                entryArray = document.array();  // Written before the journal existed
+            } else if (document.isObject()) {
+                QJsonObject root = document.object();
+                entryArray = root.value("entries").toArray();
+                snapshotGeneration = root.value("generation").toVariant().toULongLong();
+            } else {
+                m_errorString = "History file is not a valid JSON array";
+                ok = false;
+            }
+
+            entries.reserve(entryArray.size());
+            for (const QJsonValue &value : entryArray) {
+                entries.append(HistoryEntry::fromJson(value.toObject()));
+            }
+        }
+    }
+
+    // Everything recorded since that snapshot, oldest segment first
+    const QMap<quint64, QString> found = segments(path);
+    int skipped = 0;
+    m_generation = snapshotGeneration;
+    for (auto it = found.cbegin(); it != found.cend(); ++it) {
+        if (it.key() < snapshotGeneration) {
+            QFile::remove(it.value());  // Already in the snapshot
+            continue;
+        }
+        replay(it.value(), entries, skipped);
+        m_generation = it.key();
+    }
+    if (skipped > 0) {
+        qWarning() << "Skipped" << skipped << "unreadable history journal records in" << path;
+    }
+
+    if (!openSegment()) {
+        ok = false;
+    }
+    return ok;
+}
+
+void HistoryJournal::replay(const QString &segmentPath, QList<HistoryEntry> &entries, int &skipped)
+{
+    QFile segment(segmentPath);
+    if (!segment.open(QIODevice::ReadOnly)) {
+        qWarning() << "Cannot replay history journal" << segmentPath << ":" << segment.errorString();
+        return;
+    }
+
+    while (!segment.atEnd()) {
+        const QByteArray line = segment.readLine().trimmed();
+        if (line.isEmpty()) {
+            continue;
+        }
+
+        QJsonParseError parseError;
+        const QJsonObject record = QJsonDocument::fromJson(line, &parseError).object();
+        const QString op = record.value("op").toString();
+        if (parseError.error != QJsonParseError::NoError || op.isEmpty()) {
+            skipped++;  // Torn by a crash mid-append
+            continue;
+        }
+
+        m_recordCount++;
+        if (op == "add") {
+            entries.append(HistoryEntry::fromJson(record.value("entry").toObject()));
+            trimTo(entries, record.value("keep").toInt());
+        } else if (op == "remove") {
+            const QString id = record.value("id").toString();
+            for (int i = 0; i < entries.size(); ++i) {
+                if (entries[i].id == id) {
+                    entries.removeAt(i);
+                    break;
+                }
+            }
+        } else if (op == "trim") {
+            trimTo(entries, record.value("keep").toInt());
+        } else if (op == "clear") {
+            entries.clear();
+        } else {
+            skipped++;
+        }
+    }
+}
+
+// ========== RECORDS ==========
+
+bool HistoryJournal::appendEntry(const HistoryEntry &entry, int keep)
+{
+    QJsonObject record;
+    record["op"] = "add";
+    record["entry"] = entry.toJson();
+    record["keep"] = keep;
+    return append(record);
+}
+
+bool HistoryJournal::appendRemoval(const QString &id)
+{
+    QJsonObject record;
+    record["op"] = "remove";
+    record["id"] = id;
+    return append(record);
+}
+
+bool HistoryJournal::appendTrim(int keep)
+{
+    QJsonObject record;
+    record["op"] = "trim";
+    record["keep"] = keep;
+    return append(record);
+}
+
+bool HistoryJournal::appendClear()
+{
+    QJsonObject record;
+    record["op"] = "clear";
+    return append(record);
+}
+
+bool HistoryJournal::append(const QJsonObject &record)
+{
+    if (m_segmentPath.isEmpty()) {
+        m_errorString = "No history file loaded";
+        return false;
+    }
+
+    // Whole lines only, so a crash tears at most the last one
+    QByteArray line = QJsonDocument(record).toJson(QJsonDocument::Compact);
+    line.append('\n');
+    m_writer->append(m_segmentPath, line);
+
+    m_recordCount++;
+    return true;
+}
+
+bool HistoryJournal::openSegment()
+{
+    m_segmentPath = segmentPath(m_path, m_generation);
+
+    // A record torn by a crash would swallow the next one without this.
+    // Nothing is queued for the segment yet; the writer creates it on the
+    // first append.
+    QFile segment(m_segmentPath);
+    if (segment.size() > 0) {
+        if (!segment.open(QIODevice::ReadWrite)) {
+            m_errorString = QString("Cannot open history journal: %1").arg(segment.errorString());
+            return false;
+        }
+        const qint64 size = segment.size();
+        if (segment.seek(size - 1) && segment.peek(1) != "\n") {
+            segment.seek(size);
+            segment.write("\n");
+        }
+    }
+    return true;
+}
+
+int HistoryJournal::recordCount() const
+{
+    return m_recordCount;
+}
+
+QString HistoryJournal::errorString() const
+{
+    return m_errorString;
+}
+
+// ========== COMPACTION ==========
+
+bool HistoryJournal::isCompacting() const
+{
+    return m_compacting;
+}
+
+quint64 HistoryJournal::rotate()
+{
+    m_generation++;
+    m_recordCount = 0;
+    openSegment();
+    return m_generation;
+}
+
+bool HistoryJournal::compact(const QList<HistoryEntry> &entries)
+{
+    if (m_compacting) {
+        return false;
+    }
+
+    // Records from here on land in the new segment, on top of the snapshot.
+    // entries is shared, not copied; the manager's next change detaches it
+    // once per compaction.
+    const QString path = m_path;
+    const quint64 generation = rotate();
+    m_compacting = true;
+
+    m_compactor.start([this, path, generation, entries]() {
+        QString errorString;
+        bool ok = writeSnapshot(path, generation, entries, &errorString);
+        QMetaObject::invokeMethod(this, [this, path, generation, ok, errorString]() {
+            finishCompaction(path, generation, ok, errorString);
+        }, Qt::QueuedConnection);
+    });
+    return true;
+}
+
+bool HistoryJournal::compactNow(const QList<HistoryEntry> &entries)
+{
+    m_compactor.waitForDone();
+    m_compacting = false;
+
+    const quint64 generation = rotate();
+    QString errorString;
+    bool ok = writeSnapshot(m_path, generation, entries, &errorString);
+    finishCompaction(m_path, generation, ok, errorString);
+    return ok;
+}
+
+void HistoryJournal::finishCompaction(const QString &path, quint64 generation, bool ok,
+                                      const QString &errorString)
+{
+    if (path == m_path) {
+        m_compacting = false;
+    }
+
+    // A failed snapshot leaves the older segments in place; the next
+    // compaction folds them in. Records still queued for the folded
+    // segments are in the snapshot, and the writer drops them with the file.
+    if (ok) {
+        QMap<quint64, QString> folded = segments(path);
+        folded.insert(generation - 1, segmentPath(path, generation - 1));  // maybe not written yet
+        for (auto it = folded.cbegin(); it != folded.cend() && it.key() < generation; ++it) {
+            m_writer->remove(it.value());
+        }
+    } else {
+        m_errorString = errorString;
+    }
+    emit compacted(ok, errorString);
+}
+
+bool HistoryJournal::writeSnapshot(const QString &path, quint64 generation,
+                                   const QList<HistoryEntry> &entries, QString *errorString)
+{
+    QJsonArray entryArray;
+    for (const HistoryEntry &entry : entries) {
+        entryArray.append(entry.toJson());
+    }
+
+    QJsonObject root;
+    root["version"] = SNAPSHOT_VERSION;
+    root["generation"] = static_cast<qint64>(generation);
+    root["entries"] = entryArray;
+
+    QDir dir = QFileInfo(path).dir();
+    if (!dir.exists()) {
+        dir.mkpath(".");
+    }
+
+    // Replaces the old snapshot only once the new one is complete on disk
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        *errorString = file.errorString();
+        return false;
+    }
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    if (!file.commit()) {
+        *errorString = file.errorString();
+        return false;
+    }
+    return true;
+}
+
+QMap<quint64, QString> HistoryJournal::segments(const QString &path)
+{
+    const QFileInfo info(path);
+    const QString prefix = info.fileName() + ".";
+    const qsizetype suffixLength = static_cast<qsizetype>(sizeof(SEGMENT_SUFFIX) - 1);
+
+    QMap<quint64, QString> found;
+    const QStringList names = info.dir().entryList({ prefix + "*" + SEGMENT_SUFFIX }, QDir::Files);
+    for (const QString &name : names) {
+        bool ok = false;
+        quint64 generation = name.mid(prefix.size(), name.size() - prefix.size() - suffixLength)
+                                 .toULongLong(&ok);
+        if (ok) {
+            found.insert(generation, info.dir().filePath(name));
+        }
+    }
+    return found;
+}
+
+QString HistoryJournal::segmentPath(const QString &path, quint64 generation)
+{
+    return QString("%1.%2%3").arg(path).arg(generation).arg(SEGMENT_SUFFIX);
+}
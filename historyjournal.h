@@ -0,0 +1,102 @@
+#ifndef HISTORYJOURNAL_H
+#define HISTORYJOURNAL_H
+
+#include <QObject>
+#include <QFile>
+#include <QJsonObject>
+#include <QList>
+#include <QMap>
+#include <QString>
+#include <QThreadPool>
+
+struct HistoryEntry;
+class HistoryWriter;
+
+// Append-only persistence for HistoryManager.
+//
+// Every change to the history is one JSON line appended to a journal
+// segment next to the history file, so saving a result costs the same with
+// ten entries as with a hundred thousand. The lines are written behind the
+// caller's back by a HistoryWriter. Now and then the whole history is
+// compacted into the history file itself (the snapshot) on a pool thread,
+// after which the segments it covers are deleted, in order with the
+// appends still queued for them.
+//
+// Files for a history file gdss_history.json:
+//
+//   gdss_history.json            {"version": 2, "generation": g, "entries": [...]}
+//                                (a bare entry array from before the journal
+//                                is read as generation 0)
+//   gdss_history.json.<g>.journal  records made after snapshot g was taken:
+//                                {"op": "add", "entry": {...}, "keep": n}
+//                                {"op": "remove", "id": "..."}
+//                                {"op": "trim", "keep": n}
+//                                {"op": "clear"}
+//
+// "keep" is the entry cap in force when the record was made, so replay trims
+// exactly as the running manager did. A compaction first switches appends to
+// segment g + 1 and only then writes snapshot g + 1, atomically (QSaveFile),
+// so a crash at any point leaves a snapshot plus the segments still to be
+// replayed on top of it; segments older than the snapshot are left-overs of
+// a compaction that finished and are deleted on load. A record torn by a
+// crash mid-append is skipped.
+class HistoryJournal : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Segment appends and removals go through writer
+    explicit HistoryJournal(HistoryWriter *writer, QObject *parent = nullptr);
+    // Waits for a running compaction
+    ~HistoryJournal();
+
+    // Reads the snapshot at path and replays its segments into entries, then
+    // appends to that history from here on. Missing files are an empty
+    // history. False with errorString() set if the snapshot is unreadable.
+    bool load(const QString &path, QList<HistoryEntry> &entries);
+
+    // One record each, queued on the writer; failures are reported by
+    // HistoryWriter::writeFailed
+    bool appendEntry(const HistoryEntry &entry, int keep);
+    bool appendRemoval(const QString &id);
+    bool appendTrim(int keep);
+    bool appendClear();
+
+    // Records appended since the last compaction started
+    int recordCount() const;
+    bool isCompacting() const;
+    // Writes entries as the new snapshot on a pool thread and reports through
+    // compacted(); false if a compaction is already running
+    bool compact(const QList<HistoryEntry> &entries);
+    // Same, before returning; for rare bulk changes and benchmarks
+    bool compactNow(const QList<HistoryEntry> &entries);
+
+    QString errorString() const;
+
+signals:
+    void compacted(bool ok, const QString &errorString);
+
+private:
+    bool append(const QJsonObject &record);
+    bool openSegment();
+    // Starts segment m_generation + 1; the snapshot of that generation is due next
+    quint64 rotate();
+    void finishCompaction(const QString &path, quint64 generation, bool ok, const QString &errorString);
+    void replay(const QString &segmentPath, QList<HistoryEntry> &entries, int &skipped);
+
+    static QMap<quint64, QString> segments(const QString &path);
+    static QString segmentPath(const QString &path, quint64 generation);
+    static bool writeSnapshot(const QString &path, quint64 generation,
+                              const QList<HistoryEntry> &entries, QString *errorString);
+
+    HistoryWriter *m_writer;
+    QString m_path;
+    QString m_segmentPath;  // the segment appends go to
+    quint64 m_generation;  // of that segment
+    int m_recordCount;
+    bool m_compacting;
+    QString m_errorString;
+    QThreadPool m_compactor;  // one thread, so snapshots are written in order
+};
+
+#endif // HISTORYJOURNAL_H
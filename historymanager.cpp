@@ -1,4 +1,7 @@
-#include "HistoryManager.h"
+#include "historymanager.h"
+#include "historyjournal.h"
+#include "historydatabase.h"
+#include "historywriter.h"
 #include <QJsonDocument>
 #include <QJsonArray>
 #include <QJsonObject>
@@ -8,13 +11,62 @@
 #include <QDateTime>
 #include <algorithm>
 #include <cmath>
+#include <limits>
 
 // Default file paths
 const QString HistoryManager::DEFAULT_HISTORY_FILE = "gdss_history.json";
 const QString HistoryManager::DEFAULT_LOG_FILE = "gdss_log.txt";
+const QString HistoryManager::JSON_BACKEND = "json";
+const QString HistoryManager::SQLITE_BACKEND = "sqlite";
+
+namespace {
+
+// A date from QML (Date object) or an ISO 8601 string
+QDateTime filterDate(const QVariant &value)
+{
+    if (value.typeId() == QMetaType::QString) {
+        return QDateTime::fromString(value.toString(), Qt::ISODate);
+    }
+    return value.toDateTime();
+}
+
+HistoryDatabase::Filter entryFilter(const QVariantMap &filter)
+{
+    HistoryDatabase::Filter parsed;
+    parsed.algorithm = filter.value("algorithm").toString();
+    parsed.status = filter.value("status").toString();
+    parsed.from = filterDate(filter.value("from"));
+    parsed.to = filterDate(filter.value("to"));
+    parsed.offset = filter.value("offset", 0).toInt();
+    parsed.limit = filter.value("limit", -1).toInt();
+    return parsed;
+}
+
+// A slot left in the entry list by removeEntry(), see HistoryIndex
+bool isRemoved(const HistoryEntry &entry)
+{
+    return entry.id.isEmpty();
+}
+
+bool matches(const HistoryEntry &entry, const HistoryDatabase::Filter &filter)
+{
+    return !isRemoved(entry)
+           && (filter.algorithm.isEmpty() || entry.algorithm == filter.algorithm)
+           && (filter.status.isEmpty() || entry.status == filter.status)
+           && (!filter.from.isValid() || entry.timestamp >= filter.from)
+           && (!filter.to.isValid() || entry.timestamp <= filter.to);
+}
+
+} // namespace
 
 HistoryManager::HistoryManager(QObject *parent)
     : QObject(parent),
+    m_removedCount(0),
+    m_statisticsCached(false),
+    m_averageResult(0.0),
+    m_writer(new HistoryWriter(HistoryWriter::DEFAULT_MAX_QUEUED_BYTES, this)),
+    m_journal(new HistoryJournal(m_writer, this)),
+    m_database(nullptr),
     m_maxEntries(DEFAULT_MAX_ENTRIES),
     m_loggingEnabled(true)
 {
@@ -31,27 +83,50 @@ HistoryManager::HistoryManager(QObject *parent)
     m_historyFilePath = QDir(gdssFolder).filePath(DEFAULT_HISTORY_FILE);
     m_logFilePath = QDir(gdssFolder).filePath(DEFAULT_LOG_FILE);
 
+    connect(m_writer, &HistoryWriter::writeFailed, this, [this](const QString &path, const QString &errorString) {
+        // Logging a failure to write the log would only fail again
+        if (path == m_logFilePath) {
+            qWarning() << "Cannot write log file" << path << ":" << errorString;
+        } else {
+            logError(QString("Cannot write %1: %2").arg(path, errorString), "History");
+        }
+    });
+    connect(m_journal, &HistoryJournal::compacted, this, [this](bool ok, const QString &errorString) {
+        if (!ok) {
+            logError(QString("Cannot write history snapshot: %1").arg(errorString), "History");
+        }
+    });
+
     // Load existing history
     loadHistoryFromFile();
 
+    // Lets the GUI use the database without a settings page
+    const QString backend = qEnvironmentVariable("GDSS_HISTORY_BACKEND");
+    if (!backend.isEmpty()) {
+        setStorageBackend(backend);
+    }
+
     // Log startup
     logInfo("HistoryManager initialized", "System");
 }
 
 HistoryManager::~HistoryManager()
 {
-    // Save history before destruction
-    saveHistoryToFile();
+    // Nothing to save: every change is already in the database or queued
+    // for the journal, and the journal waits for a snapshot still being
+    // written. What is queued goes to disk before returning.
+    flush();
+    delete m_database;
 }
 
 // Configuration methods
 void HistoryManager::setHistoryFilePath(const QString &path)
 {
     if (m_historyFilePath != path) {
-        saveHistoryToFile();
-
+        // The current file needs no save, its journal is up to date
         m_historyFilePath = path;
         loadHistoryFromFile();
+        statisticsModified();
     }
 }
 
@@ -64,14 +139,68 @@ void HistoryManager::setMaxHistoryEntries(int maxEntries)
 {
     m_maxEntries = qMax(100, maxEntries); // Minimum 100 entries
 
+    // The database keeps everything; only the window shown changes
+    if (m_database) {
+        emit historyChanged();
+        return;
+    }
+
     // Trim if we have more entries than the new limit
-    if (m_entries.size() > m_maxEntries) {
-        m_entries = m_entries.mid(m_entries.size() - m_maxEntries);
-        saveHistoryToFile();
+    if (liveEntryCount() > m_maxEntries) {
+        trimEntries();
+        journalWritten(m_journal->appendTrim(m_maxEntries));
+        statisticsModified();
         emit historyChanged();
     }
 }
 
+QString HistoryManager::storageBackend() const
+{
+    return m_database ? SQLITE_BACKEND : JSON_BACKEND;
+}
+
+void HistoryManager::setStorageBackend(const QString &backend)
+{
+    if (backend == storageBackend()) {
+        return;
+    }
+
+    if (backend == JSON_BACKEND) {
+        delete m_database;
+        m_database = nullptr;
+        loadHistoryFromFile();
+    } else if (backend == SQLITE_BACKEND) {
+        if (!HistoryDatabase::isAvailable()) {
+            logError("SQLite history storage is unavailable: the QSQLITE driver did not load", "History");
+            return;
+        }
+        // m_entries is what an empty database starts out with
+        m_database = new HistoryDatabase;
+        if (!openDatabase()) {
+            delete m_database;
+            m_database = nullptr;
+            return;
+        }
+    } else {
+        logWarning(QString("Unknown history storage backend: %1").arg(backend), "History");
+        return;
+    }
+
+    logInfo(QString("History storage backend: %1").arg(backend), "History");
+    emit storageBackendChanged();
+    statisticsModified();
+    emit historyChanged();
+}
+
+QStringList HistoryManager::availableStorageBackends() const
+{
+    QStringList backends{ JSON_BACKEND };
+    if (HistoryDatabase::isAvailable()) {
+        backends.append(SQLITE_BACKEND);
+    }
+    return backends;
+}
+
 // History management
 void HistoryManager::saveFusionResult(const QVariantList &agents,
                                       const QVariantList &confidences,
@@ -79,7 +208,8 @@ void HistoryManager::saveFusionResult(const QVariantList &agents,
                                       double result,
                                       double confidence,
                                       double executionTime,
-                                      const QString &notes)
+                                      const QString &notes,
+                                      const QVariantMap &stages)
 {
     HistoryEntry entry;
     entry.id = generateId();
@@ -90,20 +220,13 @@ void HistoryManager::saveFusionResult(const QVariantList &agents,
     entry.result = result;
     entry.confidence = confidence;
     entry.executionTime = executionTime;
+    entry.stages = stages;
     entry.notes = notes;
     entry.status = "success";
     entry.errorMessage = "";
 
     // Add to history
-    m_entries.append(entry);
-
-    // Trim if exceeding max entries
-    if (m_entries.size() > m_maxEntries) {
-        m_entries.removeFirst();
-    }
-
-    // Save to file
-    saveHistoryToFile();
+    storeEntry(entry);
 
     // Log the operation
     logInfo(QString("Fusion completed: %1 with %2 agents, result: %3")
@@ -121,7 +244,29 @@ void HistoryManager::saveErrorResult(const QVariantList &agents,
                                      const QVariantList &confidences,
                                      const QString &algorithm,
                                      const QString &errorMessage,
-                                     double executionTime)
+                                     double executionTime,
+                                     const QVariantMap &stages)
+{
+    saveFailedResult(agents, confidences, algorithm, errorMessage, executionTime, stages, "error");
+}
+
+void HistoryManager::saveTimeoutResult(const QVariantList &agents,
+                                       const QVariantList &confidences,
+                                       const QString &algorithm,
+                                       const QString &errorMessage,
+                                       double executionTime,
+                                       const QVariantMap &stages)
+{
+    saveFailedResult(agents, confidences, algorithm, errorMessage, executionTime, stages, "timeout");
+}
+
+void HistoryManager::saveFailedResult(const QVariantList &agents,
+                                      const QVariantList &confidences,
+                                      const QString &algorithm,
+                                      const QString &errorMessage,
+                                      double executionTime,
+                                      const QVariantMap &stages,
+                                      const QString &status)
 {
     HistoryEntry entry;
     entry.id = generateId();
@@ -132,23 +277,17 @@ void HistoryManager::saveErrorResult(const QVariantList &agents,
     entry.result = 0.0;
     entry.confidence = 0.0;
     entry.executionTime = executionTime;
+    entry.stages = stages;
     entry.notes = "";
-    entry.status = "error";
+    entry.status = status;
     entry.errorMessage = errorMessage;
 
     // Add to history
-    m_entries.append(entry);
-
-    // Trim if exceeding max entries
-    if (m_entries.size() > m_maxEntries) {
-        m_entries.removeFirst();
-    }
-
-    // Save to file
-    saveHistoryToFile();
+    storeEntry(entry);
 
     // Log the error
-    logError(QString("Fusion failed: %1 - %2")
+    logError(QString("Fusion %1: %2 - %3")
+                 .arg(status == "timeout" ? "timed out" : "failed")
                  .arg(algorithm)
                  .arg(errorMessage),
              "Fusion");
@@ -162,9 +301,23 @@ QVariantList HistoryManager::getHistoryEntries() const
 {
     QVariantList entries;
 
+    // The newest m_maxEntries rows; the rest stay on disk
+    if (m_database) {
+        HistoryDatabase::Filter newest;
+        newest.limit = m_maxEntries;
+        const QList<HistoryEntry> rows = m_database->query(newest);
+        entries.reserve(rows.size());
+        for (const HistoryEntry &entry : rows) {
+            entries.append(entry.toVariantMap());
+        }
+        return entries;
+    }
+
     // Return in reverse chronological order (newest first)
     for (int i = m_entries.size() - 1; i >= 0; --i) {
-        entries.append(m_entries[i].toVariantMap());
+        if (!isRemoved(m_entries[i])) {
+            entries.append(m_entries[i].toVariantMap());
+        }
     }
 
     return entries;
@@ -172,37 +325,106 @@ QVariantList HistoryManager::getHistoryEntries() const
 
 QVariantMap HistoryManager::getEntry(const QString &id) const
 {
-    for (const HistoryEntry &entry : m_entries) {
-        if (entry.id == id) {
-            return entry.toVariantMap();
-        }
+    if (m_database) {
+        HistoryEntry entry;
+        return m_database->entry(id, entry) ? entry.toVariantMap() : QVariantMap();
     }
-    return QVariantMap();
+
+    const qsizetype position = m_index.find(m_entries, id);
+    return position >= 0 ? m_entries[position].toVariantMap() : QVariantMap();
 }
 
 void HistoryManager::clearHistory()
 {
-    m_entries.clear();
-    saveHistoryToFile();
+    if (m_database) {
+        if (!m_database->clear()) {
+            logError(QString("Cannot clear history database: %1").arg(m_database->errorString()), "History");
+            return;
+        }
+        m_aggregates.clear();
+    } else {
+        m_entries.clear();
+        m_index.clear();
+        m_aggregates.clear();
+        m_removedCount = 0;
+        journalWritten(m_journal->appendClear());
+    }
 
     logInfo("History cleared", "History");
+    statisticsModified();
     emit historyCleared();
     emit historyChanged();
 }
 
 void HistoryManager::removeEntry(const QString &id)
 {
-    for (int i = 0; i < m_entries.size(); ++i) {
-        if (m_entries[i].id == id) {
-            m_entries.removeAt(i);
-            saveHistoryToFile();
-
+    if (m_database) {
+        // The totals need the row's values, which go with it
+        HistoryEntry removed;
+        if (m_database->entry(id, removed) && m_database->remove(id)) {
+            m_aggregates.remove(removed);
             logInfo(QString("Removed history entry: %1").arg(id), "History");
+            statisticsModified();
             emit entryRemoved(id);
             emit historyChanged();
-            return;
+        } else if (!m_database->errorString().isEmpty()) {
+            logError(QString("Cannot remove history entry %1: %2").arg(id, m_database->errorString()), "History");
+        }
+        return;
+    }
+
+    const qsizetype position = m_index.find(m_entries, id);
+    if (position < 0) {
+        return;
+    }
+
+    // The slot stays so no other position moves; the list is swept once
+    // removed slots outnumber entries, keeping removal O(1) amortized
+    m_index.remove(id, position);
+    m_aggregates.remove(m_entries[position]);
+    m_entries[position] = HistoryEntry{};
+    m_removedCount++;
+    if (m_removedCount > liveEntryCount()) {
+        purgeRemoved();
+    }
+    journalWritten(m_journal->appendRemoval(id));
+
+    logInfo(QString("Removed history entry: %1").arg(id), "History");
+    statisticsModified();
+    emit entryRemoved(id);
+    emit historyChanged();
+}
+
+QVariantList HistoryManager::queryEntries(const QVariantMap &filter) const
+{
+    const HistoryDatabase::Filter parsed = entryFilter(filter);
+    QVariantList entries;
+
+    // Served by the database indexes
+    if (m_database) {
+        const QList<HistoryEntry> rows = m_database->query(parsed);
+        entries.reserve(rows.size());
+        for (const HistoryEntry &entry : rows) {
+            entries.append(entry.toVariantMap());
+        }
+        return entries;
+    }
+
+    int skip = qMax(0, parsed.offset);
+    for (int i = m_entries.size() - 1; i >= 0; --i) {
+        if (parsed.limit >= 0 && entries.size() >= parsed.limit) {
+            break;
+        }
+        if (!matches(m_entries[i], parsed)) {
+            continue;
         }
+        if (skip > 0) {
+            skip--;
+            continue;
+        }
+        entries.append(m_entries[i].toVariantMap());
     }
+    return entries;
 }
 
 // Logging methods
@@ -266,6 +488,9 @@ void HistoryManager::logDebug(const QString &message, const QString &context)
 
 QString HistoryManager::getLogs(int maxLines) const
 {
+    // Lines still queued belong in the result
+    m_writer->flush();
+
     QFile logFile(m_logFilePath);
     if (!logFile.exists()) {
         return "No log file found.";
@@ -293,57 +518,42 @@ QString HistoryManager::getLogs(int maxLines) const
 
 void HistoryManager::clearLogs()
 {
-    QFile logFile(m_logFilePath);
-    if (logFile.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
-        QTextStream out(&logFile);
-        out << QString("[%1] Log file cleared\n")
-                   .arg(QDateTime::currentDateTime().toString("yyyy-MM-dd HH:mm:ss"));
-        logFile.close();
-    }
+    // Queued, so lines logged before this are dropped with the file
+    m_writer->remove(m_logFilePath);
+    m_writer->append(m_logFilePath, QString("[%1] Log file cleared\n")
+                                        .arg(QDateTime::currentDateTime().toString("yyyy-MM-dd HH:mm:ss"))
+                                        .toUtf8());
 
     logInfo("Logs cleared", "System");
     emit logAdded("[Logs cleared]");
 }
 
+bool HistoryManager::flush(int timeoutMs)
+{
+    return m_writer->flush(timeoutMs < 0 ? QDeadlineTimer(QDeadlineTimer::Forever)
+                                         : QDeadlineTimer(timeoutMs));
+}
+
+QVariantMap HistoryManager::persistenceMetrics() const
+{
+    return m_writer->metrics();
+}
+
 // Export/Import methods
 bool HistoryManager::exportHistoryToJson(const QString &filePath)
 {
     QJsonArray entriesArray;
 
-    for (const HistoryEntry &entry : m_entries) {
-        QJsonObject entryObj;
-        entryObj["id"] = entry.id;
-        entryObj["timestamp"] = entry.timestamp.toString(Qt::ISODate);
-        entryObj["algorithm"] = entry.algorithm;
-        entryObj["result"] = entry.result;
-        entryObj["confidence"] = entry.confidence;
-        entryObj["executionTime"] = entry.executionTime;
+    forEachEntry([&entriesArray](const HistoryEntry &entry) {
+        QJsonObject entryObj = entry.toJson();
         entryObj["agentCount"] = entry.agents.size();
-        entryObj["status"] = entry.status;
-        entryObj["errorMessage"] = entry.errorMessage;
-        entryObj["notes"] = entry.notes;
-
-        // Add agents array
-        QJsonArray agentsArray;
-        for (const QVariant &agent : entry.agents) {
-            agentsArray.append(agent.toDouble());
-        }
-        entryObj["agents"] = agentsArray;
-
-        // Add confidences array
-        QJsonArray confidencesArray;
-        for (const QVariant &confidence : entry.confidences) {
-            confidencesArray.append(confidence.toDouble());
-        }
-        entryObj["confidences"] = confidencesArray;
-
         entriesArray.append(entryObj);
-    }
+    });
 
     QJsonObject root;
     root["version"] = "1.0";
     root["exportDate"] = QDateTime::currentDateTime().toString(Qt::ISODate);
-    root["totalEntries"] = m_entries.size();
+    root["totalEntries"] = entriesArray.size();
     root["entries"] = entriesArray;
 
     QJsonDocument doc(root);
@@ -359,7 +569,7 @@ bool HistoryManager::exportHistoryToJson(const QString &filePath)
 
     logInfo(QString("History exported to: %1 (%2 entries)")
                 .arg(filePath)
-                .arg(m_entries.size()),
+                .arg(entriesArray.size()),
             "Export");
 
     return true;
@@ -378,7 +588,8 @@ bool HistoryManager::exportHistoryToCsv(const QString &filePath)
     out << "Timestamp,Algorithm,Result,Confidence,ExecutionTime(ms),AgentCount,Status,ErrorMessage,Notes\n";
 
     // Write data
-    for (const HistoryEntry &entry : m_entries) {
+    qint64 written = 0;
+    forEachEntry([&out, &written](const HistoryEntry &entry) {
         // Escape quotes in strings for CSV
         QString errorMsg = entry.errorMessage;
         QString notes = entry.notes;
@@ -399,13 +610,14 @@ bool HistoryManager::exportHistoryToCsv(const QString &filePath)
                            .arg(notes);
 
         out << line;
-    }
+        written++;
+    });
 
     file.close();
 
     logInfo(QString("History exported to CSV: %1 (%2 entries)")
                 .arg(filePath)
-                .arg(m_entries.size()),
+                .arg(written),
             "Export");
 
     return true;
@@ -440,50 +652,41 @@ bool HistoryManager::importHistoryFromJson(const QString &filePath)
     QList<HistoryEntry> importedEntries;
 
     for (const QJsonValue &entryValue : entriesArray) {
-        QJsonObject entryObj = entryValue.toObject();
+        importedEntries.append(HistoryEntry::fromJson(entryValue.toObject()));
+    }
 
-        HistoryEntry entry;
-        entry.id = entryObj["id"].toString(generateId());
-        entry.timestamp = QDateTime::fromString(entryObj["timestamp"].toString(), Qt::ISODate);
-        entry.algorithm = entryObj["algorithm"].toString();
-        entry.result = entryObj["result"].toDouble();
-        entry.confidence = entryObj["confidence"].toDouble(1.0);
-        entry.executionTime = entryObj["executionTime"].toDouble();
-        entry.status = entryObj["status"].toString("success");
-        entry.errorMessage = entryObj["errorMessage"].toString();
-        entry.notes = entryObj["notes"].toString();
-
-        // Parse agents
-        QJsonArray agentsArray = entryObj["agents"].toArray();
-        for (const QJsonValue &agentValue : agentsArray) {
-            entry.agents.append(agentValue.toDouble());
+    if (m_database) {
+        // One transaction, and nothing trimmed
+        if (!m_database->insert(importedEntries)) {
+            logError(QString("Cannot import into history database: %1").arg(m_database->errorString()), "Import");
+            return false;
         }
-
-        // Parse confidences
-        QJsonArray confidencesArray = entryObj["confidences"].toArray();
-        for (const QJsonValue &confidenceValue : confidencesArray) {
-            entry.confidences.append(confidenceValue.toDouble(1.0));
+        for (const HistoryEntry &entry : importedEntries) {
+            m_aggregates.add(entry);
         }
-
-        importedEntries.append(entry);
+        logInfo(QString("Imported %1 entries from: %2")
+                    .arg(importedEntries.size())
+                    .arg(filePath),
+                "Import");
+        statisticsModified();
+        emit historyChanged();
+        return true;
     }
 
-    // Add imported entries
-    m_entries.append(importedEntries);
-
-    // Trim if exceeding max entries
-    if (m_entries.size() > m_maxEntries) {
-        m_entries = m_entries.mid(m_entries.size() - m_maxEntries);
+    // Add imported entries, one journal record each, trimming as they go
+    bool written = true;
+    for (const HistoryEntry &entry : importedEntries) {
+        appendEntry(entry);
+        written = m_journal->appendEntry(entry, m_maxEntries) && written;
     }
-
-    // Save to file
-    saveHistoryToFile();
+    journalWritten(written);
 
     logInfo(QString("Imported %1 entries from: %2")
                 .arg(importedEntries.size())
                 .arg(filePath),
             "Import");
 
+    statisticsModified();
     emit historyChanged();
     return true;
 }
@@ -491,125 +694,48 @@ bool HistoryManager::importHistoryFromJson(const QString &filePath)
 // Statistics methods
 QVariantMap HistoryManager::getStatistics() const
 {
-    QVariantMap stats;
-
-    if (m_entries.isEmpty()) {
-        stats["totalEntries"] = 0;
-        stats["successCount"] = 0;
-        stats["errorCount"] = 0;
-        stats["averageResult"] = 0.0;
-        stats["averageConfidence"] = 0.0;
-        stats["averageExecutionTime"] = 0.0;
-        return stats;
-    }
-
-    int successCount = 0;
-    int errorCount = 0;
-    double totalResult = 0.0;
-    double totalConfidence = 0.0;
-    double totalExecutionTime = 0.0;
-
-    for (const HistoryEntry &entry : m_entries) {
-        if (entry.status == "success") {
-            successCount++;
-            totalResult += entry.result;
-            totalConfidence += entry.confidence;
-            totalExecutionTime += entry.executionTime;
-        } else {
-            errorCount++;
-        }
-    }
-
-    stats["totalEntries"] = m_entries.size();
-    stats["successCount"] = successCount;
-    stats["errorCount"] = errorCount;
-    stats["successRate"] = successCount * 100.0 / m_entries.size();
-
-    if (successCount > 0) {
-        stats["averageResult"] = totalResult / successCount;
-        stats["averageConfidence"] = totalConfidence / successCount;
-        stats["averageExecutionTime"] = totalExecutionTime / successCount;
-    } else {
-        stats["averageResult"] = 0.0;
-        stats["averageConfidence"] = 0.0;
-        stats["averageExecutionTime"] = 0.0;
-    }
-
-    // Date range
-    if (!m_entries.isEmpty()) {
-        stats["firstEntry"] = m_entries.first().timestamp.toString("yyyy-MM-dd");
-        stats["lastEntry"] = m_entries.last().timestamp.toString("yyyy-MM-dd");
-    }
-
-    return stats;
+    cacheStatistics();
+    return m_statistics;
 }
 
 double HistoryManager::getAverageResult() const
 {
-    if (m_entries.isEmpty()) return 0.0;
-
-    double total = 0.0;
-    int count = 0;
-
-    for (const HistoryEntry &entry : m_entries) {
-        if (entry.status == "success") {
-            total += entry.result;
-            count++;
-        }
-    }
-
-    return count > 0 ? total / count : 0.0;
+    cacheStatistics();
+    return m_averageResult;
 }
 
 QVariantMap HistoryManager::getAlgorithmStatistics() const
 {
-    QVariantMap algoStats;
-    QMap<QString, QVariantMap> algorithmData;
-
-    for (const HistoryEntry &entry : m_entries) {
-        if (entry.status != "success") continue;
-
-        QString algo = entry.algorithm;
-
-        if (!algorithmData.contains(algo)) {
-            QVariantMap data;
-            data["count"] = 0;
-            data["totalResult"] = 0.0;
-            data["totalTime"] = 0.0;
-            algorithmData[algo] = data;
-        }
+    cacheStatistics();
+    return m_algorithmStatistics;
+}
 
-        QVariantMap data = algorithmData[algo];
-        data["count"] = data["count"].toInt() + 1;
-        data["totalResult"] = data["totalResult"].toDouble() + entry.result;
-        data["totalTime"] = data["totalTime"].toDouble() + entry.executionTime;
-        algorithmData[algo] = data;
+void HistoryManager::cacheStatistics() const
+{
+    if (m_statisticsCached) {
+        return;
     }
 
-    for (auto it = algorithmData.begin(); it != algorithmData.end(); ++it) {
-        QString algo = it.key();
-        QVariantMap data = it.value();
-
-        int count = data["count"].toInt();
-        double avgResult = data["totalResult"].toDouble() / count;
-        double avgTime = data["totalTime"].toDouble() / count;
-
-        QVariantMap stats;
-        stats["usageCount"] = count;
-        stats["usagePercentage"] = count * 100.0 / m_entries.size();
-        stats["averageResult"] = avgResult;
-        stats["averageExecutionTime"] = avgTime;
-
-        algoStats[algo] = stats;
-    }
+    // From the running totals, whichever backend is in use
+    m_statistics = m_aggregates.statistics();
+    m_algorithmStatistics = m_aggregates.algorithmStatistics();
+    m_averageResult = m_aggregates.averageResult();
+    m_statisticsCached = true;
+}
 
-    return algoStats;
+void HistoryManager::statisticsModified()
+{
+    m_statisticsCached = false;
+    emit statisticsChanged();
 }
 
 // Property getters
 int HistoryManager::getEntryCount() const
 {
-    return m_entries.size();
+    if (m_database) {
+        return static_cast<int>(qMin<qint64>(m_database->count(), std::numeric_limits<int>::max()));
+    }
+    return liveEntryCount();
 }
 
 bool HistoryManager::isLoggingEnabled() const
@@ -629,149 +755,264 @@ void HistoryManager::setLoggingEnabled(bool enabled)
 // Private helper methods
 bool HistoryManager::loadHistoryFromFile()
 {
-    QFile file(m_historyFilePath);
-    if (!file.exists()) {
-        logInfo("No existing history file found", "History");
-        return true; // Not an error if file doesn't exist
+    if (m_database) {
+        m_entries.clear();
+        m_removedCount = 0;
+        if (openDatabase()) {
+            return true;
+        }
+
+        // Keep a usable history rather than none
+        delete m_database;
+        m_database = nullptr;
+        logWarning("Falling back to the JSON history file", "History");
+        emit storageBackendChanged();
     }
 
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        logError(QString("Cannot open history file: %1").arg(file.errorString()), "History");
+    // The snapshot plus whatever the journal recorded after it
+    const bool loaded = m_journal->load(m_historyFilePath, m_entries);
+    m_index.rebuild(m_entries);
+    m_aggregates.rebuild(m_entries);
+    m_removedCount = 0;
+    if (!loaded) {
+        logError(m_journal->errorString(), "History");
         return false;
     }
 
-    QByteArray data = file.readAll();
-    file.close();
+    if (m_entries.isEmpty() && !QFile::exists(m_historyFilePath)) {
+        logInfo("No existing history file found", "History");
+        return true;
+    }
 
-    QJsonParseError parseError;
-    QJsonDocument doc = QJsonDocument::fromJson(data, &parseError);
+    logInfo(QString("Loaded %1 history entries from %2")
+                .arg(m_entries.size())
+                .arg(m_historyFilePath),
+            "History");
 
-    if (parseError.error != QJsonParseError::NoError) {
-        logError(QString("History file parse error: %1").arg(parseError.errorString()), "History");
-        return false;
-    }
+    return true;
+}
 
-    if (!doc.isArray()) {
-        logError("History file is not a valid JSON array", "History");
-        return false;
+bool HistoryManager::saveHistoryToFile()
+{
+    // Failures are logged through HistoryJournal::compacted
+    purgeRemoved();
+    return m_journal->compactNow(m_entries);
+}
+
+void HistoryManager::journalWritten(bool ok)
+{
+    if (!ok) {
+        logError(QString("Cannot write history journal: %1").arg(m_journal->errorString()), "History");
     }
 
-    QJsonArray entriesArray = doc.array();
-    m_entries.clear();
+    if (!m_journal->isCompacting()
+        && m_journal->recordCount() >= qMax(MIN_COMPACTION_RECORDS, liveEntryCount())) {
+        // The snapshot holds entries only, not the slots of removed ones
+        purgeRemoved();
+        m_journal->compact(m_entries);
+    }
+}
 
-    for (const QJsonValue &entryValue : entriesArray) {
-        QJsonObject entryObj = entryValue.toObject();
+bool HistoryManager::openDatabase()
+{
+    const QString path = databaseFilePath();
+    if (!m_database->open(path)) {
+        logError(m_database->errorString(), "History");
+        return false;
+    }
 
-        HistoryEntry entry;
-        entry.id = entryObj["id"].toString(generateId());
-        entry.timestamp = QDateTime::fromString(entryObj["timestamp"].toString(), Qt::ISODate);
-        entry.algorithm = entryObj["algorithm"].toString();
-        entry.result = entryObj["result"].toDouble();
-        entry.confidence = entryObj["confidence"].toDouble(1.0);
-        entry.executionTime = entryObj["executionTime"].toDouble(0.0);
-        entry.notes = entryObj["notes"].toString();
-        entry.status = entryObj["status"].toString("success");
-        entry.errorMessage = entryObj["errorMessage"].toString();
-
-        // Parse agents
-        QJsonArray agentsArray = entryObj["agents"].toArray();
-        for (const QJsonValue &agentValue : agentsArray) {
-            entry.agents.append(agentValue.toDouble());
+    // A new database starts out with the JSON history, in one transaction
+    if (m_database->count() == 0) {
+        if (m_entries.isEmpty()) {
+            m_journal->load(m_historyFilePath, m_entries);
         }
-
-        // Parse confidences
-        QJsonArray confidencesArray = entryObj["confidences"].toArray();
-        if (confidencesArray.isEmpty()) {
-            // Backward compatibility: if no confidences array, create default ones
-            for (int i = 0; i < entry.agents.size(); ++i) {
-                entry.confidences.append(1.0);
-            }
-        } else {
-            for (const QJsonValue &confidenceValue : confidencesArray) {
-                entry.confidences.append(confidenceValue.toDouble(1.0));
+        purgeRemoved();
+        if (!m_entries.isEmpty()) {
+            if (!m_database->insert(m_entries)) {
+                logError(QString("Cannot copy history into %1: %2").arg(path, m_database->errorString()), "History");
+                m_database->close();
+                return false;
             }
+            logInfo(QString("Copied %1 history entries from %2 into %3")
+                        .arg(m_entries.size())
+                        .arg(m_historyFilePath, path),
+                    "History");
         }
+    }
 
-        m_entries.append(entry);
+    // The only time statistics come from SQL; every change after this
+    // updates the totals directly
+    HistoryAggregates aggregates;
+    if (!m_database->forEachSummary([&aggregates](const HistoryEntry &entry) { aggregates.add(entry); })) {
+        logError(QString("Cannot read history statistics from %1: %2").arg(path, m_database->errorString()), "History");
+        m_database->close();
+        return false;
     }
+    m_aggregates = aggregates;
+    m_entries.clear();
+    m_index.clear();
+    m_removedCount = 0;
 
-    logInfo(QString("Loaded %1 history entries from %2")
-                .arg(m_entries.size())
-                .arg(m_historyFilePath),
+    logInfo(QString("Opened history database %1 with %2 entries")
+                .arg(path)
+                .arg(m_database->count()),
             "History");
-
     return true;
 }
 
-bool HistoryManager::saveHistoryToFile()
+QString HistoryManager::databaseFilePath() const
 {
-    QJsonArray entriesArray;
+    const QFileInfo info(m_historyFilePath);
+    return info.dir().filePath(info.completeBaseName() + ".sqlite");
+}
 
-    for (const HistoryEntry &entry : m_entries) {
-        QJsonObject entryObj;
-        entryObj["id"] = entry.id;
-        entryObj["timestamp"] = entry.timestamp.toString(Qt::ISODate);
-        entryObj["algorithm"] = entry.algorithm;
-        entryObj["result"] = entry.result;
-        entryObj["confidence"] = entry.confidence;
-        entryObj["executionTime"] = entry.executionTime;
-        entryObj["notes"] = entry.notes;
-        entryObj["status"] = entry.status;
-        entryObj["errorMessage"] = entry.errorMessage;
-
-        // Add agents array
-        QJsonArray agentsArray;
-        for (const QVariant &agent : entry.agents) {
-            agentsArray.append(agent.toDouble());
+void HistoryManager::storeEntry(const HistoryEntry &entry)
+{
+    if (m_database) {
+        // Kept whatever the entry cap; disk is the limit
+        if (m_database->insert(entry)) {
+            m_aggregates.add(entry);
+        } else {
+            logError(QString("Cannot write history database: %1").arg(m_database->errorString()), "History");
         }
-        entryObj["agents"] = agentsArray;
+    } else {
+        appendEntry(entry);
+
+        // One journal record, whatever the history size
+        journalWritten(m_journal->appendEntry(entry, m_maxEntries));
+    }
+    statisticsModified();
+}
+
+void HistoryManager::appendEntry(const HistoryEntry &entry)
+{
+    m_entries.append(entry);
+    m_index.append(entry.id);
+    m_aggregates.add(entry);
+    trimEntries();
+}
 
-        // Add confidences array
-        QJsonArray confidencesArray;
-        for (const QVariant &confidence : entry.confidences) {
-            confidencesArray.append(confidence.toDouble());
+void HistoryManager::trimEntries()
+{
+    // Trim if exceeding max entries; removed slots at the front go with them
+    while (liveEntryCount() > m_maxEntries) {
+        const QString id = m_entries.first().id;
+        if (id.isEmpty()) {
+            m_removedCount--;
+        } else {
+            m_aggregates.remove(m_entries.first());
         }
-        entryObj["confidences"] = confidencesArray;
+        m_index.removeFirst(id);
+        m_entries.removeFirst();
+    }
+}
 
-        entriesArray.append(entryObj);
+void HistoryManager::purgeRemoved()
+{
+    if (m_removedCount == 0) {
+        return;
     }
 
-    QJsonDocument doc(entriesArray);
+    m_entries.removeIf(isRemoved);
+    m_removedCount = 0;
+    m_index.rebuild(m_entries);
+}
+
+int HistoryManager::liveEntryCount() const
+{
+    return static_cast<int>(m_entries.size()) - m_removedCount;
+}
 
-    // Create directory if it doesn't exist
-    QFileInfo fileInfo(m_historyFilePath);
-    QDir dir = fileInfo.dir();
-    if (!dir.exists()) {
-        dir.mkpath(".");
+void HistoryManager::forEachEntry(const std::function<void(const HistoryEntry &)> &visit) const
+{
+    if (m_database) {
+        // Row by row, never the whole history in memory at once
+        if (!m_database->forEach(visit)) {
+            qWarning() << "Cannot read history database:" << m_database->errorString();
+        }
+        return;
     }
 
-    QFile file(m_historyFilePath);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        logError(QString("Cannot save history file: %1").arg(file.errorString()), "History");
-        return false;
+    for (const HistoryEntry &entry : m_entries) {
+        if (!isRemoved(entry)) {
+            visit(entry);
+        }
     }
+}
 
-    file.write(doc.toJson(QJsonDocument::Indented));
-    file.close();
+void HistoryManager::appendToLogFile(const QString &logLine)
+{
+    // The writer creates the file and its directory
+    m_writer->append(m_logFilePath, (logLine + "\n").toUtf8());
+}
 
-    return true;
+QJsonObject HistoryEntry::toJson() const
+{
+    QJsonObject object;
+    object["id"] = id;
+    object["timestamp"] = timestamp.toString(Qt::ISODate);
+    object["algorithm"] = algorithm;
+    object["result"] = result;
+    object["confidence"] = confidence;
+    object["executionTime"] = executionTime;
+    if (!stages.isEmpty()) {
+        object["stages"] = QJsonObject::fromVariantMap(stages);
+    }
+    object["notes"] = notes;
+    object["status"] = status;
+    object["errorMessage"] = errorMessage;
+
+    // Add agents array
+    QJsonArray agentsArray;
+    for (const QVariant &agent : agents) {
+        agentsArray.append(agent.toDouble());
+    }
+    object["agents"] = agentsArray;
+
+    // Add confidences array
+    QJsonArray confidencesArray;
+    for (const QVariant &agentConfidence : confidences) {
+        confidencesArray.append(agentConfidence.toDouble());
+    }
+    object["confidences"] = confidencesArray;
+
+    return object;
 }
 
-void HistoryManager::appendToLogFile(const QString &logLine)
+HistoryEntry HistoryEntry::fromJson(const QJsonObject &object)
 {
-    // Create directory if it doesn't exist
-    QFileInfo fileInfo(m_logFilePath);
-    QDir dir = fileInfo.dir();
-    if (!dir.exists()) {
-        dir.mkpath(".");
+    HistoryEntry entry;
+    entry.id = object["id"].toString(QUuid::createUuid().toString(QUuid::WithoutBraces));
+    entry.timestamp = QDateTime::fromString(object["timestamp"].toString(), Qt::ISODate);
+    entry.algorithm = object["algorithm"].toString();
+    entry.result = object["result"].toDouble();
+    entry.confidence = object["confidence"].toDouble(1.0);
+    entry.executionTime = object["executionTime"].toDouble(0.0);
+    entry.stages = object["stages"].toObject().toVariantMap();
+    entry.notes = object["notes"].toString();
+    entry.status = object["status"].toString("success");
+    entry.errorMessage = object["errorMessage"].toString();
+
+    // Parse agents
+    QJsonArray agentsArray = object["agents"].toArray();
+    for (const QJsonValue &agentValue : agentsArray) {
+        entry.agents.append(agentValue.toDouble());
     }
 
-    QFile file(m_logFilePath);
-    if (file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
-        QTextStream out(&file);
-        out << logLine << "\n";
-        file.close();
+    // Parse confidences
+    QJsonArray confidencesArray = object["confidences"].toArray();
+    if (confidencesArray.isEmpty()) {
+        // Backward compatibility: if no confidences array, create default ones
+        for (int i = 0; i < entry.agents.size(); ++i) {
+            entry.confidences.append(1.0);
+        }
+    } else {
+        for (const QJsonValue &confidenceValue : confidencesArray) {
+            entry.confidences.append(confidenceValue.toDouble(1.0));
+        }
     }
+
+    return entry;
 }
 
 QString HistoryManager::generateId() const
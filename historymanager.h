@@ -9,6 +9,10 @@
 #include <QFile>
 #include <QTextStream>
 #include <QDir>
+#include <QJsonObject>
+#include <functional>
+#include "historyaggregates.h"
+#include "historyindex.h"
 
 // Log levels
 enum LogLevel {
@@ -28,6 +32,7 @@ struct HistoryEntry {
     double result;
     double confidence;
     double executionTime;
+    QVariantMap stages;  // stage -> ns, see DecisionEngine::scriptStages(); empty for older entries
     QString notes;
     QString status;
     QString errorMessage;
@@ -42,6 +47,7 @@ struct HistoryEntry {
         map["result"] = result;
         map["confidence"] = confidence;
         map["executionTime"] = executionTime;
+        map["stages"] = stages;
         map["agentCount"] = agents.size();
         map["agents"] = agents;
         map["confidences"] = confidences;
@@ -50,14 +56,27 @@ struct HistoryEntry {
         map["errorMessage"] = errorMessage;
         return map;
     }
+
+    // The history file's form of an entry; stages are left out when empty
+    QJsonObject toJson() const;
+    // Missing ids get a new one, missing confidences default to 1.0
+    static HistoryEntry fromJson(const QJsonObject &object);
 };
 
+class HistoryJournal;
+class HistoryDatabase;
+class HistoryWriter;
+
 class HistoryManager : public QObject
 {
     Q_OBJECT
     Q_PROPERTY(QVariantList historyEntries READ getHistoryEntries NOTIFY historyChanged)
     Q_PROPERTY(int entryCount READ getEntryCount NOTIFY historyChanged)
     Q_PROPERTY(bool loggingEnabled READ isLoggingEnabled WRITE setLoggingEnabled NOTIFY loggingEnabledChanged)
+    Q_PROPERTY(QString storageBackend READ storageBackend WRITE setStorageBackend NOTIFY storageBackendChanged)
+    Q_PROPERTY(QVariantMap statistics READ getStatistics NOTIFY statisticsChanged)
+    Q_PROPERTY(QVariantMap algorithmStatistics READ getAlgorithmStatistics NOTIFY statisticsChanged)
+    Q_PROPERTY(double averageResult READ getAverageResult NOTIFY statisticsChanged)
 
 public:
     explicit HistoryManager(QObject *parent = nullptr);
@@ -68,6 +87,17 @@ public:
     void setLogFilePath(const QString &path);
     void setMaxHistoryEntries(int maxEntries);
 
+    // Where the history lives. "json": in memory, persisted to the history
+    // file and its journal, capped at the max entry count. "sqlite": in a
+    // database next to the history file (gdss_history.json ->
+    // gdss_history.sqlite), limited by disk only; the cap then just bounds
+    // historyEntries. An empty database starts with the JSON history; going
+    // back to "json" reloads the history file, which saw none of the
+    // database's changes.
+    QString storageBackend() const;
+    void setStorageBackend(const QString &backend);
+    Q_INVOKABLE QStringList availableStorageBackends() const;
+
     // History management
     Q_INVOKABLE void saveFusionResult(const QVariantList &agents,
                                       const QVariantList &confidences,
@@ -75,18 +105,31 @@ public:
                                       double result,
                                       double confidence = 1.0,
                                       double executionTime = 0.0,
-                                      const QString &notes = "");
+                                      const QString &notes = "",
+                                      const QVariantMap &stages = QVariantMap());
 
     Q_INVOKABLE void saveErrorResult(const QVariantList &agents,
                                      const QVariantList &confidences,
                                      const QString &algorithm,
                                      const QString &errorMessage,
-                                     double executionTime = 0.0);
+                                     double executionTime = 0.0,
+                                     const QVariantMap &stages = QVariantMap());
+
+    // A run killed for exceeding its deadline; counted with the errors
+    Q_INVOKABLE void saveTimeoutResult(const QVariantList &agents,
+                                       const QVariantList &confidences,
+                                       const QString &algorithm,
+                                       const QString &errorMessage,
+                                       double executionTime = 0.0,
+                                       const QVariantMap &stages = QVariantMap());
 
     Q_INVOKABLE QVariantList getHistoryEntries() const;
     Q_INVOKABLE QVariantMap getEntry(const QString &id) const;
     Q_INVOKABLE void clearHistory();
     Q_INVOKABLE void removeEntry(const QString &id);
+    // Entries matching filter, newest first. Keys, all optional: algorithm,
+    // status, from and to (dates or ISO strings, inclusive), offset, limit.
+    Q_INVOKABLE QVariantList queryEntries(const QVariantMap &filter) const;
 
     // Logging
     Q_INVOKABLE void log(LogLevel level, const QString &message, const QString &context = "");
@@ -98,12 +141,21 @@ public:
     Q_INVOKABLE QString getLogs(int maxLines = 100) const;
     Q_INVOKABLE void clearLogs();
 
+    // Journal records and log lines are written behind the caller, see
+    // HistoryWriter. flush() returns once everything so far is on disk
+    // (false if timeoutMs passed first, -1 waits as long as it takes);
+    // persistenceMetrics() has the writer's queue depth and flush latency.
+    Q_INVOKABLE bool flush(int timeoutMs = -1);
+    Q_INVOKABLE QVariantMap persistenceMetrics() const;
+
     // Export/Import
     Q_INVOKABLE bool exportHistoryToJson(const QString &filePath);
     Q_INVOKABLE bool exportHistoryToCsv(const QString &filePath);
     Q_INVOKABLE bool importHistoryFromJson(const QString &filePath);
 
-    // Statistics
+    // Statistics. Kept up to date as entries come and go (see
+    // HistoryAggregates) and cached between changes, so reading them is O(1);
+    // statisticsChanged() is the one signal for all three.
     Q_INVOKABLE QVariantMap getStatistics() const;
     Q_INVOKABLE double getAverageResult() const;
     Q_INVOKABLE QVariantMap getAlgorithmStatistics() const;
@@ -118,23 +170,61 @@ signals:
     void newEntryAdded(const QVariantMap &entry);
     void entryRemoved(const QString &id);
     void historyCleared();
+    void statisticsChanged();
 
     void logAdded(const QString &logLine);
     void loggingEnabledChanged();
+    void storageBackendChanged();
 
 private:
     // File operations
     bool loadHistoryFromFile();
+    // Compacts the whole history into the history file before returning
     bool saveHistoryToFile();
+    // Compacts in the background once the journal holds as many records as
+    // there are entries, which keeps the cost per save O(1) amortized
+    void journalWritten(bool ok);
+    // Opens the database for the history file, copying the JSON history into it if it is new
+    bool openDatabase();
+    QString databaseFilePath() const;
+    // Adds a new entry to whichever backend is in use
+    void storeEntry(const HistoryEntry &entry);
+    // JSON backend: appends to m_entries and m_index, then trims to m_maxEntries
+    void appendEntry(const HistoryEntry &entry);
+    void trimEntries();
+    // Drops the slots of removed entries and renumbers the index
+    void purgeRemoved();
+    int liveEntryCount() const;
+    // Drops the cached statistics and emits statisticsChanged()
+    void statisticsModified();
+    void cacheStatistics() const;
+    // Oldest first
+    void forEachEntry(const std::function<void(const HistoryEntry &)> &visit) const;
     void appendToLogFile(const QString &logLine);
 
     // Helper methods
+    void saveFailedResult(const QVariantList &agents, const QVariantList &confidences,
+                          const QString &algorithm, const QString &errorMessage,
+                          double executionTime, const QVariantMap &stages,
+                          const QString &status);
     QString generateId() const;
     QString logLevelToString(LogLevel level) const;
     QString getLogLevelColor(LogLevel level) const;
 
     // Data storage
     QList<HistoryEntry> m_entries;
+    HistoryIndex m_index;  // id -> position in m_entries
+    int m_removedCount;  // slots in m_entries left by removeEntry(), id empty; see HistoryIndex
+    HistoryAggregates m_aggregates;  // over m_entries, or the database's rows when it is in use
+
+    // Statistics as last handed out, valid until the history changes
+    mutable bool m_statisticsCached;
+    mutable QVariantMap m_statistics;
+    mutable QVariantMap m_algorithmStatistics;
+    mutable double m_averageResult;
+    HistoryWriter *m_writer;  // the background thread journal and log appends go through
+    HistoryJournal *m_journal;  // every change is appended here, see HistoryJournal
+    HistoryDatabase *m_database;  // null unless the sqlite backend is in use; m_entries is empty then
     QString m_historyFilePath;
     QString m_logFilePath;
     int m_maxEntries;
@@ -143,7 +233,10 @@ private:
     // Default paths
     static const QString DEFAULT_HISTORY_FILE;
     static const QString DEFAULT_LOG_FILE;
+    static const QString JSON_BACKEND;
+    static const QString SQLITE_BACKEND;
     static const int DEFAULT_MAX_ENTRIES = 1000;
+    static constexpr int MIN_COMPACTION_RECORDS = 256;  // journal records before compaction is considered
 };
 
 #endif // HISTORYMANAGER_H
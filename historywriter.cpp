@@ -0,0 +1,191 @@
+#include "historywriter.h"
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QStringList>
+#include <QThread>
+
+HistoryWriter::HistoryWriter(qsizetype maxQueuedBytes, QObject *parent)
+    : QObject(parent),
+    m_thread(QThread::create([this]() { run(); })),
+    m_maxQueuedBytes(maxQueuedBytes),
+    m_queuedBytes(0),
+    m_enqueuedCount(0),
+    m_writtenCount(0),
+    m_stopping(false),
+    m_peakQueueDepth(0),
+    m_flushes(0),
+    m_recordsWritten(0),
+    m_bytesWritten(0),
+    m_writeErrors(0),
+    m_lastFlushMs(0.0),
+    m_totalFlushMs(0.0),
+    m_maxFlushMs(0.0)
+{
+    m_thread->setObjectName("HistoryWriter");
+    m_thread->start();
+}
+
+HistoryWriter::~HistoryWriter()
+{
+    flush();
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stopping = true;
+        m_queued.wakeAll();
+        m_room.wakeAll();
+    }
+    m_thread->wait();
+    delete m_thread;
+}
+
+void HistoryWriter::append(const QString &path, const QByteArray &data)
+{
+    enqueue({ Operation::Append, path, data });
+}
+
+void HistoryWriter::remove(const QString &path)
+{
+    enqueue({ Operation::Remove, path, QByteArray() });
+}
+
+void HistoryWriter::enqueue(Operation operation)
+{
+    QMutexLocker locker(&m_mutex);
+
+    // Bytes of the burst being written still count, so memory stays bounded
+    // while the disk is slow; an operation larger than the bound goes alone
+    const qsizetype size = operation.data.size();
+    while (!m_stopping && m_queuedBytes > 0 && m_queuedBytes + size > m_maxQueuedBytes) {
+        m_room.wait(&m_mutex);
+    }
+
+    m_queue.append(std::move(operation));
+    m_queuedBytes += size;
+    m_enqueuedCount++;
+    m_peakQueueDepth = qMax(m_peakQueueDepth, static_cast<int>(m_queue.size()));
+    m_queued.wakeOne();
+}
+
+bool HistoryWriter::flush(QDeadlineTimer deadline)
+{
+    QMutexLocker locker(&m_mutex);
+    const quint64 target = m_enqueuedCount;
+    while (m_writtenCount < target) {
+        if (!m_written.wait(&m_mutex, deadline)) {
+            return m_writtenCount >= target;
+        }
+    }
+    return true;
+}
+
+QVariantMap HistoryWriter::metrics() const
+{
+    QMutexLocker locker(&m_mutex);
+    QVariantMap metrics;
+    metrics["queueDepth"] = static_cast<int>(m_queue.size());
+    metrics["queuedBytes"] = static_cast<qint64>(m_queuedBytes);
+    metrics["peakQueueDepth"] = m_peakQueueDepth;
+    metrics["flushes"] = m_flushes;
+    metrics["recordsWritten"] = m_recordsWritten;
+    metrics["bytesWritten"] = m_bytesWritten;
+    metrics["lastFlushMs"] = m_lastFlushMs;
+    metrics["averageFlushMs"] = m_flushes > 0 ? m_totalFlushMs / m_flushes : 0.0;
+    metrics["maxFlushMs"] = m_maxFlushMs;
+    metrics["writeErrors"] = m_writeErrors;
+    return metrics;
+}
+
+// ========== WRITER THREAD ==========
+
+void HistoryWriter::run()
+{
+    QMutexLocker locker(&m_mutex);
+    for (;;) {
+        while (m_queue.isEmpty() && !m_stopping) {
+            m_queued.wait(&m_mutex);
+        }
+        if (m_queue.isEmpty()) {
+            return;  // Stopping, and nothing left
+        }
+
+        // Everything queued since the last pass is one burst
+        QList<Operation> batch;
+        batch.swap(m_queue);
+        const qsizetype batchBytes = m_queuedBytes;
+        locker.unlock();
+
+        QElapsedTimer timer;
+        timer.start();
+        write(batch);
+        const double elapsedMs = timer.nsecsElapsed() / 1e6;
+
+        qint64 records = 0;
+        for (const Operation &operation : batch) {
+            if (operation.kind == Operation::Append) {
+                records++;
+            }
+        }
+
+        locker.relock();
+        m_queuedBytes -= batchBytes;
+        m_writtenCount += batch.size();
+        m_flushes++;
+        m_recordsWritten += records;
+        m_bytesWritten += batchBytes;
+        m_lastFlushMs = elapsedMs;
+        m_totalFlushMs += elapsedMs;
+        m_maxFlushMs = qMax(m_maxFlushMs, elapsedMs);
+        m_room.wakeAll();
+        m_written.wakeAll();
+    }
+}
+
+void HistoryWriter::write(const QList<Operation> &batch)
+{
+    // Appends to one file become one write; a removal drops what was
+    // queued for the file before it
+    QHash<QString, QByteArray> pending;
+    QStringList order;
+    for (const Operation &operation : batch) {
+        if (operation.kind == Operation::Append) {
+            auto it = pending.find(operation.path);
+            if (it == pending.end()) {
+                pending.insert(operation.path, operation.data);
+                order.append(operation.path);
+            } else {
+                it->append(operation.data);
+            }
+        } else {
+            pending.remove(operation.path);
+            order.removeAll(operation.path);
+            QFile::remove(operation.path);
+        }
+    }
+
+    for (const QString &path : order) {
+        writeFile(path, pending.value(path));
+    }
+}
+
+bool HistoryWriter::writeFile(const QString &path, const QByteArray &data)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        QDir().mkpath(QFileInfo(path).absolutePath());
+    }
+    if ((file.isOpen() || file.open(QIODevice::WriteOnly | QIODevice::Append))
+        && file.write(data) == data.size() && file.flush()) {
+        return true;
+    }
+
+    const QString errorString = file.errorString();
+    {
+        QMutexLocker locker(&m_mutex);
+        m_writeErrors++;
+    }
+    emit writeFailed(path, errorString);
+    return false;
+}
@@ -0,0 +1,99 @@
+#ifndef HISTORYWRITER_H
+#define HISTORYWRITER_H
+
+#include <QByteArray>
+#include <QDeadlineTimer>
+#include <QList>
+#include <QMutex>
+#include <QObject>
+#include <QString>
+#include <QVariantMap>
+#include <QWaitCondition>
+
+class QThread;
+
+// Write-behind file appends for HistoryManager.
+//
+// Journal records and log lines are queued here and written by one
+// background thread, so saving a result or logging a line never waits for
+// the disk. The thread takes everything queued since its last pass and
+// writes it as one burst: all the data for one file goes out in a single
+// write and flush, however many records a comparison finishing at once
+// produced. The queue is bounded by bytes; a producer that outruns the disk
+// waits for room instead of growing memory without limit.
+//
+// Appends to one file land in the order they were queued, and a queued
+// removal of a file happens after the appends queued before it. What is
+// still queued when the process dies is lost; flush() is the barrier for
+// shutdown and for readers of the files.
+class HistoryWriter : public QObject
+{
+    Q_OBJECT
+
+public:
+    static const qsizetype DEFAULT_MAX_QUEUED_BYTES = 8 * 1024 * 1024;
+
+    explicit HistoryWriter(qsizetype maxQueuedBytes = DEFAULT_MAX_QUEUED_BYTES,
+                           QObject *parent = nullptr);
+    // Flushes, then stops the thread
+    ~HistoryWriter();
+
+    // Queues data to be appended to the file, creating it and its directory
+    // if needed; waits while the queue is full
+    void append(const QString &path, const QByteArray &data);
+    // Queues deleting the file
+    void remove(const QString &path);
+
+    // Returns once everything queued so far is written and flushed; false if
+    // the deadline passed first
+    bool flush(QDeadlineTimer deadline = QDeadlineTimer(QDeadlineTimer::Forever));
+
+    // queueDepth (operations waiting), queuedBytes, peakQueueDepth, flushes
+    // (bursts written), recordsWritten, bytesWritten, lastFlushMs,
+    // averageFlushMs and maxFlushMs (time to write and flush one burst),
+    // writeErrors
+    QVariantMap metrics() const;
+
+signals:
+    // From the writer thread; the data of that burst for the file is dropped
+    void writeFailed(const QString &path, const QString &errorString);
+
+private:
+    struct Operation {
+        enum Kind { Append, Remove };
+        Kind kind;
+        QString path;
+        QByteArray data;
+    };
+
+    void enqueue(Operation operation);
+    void run();
+    // Writes one burst, coalescing the appends per file
+    void write(const QList<Operation> &batch);
+    bool writeFile(const QString &path, const QByteArray &data);
+
+    QThread *m_thread;
+    const qsizetype m_maxQueuedBytes;
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_queued;  // work for the thread, or m_stopping
+    QWaitCondition m_room;  // queued bytes went down
+    QWaitCondition m_written;  // m_written went up
+    QList<Operation> m_queue;
+    qsizetype m_queuedBytes;
+    quint64 m_enqueuedCount;  // operations queued so far
+    quint64 m_writtenCount;  // of those, operations done
+    bool m_stopping;
+
+    // Metrics, under m_mutex
+    int m_peakQueueDepth;
+    qint64 m_flushes;
+    qint64 m_recordsWritten;
+    qint64 m_bytesWritten;
+    qint64 m_writeErrors;
+    double m_lastFlushMs;
+    double m_totalFlushMs;
+    double m_maxFlushMs;
+};
+
+#endif // HISTORYWRITER_H
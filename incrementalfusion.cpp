@@ -0,0 +1,280 @@
+#include "incrementalfusion.h"
+#include "nativefusion.h"
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+namespace {
+
+const double HIGH_THRESHOLD = 0.5;  // fuzzy.py's majority split
+
+double clampUnit(double value)
+{
+    return qBound(0.0, value, 1.0);
+}
+
+NativeFusionResult failure(const QString &message)
+{
+    NativeFusionResult result;
+    result.ok = false;
+    result.errorMessage = message;
+    return result;
+}
+
+} // namespace
+
+IncrementalFusion::IncrementalFusion()
+{
+    clear();
+}
+
+bool IncrementalFusion::supports(const QString &scriptName)
+{
+    return scriptName == QLatin1String("weighted.py")
+           || scriptName == QLatin1String("weighted_with_confidence.py")
+           || scriptName == QLatin1String("consensus.py")
+           || scriptName == QLatin1String("fuzzy.py");
+}
+
+void IncrementalFusion::clear()
+{
+    m_count = 0;
+    m_sum = 0.0;
+    m_sumSquares = 0.0;
+    m_confidenceSum = 0.0;
+    m_weightedSum = 0.0;
+    m_mean = 0.0;
+    m_m2 = 0.0;
+    m_highCount = 0;
+    m_highSum = 0.0;
+    m_removals = 0;
+    m_sorted.clear();
+    m_pending.clear();
+    m_pendingRemovals.clear();
+}
+
+void IncrementalFusion::add(double value, double confidence)
+{
+    m_count++;
+    m_sum += value;
+    m_sumSquares += value * value;
+    m_confidenceSum += confidence;
+    m_weightedSum += value * confidence;
+
+    const double delta = value - m_mean;
+    m_mean += delta / m_count;
+    m_m2 += delta * (value - m_mean);
+
+    if (value > HIGH_THRESHOLD) {
+        m_highCount++;
+        m_highSum += value;
+    }
+
+    insertSorted(value);
+}
+
+void IncrementalFusion::remove(double value, double confidence)
+{
+    if (m_count <= 1) {
+        // Start over exactly rather than keep the rounding residue
+        clear();
+        return;
+    }
+
+    m_sum -= value;
+    m_sumSquares -= value * value;
+    m_confidenceSum -= confidence;
+    m_weightedSum -= value * confidence;
+
+    // Welford in reverse
+    const double previousMean = (m_count * m_mean - value) / (m_count - 1);
+    m_m2 = std::max(0.0, m_m2 - (value - m_mean) * (value - previousMean));
+    m_mean = previousMean;
+    m_count--;
+
+    if (value > HIGH_THRESHOLD) {
+        m_highCount--;
+        m_highSum -= value;
+    }
+
+    eraseSorted(value);
+    m_removals++;
+}
+
+void IncrementalFusion::replace(double oldValue, double oldConfidence, double value, double confidence)
+{
+    if (oldValue == value) {
+        // Confidence-only edits leave everything but the confidence sums alone
+        m_confidenceSum += confidence - oldConfidence;
+        m_weightedSum += value * (confidence - oldConfidence);
+        m_removals++;
+        return;
+    }
+
+    remove(oldValue, oldConfidence);
+    add(value, confidence);
+}
+
+bool IncrementalFusion::needsRebuild() const
+{
+    // Amortized O(1): a rebuild costs O(n) and waits for at least n removals
+    return m_removals > std::max(REBUILD_MIN_REMOVALS, m_count);
+}
+
+NativeFusionResult IncrementalFusion::result(const QString &scriptName) const
+{
+    if (m_count <= 0) {
+        return failure("No agent data!");
+    }
+
+    if (scriptName == QLatin1String("weighted.py")) {
+        return weighted();
+    }
+    if (scriptName == QLatin1String("weighted_with_confidence.py")) {
+        return weightedWithConfidence();
+    }
+    if (scriptName == QLatin1String("consensus.py")) {
+        return consensus();
+    }
+    if (scriptName == QLatin1String("fuzzy.py")) {
+        return fuzzy();
+    }
+    return failure(QString("No incremental implementation for %1").arg(scriptName));
+}
+
+// ========== SORTED VALUES ==========
+
+void IncrementalFusion::insertSorted(double value)
+{
+    m_pending.push_back(value);
+    boundPending();
+}
+
+void IncrementalFusion::eraseSorted(double value)
+{
+    m_pendingRemovals.push_back(value);
+    boundPending();
+}
+
+void IncrementalFusion::boundPending()
+{
+    // Without consensus lookups the buffers would grow with every edit;
+    // merging once they outgrow the sorted values keeps edits O(log n)
+    // amortized
+    const std::size_t buffered = m_pending.size() + m_pendingRemovals.size();
+    if (buffered > std::max<std::size_t>(MERGE_MIN_PENDING, m_sorted.size())) {
+        mergePending();
+    }
+}
+
+void IncrementalFusion::mergePending() const
+{
+    // Adds first: a value added and removed since the last merge is only
+    // found in m_pending
+    if (m_pending.size() == 1) {
+        const double value = m_pending.front();
+        m_sorted.insert(std::upper_bound(m_sorted.begin(), m_sorted.end(), value), value);
+    } else if (!m_pending.empty()) {
+        std::sort(m_pending.begin(), m_pending.end());
+        const std::size_t middle = m_sorted.size();
+        m_sorted.insert(m_sorted.end(), m_pending.begin(), m_pending.end());
+        std::inplace_merge(m_sorted.begin(), m_sorted.begin() + middle, m_sorted.end());
+    }
+    m_pending.clear();
+
+    if (m_pendingRemovals.size() == 1) {
+        const double value = m_pendingRemovals.front();
+        auto it = std::lower_bound(m_sorted.begin(), m_sorted.end(), value);
+        if (it != m_sorted.end() && *it == value) {
+            m_sorted.erase(it);
+        }
+    } else if (!m_pendingRemovals.empty()) {
+        // One pass drops every removed value, each copy at most once
+        std::sort(m_pendingRemovals.begin(), m_pendingRemovals.end());
+        std::vector<double> kept;
+        kept.reserve(m_sorted.size());
+        std::set_difference(m_sorted.begin(), m_sorted.end(),
+                            m_pendingRemovals.begin(), m_pendingRemovals.end(),
+                            std::back_inserter(kept));
+        m_sorted.swap(kept);
+    }
+    m_pendingRemovals.clear();
+}
+
+// ========== ALGORITHMS ==========
+
+// Same formulas as NativeFusion, fed from the running sums
+
+NativeFusionResult IncrementalFusion::weighted() const
+{
+    NativeFusionResult result;
+    result.fused = clampUnit(m_sum > 0.0 ? m_sumSquares / m_sum : m_sum / m_count);
+    return result;
+}
+
+NativeFusionResult IncrementalFusion::weightedWithConfidence() const
+{
+    if (m_confidenceSum == 0.0) {
+        return failure("Confidences sum to zero; cannot weight agents.");
+    }
+
+    NativeFusionResult result;
+    result.fused = m_weightedSum / m_confidenceSum;
+    result.confidence = m_confidenceSum / m_count;
+    return result;
+}
+
+NativeFusionResult IncrementalFusion::consensus() const
+{
+    mergePending();
+
+    const double threshold = 0.2f;
+    const double mean = static_cast<float>(m_sum / m_count);
+
+    // |v - mean| < threshold holds on one contiguous run of the sorted values
+    auto first = std::partition_point(m_sorted.begin(), m_sorted.end(), [mean, threshold](double v) {
+        return v < mean && !(mean - v < threshold);
+    });
+    auto last = std::partition_point(first, m_sorted.end(), [mean, threshold](double v) {
+        return v <= mean || v - mean < threshold;
+    });
+    const double consensusRatio = static_cast<double>(last - first) / m_count;
+
+    NativeFusionResult result;
+    if (consensusRatio > 0.7) {
+        result.fused = clampUnit(mean);
+        return result;
+    }
+
+    const std::size_t middle = m_sorted.size() / 2;
+    double median = m_sorted[middle];
+    if (m_sorted.size() % 2 == 0) {
+        median = (m_sorted[middle - 1] + median) / 2.0;
+    }
+
+    result.fused = clampUnit(median);
+    return result;
+}
+
+NativeFusionResult IncrementalFusion::fuzzy() const
+{
+    const double mean = m_mean;
+    const double stdDev = std::sqrt(m_m2 / m_count);
+
+    double fused;
+    if (mean > 0.8 && stdDev < 0.1) {
+        fused = 0.95;
+    } else if (mean < 0.2 && stdDev < 0.1) {
+        fused = 0.05;
+    } else if (stdDev < 0.2) {
+        fused = mean;
+    } else if (m_highCount > m_count / 2.0) {
+        fused = m_highSum / m_highCount;
+    } else {
+        fused = (m_sum - m_highSum) / (m_count - m_highCount);
+    }
+
+    NativeFusionResult result;
+    result.fused = clampUnit(fused);
+    return result;
+}
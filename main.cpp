@@ -1,8 +1,9 @@
 #include <QGuiApplication>
 #include <QQmlApplicationEngine>
 #include <QQmlContext>
-#include "DecisionEngine.h"
-#include "HistoryManager.h"
+#include "decisionengine.h"
+#include "historymanager.h"
+#include "streamingfusion.h"
 
 int main(int argc, char *argv[]) {
 
@@ -12,6 +13,9 @@ int main(int argc, char *argv[]) {
 
     qmlRegisterType<DecisionEngine>("GDSS", 1, 0, "DecisionEngine");
     qmlRegisterType<HistoryManager>("GDSS", 1, 0, "HistoryManager");
+    qmlRegisterType<StreamingFusion>("GDSS", 1, 0, "StreamingFusion");
+    qmlRegisterUncreatableType<ComparisonResultModel>("GDSS", 1, 0, "ComparisonResultModel",
+                                                      "Owned by DecisionEngine");
 
     QQmlApplicationEngine engine;
     engine.load(QUrl(QStringLiteral("qrc:DSSS_2025/Main.qml")));
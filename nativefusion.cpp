@@ -0,0 +1,201 @@
+#include "nativefusion.h"
+#include "fusionkernels.h"
+#include <QtGlobal>
+#include <QVector>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace {
+
+double clampUnit(double value)
+{
+    return qBound(0.0, value, 1.0);
+}
+
+NativeFusionResult failure(const QString &message)
+{
+    NativeFusionResult result;
+    result.ok = false;
+    result.errorMessage = message;
+    return result;
+}
+
+} // namespace
+
+bool NativeFusion::contains(const QString &scriptName)
+{
+    return registry().contains(scriptName);
+}
+
+QStringList NativeFusion::algorithms()
+{
+    QStringList names = registry().keys();
+    names.sort();
+    return names;
+}
+
+NativeFusionResult NativeFusion::run(const QString &scriptName,
+                                     const QList<AgentData> &agents,
+                                     bool hasConfidences)
+{
+    // Split into the columnar layout the kernels stream over
+    QVector<double> values;
+    QVector<double> confidences;
+    values.reserve(agents.size());
+    if (hasConfidences)
+        confidences.reserve(agents.size());
+
+    for (const AgentData &agent : agents) {
+        values.append(agent.value);
+        if (hasConfidences)
+            confidences.append(agent.confidence);
+    }
+
+    return run(scriptName, values.constData(),
+               hasConfidences ? confidences.constData() : nullptr,
+               values.size());
+}
+
+NativeFusionResult NativeFusion::run(const QString &scriptName,
+                                     const double *values,
+                                     const double *confidences,
+                                     qsizetype count)
+{
+    auto it = registry().constFind(scriptName);
+    if (it == registry().constEnd()) {
+        return failure(QString("No native implementation for %1").arg(scriptName));
+    }
+
+    if (count <= 0) {
+        return failure("No agent data!");
+    }
+
+    return it.value()(values, confidences, count);
+}
+
+QVector<NativeFusionResult> NativeFusion::run(const QString &scriptName, const CriteriaTable &table)
+{
+    // The columns are contiguous, so each one goes through the kernels just
+    // like a single-criterion agent set
+    QVector<NativeFusionResult> results;
+    results.reserve(table.criteriaCount());
+    for (int k = 0; k < table.criteriaCount(); ++k) {
+        results.append(run(scriptName, table.column(k), table.confidences(), table.agentCount()));
+    }
+    return results;
+}
+
+// weighted.py: each value is weighted by itself, w_i = v_i / sum(v)
+NativeFusionResult NativeFusion::weighted(const double *values, const double *confidences, qsizetype count)
+{
+    Q_UNUSED(confidences) // The script ignores confidences
+
+    const double sum = FusionKernels::sum(values, count);
+    const double sumSquares = FusionKernels::dot(values, values, count);
+
+    NativeFusionResult result;
+    result.fused = clampUnit(sum > 0.0 ? sumSquares / sum : sum / count);
+    return result;
+}
+
+// weighted_with_confidence.py: w_i = c_i / sum(c), equal weights without confidences
+NativeFusionResult NativeFusion::weightedWithConfidence(const double *values, const double *confidences, qsizetype count)
+{
+    NativeFusionResult result;
+
+    if (!confidences) {
+        result.fused = FusionKernels::sum(values, count) / count;
+        result.confidence = 1.0;
+        return result;
+    }
+
+    const double confidenceSum = FusionKernels::sum(confidences, count);
+    if (confidenceSum == 0.0) {
+        // numpy yields NaN here, which the JSON reply cannot carry either
+        return failure("Confidences sum to zero; cannot weight agents.");
+    }
+
+    result.fused = FusionKernels::dot(values, confidences, count) / confidenceSum;
+    result.confidence = confidenceSum / count;
+    return result;
+}
+
+// consensus.py: mean if >70% of agents lie within 0.2 of it, otherwise median
+NativeFusionResult NativeFusion::consensus(const double *values, const double *confidences, qsizetype count)
+{
+    Q_UNUSED(confidences)
+
+    // The script works in float32; rounding the mean and threshold the same
+    // way keeps the agreement test in step with it
+    const double threshold = 0.2f;
+    const double mean = static_cast<float>(FusionKernels::sum(values, count) / count);
+    const std::size_t withinThreshold = FusionKernels::countWithin(values, count, mean, threshold);
+    const double consensusRatio = static_cast<double>(withinThreshold) / count;
+
+    NativeFusionResult result;
+    if (consensusRatio > 0.7) {
+        result.fused = clampUnit(mean);
+        return result;
+    }
+
+    // Weak consensus: fall back to the median
+    std::vector<double> sorted(values, values + count);
+
+    const std::size_t middle = sorted.size() / 2;
+    std::nth_element(sorted.begin(), sorted.begin() + middle, sorted.end());
+    double median = sorted[middle];
+    if (sorted.size() % 2 == 0) {
+        double lower = *std::max_element(sorted.begin(), sorted.begin() + middle);
+        median = (lower + median) / 2.0;
+    }
+
+    result.fused = clampUnit(median);
+    return result;
+}
+
+// fuzzy.py: rules over mean and population standard deviation
+NativeFusionResult NativeFusion::fuzzy(const double *values, const double *confidences, qsizetype count)
+{
+    Q_UNUSED(confidences)
+
+    double mean = 0.0;
+    double variance = 0.0;
+    FusionKernels::meanVariance(values, count, mean, variance);
+    const double stdDev = std::sqrt(variance);
+
+    double fused;
+    if (mean > 0.8 && stdDev < 0.1) {
+        fused = 0.95; // Strong consensus high
+    } else if (mean < 0.2 && stdDev < 0.1) {
+        fused = 0.05; // Strong consensus low
+    } else if (stdDev < 0.2) {
+        fused = mean; // Good agreement
+    } else {
+        // High conflict - trust the majority
+        double highSum = 0.0;
+        const std::size_t highCount = FusionKernels::countAbove(values, count, 0.5, highSum);
+
+        if (highCount > count / 2.0) {
+            fused = highSum / highCount;
+        } else {
+            const double lowSum = FusionKernels::sum(values, count) - highSum;
+            fused = lowSum / (count - highCount);
+        }
+    }
+
+    NativeFusionResult result;
+    result.fused = clampUnit(fused);
+    return result;
+}
+
+const QHash<QString, NativeFusion::FusionFunction> &NativeFusion::registry()
+{
+    static const QHash<QString, FusionFunction> functions = {
+        { QStringLiteral("weighted.py"), &NativeFusion::weighted },
+        { QStringLiteral("weighted_with_confidence.py"), &NativeFusion::weightedWithConfidence },
+        { QStringLiteral("consensus.py"), &NativeFusion::consensus },
+        { QStringLiteral("fuzzy.py"), &NativeFusion::fuzzy },
+    };
+    return functions;
+}
@@ -0,0 +1,60 @@
+#ifndef NATIVEFUSION_H
+#define NATIVEFUSION_H
+
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <functional>
+#include "decisionengine.h"
+#include "criteriatable.h"
+
+// Result of an in-process fusion; mirrors the JSON a script prints
+struct NativeFusionResult {
+    bool ok = true;
+    double fused = 0.0;
+    double confidence = 1.0;
+    QString errorMessage;
+};
+
+// In-process C++ implementations of the deterministic fusion scripts.
+//
+// The registry is keyed by the script file name ("weighted.py", ...), so
+// DecisionEngine can take the native path whenever one exists and fall
+// back to the Python worker pool otherwise. Each implementation follows
+// the numpy arithmetic of its script closely enough to agree within 1e-6.
+//
+// The algorithms work on contiguous value/confidence arrays so the
+// reductions run through the SIMD kernels in FusionKernels; confidences
+// may be null when the caller has none.
+class NativeFusion
+{
+public:
+    using FusionFunction = std::function<NativeFusionResult(const double *values,
+                                                            const double *confidences,
+                                                            qsizetype count)>;
+
+    static bool contains(const QString &scriptName);
+    static QStringList algorithms();
+    static NativeFusionResult run(const QString &scriptName,
+                                  const QList<AgentData> &agents,
+                                  bool hasConfidences);
+    static NativeFusionResult run(const QString &scriptName,
+                                  const double *values,
+                                  const double *confidences,
+                                  qsizetype count);
+    // One result per criterion, in table order; each column is fused on its own
+    static QVector<NativeFusionResult> run(const QString &scriptName, const CriteriaTable &table);
+
+    // Individual algorithms, named after the scripts they replace
+    static NativeFusionResult weighted(const double *values, const double *confidences, qsizetype count);
+    static NativeFusionResult weightedWithConfidence(const double *values, const double *confidences, qsizetype count);
+    static NativeFusionResult consensus(const double *values, const double *confidences, qsizetype count);
+    static NativeFusionResult fuzzy(const double *values, const double *confidences, qsizetype count);
+
+private:
+    static const QHash<QString, FusionFunction> &registry();
+};
+
+#endif // NATIVEFUSION_H
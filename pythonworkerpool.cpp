@@ -0,0 +1,500 @@
+#include "pythonworkerpool.h"
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QTimer>
+
+PythonWorkerPool::PythonWorkerPool(QObject *parent)
+    : QObject(parent),
+    m_pythonProgram("python"),
+    m_poolSize(2),
+    m_environment(QProcessEnvironment::systemEnvironment()),
+    m_nextRequestId(1)
+{
+    m_clock.start();
+}
+
+PythonWorkerPool::~PythonWorkerPool()
+{
+    shutdown();
+}
+
+// Configuration
+void PythonWorkerPool::setPythonProgram(const QString &program)
+{
+    m_pythonProgram = program;
+}
+
+QString PythonWorkerPool::pythonProgram() const
+{
+    return m_pythonProgram;
+}
+
+void PythonWorkerPool::setWorkerScript(const QString &path)
+{
+    if (m_workerScript == path)
+        return;
+
+    m_workerScript = path;
+
+    // Idle workers were started from the old location; busy ones finish first
+    const QList<Worker *> workers = m_workers;
+    for (Worker *worker : workers) {
+        if (worker->activeRequest == 0)
+            stopWorker(worker);
+    }
+}
+
+QString PythonWorkerPool::workerScript() const
+{
+    return m_workerScript;
+}
+
+void PythonWorkerPool::setPoolSize(int size)
+{
+    m_poolSize = qMax(1, size);
+
+    // Shrink by retiring idle workers; busy ones are retired when they finish
+    const QList<Worker *> workers = m_workers;
+    for (Worker *worker : workers) {
+        if (m_workers.size() <= m_poolSize)
+            break;
+        if (worker->activeRequest == 0)
+            stopWorker(worker);
+    }
+
+    dispatch();
+}
+
+int PythonWorkerPool::poolSize() const
+{
+    return m_poolSize;
+}
+
+void PythonWorkerPool::setProcessEnvironment(const QProcessEnvironment &environment)
+{
+    m_environment = environment;
+}
+
+QProcessEnvironment PythonWorkerPool::processEnvironment() const
+{
+    return m_environment;
+}
+
+int PythonWorkerPool::workerCount() const
+{
+    return m_workers.size();
+}
+
+int PythonWorkerPool::busyWorkers() const
+{
+    int busy = 0;
+    for (const Worker *worker : m_workers) {
+        if (worker->activeRequest != 0)
+            busy++;
+    }
+    return busy;
+}
+
+int PythonWorkerPool::pendingRequests() const
+{
+    return m_queue.size();
+}
+
+bool PythonWorkerPool::scriptCapabilities(const QString &scriptPath,
+                                          ScriptCapabilities &capabilities) const
+{
+    auto it = m_capabilities.constFind(scriptPath);
+    if (it == m_capabilities.constEnd() || it->modified != QFileInfo(scriptPath).lastModified()) {
+        return false;
+    }
+    capabilities = it.value();
+    return true;
+}
+
+quint64 PythonWorkerPool::reserveRequestId()
+{
+    return m_nextRequestId.fetch_add(1, std::memory_order_relaxed);
+}
+
+quint64 PythonWorkerPool::submit(const QString &scriptPath, const QByteArray &input,
+                                 const QString &entry, quint64 requestId)
+{
+    Request request;
+    request.id = requestId != 0 ? requestId : reserveRequestId();
+    request.scriptPath = scriptPath;
+    request.entry = entry;
+    request.input = input;
+    request.submitted = m_clock.nsecsElapsed();
+    m_queue.enqueue(request);
+
+    // Dispatch from the event loop so callers always learn the id before any reply
+    QTimer::singleShot(0, this, &PythonWorkerPool::dispatch);
+    return request.id;
+}
+
+quint64 PythonWorkerPool::submitShared(const QString &scriptPath, const QString &segmentPath,
+                                       qint64 segmentBytes, const QString &entry, quint64 requestId)
+{
+    Request request;
+    request.id = requestId != 0 ? requestId : reserveRequestId();
+    request.scriptPath = scriptPath;
+    request.entry = entry;
+    request.segmentPath = segmentPath;
+    request.segmentBytes = segmentBytes;
+    request.submitted = m_clock.nsecsElapsed();
+    m_queue.enqueue(request);
+
+    QTimer::singleShot(0, this, &PythonWorkerPool::dispatch);
+    return request.id;
+}
+
+quint64 PythonWorkerPool::submitPipeline(const QVariantList &stages, const QByteArray &frame,
+                                         quint64 requestId)
+{
+    Request request;
+    request.id = requestId != 0 ? requestId : reserveRequestId();
+    request.scriptPath = stages.isEmpty() ? QString() : stages.first().toMap().value("path").toString();
+    request.entry = "pipeline";
+    request.input = frame;
+    request.stages = stages;
+    request.submitted = m_clock.nsecsElapsed();
+    m_queue.enqueue(request);
+
+    QTimer::singleShot(0, this, &PythonWorkerPool::dispatch);
+    return request.id;
+}
+
+bool PythonWorkerPool::cancel(quint64 requestId, const QString &reason)
+{
+    for (auto it = m_queue.begin(); it != m_queue.end(); ++it) {
+        if (it->id == requestId) {
+            m_queue.erase(it);
+            failRequest(requestId, reason);
+            return true;
+        }
+    }
+
+    Worker *running = nullptr;
+    for (Worker *worker : m_workers) {
+        if (worker->activeRequest == requestId) {
+            running = worker;
+            break;
+        }
+    }
+    if (!running)
+        return false;
+
+    // A script cannot be interrupted through the protocol; the worker goes with it
+    running->activeRequest = 0;
+    stopWorker(running, StopMode::Kill);
+    failRequest(requestId, reason);
+
+    // A replacement worker picks up the queue
+    QTimer::singleShot(0, this, &PythonWorkerPool::dispatch);
+    return true;
+}
+
+void PythonWorkerPool::shutdown()
+{
+    m_queue.clear();
+
+    const QList<Worker *> workers = m_workers;
+    for (Worker *worker : workers) {
+        stopWorker(worker, StopMode::Wait);
+    }
+}
+
+// Private helper methods
+PythonWorkerPool::Worker *PythonWorkerPool::spawnWorker()
+{
+    if (!QFile::exists(m_workerScript)) {
+        emit workerError(QString("Worker script not found: %1").arg(m_workerScript));
+        return nullptr;
+    }
+
+    Worker *worker = new Worker;
+    worker->process = new QProcess(this);
+    worker->process->setProgram(m_pythonProgram);
+    worker->process->setArguments(QStringList() << "-u" << m_workerScript);
+    worker->process->setProcessEnvironment(m_environment);
+
+    connect(worker->process, &QProcess::readyReadStandardOutput, this, [this, worker]() {
+        onWorkerReadyRead(worker);
+    });
+
+    connect(worker->process, &QProcess::readyReadStandardError, this, [worker]() {
+        // Scripts' stderr travels in the reply; this is the worker's own output
+        QByteArray error = worker->process->readAllStandardError();
+        if (!error.isEmpty()) {
+            qDebug() << "Python worker STDERR:" << error;
+        }
+    });
+
+    connect(worker->process, &QProcess::finished, this, [this, worker]() {
+        onWorkerFinished(worker);
+    });
+
+    connect(worker->process, &QProcess::started, this, [this, worker]() {
+        worker->started = m_clock.nsecsElapsed();
+    });
+
+    // The request is on its way once the last byte has left the write buffer
+    connect(worker->process, &QProcess::bytesWritten, this, [this, worker]() {
+        if (worker->activeRequest != 0 && worker->written < 0
+            && worker->process->bytesToWrite() == 0) {
+            worker->written = m_clock.nsecsElapsed();
+        }
+    });
+
+    // Crashes also end in finished(); only a failed start has to be caught here
+    connect(worker->process, &QProcess::errorOccurred, this, [this, worker](QProcess::ProcessError error) {
+        if (error == QProcess::FailedToStart) {
+            onWorkerStartFailed(worker);
+        }
+    });
+
+    // Listed before start(), since some platforms report a failed start from inside it
+    m_workers.append(worker);
+
+    qDebug() << "Starting Python worker:" << m_pythonProgram << m_workerScript;
+    worker->spawned = m_clock.nsecsElapsed();
+    worker->process->start();
+
+    if (!m_workers.contains(worker)) {
+        return nullptr; // Already cleaned up by onWorkerStartFailed()
+    }
+    return worker;
+}
+
+void PythonWorkerPool::dispatch()
+{
+    while (!m_queue.isEmpty()) {
+        Worker *idle = nullptr;
+        for (Worker *worker : m_workers) {
+            if (worker->activeRequest == 0) {
+                idle = worker;
+                break;
+            }
+        }
+
+        if (!idle && m_workers.size() < m_poolSize) {
+            idle = spawnWorker();
+            if (!idle) {
+                // Nothing can run until the configuration changes
+                while (!m_queue.isEmpty()) {
+                    failRequest(m_queue.dequeue().id,
+                                "Failed to start Python process. Make sure Python is installed.");
+                }
+                return;
+            }
+        }
+
+        if (!idle)
+            return; // All workers busy; the next reply dispatches again
+
+        Request request = m_queue.dequeue();
+
+        QJsonObject header;
+        header["id"] = QString::number(request.id);
+        header["script"] = request.scriptPath;
+        if (!request.entry.isEmpty()) {
+            header["entry"] = request.entry;
+        }
+        if (!request.segmentPath.isEmpty()) {
+            QJsonObject segment;
+            segment["path"] = request.segmentPath;
+            segment["bytes"] = request.segmentBytes;
+            header["shm"] = segment;
+        }
+        if (!request.stages.isEmpty()) {
+            header["stages"] = QJsonArray::fromVariantList(request.stages);
+        }
+        ScriptCapabilities known;
+        if (!scriptCapabilities(request.scriptPath, known)) {
+            header["describe"] = true;
+        }
+        header["input_bytes"] = static_cast<qint64>(request.input.size());
+
+        QByteArray frame = QJsonDocument(header).toJson(QJsonDocument::Compact);
+        frame.append('\n');
+        frame.append(request.input);
+
+        idle->activeRequest = request.id;
+        idle->activeScript = request.scriptPath;
+        idle->queued = request.submitted;
+        idle->dispatched = m_clock.nsecsElapsed();
+        idle->written = -1;
+        if (idle->process->write(frame) == -1) {
+            idle->activeRequest = 0;
+            failRequest(request.id, "Failed to write data to Python process.");
+            stopWorker(idle);
+            continue;
+        }
+
+        emit requestStarted(request.id);
+    }
+}
+
+void PythonWorkerPool::stopWorker(Worker *worker, StopMode mode)
+{
+    m_workers.removeOne(worker);
+
+    QProcess *process = worker->process;
+    quint64 requestId = worker->activeRequest;
+    delete worker;
+
+    process->disconnect(this);
+    if (process->state() == QProcess::NotRunning) {
+        process->deleteLater();
+    } else if (mode == StopMode::Wait) {
+        process->closeWriteChannel(); // EOF lets the worker exit cleanly
+        if (!process->waitForFinished(1000)) {
+            process->kill();
+            process->waitForFinished(1000);
+        }
+        process->deleteLater();
+    } else {
+        // The process reaps itself; nothing on this thread waits for it
+        connect(process, &QProcess::finished, process, &QObject::deleteLater);
+        if (mode == StopMode::Kill) {
+            process->kill();
+        } else {
+            process->closeWriteChannel();
+            QTimer::singleShot(1000, process, [process]() {
+                if (process->state() != QProcess::NotRunning) {
+                    process->kill();
+                } else {
+                    process->deleteLater();
+                }
+            });
+        }
+    }
+
+    if (requestId != 0) {
+        failRequest(requestId, "Python worker was stopped.");
+    }
+}
+
+void PythonWorkerPool::onWorkerReadyRead(Worker *worker)
+{
+    worker->buffer.append(worker->process->readAllStandardOutput());
+
+    qsizetype newline;
+    while ((newline = worker->buffer.indexOf('\n')) != -1) {
+        QByteArray line = worker->buffer.left(newline).trimmed();
+        worker->buffer.remove(0, newline + 1);
+
+        if (line.isEmpty())
+            continue;
+
+        QJsonParseError parseError;
+        QJsonDocument doc = QJsonDocument::fromJson(line, &parseError);
+        if (parseError.error != QJsonParseError::NoError || !doc.isObject()) {
+            qDebug() << "Ignoring malformed worker reply:" << line;
+            continue;
+        }
+
+        QJsonObject reply = doc.object();
+        quint64 requestId = reply["id"].toString().toULongLong();
+        if (requestId == 0 || requestId != worker->activeRequest) {
+            qDebug() << "Ignoring reply for unknown request" << requestId;
+            continue;
+        }
+
+        if (reply.contains("capabilities")) {
+            QJsonObject description = reply["capabilities"].toObject();
+            ScriptCapabilities capabilities;
+            for (const QJsonValue &entry : description["entries"].toArray()) {
+                capabilities.entries.append(entry.toString());
+            }
+            capabilities.dtype = description["dtype"].toString("float64");
+            capabilities.modified = QFileInfo(worker->activeScript).lastModified();
+            m_capabilities.insert(worker->activeScript, capabilities);
+        }
+
+        QVariantMap timings = reply["timings"].toObject().toVariantMap();
+        const qint64 now = m_clock.nsecsElapsed();
+        timings["queue_ns"] = worker->dispatched - worker->queued;
+        timings["reply_ns"] = now - worker->dispatched;
+        qint64 sendFrom = worker->dispatched;
+        if (worker->fresh && worker->started >= 0) {
+            timings["start_ns"] = worker->started - worker->spawned;
+            sendFrom = qMax(sendFrom, worker->started); // Nothing is written before the start
+        }
+        if (worker->written >= 0) {
+            timings["write_ns"] = worker->written - sendFrom;
+        }
+
+        worker->activeRequest = 0;
+        worker->activeScript.clear();
+        worker->fresh = false;
+
+        // Retire surplus workers after a shrink
+        if (m_workers.size() > m_poolSize) {
+            stopWorker(worker);
+        }
+
+        emit requestFinished(requestId,
+                             reply["exit_code"].toInt(),
+                             reply["stdout"].toString().toUtf8(),
+                             reply["stderr"].toString(),
+                             timings);
+
+        // stopWorker() may have freed the worker; never touch it after this
+        dispatch();
+        return;
+    }
+}
+
+void PythonWorkerPool::onWorkerFinished(Worker *worker)
+{
+    quint64 requestId = worker->activeRequest;
+    QString error = QString::fromUtf8(worker->process->readAllStandardError());
+
+    m_workers.removeOne(worker);
+    worker->process->deleteLater();
+    delete worker;
+
+    if (requestId != 0) {
+        failRequest(requestId, error.isEmpty()
+                                   ? QString("Python script crashed.")
+                                   : QString("Python script crashed: %1").arg(error));
+    }
+
+    dispatch();
+}
+
+void PythonWorkerPool::onWorkerStartFailed(Worker *worker)
+{
+    if (!m_workers.contains(worker))
+        return;
+
+    quint64 requestId = worker->activeRequest;
+    QString error = worker->process->errorString();
+
+    m_workers.removeOne(worker);
+    worker->process->disconnect(this);
+    worker->process->deleteLater();
+    delete worker;
+
+    qDebug() << "Python worker failed to start:" << error;
+    QString message = "Failed to start Python process. Make sure Python is installed.";
+    emit workerError(message);
+
+    // Nothing can run until the configuration changes
+    if (requestId != 0) {
+        failRequest(requestId, message);
+    }
+    while (!m_queue.isEmpty()) {
+        failRequest(m_queue.dequeue().id, message);
+    }
+}
+
+void PythonWorkerPool::failRequest(quint64 requestId, const QString &message)
+{
+    emit requestFinished(requestId, -1, QByteArray(), message, QVariantMap());
+}
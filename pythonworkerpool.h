@@ -0,0 +1,148 @@
+#ifndef PYTHONWORKERPOOL_H
+#define PYTHONWORKERPOOL_H
+
+#include <QObject>
+#include <QProcess>
+#include <QByteArray>
+#include <QString>
+#include <QList>
+#include <QQueue>
+#include <QHash>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QStringList>
+#include <QVariantMap>
+#include <atomic>
+
+// Pool of long-lived Python interpreters running scripts/gdss_worker.py.
+//
+// Each worker speaks a line-delimited protocol over stdin/stdout: a request
+// is one JSON header line followed by the raw stdin bytes for the fusion
+// script, and the reply is a single JSON line carrying the script's exit
+// code, stdout and stderr. Workers are started lazily and reused, so a
+// fusion costs one round trip instead of an interpreter launch.
+//
+// The first request for a script also asks the worker to describe it; the
+// entry points and input dtype it reports are kept until the file changes,
+// so callers can switch to the binary "fuse" frame where it is supported.
+//
+// Every reply comes with the nanosecond spans of its request: "queue_ns"
+// (submitted until a worker took it), "start_ns" (interpreter launch, only
+// for the request a worker was spawned for), "write_ns" (piping the request
+// in), "reply_ns" (dispatch until the reply was read) and the worker's own
+// read_ns, load_ns, call_ns and run_ns, see gdss_worker.py.
+class PythonWorkerPool : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct ScriptCapabilities {
+        QStringList entries;      // e.g. "fuse", "fuse_batch"
+        QString dtype;            // input dtype fuse() wants: "float32" or "float64"
+        QDateTime modified;       // script mtime the description applies to
+    };
+
+    explicit PythonWorkerPool(QObject *parent = nullptr);
+    ~PythonWorkerPool();
+
+    // Configuration
+    void setPythonProgram(const QString &program);
+    QString pythonProgram() const;
+    void setWorkerScript(const QString &path);
+    QString workerScript() const;
+    void setPoolSize(int size);
+    int poolSize() const;
+    // Environment for workers started from now on
+    void setProcessEnvironment(const QProcessEnvironment &environment);
+    QProcessEnvironment processEnvironment() const;
+
+    // State
+    int workerCount() const;
+    int busyWorkers() const;
+    int pendingRequests() const;
+    // False until a reply for this script version has described it
+    bool scriptCapabilities(const QString &scriptPath, ScriptCapabilities &capabilities) const;
+
+    // A fresh request id for submit(); the only call that is thread safe
+    quint64 reserveRequestId();
+    // Queue a script run; returns the request id reported in requestFinished().
+    // An empty entry runs the script as __main__; otherwise the worker calls
+    // that function of the script (e.g. "fuse_batch"). requestId 0 reserves
+    // a new id.
+    quint64 submit(const QString &scriptPath, const QByteArray &input,
+                   const QString &entry = QString(), quint64 requestId = 0);
+    // Like submit(), but the input is a frame the worker maps from segmentPath
+    quint64 submitShared(const QString &scriptPath, const QString &segmentPath,
+                         qint64 segmentBytes, const QString &entry, quint64 requestId = 0);
+    // Run a chain of scripts over one binary frame in a single request; each
+    // stage is {"path": scriptPath, "call": "transform" | "fuse"}, see the
+    // "pipeline" entry in gdss_worker.py
+    quint64 submitPipeline(const QVariantList &stages, const QByteArray &frame, quint64 requestId = 0);
+    // Drop a queued request or kill the worker running it. The request is
+    // reported through requestFinished() with exit code -1 and the reason;
+    // returns false if the id is unknown or already finished.
+    bool cancel(quint64 requestId, const QString &reason);
+    // Stops every worker, waiting briefly for each to exit
+    void shutdown();
+
+signals:
+    void requestStarted(quint64 requestId);
+    // exitCode < 0 means the worker itself failed (crash, start or pipe error);
+    // timings is empty then
+    void requestFinished(quint64 requestId, int exitCode,
+                         const QByteArray &output, const QString &errorOutput,
+                         const QVariantMap &timings);
+    void workerError(const QString &message);
+
+private:
+    struct Request {
+        quint64 id;
+        QString scriptPath;
+        QString entry;
+        QByteArray input;
+        QString segmentPath;  // Shared input instead of piped bytes
+        qint64 segmentBytes = 0;
+        QVariantList stages;  // Pipeline stages for the "pipeline" entry
+        qint64 submitted = 0;  // ns on m_clock
+    };
+
+    struct Worker {
+        QProcess *process = nullptr;
+        QByteArray buffer;
+        quint64 activeRequest = 0;
+        QString activeScript;
+        // Timestamps in ns on m_clock, -1 until they happen
+        qint64 spawned = -1;
+        qint64 started = -1;
+        qint64 queued = 0;  // submission time of the active request
+        qint64 dispatched = -1;
+        qint64 written = -1;
+        bool fresh = true;  // no reply yet, so the launch is charged to the active request
+    };
+
+    enum class StopMode {
+        Graceful,  // EOF on stdin, killed if it has not exited within a second
+        Kill,      // Abandon whatever the worker is running
+        Wait       // Graceful, but block until the process is gone
+    };
+
+    Worker *spawnWorker();
+    void dispatch();
+    void stopWorker(Worker *worker, StopMode mode = StopMode::Graceful);
+    void onWorkerReadyRead(Worker *worker);
+    void onWorkerFinished(Worker *worker);
+    void onWorkerStartFailed(Worker *worker);
+    void failRequest(quint64 requestId, const QString &message);
+
+    QString m_pythonProgram;
+    QString m_workerScript;
+    int m_poolSize;
+    QProcessEnvironment m_environment;
+    std::atomic<quint64> m_nextRequestId;
+    QList<Worker *> m_workers;
+    QQueue<Request> m_queue;
+    QHash<QString, ScriptCapabilities> m_capabilities;  // scriptPath -> description
+    QElapsedTimer m_clock;
+};
+
+#endif // PYTHONWORKERPOOL_H
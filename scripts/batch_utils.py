@@ -0,0 +1,60 @@
+"""
+Helpers for the scripts' vectorized batch entry point, fuse_batch(cases).
+
+A batch is a list of independent cases, each {"values": [...]} with an
+optional "confidences" list of the same length. Cases with the same agent
+count (and confidence presence) are stacked into 2-D arrays so a script
+fuses a whole group with one set of numpy operations - or one
+model.predict() call - instead of once per case.
+"""
+import numpy as np
+
+
+def group_cases(cases, dtype=np.float64):
+    """Yield (indices, values[k, n], confidences[k, n] or None) per group."""
+    groups = {}
+    for index, case in enumerate(cases):
+        values = case.get("values") or []
+        confidences = case.get("confidences")
+        has_confidences = bool(confidences) and len(confidences) == len(values)
+        groups.setdefault((len(values), has_confidences), []).append(index)
+
+    for (n_agents, has_confidences), indices in groups.items():
+        if n_agents == 0:
+            yield indices, None, None
+            continue
+        values = np.array([cases[i]["values"] for i in indices], dtype=dtype)
+        confidences = None
+        if has_confidences:
+            confidences = np.array([cases[i]["confidences"] for i in indices], dtype=dtype)
+        yield indices, values, confidences
+
+
+def run_grouped(cases, fuse_matrix, dtype=np.float64):
+    """Apply fuse_matrix(values, confidences) -> list of result dicts per group.
+
+    Results come back in case order; empty cases get an error entry.
+    """
+    results = [None] * len(cases)
+    for indices, values, confidences in group_cases(cases, dtype):
+        if values is None:
+            group_results = [{"error": "No agent data!"}] * len(indices)
+        else:
+            group_results = fuse_matrix(values, confidences)
+        for index, result in zip(indices, group_results):
+            results[index] = result
+    return results
+
+
+def results_from(fused, confidence=None):
+    """Turn per-row arrays into result dicts; non-finite values become errors."""
+    results = []
+    for row, value in enumerate(fused):
+        if not np.isfinite(value):
+            results.append({"error": "Fusion produced a non-finite value."})
+            continue
+        result = {"fused": float(value)}
+        if confidence is not None:
+            result["confidence"] = float(confidence[row])
+        results.append(result)
+    return results
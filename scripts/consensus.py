@@ -1,11 +1,13 @@
 import sys
 import json
+import time
 import numpy as np
+from batch_utils import run_grouped, results_from
 
-def main():
-    raw = sys.stdin.read()
-    data = json.loads(raw)
-    values = np.array(data["values"], dtype=np.float32)
+INPUT_DTYPE = "float32"
+
+def fuse(values, confidences=None):
+    values = np.asarray(values, dtype=np.float32)
 
     # Consensus-based fusion
     threshold = 0.2
@@ -20,9 +22,32 @@ def main():
     else:  # Weak consensus, be conservative
         fused = np.median(values)
 
-    fused = np.clip(fused, 0, 1)
+    fused = float(np.clip(fused, 0, 1))
+
+    return {"fused": fused}
+
+def main():
+    raw = sys.stdin.read()
+    data = json.loads(raw)
+
+    start = time.perf_counter_ns()
+    result = fuse(data["values"])
+    result["compute_ns"] = time.perf_counter_ns() - start
+    print(json.dumps(result), flush=True)
+
+def fuse_matrix(values, confidences=None):
+    """Batch version of main(): one row of values per case."""
+    threshold = 0.2
+    mean_val = values.mean(axis=1)
+
+    within_threshold = np.abs(values - mean_val[:, None]) < threshold
+    consensus_ratio = within_threshold.sum(axis=1) / values.shape[1]
+
+    fused = np.where(consensus_ratio > 0.7, mean_val, np.median(values, axis=1))
+    return results_from(np.clip(fused, 0, 1))
 
-    print(json.dumps({"fused": fused}), flush=True)
+def fuse_batch(cases):
+    return run_grouped(cases, fuse_matrix, np.float32)
 
 if __name__ == "__main__":
     main()
@@ -1,27 +1,31 @@
 import sys
 import json
+import time
 import numpy as np
-from sklearn.neural_network import MLPRegressor
+from neural import predict
+from neural import fuse_batch  # Same model, so the same batch entry point
 
-# read JSON from C++
-raw = sys.stdin.read()
-data = json.loads(raw)
-values = np.array(data["values"], dtype=np.float32)
+INPUT_DTYPE = "float32"
 
-# ---- AI MODEL (placeholder) ----
-# simple neural fusion: train a tiny model on synthetic examples
-X_train = np.random.rand(300, len(values))
-y_train = X_train.mean(axis=1) + np.random.normal(0, 0.01, 300)
+def fuse(values, confidences=None):
+    values = np.asarray(values, dtype=np.float32)
 
-model = MLPRegressor(hidden_layer_sizes=(16,),
-                     activation='relu',
-                     max_iter=300)
-model.fit(X_train, y_train)
+    # ---- AI MODEL (placeholder) ----
+    # simple neural fusion: a tiny model trained on synthetic examples,
+    # shared with neural.py through the model cache
 
-# produce fused result
-fused = float(model.predict(values.reshape(1, -1))[0])
+    # produce fused result, clipped to [0, 1] like fuse_batch()
+    return {"fused": float(predict(values.reshape(1, -1))[0])}
 
-# print result for C++
-result = json.dumps({"fused": fused})
-print(result, flush=True)  # Add flush=True to ensure output is sent
-sys.stdout.flush()  # Alternative flush method
+if __name__ == "__main__":
+    # read JSON from C++
+    raw = sys.stdin.read()
+    data = json.loads(raw)
+
+    # print result for C++
+    start = time.perf_counter_ns()
+    result = fuse(data["values"])
+    result["compute_ns"] = time.perf_counter_ns() - start
+    result = json.dumps(result)
+    print(result, flush=True)  # Add flush=True to ensure output is sent
+    sys.stdout.flush()  # Alternative flush method
@@ -1,6 +1,8 @@
 import sys
 import json
+import time
 import numpy as np
+from batch_utils import run_grouped, results_from
 
 def fuzzy_fusion(values):
     """Simple fuzzy logic fusion"""
@@ -23,15 +25,42 @@ def fuzzy_fusion(values):
         else:
             return np.mean(values[values <= 0.5])
 
+def fuse_matrix(values, confidences=None):
+    """Batch version of fuzzy_fusion(): the rules applied row by row."""
+    mean_val = values.mean(axis=1)
+    std_val = values.std(axis=1)
+
+    high = values > 0.5
+    high_count = high.sum(axis=1)
+    low_count = values.shape[1] - high_count
+    with np.errstate(divide="ignore", invalid="ignore"):
+        high_mean = np.where(high, values, 0).sum(axis=1) / high_count
+        low_mean = np.where(high, 0, values).sum(axis=1) / low_count
+    majority = np.where(high_count > values.shape[1] / 2, high_mean, low_mean)
+
+    fused = np.select(
+        [(mean_val > 0.8) & (std_val < 0.1),
+         (mean_val < 0.2) & (std_val < 0.1),
+         std_val < 0.2],
+        [0.95, 0.05, mean_val],
+        default=majority)
+    return results_from(np.clip(fused, 0, 1))
+
+def fuse_batch(cases):
+    return run_grouped(cases, fuse_matrix)
+
+def fuse(values, confidences=None):
+    fused = fuzzy_fusion(values)
+    return {"fused": float(np.clip(fused, 0, 1))}
+
 def main():
     raw = sys.stdin.read()
     data = json.loads(raw)
-    values = data["values"]
-
-    fused = fuzzy_fusion(values)
-    fused = np.clip(fused, 0, 1)
 
-    print(json.dumps({"fused": fused}), flush=True)
+    start = time.perf_counter_ns()
+    result = fuse(data["values"])
+    result["compute_ns"] = time.perf_counter_ns() - start
+    print(json.dumps(result), flush=True)
 
 if __name__ == "__main__":
     main()
@@ -0,0 +1,437 @@
+"""
+Long-lived fusion worker driven by PythonWorkerPool on the C++ side.
+
+Protocol (one request at a time over stdin/stdout):
+    request : one JSON header line {"id": str, "script": path, "input_bytes": n}
+              followed by exactly n bytes, which become the script's stdin
+    response: one JSON line {"id": str, "exit_code": int,
+              "stdout": str, "stderr": str, "timings": {...}}
+
+The fusion scripts run unchanged: each request executes the script as
+__main__ with stdin/stdout/stderr redirected to in-memory buffers. Heavy
+imports (numpy, sklearn) are paid once per worker, not once per fusion.
+
+A header may name an "entry" instead. For "fuse_batch" the payload is
+{"cases": [{"values": [...], "confidences": [...]}, ...]}; the script is
+loaded as a module (once per modification time) and its fuse_batch(cases)
+is called, and stdout carries {"results": [...]} in case order. Scripts
+without fuse_batch are run as __main__ once per case instead.
+
+For "fuse" the payload is a binary frame instead of JSON text (all fields
+little-endian):
+    0   4 bytes  magic b"GDSB"
+    4   uint8    version (1)
+    5   uint8    item size: 4 = float32, 8 = float64
+    6   uint8    flags: bit 0 set when confidences follow the values
+    7   uint8    reserved
+    8   uint64   agent count n
+    16  n items  values, then n items of confidences if flagged
+The arrays are handed to the script's fuse(values, confidences) as
+read-only numpy views; its returned dict becomes stdout.
+
+Version 2 frames carry agents scored on K criteria:
+    16  uint32   criteria count K
+    20  uint32   reserved
+    24  K*n items  values, one column of n per criterion, back to back,
+                   then n items of confidences (one per agent) if flagged
+The values decode as a read-only (K, n) view, one row per criterion. The
+"fuse_criteria" entry takes such a frame and prints {"criteria": [...]},
+one result dict per criterion in order: a script's fuse_matrix() gets all
+K rows in one call (with the confidences broadcast to every row), fuse()
+is called once per row, and scripts with neither run as __main__ on one
+JSON case per criterion. With binary framing turned off the engine sends
+"fuse_criteria" the same table as JSON text instead, {"criteria": [[...],
+...], "confidences": [...]}, one list of n values per criterion.
+
+Large frames are not sent through the pipe at all: the header then carries
+"shm": {"path": str, "bytes": n} and input_bytes 0. The path is a file the
+engine wrote the frame into once per run (on tmpfs where available); the
+worker maps it read-only and the numpy views point straight into the
+mapping, so every script of a comparison reads the same pages.
+
+For "pipeline" the payload is such a frame too and the header carries
+"stages": [{"path": str, "call": "transform" | "fuse"}, ...]. The stages
+run in order in this one request: each "transform" stage's
+transform(values, confidences) returns the arrays the next stage gets,
+as numpy arrays handed on without copying (transforms must not write to
+their inputs), and a final "fuse" stage's fuse() result becomes stdout.
+A segment that ends on a transform prints {"values": [...],
+"confidences": [...] or null} for the engine to carry on with.
+
+A header with "describe": true gets a "capabilities" object in the reply,
+{"entries": [...], "dtype": "float32" | "float64"}, listing which entry
+points the script defines and the dtype its fuse() wants. PythonWorkerPool
+uses it to pick the binary frame per script; JSON stays the fallback.
+
+Every reply also carries "timings", nanosecond spans of what the worker did
+with the request: {"read_ns": reading the payload or mapping the segment,
+"load_ns": loading the script module (0 when cached or run as __main__),
+"call_ns": the script's own code - fuse(), fuse_batch() or the __main__ run,
+"run_ns": the whole entry point, call and load included}. A script may add
+"compute_ns" to its result to tell its algorithm apart from the rest.
+"""
+import contextlib
+import io
+import json
+import mmap
+import os
+import runpy
+import sys
+import time
+import traceback
+
+FRAME_MAGIC = b"GDSB"
+FRAME_HEADER_BYTES = 16
+CRITERIA_FRAME_HEADER_BYTES = 24
+
+# Spans of the request being handled, reset by main() for each one
+timings = {}
+
+
+@contextlib.contextmanager
+def timed(name):
+    """Add the time spent in the block to timings[name]."""
+    start = time.perf_counter_ns()
+    try:
+        yield
+    finally:
+        timings[name] = timings.get(name, 0) + time.perf_counter_ns() - start
+
+
+def preload():
+    """Import the modules the fusion scripts depend on up front."""
+    for name in ("numpy", "sklearn.neural_network", "sklearn.ensemble"):
+        try:
+            __import__(name)
+        except Exception:
+            pass  # The script reports the ImportError itself when it runs
+
+
+def run_script(path, data):
+    """Run one script as __main__ and capture what it would have printed."""
+    script_dir = os.path.dirname(os.path.abspath(path))
+    if script_dir not in sys.path:
+        sys.path.insert(0, script_dir)
+
+    stdin = io.TextIOWrapper(io.BytesIO(data), encoding="utf-8")
+    stdout = io.StringIO()
+    stderr = io.StringIO()
+
+    saved = (sys.stdin, sys.stdout, sys.stderr, sys.argv)
+    sys.stdin, sys.stdout, sys.stderr = stdin, stdout, stderr
+    sys.argv = [path]
+
+    exit_code = 0
+    try:
+        with timed("call_ns"):
+            runpy.run_path(path, run_name="__main__")
+    except SystemExit as exc:
+        if exc.code is None:
+            exit_code = 0
+        elif isinstance(exc.code, int):
+            exit_code = exc.code
+        else:
+            stderr.write(str(exc.code))
+            exit_code = 1
+    except BaseException:
+        traceback.print_exc(file=stderr)
+        exit_code = 1
+    finally:
+        sys.stdin, sys.stdout, sys.stderr, sys.argv = saved
+
+    return exit_code, stdout.getvalue(), stderr.getvalue()
+
+
+_modules = {}
+
+
+@contextlib.contextmanager
+def isolated(log):
+    """Keep script code off the protocol pipes: empty stdin, output to log."""
+    saved = sys.stdin, sys.stdout, sys.stderr
+    sys.stdin = io.TextIOWrapper(io.BytesIO(b""), encoding="utf-8")
+    sys.stdout, sys.stderr = log, log
+    try:
+        yield
+    finally:
+        sys.stdin, sys.stdout, sys.stderr = saved
+
+
+def load_script(path):
+    """Load a script as a module namespace, reusing it until the file changes."""
+    mtime = os.path.getmtime(path)
+    cached = _modules.get(path)
+    if cached is not None and cached[0] == mtime:
+        return cached[1]
+
+    script_dir = os.path.dirname(os.path.abspath(path))
+    if script_dir not in sys.path:
+        sys.path.insert(0, script_dir)
+
+    # Module-level code of a script without a __main__ guard must not
+    # read the request stream
+    with isolated(io.StringIO()), timed("load_ns"):
+        namespace = runpy.run_path(path, run_name="gdss_script")
+    _modules[path] = (mtime, namespace)
+    return namespace
+
+
+def describe(path):
+    """Entry points and input dtype a script supports."""
+    try:
+        namespace = load_script(path)
+    except BaseException:
+        return {"entries": [], "dtype": "float64"}
+
+    entries = [name for name in ("fuse", "fuse_batch") if callable(namespace.get(name))]
+    dtype = namespace.get("INPUT_DTYPE", "float64")
+    if dtype not in ("float32", "float64"):
+        dtype = "float64"
+    return {"entries": entries, "dtype": dtype}
+
+
+def decode_frame(data):
+    """Binary frame -> (values, confidences or None) as read-only numpy views.
+
+    Values are one-dimensional for version 1 frames and (criteria, agents)
+    for version 2.
+    """
+    import numpy as np
+
+    if len(data) < FRAME_HEADER_BYTES or data[:4] != FRAME_MAGIC:
+        raise ValueError("Not a binary fusion frame")
+    version, item_size, flags = data[4], data[5], data[6]
+    if version not in (1, 2) or item_size not in (4, 8):
+        raise ValueError("Unsupported frame (version %d, item size %d)" % (version, item_size))
+
+    count = int.from_bytes(data[8:16], "little")
+    criteria, header_bytes = 1, FRAME_HEADER_BYTES
+    if version == 2:
+        if len(data) < CRITERIA_FRAME_HEADER_BYTES:
+            raise ValueError("Truncated frame")
+        criteria = int.from_bytes(data[16:20], "little")
+        header_bytes = CRITERIA_FRAME_HEADER_BYTES
+
+    dtype = "<f4" if item_size == 4 else "<f8"
+    cells = criteria * count
+    if len(data) < header_bytes + (cells + (count if flags & 1 else 0)) * item_size:
+        raise ValueError("Truncated frame")
+
+    values = np.frombuffer(data, dtype=dtype, count=cells, offset=header_bytes)
+    if version == 2:
+        values = values.reshape(criteria, count)
+    confidences = None
+    if flags & 1:
+        confidences = np.frombuffer(data, dtype=dtype, count=count,
+                                    offset=header_bytes + cells * item_size)
+    return values, confidences
+
+
+def map_shared(spec):
+    """Map a shared frame segment read-only."""
+    with open(spec["path"], "rb") as handle:
+        mapping = mmap.mmap(handle.fileno(), 0, access=mmap.ACCESS_READ)
+    if len(mapping) < int(spec.get("bytes", 0)):
+        mapping.close()
+        raise ValueError("Shared segment is shorter than announced")
+    return mapping
+
+
+def release_shared(mapping):
+    try:
+        mapping.close()
+    except BufferError:
+        pass  # A script kept a view; the mapping goes away with it
+
+
+def run_fuse(path, data):
+    """Call the script's fuse() on a binary frame; same triple as run_script()."""
+    stderr = io.StringIO()
+    try:
+        values, confidences = decode_frame(data)
+        fuse = load_script(path).get("fuse")
+        if fuse is None:
+            raise RuntimeError("%s has no fuse() entry point" % os.path.basename(path))
+        with isolated(stderr), timed("call_ns"):
+            result = fuse(values, confidences)
+    except BaseException:
+        traceback.print_exc(file=stderr)
+        return 1, "", stderr.getvalue()
+
+    return 0, json.dumps(result), stderr.getvalue()
+
+
+def run_batch(path, data):
+    """Fuse every case of a batch; returns the same triple as run_script()."""
+    stderr = io.StringIO()
+    try:
+        cases = json.loads(data.decode("utf-8"))["cases"]
+        fuse_batch = load_script(path).get("fuse_batch")
+
+        if fuse_batch is not None:
+            with isolated(stderr), timed("call_ns"):
+                results = fuse_batch(cases)
+        else:
+            results = [run_case(path, case, stderr) for case in cases]
+    except BaseException:
+        traceback.print_exc(file=stderr)
+        return 1, "", stderr.getvalue()
+
+    return 0, json.dumps({"results": results}), stderr.getvalue()
+
+
+def run_case(path, case, stderr):
+    """Run the script as __main__ on one JSON case; its result dict or {"error": ...}."""
+    exit_code, out, err = run_script(path, json.dumps(case).encode("utf-8"))
+    stderr.write(err)
+    if exit_code != 0:
+        return {"error": err.strip() or "Exit code %d" % exit_code}
+    try:
+        return json.loads(out)
+    except ValueError:
+        return {"error": "Invalid output: %s" % out.strip()}
+
+
+def decode_criteria(data):
+    """Version 2 frame or JSON criteria table -> (values (K, n), confidences or None)."""
+    import numpy as np
+
+    if data[:4] == FRAME_MAGIC:
+        return decode_frame(data)
+
+    table = json.loads(bytes(data).decode("utf-8"))
+    values = np.array(table["criteria"], dtype=np.float64)
+    if values.ndim != 2:
+        raise ValueError("Criteria must be lists of equal length")
+    confidences = table.get("confidences")
+    if confidences is not None:
+        confidences = np.array(confidences, dtype=np.float64)
+    return values, confidences
+
+
+def run_criteria(path, data):
+    """Fuse each criterion of a version 2 frame or JSON table; same triple as run_script()."""
+    import numpy as np
+
+    stderr = io.StringIO()
+    try:
+        values, confidences = decode_criteria(data)
+        if values.ndim == 1:
+            values = values.reshape(1, -1)
+        namespace = load_script(path)
+        fuse_matrix = namespace.get("fuse_matrix")
+        fuse = namespace.get("fuse")
+
+        if fuse_matrix is not None:
+            # Every criterion shares the agents' confidences
+            rows = None if confidences is None else np.broadcast_to(confidences, values.shape)
+            with isolated(stderr), timed("call_ns"):
+                results = fuse_matrix(values, rows)
+        elif fuse is not None:
+            with isolated(stderr), timed("call_ns"):
+                results = [fuse(row, confidences) for row in values]
+        else:
+            results = []
+            for row in values:
+                case = {"values": row.tolist(), "agent_count": len(row)}
+                if confidences is not None:
+                    case["confidences"] = confidences.tolist()
+                results.append(run_case(path, case, stderr))
+    except BaseException:
+        traceback.print_exc(file=stderr)
+        return 1, "", stderr.getvalue()
+
+    return 0, json.dumps({"criteria": list(results)}), stderr.getvalue()
+
+
+def run_pipeline(stages, data):
+    """Chain transform()/fuse() calls over one binary frame; same triple as run_script()."""
+    import numpy as np
+
+    stderr = io.StringIO()
+    try:
+        values, confidences = decode_frame(data)
+        for stage in stages:
+            path, call = stage["path"], stage.get("call", "fuse")
+            function = load_script(path).get(call)
+            if function is None:
+                raise RuntimeError("%s has no %s() entry point" % (os.path.basename(path), call))
+
+            with isolated(stderr), timed("call_ns"):
+                if call == "fuse":
+                    return 0, json.dumps(function(values, confidences)), stderr.getvalue()
+                values, confidences = function(values, confidences)
+            values = np.asarray(values, dtype=float)
+            if confidences is not None:
+                confidences = np.asarray(confidences, dtype=float)
+    except BaseException:
+        traceback.print_exc(file=stderr)
+        return 1, "", stderr.getvalue()
+
+    result = {"values": values.tolist(),
+              "confidences": None if confidences is None else confidences.tolist()}
+    return 0, json.dumps(result), stderr.getvalue()
+
+
+ENTRIES = {"fuse": run_fuse, "fuse_batch": run_batch, "pipeline": run_pipeline,
+           "fuse_criteria": run_criteria}
+
+
+def reply(channel, message):
+    channel.write(json.dumps(message).encode("utf-8") + b"\n")
+    channel.flush()
+
+
+def main():
+    preload()
+
+    requests = sys.stdin.buffer
+    responses = sys.stdout.buffer
+
+    while True:
+        line = requests.readline()
+        if not line:
+            break  # Pool closed our stdin: shut down
+        line = line.strip()
+        if not line:
+            continue
+
+        try:
+            header = json.loads(line)
+        except ValueError as exc:
+            reply(responses, {"id": "0", "exit_code": 1, "stdout": "",
+                              "stderr": "Malformed request: %s" % exc})
+            continue
+
+        timings.clear()
+        with timed("read_ns"):
+            data = requests.read(int(header.get("input_bytes", 0)))
+        entry = header.get("entry")
+        shared = None
+        if entry and entry not in ENTRIES:
+            exit_code, out, err = 1, "", "Unknown entry point: %s" % entry
+        else:
+            try:
+                if header.get("shm"):
+                    with timed("read_ns"):
+                        shared = data = map_shared(header["shm"])
+                # A pipeline names its scripts per stage
+                target = header.get("stages", []) if entry == "pipeline" else header.get("script", "")
+                with timed("run_ns"):
+                    exit_code, out, err = ENTRIES.get(entry, run_script)(target, data)
+            except Exception as exc:
+                exit_code, out, err = 1, "", "Cannot read shared segment: %s" % exc
+            finally:
+                data = None
+                if shared is not None:
+                    release_shared(shared)
+
+        message = {"id": header.get("id", "0"), "exit_code": exit_code,
+                   "stdout": out, "stderr": err, "timings": dict(timings)}
+        if header.get("describe"):
+            message["capabilities"] = describe(header.get("script", ""))
+        reply(responses, message)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,149 @@
+"""
+Trained-model cache shared by the learning fusion scripts.
+
+Training an MLPRegressor or a 100-tree RandomForestRegressor dominates the
+cost of neural.py, fuse.py and random_forest.py, and the models depend only
+on the agent count and hyperparameters - never on the values being fused.
+Models are therefore trained once per shape with fixed seeds and kept:
+
+    * in memory, for the lifetime of the interpreter (gdss_worker.py keeps
+      this module imported between requests), and
+    * on disk as pickles, so a fresh worker or a standalone run skips the
+      training too.
+
+Both tiers are bounded, since every agent count trains its own models: the
+memory tier keeps the MEMORY_LIMIT most recently used models, and the disk
+tier drops the least recently used pickles once there are more than
+DISK_LIMIT_FILES of them or they take more than DISK_LIMIT_BYTES.
+
+The disk location is $GDSS_MODEL_CACHE (set by DecisionEngine to the
+application cache directory), falling back to ~/.cache/gdss/models.
+"""
+import hashlib
+import json
+import os
+import pickle
+import sys
+import tempfile
+from collections import OrderedDict
+
+MEMORY_LIMIT = 16                    # models kept per interpreter
+DISK_LIMIT_FILES = 128               # pickles kept on disk
+DISK_LIMIT_BYTES = 512 * 1024 * 1024
+
+_memory = OrderedDict()  # key -> model, least recently used first
+
+
+def cache_dir():
+    path = os.environ.get("GDSS_MODEL_CACHE")
+    if not path:
+        path = os.path.join(os.path.expanduser("~"), ".cache", "gdss", "models")
+    return path
+
+
+def _key(kind, n_agents, params):
+    import sklearn
+
+    # The sklearn version is part of the key: pickles are not portable across it
+    description = json.dumps({"kind": kind, "agents": n_agents, "params": params,
+                              "sklearn": sklearn.__version__}, sort_keys=True)
+    return hashlib.sha1(description.encode("utf-8")).hexdigest()
+
+
+def _load(path):
+    try:
+        with open(path, "rb") as handle:
+            model = pickle.load(handle)
+        os.utime(path)  # The modification time orders the pickles for _prune()
+        return model
+    except FileNotFoundError:
+        return None
+    except Exception as exc:
+        # A truncated or stale pickle is just a cache miss
+        print("model_cache: ignoring unreadable %s (%s)" % (path, exc), file=sys.stderr)
+        return None
+
+
+def _store(path, model):
+    try:
+        os.makedirs(os.path.dirname(path), exist_ok=True)
+        fd, tmp = tempfile.mkstemp(dir=os.path.dirname(path), suffix=".tmp")
+        with os.fdopen(fd, "wb") as handle:
+            pickle.dump(model, handle, protocol=pickle.HIGHEST_PROTOCOL)
+        os.replace(tmp, path)  # Atomic, so concurrent workers never read half a file
+    except Exception as exc:
+        print("model_cache: could not write %s (%s)" % (path, exc), file=sys.stderr)
+
+
+def _prune(directory, keep):
+    """Delete the least recently used pickles until the disk limits hold."""
+    pickles = []
+    try:
+        with os.scandir(directory) as entries:
+            for entry in entries:
+                if entry.name.endswith(".pkl") and entry.path != keep:
+                    try:
+                        stat = entry.stat()
+                    except OSError:
+                        continue  # Removed by another worker meanwhile
+                    pickles.append((stat.st_mtime, stat.st_size, entry.path))
+        total = sum(size for _, size, _ in pickles)
+        if os.path.exists(keep):
+            total += os.path.getsize(keep)
+    except OSError:
+        return
+
+    pickles.sort()
+    count = len(pickles) + 1
+    for _, size, path in pickles:
+        if count <= DISK_LIMIT_FILES and total <= DISK_LIMIT_BYTES:
+            break
+        try:
+            os.remove(path)
+        except OSError:
+            pass  # Already gone, or in use on Windows; the next store retries
+        count -= 1
+        total -= size
+
+
+def _remember(key, model):
+    _memory[key] = model
+    _memory.move_to_end(key)
+    while len(_memory) > MEMORY_LIMIT:
+        _memory.popitem(last=False)
+
+
+def get_model(kind, n_agents, params, train):
+    """Return the model for (kind, n_agents, params), training it on first use.
+
+    train(n_agents, params) must be deterministic (seeded) so cached and
+    freshly trained models agree.
+    """
+    key = _key(kind, n_agents, params)
+
+    model = _memory.get(key)
+    if model is not None:
+        _memory.move_to_end(key)
+        return model
+
+    path = os.path.join(cache_dir(), "%s-%s.pkl" % (kind, key))
+    model = _load(path)
+    if model is None:
+        model = train(n_agents, params)
+        _store(path, model)
+        _prune(os.path.dirname(path), path)
+
+    _remember(key, model)
+    return model
+
+
+def mean_training_set(n_samples, n_agents, noise, seed):
+    """Synthetic examples whose target is the mean agent value."""
+    import numpy as np
+
+    rng = np.random.default_rng(seed)
+    X_train = rng.random((n_samples, n_agents))
+    y_train = X_train.mean(axis=1)
+    if noise > 0:
+        y_train = y_train + rng.normal(0, noise, n_samples)
+    return X_train, y_train
@@ -1,24 +1,56 @@
 import sys
 import json
+import time
 import numpy as np
 from sklearn.neural_network import MLPRegressor
+from model_cache import get_model, mean_training_set
+from batch_utils import run_grouped, results_from
+
+INPUT_DTYPE = "float32"
+
+PARAMS = {"samples": 300, "noise": 0.01, "hidden_layer_sizes": [16],
+          "activation": "relu", "max_iter": 300, "seed": 42}
+
+def train(n_agents, params):
+    X_train, y_train = mean_training_set(params["samples"], n_agents,
+                                         params["noise"], params["seed"])
+
+    model = MLPRegressor(hidden_layer_sizes=tuple(params["hidden_layer_sizes"]),
+                         activation=params["activation"],
+                         max_iter=params["max_iter"],
+                         random_state=params["seed"])
+    model.fit(X_train, y_train)
+    return model
+
+def predict(values):
+    """Fused value of each row of values[k, n], clipped to [0, 1].
+
+    Shared by fuse() and fuse_matrix() (and fuse.py), so a case fused on
+    its own and the same case in a batch give the same result.
+    """
+    # Neural network fusion; the model is trained once per agent count
+    model = get_model("mlp", values.shape[1], PARAMS, train)
+    return np.clip(model.predict(values), 0, 1)
+
+def fuse(values, confidences=None):
+    values = np.asarray(values, dtype=np.float32)
+    return {"fused": float(predict(values.reshape(1, -1))[0])}
 
 def main():
     raw = sys.stdin.read()
     data = json.loads(raw)
-    values = np.array(data["values"], dtype=np.float32)
 
-    # Neural network fusion
-    X_train = np.random.rand(300, len(values))
-    y_train = X_train.mean(axis=1) + np.random.normal(0, 0.01, 300)
-
-    model = MLPRegressor(hidden_layer_sizes=(16,), activation='relu', max_iter=300)
-    model.fit(X_train, y_train)
+    start = time.perf_counter_ns()
+    result = fuse(data["values"])
+    result["compute_ns"] = time.perf_counter_ns() - start
+    print(json.dumps(result), flush=True)
 
-    fused = float(model.predict(values.reshape(1, -1))[0])
-    fused = np.clip(fused, 0, 1)
+def fuse_matrix(values, confidences=None):
+    """One predict() call for every case with this agent count."""
+    return results_from(predict(values))
 
-    print(json.dumps({"fused": fused}), flush=True)
+def fuse_batch(cases):
+    return run_grouped(cases, fuse_matrix, np.float32)
 
 if __name__ == "__main__":
     main()
@@ -1,29 +1,49 @@
 import sys
 import json
+import time
 import numpy as np
-import pickle
-import os
 from sklearn.ensemble import RandomForestRegressor
+from model_cache import get_model, mean_training_set
+from batch_utils import run_grouped, results_from
 
-def main():
-    raw = sys.stdin.read()
-    data = json.loads(raw)
-    values = np.array(data["values"], dtype=np.float32).reshape(1, -1)
+INPUT_DTYPE = "float32"
 
-    # Generate training data
-    n_samples = 500
-    n_agents = len(values[0])
+PARAMS = {"samples": 500, "n_estimators": 100, "seed": 42}
 
-    X_train = np.random.rand(n_samples, n_agents)
-    y_train = X_train.mean(axis=1)  # Simple target
+def train(n_agents, params):
+    # Generate training data
+    X_train, y_train = mean_training_set(params["samples"], n_agents, 0.0, params["seed"])
 
-    model = RandomForestRegressor(n_estimators=100, random_state=42)
+    model = RandomForestRegressor(n_estimators=params["n_estimators"],
+                                  random_state=params["seed"])
     model.fit(X_train, y_train)
+    return model
+
+def fuse(values, confidences=None):
+    values = np.asarray(values, dtype=np.float32).reshape(1, -1)
+
+    # Trained once per agent count, then served from the model cache
+    model = get_model("random_forest", values.shape[1], PARAMS, train)
 
     fused = float(model.predict(values)[0])
-    fused = np.clip(fused, 0, 1)
+    return {"fused": float(np.clip(fused, 0, 1))}
+
+def main():
+    raw = sys.stdin.read()
+    data = json.loads(raw)
+
+    start = time.perf_counter_ns()
+    result = fuse(data["values"])
+    result["compute_ns"] = time.perf_counter_ns() - start
+    print(json.dumps(result), flush=True)
+
+def fuse_matrix(values, confidences=None):
+    """One predict() call for every case with this agent count."""
+    model = get_model("random_forest", values.shape[1], PARAMS, train)
+    return results_from(np.clip(model.predict(values), 0, 1))
 
-    print(json.dumps({"fused": fused}), flush=True)
+def fuse_batch(cases):
+    return run_grouped(cases, fuse_matrix, np.float32)
 
 if __name__ == "__main__":
     main()
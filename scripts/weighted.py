@@ -1,20 +1,43 @@
 import sys
 import json
+import time
 import numpy as np
+from batch_utils import run_grouped, results_from
 
-def main():
-    raw = sys.stdin.read()
-    data = json.loads(raw)
-    values = np.array(data["values"], dtype=np.float32)
+INPUT_DTYPE = "float32"  # Binary frames are sent in the precision used below
+
+def fuse(values, confidences=None):
+    values = np.asarray(values, dtype=np.float32)
 
     # Weighted average with confidence weighting
     weights = values  # Use values as confidence
     weights = weights / weights.sum() if weights.sum() > 0 else np.ones_like(values) / len(values)
 
     fused = float(np.sum(values * weights))
-    fused = np.clip(fused, 0, 1)
+    fused = float(np.clip(fused, 0, 1))
+
+    return {"fused": fused}
+
+def main():
+    raw = sys.stdin.read()
+    data = json.loads(raw)
+
+    start = time.perf_counter_ns()
+    result = fuse(data["values"])
+    result["compute_ns"] = time.perf_counter_ns() - start
+    print(json.dumps(result), flush=True)
+
+def fuse_matrix(values, confidences=None):
+    """Batch version of main(): one row of values per case."""
+    sums = values.sum(axis=1, keepdims=True)
+    with np.errstate(divide="ignore", invalid="ignore"):
+        weights = np.where(sums > 0, values / sums, 1.0 / values.shape[1])
+
+    fused = np.clip(np.sum(values * weights, axis=1), 0, 1)
+    return results_from(fused)
 
-    print(json.dumps({"fused": fused}), flush=True)
+def fuse_batch(cases):
+    return run_grouped(cases, fuse_matrix, np.float32)
 
 if __name__ == "__main__":
     main()
@@ -0,0 +1,55 @@
+#include "serviceprotocol.h"
+#include <QJsonDocument>
+#include <QtEndian>
+
+namespace ServiceProtocol {
+
+namespace {
+
+const qsizetype LENGTH_BYTES = sizeof(quint32);
+
+} // namespace
+
+QByteArray encode(const QJsonObject &message)
+{
+    QByteArray body = QJsonDocument(message).toJson(QJsonDocument::Compact);
+
+    QByteArray frame(LENGTH_BYTES, Qt::Uninitialized);
+    qToLittleEndian<quint32>(static_cast<quint32>(body.size()), frame.data());
+    frame.append(body);
+    return frame;
+}
+
+ReadStatus take(QByteArray &buffer, QJsonObject &message, QString &errorString)
+{
+    if (buffer.size() < LENGTH_BYTES) {
+        return ReadStatus::NeedMoreData;
+    }
+
+    quint32 length = qFromLittleEndian<quint32>(buffer.constData());
+    if (length > MAX_MESSAGE_BYTES) {
+        errorString = QString("Message of %1 bytes exceeds the %2 byte limit")
+                          .arg(length)
+                          .arg(MAX_MESSAGE_BYTES);
+        return ReadStatus::Oversized;
+    }
+    if (buffer.size() < LENGTH_BYTES + static_cast<qsizetype>(length)) {
+        return ReadStatus::NeedMoreData;
+    }
+
+    QJsonParseError parseError;
+    QJsonDocument document = QJsonDocument::fromJson(buffer.mid(LENGTH_BYTES, length), &parseError);
+    buffer.remove(0, LENGTH_BYTES + length);
+
+    if (parseError.error != QJsonParseError::NoError || !document.isObject()) {
+        errorString = parseError.error != QJsonParseError::NoError
+                          ? QString("Malformed message: %1").arg(parseError.errorString())
+                          : QString("Message is not a JSON object");
+        return ReadStatus::Malformed;
+    }
+
+    message = document.object();
+    return ReadStatus::Message;
+}
+
+} // namespace ServiceProtocol
@@ -0,0 +1,41 @@
+#ifndef SERVICEPROTOCOL_H
+#define SERVICEPROTOCOL_H
+
+#include <QByteArray>
+#include <QJsonObject>
+#include <QString>
+
+// Framing for the gdss-service local socket. Every message in either
+// direction is a little-endian u32 byte count followed by that many bytes
+// of compact JSON holding one object.
+//
+// Requests carry a client-chosen "id" that is echoed in the reply, so a
+// client may pipeline any number of them on one connection:
+//
+//   {"id": 1, "op": "fuse", "algorithm": "weighted", "values": [...], "confidences": [...]}
+//   {"id": 2, "op": "compare", "algorithms": ["weighted", "neural"], "values": [...]}
+//   {"id": 3, "op": "stats"}
+//
+// Replies carry "ok" and, on failure, "error". Fusion replies add "fused",
+// "confidence", "batch_size" (requests fused together with this one),
+// "queue_us" (receipt to batch start) and "latency_us" (receipt to reply);
+// comparisons return one such object per algorithm in "results".
+namespace ServiceProtocol {
+
+const quint32 MAX_MESSAGE_BYTES = 64 * 1024 * 1024;
+
+enum class ReadStatus {
+    NeedMoreData,
+    Message,
+    Malformed,  // Not a JSON object; the frame was skipped
+    Oversized   // Over MAX_MESSAGE_BYTES; the connection has to be dropped
+};
+
+QByteArray encode(const QJsonObject &message);
+
+// Takes the first complete message off the front of buffer
+ReadStatus take(QByteArray &buffer, QJsonObject &message, QString &errorString);
+
+} // namespace ServiceProtocol
+
+#endif // SERVICEPROTOCOL_H
@@ -0,0 +1,93 @@
+#include "sharedagentbuffer.h"
+#include "criteriatable.h"
+#include <QDir>
+#include <QFileInfo>
+
+SharedAgentBuffer::SharedAgentBuffer()
+    : m_file(QDir(segmentDirectory()).filePath("gdss-agents-XXXXXX.bin")),
+    m_size(0)
+{
+}
+
+bool SharedAgentBuffer::write(const QVariantList &values, const QVariantList &confidences,
+                              FusionFrame::ItemType type)
+{
+    qint64 size = FusionFrame::encodedSize(values.size(),
+                                           FusionFrame::hasConfidences(values, confidences),
+                                           type);
+
+    char *mapped = map(size);
+    if (!mapped) {
+        return false;
+    }
+    FusionFrame::encodeInto(mapped, values, confidences, type);
+    unmap(mapped, size);
+    return true;
+}
+
+bool SharedAgentBuffer::write(const CriteriaTable &table, FusionFrame::ItemType type)
+{
+    qint64 size = FusionFrame::encodedCriteriaSize(table.agentCount(), table.criteriaCount(),
+                                                   table.hasConfidences(), type);
+
+    char *mapped = map(size);
+    if (!mapped) {
+        return false;
+    }
+    FusionFrame::encodeCriteriaInto(mapped, table.cells(), table.confidences(),
+                                    table.agentCount(), table.criteriaCount(), type);
+    unmap(mapped, size);
+    return true;
+}
+
+char *SharedAgentBuffer::map(qint64 size)
+{
+    if (!m_file.isOpen() && !m_file.open()) {
+        m_errorString = m_file.errorString();
+        return nullptr;
+    }
+
+    if (!m_file.resize(size)) {
+        m_errorString = m_file.errorString();
+        return nullptr;
+    }
+
+    uchar *mapped = m_file.map(0, size);
+    if (!mapped) {
+        m_errorString = m_file.errorString();
+        return nullptr;
+    }
+    return reinterpret_cast<char *>(mapped);
+}
+
+void SharedAgentBuffer::unmap(char *mapped, qint64 size)
+{
+    m_file.unmap(reinterpret_cast<uchar *>(mapped));
+    m_file.flush();
+    m_size = size;
+}
+
+QString SharedAgentBuffer::path() const
+{
+    return m_file.fileName();
+}
+
+qint64 SharedAgentBuffer::size() const
+{
+    return m_size;
+}
+
+QString SharedAgentBuffer::errorString() const
+{
+    return m_errorString;
+}
+
+QString SharedAgentBuffer::segmentDirectory()
+{
+    // tmpfs keeps the segment in memory; elsewhere the page cache does
+    QFileInfo shm("/dev/shm");
+    if (shm.isDir() && shm.isWritable()) {
+        return shm.filePath();
+    }
+    return QDir::tempPath();
+}
@@ -0,0 +1,45 @@
+#ifndef SHAREDAGENTBUFFER_H
+#define SHAREDAGENTBUFFER_H
+
+#include <QString>
+#include <QTemporaryFile>
+#include <QVariantList>
+#include "fusionframe.h"
+
+class CriteriaTable;
+
+// One binary agent frame placed in a file-backed shared mapping.
+//
+// DecisionEngine writes the frame once per run and hands only the path to
+// the workers, which map it read-only; every script of a comparison then
+// reads the same pages instead of receiving its own copy through a pipe.
+// The file lives on tmpfs (/dev/shm) where available, so on Linux it never
+// touches the disk, and it is removed when the buffer is destroyed.
+class SharedAgentBuffer
+{
+public:
+    SharedAgentBuffer();
+
+    bool write(const QVariantList &values, const QVariantList &confidences,
+               FusionFrame::ItemType type);
+    // A multi-criteria (version 2) frame of the whole table
+    bool write(const CriteriaTable &table, FusionFrame::ItemType type);
+
+    QString path() const;
+    qint64 size() const;
+    QString errorString() const;
+
+private:
+    Q_DISABLE_COPY(SharedAgentBuffer)
+
+    static QString segmentDirectory();
+    // Sizes the file and maps it for writing; null with m_errorString set on failure
+    char *map(qint64 size);
+    void unmap(char *mapped, qint64 size);
+
+    QTemporaryFile m_file;
+    qint64 m_size;
+    QString m_errorString;
+};
+
+#endif // SHAREDAGENTBUFFER_H
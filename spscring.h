@@ -0,0 +1,73 @@
+#ifndef SPSCRING_H
+#define SPSCRING_H
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// Bounded lock-free queue for exactly one producer and one consumer thread.
+//
+// head is only written by the producer and tail only by the consumer, each
+// on its own cache line; both sides also keep a cached copy of the other's
+// index so the shared line is only read when the ring looks full or empty.
+// The capacity is rounded up to a power of two.
+template <typename T>
+class SpscRing
+{
+public:
+    explicit SpscRing(std::size_t capacity)
+    {
+        std::size_t size = 2;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        m_buffer.resize(size);
+        m_mask = size - 1;
+    }
+
+    SpscRing(const SpscRing &) = delete;
+    SpscRing &operator=(const SpscRing &) = delete;
+
+    std::size_t capacity() const { return m_buffer.size(); }
+
+    // Producer side; false when the ring is full
+    bool push(const T &item)
+    {
+        const std::size_t head = m_head.load(std::memory_order_relaxed);
+        if (head - m_cachedTail == m_buffer.size()) {
+            m_cachedTail = m_tail.load(std::memory_order_acquire);
+            if (head - m_cachedTail == m_buffer.size()) {
+                return false;
+            }
+        }
+        m_buffer[head & m_mask] = item;
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side; false when the ring is empty
+    bool pop(T &item)
+    {
+        const std::size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail == m_cachedHead) {
+            m_cachedHead = m_head.load(std::memory_order_acquire);
+            if (tail == m_cachedHead) {
+                return false;
+            }
+        }
+        item = m_buffer[tail & m_mask];
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    std::vector<T> m_buffer;
+    std::size_t m_mask = 0;
+
+    alignas(64) std::atomic<std::size_t> m_head{ 0 };
+    std::size_t m_cachedTail = 0;  // producer's view of m_tail
+    alignas(64) std::atomic<std::size_t> m_tail{ 0 };
+    std::size_t m_cachedHead = 0;  // consumer's view of m_head
+};
+
+#endif // SPSCRING_H
@@ -0,0 +1,347 @@
+#include "streamingfusion.h"
+#include "nativefusion.h"
+#include <QDebug>
+#include <QFile>
+#include <QRegularExpression>
+#include <QThread>
+#include <cmath>
+#include <memory>
+
+StreamingFusion::StreamingFusion(QObject *parent)
+    : QObject(parent),
+    m_ring(RING_CAPACITY),
+    m_algorithm("weighted_with_confidence.py"),
+    m_windowSize(10),
+    m_windowMs(0),
+    m_decayHalfLife(0.0),
+    m_ingestThread(nullptr),
+    m_stopIngestion(false),
+    m_dropped(0),
+    m_ingestedReadings(0),
+    m_invalidLines(0),
+    m_fusedValue(0.0),
+    m_fusedConfidence(0.0),
+    m_activeAgents(0)
+{
+    m_clock.start();
+    m_tickTimer.setInterval(100);
+    connect(&m_tickTimer, &QTimer::timeout, this, &StreamingFusion::tick);
+}
+
+StreamingFusion::~StreamingFusion()
+{
+    stop();
+    if (m_ingestThread) {
+        // The reader checks the flag between lines; on stdin this waits for
+        // the next line or the end of input
+        m_stopIngestion = true;
+        m_ingestThread->wait();
+        delete m_ingestThread;
+    }
+}
+
+// ========== PROPERTIES ==========
+
+QString StreamingFusion::algorithm() const
+{
+    return m_algorithm;
+}
+
+void StreamingFusion::setAlgorithm(const QString &scriptName)
+{
+    if (scriptName == m_algorithm) {
+        return;
+    }
+    if (!NativeFusion::contains(scriptName)) {
+        emit streamError(QString("%1 has no native implementation and cannot be streamed").arg(scriptName));
+        return;
+    }
+    m_algorithm = scriptName;
+    emit algorithmChanged();
+}
+
+int StreamingFusion::windowSize() const
+{
+    return m_windowSize;
+}
+
+void StreamingFusion::setWindowSize(int readings)
+{
+    readings = qMax(0, readings);
+    if (m_windowSize != readings) {
+        m_windowSize = readings;
+        emit windowChanged();
+        tick(); // Trim the held readings and publish under the new window
+    }
+}
+
+int StreamingFusion::windowMs() const
+{
+    return m_windowMs;
+}
+
+void StreamingFusion::setWindowMs(int milliseconds)
+{
+    milliseconds = qMax(0, milliseconds);
+    if (m_windowMs != milliseconds) {
+        m_windowMs = milliseconds;
+        emit windowChanged();
+        tick(); // Trim the held readings and publish under the new window
+    }
+}
+
+double StreamingFusion::decayHalfLife() const
+{
+    return m_decayHalfLife;
+}
+
+void StreamingFusion::setDecayHalfLife(double milliseconds)
+{
+    milliseconds = qMax(0.0, milliseconds);
+    if (m_decayHalfLife != milliseconds) {
+        m_decayHalfLife = milliseconds;
+        emit decayHalfLifeChanged();
+    }
+}
+
+int StreamingFusion::tickInterval() const
+{
+    return m_tickTimer.interval();
+}
+
+void StreamingFusion::setTickInterval(int milliseconds)
+{
+    milliseconds = qMax(1, milliseconds);
+    if (m_tickTimer.interval() != milliseconds) {
+        m_tickTimer.setInterval(milliseconds);
+        emit tickIntervalChanged();
+    }
+}
+
+bool StreamingFusion::isRunning() const
+{
+    return m_tickTimer.isActive();
+}
+
+double StreamingFusion::fusedValue() const
+{
+    return m_fusedValue;
+}
+
+double StreamingFusion::fusedConfidence() const
+{
+    return m_fusedConfidence;
+}
+
+int StreamingFusion::activeAgents() const
+{
+    return m_activeAgents;
+}
+
+qint64 StreamingFusion::droppedReadings() const
+{
+    return m_dropped.load(std::memory_order_relaxed);
+}
+
+void StreamingFusion::start()
+{
+    if (!m_tickTimer.isActive()) {
+        m_tickTimer.start();
+        emit runningChanged();
+    }
+}
+
+void StreamingFusion::stop()
+{
+    if (m_tickTimer.isActive()) {
+        m_tickTimer.stop();
+        emit runningChanged();
+    }
+}
+
+// ========== PRODUCERS ==========
+
+quint32 StreamingFusion::agentId(const QString &agent)
+{
+    auto it = m_agentIds.constFind(agent);
+    if (it != m_agentIds.constEnd()) {
+        return it.value();
+    }
+    quint32 id = static_cast<quint32>(m_agentIds.size());
+    m_agentIds.insert(agent, id);
+    return id;
+}
+
+bool StreamingFusion::enqueue(quint32 agent, double value, double confidence)
+{
+    Reading reading{ agent, value, qBound(0.0, confidence, 1.0), m_clock.nsecsElapsed() };
+    return m_ring.push(reading);
+}
+
+bool StreamingFusion::push(const QString &agent, double value, double confidence)
+{
+    if (isIngesting()) {
+        qDebug() << "StreamingFusion: push() ignored while ingesting";
+        return false;
+    }
+    if (!std::isfinite(value) || !std::isfinite(confidence)) {
+        return false;
+    }
+
+    // The owning thread must not block, so a full ring drops the reading
+    if (!enqueue(agentId(agent), value, confidence)) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+bool StreamingFusion::isIngesting() const
+{
+    return m_ingestThread != nullptr;
+}
+
+bool StreamingFusion::ingest(const QString &path)
+{
+    if (isIngesting()) {
+        emit streamError("Already ingesting a stream");
+        return false;
+    }
+
+    auto input = std::make_shared<QFile>();
+    bool opened;
+    if (path == "-") {
+        opened = input->open(stdin, QIODevice::ReadOnly);
+    } else {
+        input->setFileName(path);
+        opened = input->open(QIODevice::ReadOnly | QIODevice::Text);
+    }
+    if (!opened) {
+        emit streamError(QString("Cannot open %1: %2").arg(path, input->errorString()));
+        return false;
+    }
+
+    m_stopIngestion = false;
+    m_ingestedReadings = 0;
+    m_invalidLines = 0;
+
+    // The device is only touched by the ingestion thread from here on
+    m_ingestThread = QThread::create([this, input]() { runIngestion(input.get()); });
+    connect(m_ingestThread, &QThread::finished, this, [this]() {
+        m_ingestThread->deleteLater();
+        m_ingestThread = nullptr;
+        tick(); // Publish whatever the last lines carried
+        emit ingestionFinished(m_ingestedReadings, m_invalidLines);
+    });
+    m_ingestThread->start();
+    return true;
+}
+
+void StreamingFusion::runIngestion(QIODevice *input)
+{
+    static const QRegularExpression separators("[\\s,;]+");
+
+    while (!m_stopIngestion.load(std::memory_order_relaxed)) {
+        QByteArray line = input->readLine();
+        if (line.isEmpty()) {
+            break; // End of input; a blank line still carries its newline
+        }
+
+        QString text = QString::fromUtf8(line).trimmed();
+        if (text.isEmpty() || text.startsWith('#')) {
+            continue;
+        }
+
+        // agent value [confidence]
+        QStringList fields = text.split(separators, Qt::SkipEmptyParts);
+        bool valueOk = false;
+        bool confidenceOk = true;
+        double value = fields.size() >= 2 ? fields[1].toDouble(&valueOk) : 0.0;
+        double confidence = fields.size() >= 3 ? fields[2].toDouble(&confidenceOk) : 1.0;
+        if (!valueOk || !confidenceOk || fields.size() > 3
+            || !std::isfinite(value) || !std::isfinite(confidence)) {
+            m_invalidLines++;
+            continue;
+        }
+
+        // A file can wait for the consumer, so a full ring applies backpressure
+        const quint32 agent = agentId(fields[0]);
+        while (!enqueue(agent, value, confidence)) {
+            if (m_stopIngestion.load(std::memory_order_relaxed)) {
+                return;
+            }
+            QThread::usleep(200);
+        }
+        m_ingestedReadings++;
+    }
+}
+
+// ========== TICK ==========
+
+void StreamingFusion::tick()
+{
+    const qint64 now = m_clock.nsecsElapsed();
+
+    Reading reading;
+    while (m_ring.pop(reading)) {
+        if (reading.agent >= m_windows.size()) {
+            m_windows.resize(reading.agent + 1);
+        }
+        std::deque<Sample> &window = m_windows[reading.agent];
+        window.push_back({ reading.timestamp, reading.value, reading.confidence });
+        if (m_windowSize > 0 && window.size() > static_cast<std::size_t>(m_windowSize)) {
+            window.pop_front();
+        }
+    }
+
+    const qint64 oldest = m_windowMs > 0 ? now - qint64(m_windowMs) * 1000000 : 0;
+    const double decayRate = m_decayHalfLife > 0.0 ? 1.0 / (m_decayHalfLife * 1e6) : 0.0;
+
+    // One value per agent: its window's decay-weighted mean
+    m_values.clear();
+    m_confidences.clear();
+    for (std::deque<Sample> &window : m_windows) {
+        // Windows filled before windowSize shrank still hold more readings
+        if (m_windowSize > 0 && window.size() > static_cast<std::size_t>(m_windowSize)) {
+            window.erase(window.begin(), window.end() - m_windowSize);
+        }
+        while (!window.empty() && window.front().timestamp < oldest) {
+            window.pop_front();
+        }
+        if (window.empty()) {
+            continue;
+        }
+
+        // Ages count from the newest reading so old windows cannot underflow
+        // to all-zero weights; the common factor cancels out of the mean
+        const qint64 newest = window.back().timestamp;
+        double weightSum = 0.0;
+        double valueSum = 0.0;
+        double confidenceSum = 0.0;
+        for (const Sample &sample : window) {
+            double weight = decayRate > 0.0 ? std::exp2(-(newest - sample.timestamp) * decayRate) : 1.0;
+            weightSum += weight;
+            valueSum += weight * sample.value;
+            confidenceSum += weight * sample.confidence;
+        }
+        m_values.append(valueSum / weightSum);
+        m_confidences.append(confidenceSum / weightSum);
+    }
+
+    m_activeAgents = m_values.size();
+    if (m_activeAgents > 0) {
+        NativeFusionResult result = NativeFusion::run(m_algorithm, m_values.constData(),
+                                                      m_confidences.constData(), m_values.size());
+        if (result.ok) {
+            m_fusedValue = result.fused;
+            m_fusedConfidence = result.confidence;
+            m_lastError.clear();
+        } else if (result.errorMessage != m_lastError) {
+            // Report a failure once, not on every tick
+            m_lastError = result.errorMessage;
+            emit streamError(result.errorMessage);
+        }
+    }
+
+    emit ticked(m_fusedValue, m_fusedConfidence, m_activeAgents, now / 1000000);
+}
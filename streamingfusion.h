@@ -0,0 +1,131 @@
+#ifndef STREAMINGFUSION_H
+#define STREAMINGFUSION_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QString>
+#include <QTimer>
+#include <QVector>
+#include <atomic>
+#include <deque>
+#include <vector>
+#include "spscring.h"
+
+class QIODevice;
+class QThread;
+
+// Sliding-window fusion over agents that publish readings continuously.
+//
+// Readings enter through a lock-free ring (SpscRing) from a single
+// producer: either the ingestion thread started by ingest(), which reads
+// "agent value [confidence]" lines from a file, FIFO or stdin, or push()
+// from the owning thread. Every tickInterval ms the owning thread drains
+// the ring into a window per agent, drops readings outside the window
+// (the last windowSize readings and/or the last windowMs ms), reduces each
+// window to one decay-weighted value and fuses those with a native
+// algorithm. Python is never involved, so only algorithms NativeFusion
+// implements can be streamed.
+class StreamingFusion : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(QString algorithm READ algorithm WRITE setAlgorithm NOTIFY algorithmChanged)
+    Q_PROPERTY(int windowSize READ windowSize WRITE setWindowSize NOTIFY windowChanged)
+    Q_PROPERTY(int windowMs READ windowMs WRITE setWindowMs NOTIFY windowChanged)
+    Q_PROPERTY(double decayHalfLife READ decayHalfLife WRITE setDecayHalfLife NOTIFY decayHalfLifeChanged)
+    Q_PROPERTY(int tickInterval READ tickInterval WRITE setTickInterval NOTIFY tickIntervalChanged)
+    Q_PROPERTY(bool running READ isRunning NOTIFY runningChanged)
+    Q_PROPERTY(double fusedValue READ fusedValue NOTIFY ticked)
+    Q_PROPERTY(double fusedConfidence READ fusedConfidence NOTIFY ticked)
+    Q_PROPERTY(int activeAgents READ activeAgents NOTIFY ticked)
+    Q_PROPERTY(qint64 droppedReadings READ droppedReadings NOTIFY ticked)
+
+public:
+    explicit StreamingFusion(QObject *parent = nullptr);
+    ~StreamingFusion();
+
+    QString algorithm() const;
+    void setAlgorithm(const QString &scriptName);
+    int windowSize() const;
+    void setWindowSize(int readings);
+    int windowMs() const;
+    void setWindowMs(int milliseconds);
+    double decayHalfLife() const;
+    void setDecayHalfLife(double milliseconds);
+    int tickInterval() const;
+    void setTickInterval(int milliseconds);
+    bool isRunning() const;
+    double fusedValue() const;
+    double fusedConfidence() const;
+    int activeAgents() const;
+    qint64 droppedReadings() const;
+
+    Q_INVOKABLE void start();
+    Q_INVOKABLE void stop();
+    // Producer calls; only one of them may feed the ring at a time
+    Q_INVOKABLE bool push(const QString &agent, double value, double confidence = 1.0);
+    Q_INVOKABLE bool ingest(const QString &path);
+    Q_INVOKABLE bool isIngesting() const;
+
+    // Drains the ring and fuses once, outside the tick timer
+    Q_INVOKABLE void tick();
+
+signals:
+    void algorithmChanged();
+    void windowChanged();
+    void decayHalfLifeChanged();
+    void tickIntervalChanged();
+    void runningChanged();
+    // timestamp: ms since the stream was created
+    void ticked(double fused, double confidence, int agents, qint64 timestamp);
+    void streamError(const QString &message);
+    void ingestionFinished(qint64 readings, qint64 invalidLines);
+
+private:
+    struct Reading {
+        quint32 agent;
+        double value;
+        double confidence;
+        qint64 timestamp;  // ns on m_clock
+    };
+
+    struct Sample {
+        qint64 timestamp;
+        double value;
+        double confidence;
+    };
+
+    bool enqueue(quint32 agent, double value, double confidence);
+    quint32 agentId(const QString &agent);
+    void runIngestion(QIODevice *input);
+
+    SpscRing<Reading> m_ring;
+    QElapsedTimer m_clock;  // shared by both threads; nsecsElapsed() is thread safe
+    QTimer m_tickTimer;
+
+    QString m_algorithm;
+    int m_windowSize;  // readings per agent, 0 = no count limit
+    int m_windowMs;  // 0 = no age limit
+    double m_decayHalfLife;  // ms, 0 = equal weights
+    QString m_lastError;
+
+    // Producer state
+    QHash<QString, quint32> m_agentIds;
+    QThread *m_ingestThread;
+    std::atomic<bool> m_stopIngestion;
+    std::atomic<qint64> m_dropped;  // readings refused by a full ring
+    qint64 m_ingestedReadings;
+    qint64 m_invalidLines;
+
+    // Consumer state
+    std::vector<std::deque<Sample>> m_windows;  // indexed by agent id
+    QVector<double> m_values;
+    QVector<double> m_confidences;
+    double m_fusedValue;
+    double m_fusedConfidence;
+    int m_activeAgents;
+
+    static const int RING_CAPACITY = 1 << 16;
+};
+
+#endif // STREAMINGFUSION_H